@@ -95,6 +95,15 @@ public:
      */
     virtual bool
     print_results() = 0;
+    /**
+     * Returns whether the tool needs no more trace entries.  The analyzer stops
+     * reading the trace once every tool is done.
+     */
+    virtual bool
+    is_done()
+    {
+        return false;
+    }
 
 protected:
     bool success;
@@ -38,6 +38,7 @@
 #ifndef _ANALYSIS_TOOL_INTERFACE_H_
 #define _ANALYSIS_TOOL_INTERFACE_H_ 1
 
+#include <vector>
 #include "analysis_tool.h"
 
 /* The return value from this routine is passed to the other routines in
@@ -48,4 +49,11 @@
 analysis_tool_t *
 drmemtrace_analysis_tool_create();
 
+/* Creates one tool per configuration of a sweep (see the -sweep_file option).
+ * All of the returned tools are meant to be fed from the same trace.
+ * Returns false on failure, in which case no tools are returned.
+ */
+bool
+drmemtrace_analysis_sweep_create(std::vector<analysis_tool_t *> &tools);
+
 #endif /* _ANALYSIS_TOOL_INTERFACE_H_ */
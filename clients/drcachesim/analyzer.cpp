@@ -30,7 +30,11 @@
  * DAMAGE.
  */
 
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include "analysis_tool.h"
 #include "analyzer.h"
 #include "reader/file_reader.h"
@@ -45,6 +49,8 @@ analyzer_t::analyzer_t()
     , trace_end(NULL)
     , num_tools(0)
     , tools(NULL)
+    , pipeline_batch_size(0)
+    , pipeline_ring_size(0)
 {
     /* Nothing else: child class needs to initialize. */
 }
@@ -76,6 +82,8 @@ analyzer_t::analyzer_t(const std::string &trace_file, analysis_tool_t **tools_in
     , trace_end(NULL)
     , num_tools(num_tools_in)
     , tools(tools_in)
+    , pipeline_batch_size(0)
+    , pipeline_ring_size(0)
 {
     for (int i = 0; i < num_tools; ++i) {
         if (tools[i] == NULL || !*tools[i]) {
@@ -96,6 +104,8 @@ analyzer_t::analyzer_t(const std::string &trace_file)
     , trace_end(NULL)
     , num_tools(0)
     , tools(NULL)
+    , pipeline_batch_size(0)
+    , pipeline_ring_size(0)
 {
     if (!init_file_reader(trace_file))
         success = false;
@@ -132,15 +142,27 @@ analyzer_t::start_reading()
     return true;
 }
 
+void
+analyzer_t::set_pipeline(unsigned int batch_size, unsigned int ring_size)
+{
+    pipeline_batch_size = batch_size;
+    pipeline_ring_size = ring_size < 2 ? 2 : ring_size;
+}
+
 bool
 analyzer_t::run()
 {
     if (!start_reading())
         return false;
 
-    for (; *trace_iter != *trace_end; ++(*trace_iter)) {
+    if (pipeline_batch_size > 0 && num_tools > 0)
+        return run_pipelined();
+
+    for (; *trace_iter != *trace_end && !tools_done(); ++(*trace_iter)) {
+        // Tools take the record by const reference, so they can all share the
+        // reader's copy rather than each getting its own.
+        const memref_t &memref = **trace_iter;
         for (int i = 0; i < num_tools; ++i) {
-            memref_t memref = **trace_iter;
             // We short-circuit and exit on an error to avoid confusion over
             // the results and avoid wasted continued work.
             if (!tools[i]->process_memref(memref)) {
@@ -152,6 +174,125 @@ analyzer_t::run()
     return true;
 }
 
+bool
+analyzer_t::tools_done()
+{
+    for (int i = 0; i < num_tools; ++i) {
+        if (!tools[i]->is_done())
+            return false;
+    }
+    return num_tools > 0;
+}
+
+// The pipelined mode decodes records on the calling thread into a ring of
+// batches and hands every batch to one consumer thread per tool.  Each slot
+// counts the consumers that still have to process it; the reader refills a
+// slot only once that count is back to zero.  Batches are large enough that
+// the single lock protecting the ring is taken rarely.
+bool
+analyzer_t::run_pipelined()
+{
+    struct batch_t {
+        std::vector<memref_t> refs;
+        int pending; // Consumers that have yet to process this batch.
+        bool last;   // The reader hit the end of the trace.
+    };
+    std::vector<batch_t> ring(pipeline_ring_size);
+    for (auto &batch : ring) {
+        batch.refs.reserve(pipeline_batch_size);
+        batch.pending = 0;
+        batch.last = false;
+    }
+    std::mutex lock;
+    std::condition_variable batch_ready;
+    std::condition_variable slot_free;
+    uint64_t num_published = 0;
+    int num_done = 0; // Consumers whose tool is done with the trace.
+    bool abort = false;
+    std::string abort_error;
+
+    auto consume = [&](int tool_idx) {
+        bool done = false;
+        for (uint64_t seq = 0;; ++seq) {
+            batch_t &batch = ring[seq % ring.size()];
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                batch_ready.wait(guard, [&] { return abort || num_published > seq; });
+                if (abort)
+                    return;
+            }
+            for (const memref_t &memref : batch.refs) {
+                if (done)
+                    break;
+                // As in run(), short-circuit on an error.
+                if (!tools[tool_idx]->process_memref(memref)) {
+                    std::lock_guard<std::mutex> guard(lock);
+                    if (!abort) {
+                        abort = true;
+                        abort_error = tools[tool_idx]->get_error_string();
+                    }
+                    batch_ready.notify_all();
+                    slot_free.notify_all();
+                    return;
+                }
+            }
+            bool last = batch.last;
+            bool now_done = !done && tools[tool_idx]->is_done();
+            done = done || now_done;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                if (now_done)
+                    ++num_done;
+                if (--batch.pending == 0)
+                    slot_free.notify_one();
+            }
+            if (last)
+                return;
+        }
+    };
+
+    std::vector<std::thread> consumers;
+    for (int i = 0; i < num_tools; ++i)
+        consumers.push_back(std::thread(consume, i));
+
+    bool stop = false;
+    for (uint64_t seq = 0;; ++seq) {
+        batch_t &batch = ring[seq % ring.size()];
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            slot_free.wait(guard, [&] { return abort || batch.pending == 0; });
+            if (abort)
+                break;
+            stop = num_done == num_tools;
+        }
+        // The slot is ours until it is published below.  Once every tool is
+        // done, an empty last batch releases the consumers.
+        batch.refs.clear();
+        while (!stop && batch.refs.size() < pipeline_batch_size &&
+               *trace_iter != *trace_end) {
+            batch.refs.push_back(**trace_iter);
+            ++(*trace_iter);
+        }
+        batch.last = stop || *trace_iter == *trace_end;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            batch.pending = num_tools;
+            ++num_published;
+        }
+        batch_ready.notify_all();
+        if (batch.last)
+            break;
+    }
+
+    for (auto &consumer : consumers)
+        consumer.join();
+    if (abort) {
+        error_string = abort_error;
+        return false;
+    }
+    return true;
+}
+
 bool
 analyzer_t::print_stats()
 {
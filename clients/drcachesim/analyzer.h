@@ -87,6 +87,17 @@ public:
     virtual bool
     print_stats();
 
+    /**
+     * Switches run() to a pipelined mode.  The calling thread decodes the trace
+     * into batches of \p batch_size records held in a ring of \p ring_size
+     * buffers, and every tool consumes the batches on its own thread, in trace
+     * order.  A batch is recycled once all tools have processed it.  The tools
+     * must not share mutable state with each other.  A \p batch_size of 0
+     * restores the default serial mode.
+     */
+    void
+    set_pipeline(unsigned int batch_size, unsigned int ring_size);
+
     /** The alternate usage model exposes the iterator to a single tool. */
     analyzer_t(const std::string &trace_file);
     /**
@@ -110,12 +121,21 @@ protected:
     bool
     start_reading();
 
+    bool
+    run_pipelined();
+
+    // Whether every tool is done with the trace (see analysis_tool_t::is_done()).
+    bool
+    tools_done();
+
     bool success;
     std::string error_string;
     reader_t *trace_iter;
     reader_t *trace_end;
     int num_tools;
     analysis_tool_t **tools;
+    unsigned int pipeline_batch_size;
+    unsigned int pipeline_ring_size;
 };
 
 #endif /* _ANALYZER_H_ */
@@ -41,6 +41,7 @@
 #    include "reader/compressed_file_reader.h"
 #endif
 #include "reader/qemu_file_reader.h"
+#include "simulator/checkpoint.h"
 #include "reader/ipc_reader.h"
 #include "tracer/raw2trace_directory.h"
 #include "tracer/raw2trace.h"
@@ -55,21 +56,49 @@ analyzer_multi_t::analyzer_multi_t()
         error_string = "Failed to create analysis tool: " + error_string;
         return;
     }
+    if (op_pipeline.get_value()) {
+        if (op_pipeline_batch.get_value() == 0) {
+            success = false;
+            error_string = "-pipeline_batch must be >0";
+            return;
+        }
+        set_pipeline(op_pipeline_batch.get_value(), op_pipeline_ring.get_value());
+    }
 
     if (!op_qemu_mem_trace.get_value().empty()) {
         std::cout << "op_qemu_mem_trace=" << op_qemu_mem_trace.get_value() << std::endl;
         
+        qemu_file_reader_t *qemu_reader;
         if (op_trans_arch.get_value() == "radix") {
-            trace_iter = new qemu_file_reader_t(
+            qemu_reader = new qemu_file_reader_t(
                 op_qemu_mem_trace.get_value().c_str(), op_verbose.get_value(), RADIX, op_max_ref.get_value(), op_max_inst.get_value());
         } else if (op_trans_arch.get_value() == "ecpt") {
-            trace_iter = new qemu_file_reader_t(
+            qemu_reader = new qemu_file_reader_t(
                 op_qemu_mem_trace.get_value().c_str(), op_verbose.get_value(), ECPT, op_max_ref.get_value(), op_max_inst.get_value());
         } else {
             success = false;
             error_string = "invalid arch " + op_trans_arch.get_value();
             return;
         }
+        trace_iter = qemu_reader;
+        // The records have a fixed size, so skipping is a seek rather than
+        // the simulators dropping each reference (see analyzer_interface.cpp).
+        uint64_t skip_refs = op_skip_refs.get_value();
+        // A restored checkpoint resumes after the references it covers.
+        if (!op_checkpoint_in.get_value().empty()) {
+            uint64_t checkpoint_refs;
+            if (!checkpoint_trace_refs(op_checkpoint_in.get_value(), &checkpoint_refs,
+                                       error_string)) {
+                success = false;
+                return;
+            }
+            skip_refs += checkpoint_refs;
+        }
+        if (skip_refs > 0 && !qemu_reader->skip_records(skip_refs)) {
+            success = false;
+            error_string = "failed to skip to reference " + std::to_string(skip_refs);
+            return;
+        }
         
         trace_end = new qemu_file_reader_t();
         std::cout << "Done with qemu tracer" << std::endl;
@@ -141,6 +170,19 @@ analyzer_multi_t::create_analysis_tools()
     /* FIXME i#2006: create a single top-level tool for multi-component
      * tools.
      */
+    if (!op_sweep_file.get_value().empty()) {
+        // One simulator per sweep configuration, all fed by the same reader.
+        std::vector<analysis_tool_t *> sweep_tools;
+        if (!drmemtrace_analysis_sweep_create(sweep_tools)) {
+            error_string = "invalid sweep file " + op_sweep_file.get_value();
+            return false;
+        }
+        tools = new analysis_tool_t *[sweep_tools.size()];
+        for (size_t i = 0; i < sweep_tools.size(); i++)
+            tools[i] = sweep_tools[i];
+        num_tools = (int)sweep_tools.size();
+        return true;
+    }
     tools = new analysis_tool_t *[max_num_tools];
     tools[0] = drmemtrace_analysis_tool_create();
     if (tools[0] != NULL && !*tools[0]) {
@@ -87,10 +87,203 @@ droption_t<bool> op_mmu_to_l2(
     DROPTION_SCOPE_ALL, "mmu_to_l2", false, "MMU connects to L2 cache instead of L1 cache",
     "MMU cache connectivity");
 
+droption_t<std::string> op_pt_cache_policy(
+    DROPTION_SCOPE_FRONTEND, "pt_cache_policy", "",
+    "Page-table-aware cache policy (share, partition, priority)",
+    "Treats page table lines, the page walk requests of the PE1 to PE4 types, apart "
+    "from other lines in the caches of -pt_policy_caches and reports how many blocks "
+    "of each type they hold.  'share' only adds the occupancy statistics.  'partition' "
+    "reserves -pt_partition_ways ways of every set for page table lines and the others "
+    "for the rest.  'priority' inserts the page table lines of the top "
+    "-pt_priority_levels levels as if they had just been hit, which only changes the "
+    "replacement of policies inserting below the top, like the RRIP family, SHiP, "
+    "Hawkeye and LFU.  Empty disables it.");
+droption_t<std::string> op_pt_policy_caches(
+    DROPTION_SCOPE_FRONTEND, "pt_policy_caches", "LLC",
+    "Caches -pt_cache_policy applies to",
+    "Comma-separated list of the caches -pt_cache_policy applies to, out of L1D, L2 "
+    "and LLC.  L1D and L2 are every core's.");
+droption_t<unsigned int> op_pt_partition_ways(
+    DROPTION_SCOPE_FRONTEND, "pt_partition_ways", 2,
+    "Ways reserved for page table lines",
+    "Number of ways of every set reserved for page table lines with "
+    "-pt_cache_policy partition.  Must be less than the associativity of each cache.");
+droption_t<unsigned int> op_pt_priority_levels(
+    DROPTION_SCOPE_FRONTEND, "pt_priority_levels", 4,
+    "Page table levels inserted with priority",
+    "With -pt_cache_policy priority, the page table lines of levels PE1 (the root) to "
+    "PE<n> are inserted with priority.  In ECPT walks PE1 is the ECPT entries and PE2 "
+    "the cuckoo walk table entries.  From 1 to 4.");
+droption_t<bool> op_pt_bypass_l1(
+    DROPTION_SCOPE_FRONTEND, "pt_bypass_l1", false,
+    "Leaf page table lines bypass the L1D",
+    "The last-level (PE4) page table lines of radix walks go straight to the L2 "
+    "without being cached in the L1D.  Cannot be combined with -mmu_to_l2.");
+
+droption_t<bool> op_coherence(
+    DROPTION_SCOPE_FRONTEND, "coherence", false,
+    "Keep the cores' private caches coherent",
+    "Models a MESI directory beside the LLC that tracks the lines of each core's L2, "
+    "which is then kept inclusive of the core's L1s.  A write by a core invalidates "
+    "the line in the other cores' L1s and L2, and a read of a line another core "
+    "modified writes it back.  Page table lines, which the walkers read through the "
+    "same caches, are invalidated by the kernel's writes to them like any other.  "
+    "Each cache reports its coherence invalidations and the misses they caused, with "
+    "those of page walks apart, and the directory its traffic.  Needs -sim_threads 1 "
+    "and -epoch_refs 0.");
+
+droption_t<bool> op_pte_write_shootdown(
+    DROPTION_SCOPE_FRONTEND, "pte_write_shootdown", false,
+    "Shoot down translations on page table entry writes",
+    "Remembers the page table entries that radix walks read.  A data write to one "
+    "invalidates, on every core, the TLB entries of the addresses it maps and the "
+    "page walk cache entries at its level and below, as the kernel's TLB shootdown "
+    "and INVLPG do.  The TLB and page walk cache statistics report the extra misses "
+    "this causes as coherence misses.  Only for -arch radix; needs -sim_threads 1 and "
+    "-epoch_refs 0.");
+
 droption_t<bool> op_pwc_asplos_config(
     DROPTION_SCOPE_ALL, "pwc_asplos_config", false, "MMU connects to L2 cache instead of L1 cache",
     "MMU cache connectivity");
 
+droption_t<unsigned int> op_PWC_PGD_entries(
+    DROPTION_SCOPE_FRONTEND, "PWC_PGD_entries", 0,
+    "Number of PGD page walk cache entries",
+    "Number of entries of each core's page walk cache for top-level (PGD) entries in "
+    "radix simulation.  Must be a power of 2.  0 uses the size picked by "
+    "-pwc_asplos_config.");
+droption_t<unsigned int> op_PWC_PGD_assoc(
+    DROPTION_SCOPE_FRONTEND, "PWC_PGD_assoc", 0, "PGD page walk cache associativity",
+    "Associativity of each core's page walk cache for top-level (PGD) entries in radix "
+    "simulation.  Must be a power of 2.  0 uses the associativity picked by "
+    "-pwc_asplos_config.");
+droption_t<std::string> op_PWC_PGD_replace(
+    DROPTION_SCOPE_FRONTEND, "PWC_PGD_replace", "",
+    "PGD page walk cache replacement policy",
+    "Replacement policy of the PGD page walk caches, with the values of "
+    "-replace_policy.  Empty uses -replace_policy.");
+
+droption_t<unsigned int> op_PWC_PUD_entries(
+    DROPTION_SCOPE_FRONTEND, "PWC_PUD_entries", 0,
+    "Number of PUD page walk cache entries",
+    "Number of entries of each core's page walk cache for PUD entries in radix "
+    "simulation.  Must be a power of 2.  0 uses the size picked by -pwc_asplos_config.");
+droption_t<unsigned int> op_PWC_PUD_assoc(
+    DROPTION_SCOPE_FRONTEND, "PWC_PUD_assoc", 0, "PUD page walk cache associativity",
+    "Associativity of each core's page walk cache for PUD entries in radix "
+    "simulation.  Must be a power of 2.  0 uses the associativity picked by "
+    "-pwc_asplos_config.");
+droption_t<std::string> op_PWC_PUD_replace(
+    DROPTION_SCOPE_FRONTEND, "PWC_PUD_replace", "",
+    "PUD page walk cache replacement policy",
+    "Replacement policy of the PUD page walk caches, with the values of "
+    "-replace_policy.  Empty uses -replace_policy.");
+
+droption_t<unsigned int> op_PWC_PMD_entries(
+    DROPTION_SCOPE_FRONTEND, "PWC_PMD_entries", 0,
+    "Number of PMD page walk cache entries",
+    "Number of entries of each core's page walk cache for PMD entries in radix "
+    "simulation.  Must be a power of 2.  0 uses the size picked by -pwc_asplos_config.");
+droption_t<unsigned int> op_PWC_PMD_assoc(
+    DROPTION_SCOPE_FRONTEND, "PWC_PMD_assoc", 0, "PMD page walk cache associativity",
+    "Associativity of each core's page walk cache for PMD entries in radix "
+    "simulation.  Must be a power of 2.  0 uses the associativity picked by "
+    "-pwc_asplos_config.");
+droption_t<std::string> op_PWC_PMD_replace(
+    DROPTION_SCOPE_FRONTEND, "PWC_PMD_replace", "",
+    "PMD page walk cache replacement policy",
+    "Replacement policy of the PMD page walk caches, with the values of "
+    "-replace_policy.  Empty uses -replace_policy.");
+
+droption_t<unsigned int> op_CWC_PUD_entries(
+    DROPTION_SCOPE_FRONTEND, "CWC_PUD_entries", 2,
+    "Number of PUD cuckoo walk cache entries",
+    "Number of entries of each core's cuckoo walk cache for PUD cuckoo walk table "
+    "entries in ECPT simulation.  Must be a power of 2.");
+droption_t<unsigned int> op_CWC_PUD_assoc(
+    DROPTION_SCOPE_FRONTEND, "CWC_PUD_assoc", 2, "PUD cuckoo walk cache associativity",
+    "Associativity of each core's PUD cuckoo walk cache in ECPT simulation.  Must be a "
+    "power of 2.");
+droption_t<std::string> op_CWC_PUD_replace(
+    DROPTION_SCOPE_FRONTEND, "CWC_PUD_replace", "",
+    "PUD cuckoo walk cache replacement policy",
+    "Replacement policy of the PUD cuckoo walk caches, with the values of "
+    "-replace_policy.  Empty uses -replace_policy.");
+
+droption_t<unsigned int> op_CWC_PMD_entries(
+    DROPTION_SCOPE_FRONTEND, "CWC_PMD_entries", 16,
+    "Number of PMD cuckoo walk cache entries",
+    "Number of entries of each core's cuckoo walk cache for PMD cuckoo walk table "
+    "entries in ECPT simulation.  Must be a power of 2.");
+droption_t<unsigned int> op_CWC_PMD_assoc(
+    DROPTION_SCOPE_FRONTEND, "CWC_PMD_assoc", 16, "PMD cuckoo walk cache associativity",
+    "Associativity of each core's PMD cuckoo walk cache in ECPT simulation.  Must be a "
+    "power of 2.");
+droption_t<std::string> op_CWC_PMD_replace(
+    DROPTION_SCOPE_FRONTEND, "CWC_PMD_replace", "",
+    "PMD cuckoo walk cache replacement policy",
+    "Replacement policy of the PMD cuckoo walk caches, with the values of "
+    "-replace_policy.  Empty uses -replace_policy.");
+
+droption_t<unsigned int> op_ECPT_4K_ways(
+    DROPTION_SCOPE_FRONTEND, "ECPT_4K_ways", 3, "Number of ECPT ways for 4KB pages",
+    "Number of elastic cuckoo page table ways holding 4KB page entries.  The "
+    "ways of the 4KB pages come first, then those of the 2MB and the 1GB pages, and the "
+    "counts must match the page table the trace was recorded with.");
+
+droption_t<unsigned int> op_ECPT_2M_ways(
+    DROPTION_SCOPE_FRONTEND, "ECPT_2M_ways", 3, "Number of ECPT ways for 2MB pages",
+    "Number of elastic cuckoo page table ways holding 2MB page entries.  The "
+    "ways of the 4KB pages come first, then those of the 2MB and the 1GB pages, and the "
+    "counts must match the page table the trace was recorded with.");
+
+droption_t<unsigned int> op_ECPT_1G_ways(
+    DROPTION_SCOPE_FRONTEND, "ECPT_1G_ways", 0, "Number of ECPT ways for 1GB pages",
+    "Number of elastic cuckoo page table ways holding 1GB page entries.  The "
+    "ways of the 4KB pages come first, then those of the 2MB and the 1GB pages, and the "
+    "counts must match the page table the trace was recorded with.");
+
+droption_t<unsigned int> op_CWT_2M_ways(
+    DROPTION_SCOPE_FRONTEND, "CWT_2M_ways", 2, "Number of 2MB cuckoo walk table ways",
+    "Number of ways of the cuckoo walk table tracking 2MB regions, refetched "
+    "after a cuckoo walk cache miss.  Must match the trace, which records the 2MB ways' "
+    "steps before the 1GB ones.");
+
+droption_t<unsigned int> op_CWT_1G_ways(
+    DROPTION_SCOPE_FRONTEND, "CWT_1G_ways", 2, "Number of 1GB cuckoo walk table ways",
+    "Number of ways of the cuckoo walk table tracking 1GB regions, refetched "
+    "after a cuckoo walk cache miss.  Must match the trace, which records the 2MB ways' "
+    "steps before the 1GB ones.");
+
+droption_t<bool> op_synthetic_page_tables(
+    DROPTION_SCOPE_FRONTEND, "synthetic_page_tables", false,
+    "Simulate walks of page tables built by the simulator",
+    "Instead of the walks recorded in a QEMU trace, simulate walks of radix or ECPT "
+    "page tables (see -arch) that the simulator builds as the trace touches new pages, "
+    "in a synthetic physical address space.  This lets traces without recorded walks, "
+    "such as drmemtrace ones, exercise the TLBs, the page walk caches and ECPT.  The "
+    "physical pages and page sizes of the trace's walks are kept when it has any; other "
+    "pages are mapped in first-touch order with pages of -synthetic_page_size.  Radix "
+    "tables have 4 levels and ECPT tables follow -ECPT_4K_ways, -ECPT_2M_ways, "
+    "-ECPT_1G_ways, -CWT_2M_ways and -CWT_1G_ways.");
+
+droption_t<std::string> op_synthetic_page_size(
+    DROPTION_SCOPE_FRONTEND, "synthetic_page_size", "4K",
+    "Page size of -synthetic_page_tables",
+    "The size of the pages -synthetic_page_tables maps where the trace has no walk: "
+    "4K, 2M or 1G.  With -arch ecpt, a size without ECPT ways is mapped with 4KB "
+    "pages.");
+
+droption_t<std::string> op_translation_scheme(
+    DROPTION_SCOPE_FRONTEND, "translation_scheme", "",
+    "Translation scheme walked on TLB misses",
+    "The page table layout whose walks the TLB misses take: empty for the -arch "
+    "of the trace, or hashed (a single open-addressed table of all page sizes, "
+    "probed linearly), flattened (a radix tree with pairs of levels merged into 2MB "
+    "nodes) or nested (a guest radix walk whose every step, and the data, is "
+    "translated by a host radix walk).  The last three are built by "
+    "-synthetic_page_tables, which they need, with -arch radix.");
+
 droption_t<int> op_max_ref(
     DROPTION_SCOPE_ALL, "max_ref", -1, "max number of references to simulate",
     "MMU cache connectivity");
@@ -183,12 +376,52 @@ droption_t<unsigned int> op_num_ranges(
     "Number of ranges.");
 
 droption_t<unsigned int> op_contention_L1(
-    DROPTION_SCOPE_FRONTEND, "contention_L1", 0, "",
-    "Number of cont L1.");
+    DROPTION_SCOPE_FRONTEND, "contention_L1", 0,
+    "Interference requests into the L1D per reference, in hundredths",
+    "The expected number of requests of a co-running workload (see -interference) "
+    "injected into the core's L1D after each simulated reference, in hundredths: 150 "
+    "injects one request, plus a second one half of the time.");
 
 droption_t<unsigned int> op_contention_LLC(
-    DROPTION_SCOPE_FRONTEND, "contention_LLC", 0, "",
-    "Number of cont LLC.");
+    DROPTION_SCOPE_FRONTEND, "contention_LLC", 0,
+    "Interference requests into the LLC per LLC access, in hundredths",
+    "Like -contention_L1, but injected into the LLC after each simulated reference "
+    "that reached it.");
+
+droption_t<std::string> op_interference(
+    DROPTION_SCOPE_FRONTEND, "interference", "uniform",
+    "Source of the -contention_L1 and -contention_LLC addresses",
+    "Where the addresses of the interference requests come from: 'uniform' picks "
+    "random addresses in the first -interference_working_set bytes, 'stride' walks "
+    "them with a stride of -interference_stride bytes and 'trace' replays the physical "
+    "addresses of the references of the QEMU trace -interference_trace, in the format "
+    "of -arch, looping over it.  Random draws come from a generator seeded with "
+    "-interference_seed, so runs are reproducible.  Each cache reports the blocks of "
+    "the simulated workload that interference evicted, and how many of them were "
+    "page table lines.");
+
+droption_t<std::string> op_interference_trace(
+    DROPTION_SCOPE_FRONTEND, "interference_trace", "",
+    "QEMU trace replayed by -interference trace",
+    "The QEMU trace whose references are replayed as interference by -interference "
+    "trace.");
+
+droption_t<bytesize_t> op_interference_working_set(
+    DROPTION_SCOPE_FRONTEND, "interference_working_set", bytesize_t(1ULL << 31),
+    "Working set of -interference uniform and stride",
+    "The bytes of physical memory, from address 0, the interference requests of "
+    "-interference uniform and stride touch.");
+
+droption_t<unsigned int> op_interference_stride(
+    DROPTION_SCOPE_FRONTEND, "interference_stride", 64, "Stride of -interference stride",
+    "The bytes between consecutive interference requests of -interference stride.");
+
+droption_t<unsigned int> op_interference_seed(
+    DROPTION_SCOPE_FRONTEND, "interference_seed", 42,
+    "Seed of the interference random generator",
+    "Seeds the random generator that draws the interference addresses of "
+    "-interference uniform and whether a fractional -contention_L1 or -contention_LLC "
+    "request is injected.");
 
 droption_t<bool> op_L0_filter(
     DROPTION_SCOPE_CLIENT, "L0_filter", false,
@@ -238,6 +471,34 @@ droption_t<bool> op_cpu_scheduling(
     "thread "
     "on the core that owns the recorded cpu for that segment.");
 
+droption_t<bool> op_core_from_access_cpu(
+    DROPTION_SCOPE_FRONTEND, "core_from_access_cpu", true,
+    "Run QEMU trace references on the core of their recorded cpu",
+    "For -qemu_mem_trace input, simulate each reference on core (access_cpu modulo "
+    "-cores), where access_cpu is the cpu QEMU recorded for it, so that each cpu gets its "
+    "own L1 and L2 caches, TLBs and page walk caches while sharing the LLC.  If false, "
+    "the whole trace runs as one thread on a single core.");
+
+droption_t<unsigned int> op_sim_threads(
+    DROPTION_SCOPE_FRONTEND, "sim_threads", 1,
+    "Number of threads simulating the cores of a QEMU trace",
+    "If above 1, the private caches, TLBs and page walk caches of the cores (see "
+    "-core_from_access_cpu) are simulated in parallel, with each core owned by one of "
+    "this many threads.  The shared LLC is only updated between epochs of -epoch_refs "
+    "references: within an epoch, LLC lookups see the LLC as it was at the start of "
+    "the epoch, and the epoch's LLC accesses are then applied in trace order.  Results "
+    "thus depend on -epoch_refs but not on the number of threads, including 1 with a "
+    "positive -epoch_refs.  Cannot be combined with -contention_L1, -contention_LLC or "
+    "-interval_refs/-interval_instrs.");
+
+droption_t<bytesize_t> op_epoch_refs(
+    DROPTION_SCOPE_FRONTEND, "epoch_refs", 0,
+    "References per shared-LLC epoch",
+    "If positive, the number of references simulated between two updates of the shared "
+    "LLC (see -sim_threads), even with -sim_threads 1.  If 0, -sim_threads above 1 uses "
+    "16K and -sim_threads 1 replays the trace sequentially.  Smaller epochs keep the LLC "
+    "closer to a sequential replay at the cost of more synchronization.");
+
 droption_t<bytesize_t> op_max_trace_size(
     DROPTION_SCOPE_CLIENT, "max_trace_size", 0,
     "Cap on the raw trace size for each thread",
@@ -269,18 +530,73 @@ droption_t<bool> op_online_instr_types(
 
 droption_t<std::string> op_replace_policy(
     DROPTION_SCOPE_FRONTEND, "replace_policy", REPLACE_POLICY_LRU,
-    "Cache replacement policy (LRU, LFU, FIFO)",
+    "Cache replacement policy (LRU, LFU, FIFO, SRRIP, BRRIP, DRRIP, SHiP, Hawkeye)",
     "Specifies the replacement policy for "
     "caches. Supported policies: LRU (Least Recently Used), LFU (Least Frequently Used), "
-    "FIFO (First-In-First-Out).");
+    "FIFO (First-In-First-Out), SRRIP, BRRIP and DRRIP (static, bimodal and dynamic "
+    "Re-Reference Interval Prediction), SHiP (Signature-based Hit Predictor) and "
+    "Hawkeye (trained on Belady's optimal policy).  SHiP and Hawkeye key their "
+    "predictions by the PC when the trace has one, and by the request type and 16KB "
+    "region accessed otherwise.  -L1I_replace, -L1D_replace, -L2_replace and "
+    "-LL_replace override it per level.");
+
+droption_t<std::string> op_L1I_replace(
+    DROPTION_SCOPE_FRONTEND, "L1I_replace", "", "L1 instruction cache replacement policy",
+    "Replacement policy of the L1 instruction caches, with the values of "
+    "-replace_policy.  Empty uses -replace_policy.");
+
+droption_t<std::string> op_L1D_replace(
+    DROPTION_SCOPE_FRONTEND, "L1D_replace", "", "L1 data cache replacement policy",
+    "Replacement policy of the L1 data caches, with the values of -replace_policy.  "
+    "Empty uses -replace_policy.");
+
+droption_t<std::string> op_L2_replace(
+    DROPTION_SCOPE_FRONTEND, "L2_replace", "", "L2 cache replacement policy",
+    "Replacement policy of the L2 caches, with the values of -replace_policy.  "
+    "Empty uses -replace_policy.");
+
+droption_t<std::string> op_LL_replace(
+    DROPTION_SCOPE_FRONTEND, "LL_replace", "", "Last-level cache replacement policy",
+    "Replacement policy of the last-level cache, with the values of -replace_policy.  "
+    "Empty uses -replace_policy.");
 
 droption_t<std::string> op_data_prefetcher(
     DROPTION_SCOPE_FRONTEND, "data_prefetcher", PREFETCH_POLICY_NEXTLINE,
-    "Hardware data prefetcher policy (nextline, none)",
+    "Hardware data prefetcher policy (nextline, stride, stream, spatial, none)",
     "Specifies the hardware data "
     "prefetcher policy.  The currently supported policies are 'nextline' (fetch the "
-    "subsequent cache line) and 'none' (disables hardware prefetching).  The prefetcher "
-    "is located between the L1D and LL caches.");
+    "subsequent cache line on a miss), 'stride' (a table of the last address and "
+    "stride per load PC, or per 4KB page for QEMU traces which have no data PCs), "
+    "'stream' (ascending or descending block streams within 4KB pages), 'spatial' "
+    "(the footprints of 4KB regions, learned by the PC and offset of their first "
+    "access) and 'none' (disables hardware prefetching).  All but 'nextline' only "
+    "train on data loads and stores and stay within the page accessed.  The "
+    "prefetcher is located between the L1D and LL caches.  Each cache reports the "
+    "accuracy, coverage and lateness of the prefetches it received.");
+
+droption_t<unsigned int> op_prefetch_degree(
+    DROPTION_SCOPE_FRONTEND, "prefetch_degree", 2,
+    "How far ahead the stride and stream prefetchers fetch",
+    "Number of strides the 'stride' -data_prefetcher, or blocks the 'stream' one, "
+    "prefetches ahead of each access once it has detected a pattern.");
+
+droption_t<bytesize_t> op_prefetch_late_refs(
+    DROPTION_SCOPE_FRONTEND, "prefetch_late_refs", 16,
+    "Window in which a used prefetch counts as late",
+    "A prefetched cache block or TLB entry first used by a demand access within this "
+    "many requests to its cache or TLB of the prefetch counts as late in the "
+    "prefetch statistics, standing in for a prefetch still in flight.  0 counts none.");
+
+droption_t<std::string> op_tlb_prefetcher(
+    DROPTION_SCOPE_FRONTEND, "tlb_prefetcher", PREFETCH_POLICY_NONE,
+    "TLB prefetcher policy (sequential, none)",
+    "With 'sequential', when a core's data accesses move on to the page after one of "
+    "the last few pages they touched, the translation of the page after it is "
+    "prefetched into the L2 TLB.  A missing translation is pre-walked: its leaf page "
+    "table entry, next to the current one, is read as a prefetch through the cache "
+    "the page walker uses.  Entries that would be in another page table page, and "
+    "2MB and 1GB pages, are not prefetched.  Only for -arch radix.  The L2 TLB "
+    "reports the prefetches' accuracy, coverage and lateness.");
 
 droption_t<bytesize_t> op_page_size(DROPTION_SCOPE_FRONTEND, "page_size",
                                     bytesize_t(4 * 1024), "Virtual/physical page size",
@@ -311,11 +627,106 @@ droption_t<unsigned int> op_TLB_L2_assoc(
     DROPTION_SCOPE_FRONTEND, "TLB_L2_assoc", 4, "L2 TLB associativity",
     "Specifies the associativity of each unified L2 TLB.  Must be a power of 2.");
 
+droption_t<bool> op_TLB_page_sizes(
+    DROPTION_SCOPE_FRONTEND, "TLB_page_sizes", false,
+    "Model TLB arrays for 2MB and 1GB pages",
+    "For QEMU traces, takes the page size of each translation from its page walk "
+    "(a radix walk of 3 levels maps a 2MB page and one of 2 levels a 1GB page; for ECPT "
+    "the way the entry was found in) and looks it up and fills it in the TLB array for "
+    "that size, like x86 parts with separate 2MB/1GB L1 DTLB arrays and an L2 TLB shared "
+    "by 4KB and 2MB pages.  The arrays are sized by the -TLB_<level>_2M_* and "
+    "-TLB_<level>_1G_* options; a size with 0 entries at a level shares that level's "
+    "-page_size TLB, whose entries then carry their page size.  A miss in an L1 array "
+    "goes to the L2 TLB holding the same page size.  TLB statistics are also reported "
+    "per page size.");
+
+droption_t<unsigned int> op_TLB_L1I_2M_entries(
+    DROPTION_SCOPE_FRONTEND, "TLB_L1I_2M_entries", 8,
+    "Number of 2MB entries in instruction TLB",
+    "Specifies the number of entries in each L1 instruction TLB array for 2MB pages, "
+    "or 0 to keep them in the L1 instruction TLB.  See -TLB_page_sizes.");
+
+droption_t<unsigned int> op_TLB_L1I_2M_assoc(
+    DROPTION_SCOPE_FRONTEND, "TLB_L1I_2M_assoc", 8,
+    "Instruction TLB 2MB array associativity",
+    "Specifies the associativity of each L1 instruction TLB array for 2MB pages.  "
+    "See -TLB_page_sizes.");
+
+droption_t<unsigned int> op_TLB_L1I_1G_entries(
+    DROPTION_SCOPE_FRONTEND, "TLB_L1I_1G_entries", 0,
+    "Number of 1GB entries in instruction TLB",
+    "Specifies the number of entries in each L1 instruction TLB array for 1GB pages, "
+    "or 0 to keep them in the L1 instruction TLB.  See -TLB_page_sizes.");
+
+droption_t<unsigned int> op_TLB_L1I_1G_assoc(
+    DROPTION_SCOPE_FRONTEND, "TLB_L1I_1G_assoc", 4,
+    "Instruction TLB 1GB array associativity",
+    "Specifies the associativity of each L1 instruction TLB array for 1GB pages.  "
+    "See -TLB_page_sizes.");
+
+droption_t<unsigned int> op_TLB_L1D_2M_entries(
+    DROPTION_SCOPE_FRONTEND, "TLB_L1D_2M_entries", 32, "Number of 2MB entries in data TLB",
+    "Specifies the number of entries in each L1 data TLB array for 2MB pages, or 0 to "
+    "keep them in the L1 data TLB.  See -TLB_page_sizes.");
+
+droption_t<unsigned int> op_TLB_L1D_2M_assoc(
+    DROPTION_SCOPE_FRONTEND, "TLB_L1D_2M_assoc", 4, "Data TLB 2MB array associativity",
+    "Specifies the associativity of each L1 data TLB array for 2MB pages.  "
+    "See -TLB_page_sizes.");
+
+droption_t<unsigned int> op_TLB_L1D_1G_entries(
+    DROPTION_SCOPE_FRONTEND, "TLB_L1D_1G_entries", 4, "Number of 1GB entries in data TLB",
+    "Specifies the number of entries in each L1 data TLB array for 1GB pages, or 0 to "
+    "keep them in the L1 data TLB.  See -TLB_page_sizes.");
+
+droption_t<unsigned int> op_TLB_L1D_1G_assoc(
+    DROPTION_SCOPE_FRONTEND, "TLB_L1D_1G_assoc", 4, "Data TLB 1GB array associativity",
+    "Specifies the associativity of each L1 data TLB array for 1GB pages.  "
+    "See -TLB_page_sizes.");
+
+droption_t<unsigned int> op_TLB_L2_2M_entries(
+    DROPTION_SCOPE_FRONTEND, "TLB_L2_2M_entries", 0, "Number of 2MB entries in L2 TLB",
+    "Specifies the number of entries in each L2 TLB array for 2MB pages, or 0 to keep "
+    "them in the unified L2 TLB.  See -TLB_page_sizes.");
+
+droption_t<unsigned int> op_TLB_L2_2M_assoc(
+    DROPTION_SCOPE_FRONTEND, "TLB_L2_2M_assoc", 4, "L2 TLB 2MB array associativity",
+    "Specifies the associativity of each L2 TLB array for 2MB pages.  "
+    "See -TLB_page_sizes.");
+
+droption_t<unsigned int> op_TLB_L2_1G_entries(
+    DROPTION_SCOPE_FRONTEND, "TLB_L2_1G_entries", 16, "Number of 1GB entries in L2 TLB",
+    "Specifies the number of entries in each L2 TLB array for 1GB pages, or 0 to keep "
+    "them in the unified L2 TLB.  See -TLB_page_sizes.");
+
+droption_t<unsigned int> op_TLB_L2_1G_assoc(
+    DROPTION_SCOPE_FRONTEND, "TLB_L2_1G_assoc", 4, "L2 TLB 1GB array associativity",
+    "Specifies the associativity of each L2 TLB array for 1GB pages.  "
+    "See -TLB_page_sizes.");
+
 droption_t<std::string>
     op_TLB_replace_policy(DROPTION_SCOPE_FRONTEND, "TLB_replace_policy",
                           REPLACE_POLICY_LFU, "TLB replacement policy",
                           "Specifies the replacement policy for TLBs. "
-                          "Supported policies: LFU (Least Frequently Used).");
+                          "Supported policies: LFU (Least Frequently Used), LRU, FIFO, SRRIP, "
+                          "BRRIP, DRRIP, SHiP and Hawkeye, as described for "
+                          "-replace_policy.  -TLB_L1I_replace, -TLB_L1D_replace and "
+                          "-TLB_L2_replace override it per level.");
+
+droption_t<std::string> op_TLB_L1I_replace(
+    DROPTION_SCOPE_FRONTEND, "TLB_L1I_replace", "", "L1 instruction TLB replacement policy",
+    "Replacement policy of the L1 instruction TLBs, with the values of "
+    "-TLB_replace_policy.  Empty uses -TLB_replace_policy.");
+
+droption_t<std::string> op_TLB_L1D_replace(
+    DROPTION_SCOPE_FRONTEND, "TLB_L1D_replace", "", "L1 data TLB replacement policy",
+    "Replacement policy of the L1 data TLBs, with the values of -TLB_replace_policy.  "
+    "Empty uses -TLB_replace_policy.");
+
+droption_t<std::string> op_TLB_L2_replace(
+    DROPTION_SCOPE_FRONTEND, "TLB_L2_replace", "", "L2 TLB replacement policy",
+    "Replacement policy of the L2 TLBs, with the values of -TLB_replace_policy.  "
+    "Empty uses -TLB_replace_policy.");
 
 droption_t<std::string> op_simulator_type(DROPTION_SCOPE_FRONTEND, "simulator_type",
                                           CPU_CACHE,
@@ -363,7 +774,9 @@ droption_t<bytesize_t>
                  "Number of memory references to skip",
                  "Specifies the number of references to skip "
                  "in the beginning of the application execution. "
-                 "These memory references are dropped instead of being simulated.");
+                 "These memory references are dropped instead of being simulated.  "
+                 "For -qemu_mem_trace the reader seeks past them without decoding them, "
+                 "and -max_ref still counts from the start of the trace.");
 
 droption_t<bytesize_t> op_warmup_refs(
     DROPTION_SCOPE_FRONTEND, "warmup_refs", 0,
@@ -380,6 +793,61 @@ droption_t<double> op_warmup_fraction(
     "is computed after the skipped references and before simulated references. "
     "This flag is incompatible with warmup_refs.");
 
+droption_t<bool> op_warmup_functional(
+    DROPTION_SCOPE_FRONTEND, "warmup_functional", false,
+    "Only update cache state during warmup",
+    "During the warmup set by -warmup_refs or -warmup_fraction, only update cache, TLB "
+    "and page walk cache contents and replacement state.  Per-reference bookkeeping "
+    "that is discarded or not needed at the end of warmup (page walk trajectories, "
+    "per-access results, reference type counts and verbose output) is skipped.");
+
+droption_t<bytesize_t> op_sample_period(
+    DROPTION_SCOPE_FRONTEND, "sample_period", 0,
+    "References per sampling period, 0 for no sampling",
+    "If non-zero, the cache simulator samples the trace SMARTS-style instead of "
+    "simulating all of it in detail.  Each period of this many references starts with "
+    "-sample_skip references that are not simulated at all, then references that only "
+    "update the contents of the caches, TLBs and walk caches (as -warmup_functional "
+    "does), then -sample_warmup references simulated in detail and last a measurement "
+    "window of -sample_window references.  The page walks per 100 references, the TLB "
+    "misses per 1000 instructions and the cycles per walk (see -walk_latencies) are "
+    "estimated from the windows with confidence intervals, and the simulation stops as "
+    "soon as all of them are within -sample_error.  The other statistics cover the "
+    "references simulated in detail.  This flag is incompatible with -warmup_refs and "
+    "-warmup_fraction.");
+
+droption_t<bytesize_t> op_sample_window(
+    DROPTION_SCOPE_FRONTEND, "sample_window", 10000,
+    "References per -sample_period measurement window",
+    "The number of references measured at the end of each -sample_period.");
+
+droption_t<bytesize_t> op_sample_warmup(
+    DROPTION_SCOPE_FRONTEND, "sample_warmup", 2000,
+    "References simulated in detail before each measurement window",
+    "The number of references before each -sample_window that are simulated in detail "
+    "but not measured, for the state that functional warming does not keep up to date, "
+    "such as the timing model's, to settle.");
+
+droption_t<bytesize_t> op_sample_skip(
+    DROPTION_SCOPE_FRONTEND, "sample_skip", 0,
+    "References not simulated at the start of each -sample_period",
+    "The number of references at the start of each -sample_period that are dropped "
+    "without updating any state.  Skipping is faster than functional warming, at the "
+    "price of staler caches and TLBs in the measurement windows.");
+
+droption_t<double> op_sample_error(
+    DROPTION_SCOPE_FRONTEND, "sample_error", 0.03,
+    "Target relative error of the -sample_period estimates",
+    "The simulation stops once the confidence interval of every -sample_period "
+    "estimate is within this fraction of the estimate, after at least 30 windows.  0 "
+    "samples the whole trace.");
+
+droption_t<double> op_sample_confidence(
+    DROPTION_SCOPE_FRONTEND, "sample_confidence", 0.997,
+    "Confidence level of the -sample_period intervals",
+    "The confidence level, between 0 and 1, of the intervals of the -sample_period "
+    "estimates.");
+
 droption_t<bytesize_t>
     op_sim_refs(DROPTION_SCOPE_FRONTEND, "sim_refs", bytesize_t(1ULL << 63),
                 "Number of memory references to simulate",
@@ -387,6 +855,151 @@ droption_t<bytesize_t>
                 "The simulated references come after the skipped and warmup references, "
                 "and the references following the simulated ones are dropped.");
 
+droption_t<bytesize_t> op_interval_refs(
+    DROPTION_SCOPE_FRONTEND, "interval_refs", 0,
+    "Memory references per -interval_file record",
+    "If non-zero, the cache simulator writes a record to -interval_file every time this "
+    "many references have been simulated after warmup.  May be combined with "
+    "-interval_instrs, in which case whichever limit is reached first ends the interval.");
+
+droption_t<bytesize_t> op_interval_instrs(
+    DROPTION_SCOPE_FRONTEND, "interval_instrs", 0,
+    "Instruction fetches per -interval_file record",
+    "If non-zero, the cache simulator writes a record to -interval_file every time this "
+    "many instruction fetches have been simulated after warmup.");
+
+droption_t<std::string> op_interval_file(
+    DROPTION_SCOPE_FRONTEND, "interval_file", "",
+    "Path for periodic cache simulator statistics",
+    "If non-empty, the cache simulator writes one JSON object per line to this file for "
+    "each interval set by -interval_refs or -interval_instrs, plus one for the final "
+    "partial interval.  Each object holds the interval number, the index of its first "
+    "simulated reference, its reference and instruction counts, the [hits, misses] of "
+    "every TLB, cache, PWC and CWC during the interval keyed by name (e.g., "
+    "\"core0.L1D\", \"core0.PWC2\", \"LLC\"), and the page walk trajectory histogram of "
+    "the interval keyed like the final results (e.g., \"L2,LLC,MEMORY\").  With "
+    "-sweep_file each configuration writes to the path suffixed with '.' and its name.");
+
+droption_t<bool> op_latency_model(
+    DROPTION_SCOPE_FRONTEND, "latency_model", false,
+    "Estimate address translation latency",
+    "If true, the cache simulator charges each simulated reference the latency of its "
+    "TLB lookup, page walk and data access, using the per-level latencies of "
+    "-walk_latencies, and prints the average, percentiles and histogram of the page "
+    "walk latency along with the cycles per reference.  Radix walks are serial; ECPT "
+    "ways are probed in parallel (see -ecpt_parallel_cwc and -cwt_backfill_overlap).");
+
+droption_t<std::string> op_walk_latencies(
+    DROPTION_SCOPE_FRONTEND, "walk_latencies", "",
+    "Latencies for -latency_model",
+    "A comma-separated list of NAME=cycles overriding the -latency_model defaults "
+    "MEMORY=200,L1=4,L2=14,LLC=54,PWC=1,TLB=1,HASH=2,PUD_CWC=4,PMD_CWC=4.  MEMORY, L1, "
+    "L2, LLC and PWC are the levels serving a page walk step or data access, TLB is "
+    "the TLB lookup, HASH the ECPT hash and PUD_CWC and PMD_CWC the ECPT cuckoo walk "
+    "cache lookups.");
+
+droption_t<bool> op_ecpt_parallel_cwc(
+    DROPTION_SCOPE_FRONTEND, "ecpt_parallel_cwc", true,
+    "Look up the ECPT CWCs in parallel under -latency_model",
+    "If true, an ECPT walk under -latency_model or -timing_model waits for the slower "
+    "of the PUD and PMD cuckoo walk cache lookups; otherwise it waits for both in turn.");
+
+droption_t<bool> op_cwt_backfill_overlap(
+    DROPTION_SCOPE_FRONTEND, "cwt_backfill_overlap", true,
+    "Overlap the ECPT CWT back-fill with the walk under -latency_model",
+    "If false, an ECPT walk under -latency_model or -timing_model also waits for the "
+    "cuckoo walk table entries it refetches after missing in the CWCs.");
+
+droption_t<bool> op_timing_model(
+    DROPTION_SCOPE_FRONTEND, "timing_model", false,
+    "Cycle-approximate timing of the memory hierarchy",
+    "If true, the cache simulator timestamps each simulated reference with a "
+    "cycle-approximate model of the hierarchy, to estimate page walk latency under "
+    "memory-level parallelism.  Each core issues a reference per cycle with at most "
+    "-issue_window in flight, and a TLB miss waits for one of -page_walkers walkers.  "
+    "Each cache level has ports, MSHRs and a latency, and DRAM has banks with an open "
+    "row each; these are set by -timing_params.  Radix walk steps are serial while "
+    "ECPT ways and CWT back-fills are issued together and compete for the same "
+    "ports and MSHRs.  Prints the total cycles, the average, percentiles and maximum "
+    "of the page walk latency, the average number of walks in flight and the "
+    "port, MSHR and DRAM bank contention per level.  The levels serving each access "
+    "come from the regular simulation, which is unchanged.  Needs -sim_threads 1 and "
+    "-epoch_refs 0.");
+
+droption_t<std::string> op_timing_params(
+    DROPTION_SCOPE_FRONTEND, "timing_params", "",
+    "Parameters for -timing_model",
+    "A comma-separated list of NAME=value overriding the -timing_model defaults "
+    "L1=4,L2=10,LLC=40,L1_PORTS=2,L2_PORTS=1,LLC_PORTS=4,L1_MSHRS=8,L2_MSHRS=16,"
+    "LLC_MSHRS=64,DRAM_ROW_HIT=100,DRAM_ROW_MISS=146,DRAM_BURST=4,DRAM_BANKS=16,"
+    "DRAM_ROW_BYTES=8192,TLB=1,PWC=1,HASH=2,PUD_CWC=4,PMD_CWC=4.  L1, L2 and LLC are "
+    "the cycles each level adds to an access reaching it, *_PORTS the accesses it "
+    "starts per cycle and *_MSHRS its outstanding misses; the L1s and L2 are per "
+    "core.  DRAM_ROW_HIT and DRAM_ROW_MISS are the DRAM latencies with the row open or "
+    "not, and a bank is busy for DRAM_BURST cycles after a row hit.  TLB, PWC, HASH "
+    "and the CWCs are as in -walk_latencies.");
+
+droption_t<unsigned int> op_issue_window(
+    DROPTION_SCOPE_FRONTEND, "issue_window", 1,
+    "References in flight per core under -timing_model",
+    "The number of references each core may have in flight under -timing_model.  1 "
+    "issues them in order, each after the previous one completes.");
+
+droption_t<unsigned int> op_page_walkers(
+    DROPTION_SCOPE_FRONTEND, "page_walkers", 1,
+    "Concurrent page walks per core under -timing_model",
+    "The number of page walks each core may have in flight under -timing_model.");
+
+droption_t<bool> op_miss_ratio_curves(
+    DROPTION_SCOPE_FRONTEND, "miss_ratio_curves", false,
+    "Print LRU miss ratio curves of the TLBs and walk caches",
+    "Besides simulating the configured TLBs and page or cuckoo walk caches, records "
+    "the stack distances of the requests each of them receives and prints, per TLB "
+    "and walk cache level summed over the cores, the miss ratio an LRU structure of "
+    "each power-of-two number of entries up to -mrc_max_entries would have, for each "
+    "associativity of -mrc_assocs.  This replaces a sweep over their sizes.  The "
+    "requests a level receives depend on the configured sizes of the levels in front "
+    "of it: the L2 TLB only sees the misses of the L1 TLBs, and a walk cache level "
+    "only the walks that missed the deeper ones.");
+
+droption_t<unsigned int> op_mrc_max_entries(
+    DROPTION_SCOPE_FRONTEND, "mrc_max_entries", 4096,
+    "Largest size of the -miss_ratio_curves",
+    "The number of entries, a power of 2, of the largest structure of the "
+    "-miss_ratio_curves.");
+
+droption_t<std::string> op_mrc_assocs(
+    DROPTION_SCOPE_FRONTEND, "mrc_assocs", "",
+    "Associativities of the -miss_ratio_curves",
+    "A comma-separated list of the associativities, powers of 2 or 'full' for fully "
+    "associative, with a curve each in -miss_ratio_curves.  By default each structure "
+    "has a curve at its configured associativity and a fully associative one.");
+
+droption_t<unsigned int> op_mrc_sample_sets(
+    DROPTION_SCOPE_FRONTEND, "mrc_sample_sets", 1,
+    "Set sampling of the set-associative -miss_ratio_curves",
+    "With a power of 2 above 1, the set-associative -miss_ratio_curves only track "
+    "one set in this many, which divides their cost, at the price of accuracy for "
+    "the sizes with few sets.  The fully associative curve is exact.");
+
+droption_t<std::string> op_checkpoint_out(
+    DROPTION_SCOPE_FRONTEND, "checkpoint_out", "",
+    "Path to save the warm simulator state to",
+    "If non-empty, the cache simulator writes the contents of its caches, TLBs and "
+    "walk caches to this file once the -warmup_refs or -warmup_fraction warmup "
+    "completes, for later runs to start from with -checkpoint_in.  With -sweep_file "
+    "each configuration writes to the path suffixed with '.' and its name.");
+
+droption_t<std::string> op_checkpoint_in(
+    DROPTION_SCOPE_FRONTEND, "checkpoint_in", "",
+    "Path to restore the warm simulator state from",
+    "If non-empty, the cache simulator starts from the state saved by -checkpoint_out "
+    "instead of warming up, and the trace resumes after the references the checkpoint "
+    "covers.  The -arch, -num_cores, -skip_refs and the geometry of every cache and TLB "
+    "must match the run that wrote it; the replacement policies may differ, in which "
+    "case the contents are kept but not their recency.  Predictor tables of the "
+    "policies and the prefetchers are not saved and start cold.");
+
 droption_t<std::string>
     op_view_syntax(DROPTION_SCOPE_FRONTEND, "view_syntax", "att",
                    "Syntax to use for disassembly.",
@@ -399,6 +1012,49 @@ droption_t<std::string>
                    "Cache hierarchy configuration file",
                    "The full path to the cache hierarchy configuration file.");
 
+droption_t<bool> op_pipeline(
+    DROPTION_SCOPE_FRONTEND, "pipeline", false,
+    "Decode the trace and run each tool on separate threads",
+    "Runs the trace reader on its own thread, which decodes records into batches "
+    "(see -pipeline_batch) held in a ring of buffers (see -pipeline_ring).  Each "
+    "simulator, e.g., each -sweep_file configuration, consumes the batches on its "
+    "own thread.  Results are identical to a serial run.");
+
+droption_t<unsigned int> op_pipeline_batch(
+    DROPTION_SCOPE_FRONTEND, "pipeline_batch", 4096,
+    "Records per batch in -pipeline mode",
+    "Number of trace records the reader decodes into each batch handed to the tool "
+    "threads in -pipeline mode.");
+
+droption_t<unsigned int> op_pipeline_ring(
+    DROPTION_SCOPE_FRONTEND, "pipeline_ring", 16, "Batches in flight in -pipeline mode",
+    "Number of batches in the ring shared by the reader and the tool threads in "
+    "-pipeline mode.  Bounds how far the reader can run ahead of the slowest tool.");
+
+droption_t<std::string> op_sweep_file(
+    DROPTION_SCOPE_FRONTEND, "sweep_file", "",
+    "Run several cache/TLB configurations in one pass over the trace",
+    "The full path to a sweep file listing one or more named configurations of the "
+    "form 'name { knob value ... }'.  Each configuration starts from the values given "
+    "on the command line and overrides the listed knobs, which use the same names as "
+    "the corresponding options: TLB_L1I_entries, TLB_L1I_assoc, TLB_L1D_entries, "
+    "TLB_L1D_assoc, TLB_L2_entries, TLB_L2_assoc, TLB_page_sizes, L1I_size, L1I_assoc, "
+    "L1D_size, L1D_assoc, L2_size, L2_assoc, LL_size, LL_assoc, mmu_to_l2, "
+    "pwc_asplos_config, replace_policy, L1I_replace, L1D_replace, L2_replace, "
+    "LL_replace, TLB_replace_policy, TLB_L1I_replace, TLB_L1D_replace, "
+    "TLB_L2_replace, the -PWC_* and -CWC_* entries, assoc and replace knobs, "
+    "ECPT_4K_ways, ECPT_2M_ways, ECPT_1G_ways, CWT_2M_ways, CWT_1G_ways and the "
+    "-pt_* page-table-aware cache knobs, data_prefetcher, prefetch_degree, "
+    "tlb_prefetcher, coherence, pte_write_shootdown, timing_model, timing_params, "
+    "issue_window, page_walkers, contention_L1, contention_LLC, interference, "
+    "interference_trace, interference_working_set, interference_stride, "
+    "interference_seed, synthetic_page_tables, synthetic_page_size and "
+    "translation_scheme. "
+    "One independent cache simulator is created per configuration and all of them are "
+    "fed from a single read of the trace, so the trace is decoded only once.  Each "
+    "configuration prints its own results block headed by its name.  "
+    "Lines starting with // are comments.");
+
 // XXX: if we separate histogram + reuse_distance we should move this with them.
 droption_t<unsigned int>
     op_report_top(DROPTION_SCOPE_FRONTEND, "report_top", 10,
@@ -39,8 +39,20 @@
 #define REPLACE_POLICY_LRU "LRU"
 #define REPLACE_POLICY_LFU "LFU"
 #define REPLACE_POLICY_FIFO "FIFO"
+#define REPLACE_POLICY_SRRIP "SRRIP"
+#define REPLACE_POLICY_BRRIP "BRRIP"
+#define REPLACE_POLICY_DRRIP "DRRIP"
+#define REPLACE_POLICY_SHIP "SHiP"
+#define REPLACE_POLICY_HAWKEYE "Hawkeye"
 #define PREFETCH_POLICY_NEXTLINE "nextline"
+#define PREFETCH_POLICY_STRIDE "stride"
+#define PREFETCH_POLICY_STREAM "stream"
+#define PREFETCH_POLICY_SPATIAL "spatial"
 #define PREFETCH_POLICY_NONE "none"
+#define TLB_PREFETCH_POLICY_SEQUENTIAL "sequential"
+#define PT_CACHE_POLICY_SHARE "share"
+#define PT_CACHE_POLICY_PARTITION "partition"
+#define PT_CACHE_POLICY_PRIORITY "priority"
 #define CPU_CACHE "cache"
 #define MISS_ANALYZER "miss_analyzer"
 #define TLB "TLB"
@@ -68,7 +80,37 @@ extern droption_t<std::string> op_trans_arch;
 extern droption_t<bool> op_ecpt_early_return;
 extern droption_t<bool> op_ecpt_cache_correct_only;
 extern droption_t<bool> op_mmu_to_l2;
+extern droption_t<std::string> op_pt_cache_policy;
+extern droption_t<std::string> op_pt_policy_caches;
+extern droption_t<unsigned int> op_pt_partition_ways;
+extern droption_t<unsigned int> op_pt_priority_levels;
+extern droption_t<bool> op_pt_bypass_l1;
+extern droption_t<bool> op_coherence;
+extern droption_t<bool> op_pte_write_shootdown;
 extern droption_t<bool> op_pwc_asplos_config;
+extern droption_t<unsigned int> op_PWC_PGD_entries;
+extern droption_t<unsigned int> op_PWC_PGD_assoc;
+extern droption_t<std::string> op_PWC_PGD_replace;
+extern droption_t<unsigned int> op_PWC_PUD_entries;
+extern droption_t<unsigned int> op_PWC_PUD_assoc;
+extern droption_t<std::string> op_PWC_PUD_replace;
+extern droption_t<unsigned int> op_PWC_PMD_entries;
+extern droption_t<unsigned int> op_PWC_PMD_assoc;
+extern droption_t<std::string> op_PWC_PMD_replace;
+extern droption_t<unsigned int> op_CWC_PUD_entries;
+extern droption_t<unsigned int> op_CWC_PUD_assoc;
+extern droption_t<std::string> op_CWC_PUD_replace;
+extern droption_t<unsigned int> op_CWC_PMD_entries;
+extern droption_t<unsigned int> op_CWC_PMD_assoc;
+extern droption_t<std::string> op_CWC_PMD_replace;
+extern droption_t<unsigned int> op_ECPT_4K_ways;
+extern droption_t<unsigned int> op_ECPT_2M_ways;
+extern droption_t<unsigned int> op_ECPT_1G_ways;
+extern droption_t<unsigned int> op_CWT_2M_ways;
+extern droption_t<unsigned int> op_CWT_1G_ways;
+extern droption_t<bool> op_synthetic_page_tables;
+extern droption_t<std::string> op_synthetic_page_size;
+extern droption_t<std::string> op_translation_scheme;
 extern droption_t<int> op_max_ref;
 extern droption_t<int64_t> op_max_inst;
 extern droption_t<std::string> op_module_file;
@@ -82,6 +124,11 @@ extern droption_t<unsigned int> op_L2_assoc;
 extern droption_t<unsigned int> op_num_ranges;
 extern droption_t<unsigned int> op_contention_L1;
 extern droption_t<unsigned int> op_contention_LLC;
+extern droption_t<std::string> op_interference;
+extern droption_t<std::string> op_interference_trace;
+extern droption_t<bytesize_t> op_interference_working_set;
+extern droption_t<unsigned int> op_interference_stride;
+extern droption_t<unsigned int> op_interference_seed;
 extern droption_t<bytesize_t> op_LL_size;
 extern droption_t<bytesize_t> op_L2_size;
 extern droption_t<unsigned int> op_LL_assoc;
@@ -94,12 +141,22 @@ extern droption_t<bytesize_t> op_L0D_size;
 extern droption_t<bool> op_use_physical;
 extern droption_t<unsigned int> op_virt2phys_freq;
 extern droption_t<bool> op_cpu_scheduling;
+extern droption_t<bool> op_core_from_access_cpu;
+extern droption_t<unsigned int> op_sim_threads;
+extern droption_t<bytesize_t> op_epoch_refs;
 extern droption_t<bytesize_t> op_max_trace_size;
 extern droption_t<bytesize_t> op_trace_after_instrs;
 extern droption_t<bytesize_t> op_exit_after_tracing;
 extern droption_t<bool> op_online_instr_types;
 extern droption_t<std::string> op_replace_policy;
+extern droption_t<std::string> op_L1I_replace;
+extern droption_t<std::string> op_L1D_replace;
+extern droption_t<std::string> op_L2_replace;
+extern droption_t<std::string> op_LL_replace;
 extern droption_t<std::string> op_data_prefetcher;
+extern droption_t<unsigned int> op_prefetch_degree;
+extern droption_t<bytesize_t> op_prefetch_late_refs;
+extern droption_t<std::string> op_tlb_prefetcher;
 extern droption_t<bytesize_t> op_page_size;
 extern droption_t<unsigned int> op_TLB_L1I_entries;
 extern droption_t<unsigned int> op_TLB_L1D_entries;
@@ -107,7 +164,23 @@ extern droption_t<unsigned int> op_TLB_L1I_assoc;
 extern droption_t<unsigned int> op_TLB_L1D_assoc;
 extern droption_t<unsigned int> op_TLB_L2_entries;
 extern droption_t<unsigned int> op_TLB_L2_assoc;
+extern droption_t<bool> op_TLB_page_sizes;
+extern droption_t<unsigned int> op_TLB_L1I_2M_entries;
+extern droption_t<unsigned int> op_TLB_L1I_2M_assoc;
+extern droption_t<unsigned int> op_TLB_L1I_1G_entries;
+extern droption_t<unsigned int> op_TLB_L1I_1G_assoc;
+extern droption_t<unsigned int> op_TLB_L1D_2M_entries;
+extern droption_t<unsigned int> op_TLB_L1D_2M_assoc;
+extern droption_t<unsigned int> op_TLB_L1D_1G_entries;
+extern droption_t<unsigned int> op_TLB_L1D_1G_assoc;
+extern droption_t<unsigned int> op_TLB_L2_2M_entries;
+extern droption_t<unsigned int> op_TLB_L2_2M_assoc;
+extern droption_t<unsigned int> op_TLB_L2_1G_entries;
+extern droption_t<unsigned int> op_TLB_L2_1G_assoc;
 extern droption_t<std::string> op_TLB_replace_policy;
+extern droption_t<std::string> op_TLB_L1I_replace;
+extern droption_t<std::string> op_TLB_L1D_replace;
+extern droption_t<std::string> op_TLB_L2_replace;
 extern droption_t<std::string> op_simulator_type;
 extern droption_t<unsigned int> op_verbose;
 #ifdef DEBUG
@@ -121,8 +194,36 @@ extern droption_t<std::string> op_tracer_ops;
 extern droption_t<bytesize_t> op_skip_refs;
 extern droption_t<bytesize_t> op_warmup_refs;
 extern droption_t<double> op_warmup_fraction;
+extern droption_t<bool> op_warmup_functional;
 extern droption_t<bytesize_t> op_sim_refs;
+extern droption_t<bytesize_t> op_interval_refs;
+extern droption_t<bytesize_t> op_interval_instrs;
+extern droption_t<std::string> op_interval_file;
+extern droption_t<bool> op_latency_model;
+extern droption_t<std::string> op_walk_latencies;
+extern droption_t<bool> op_ecpt_parallel_cwc;
+extern droption_t<bool> op_cwt_backfill_overlap;
+extern droption_t<bool> op_timing_model;
+extern droption_t<std::string> op_timing_params;
+extern droption_t<unsigned int> op_issue_window;
+extern droption_t<unsigned int> op_page_walkers;
+extern droption_t<bool> op_miss_ratio_curves;
+extern droption_t<unsigned int> op_mrc_max_entries;
+extern droption_t<std::string> op_mrc_assocs;
+extern droption_t<unsigned int> op_mrc_sample_sets;
+extern droption_t<std::string> op_checkpoint_out;
+extern droption_t<std::string> op_checkpoint_in;
+extern droption_t<bytesize_t> op_sample_period;
+extern droption_t<bytesize_t> op_sample_window;
+extern droption_t<bytesize_t> op_sample_warmup;
+extern droption_t<bytesize_t> op_sample_skip;
+extern droption_t<double> op_sample_error;
+extern droption_t<double> op_sample_confidence;
 extern droption_t<std::string> op_config_file;
+extern droption_t<std::string> op_sweep_file;
+extern droption_t<bool> op_pipeline;
+extern droption_t<unsigned int> op_pipeline_batch;
+extern droption_t<unsigned int> op_pipeline_ring;
 extern droption_t<unsigned int> op_report_top;
 extern droption_t<unsigned int> op_reuse_distance_threshold;
 extern droption_t<bool> op_reuse_distance_histogram;
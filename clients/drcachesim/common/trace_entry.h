@@ -302,6 +302,8 @@ struct _memref_pgtable_results {
     uint32_t num_steps;
     int success;
     bool is_non_memory;
+    /* the CPU that issued the access (QEMU's access_cpu) */
+    uint16_t cpu;
     /* add a type field to disingtuish radix from ECPT */
     void print() const;
 };
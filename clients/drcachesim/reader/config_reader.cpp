@@ -56,6 +56,11 @@ config_reader_t::configure(const std::string &config_file, cache_simulator_knobs
         return false;
     }
 
+    std::map<std::string, unsigned int *> count_knobs;
+    std::map<std::string, unsigned int *> way_knobs;
+    std::map<std::string, std::string *> policy_knobs;
+    get_walk_cache_knobs(knobs, count_knobs, way_knobs, policy_knobs);
+
     // Walk through the configuration file.
     while (!fin.eof()) {
         std::string param;
@@ -143,6 +148,20 @@ config_reader_t::configure(const std::string &config_file, cache_simulator_knobs
                 ERRMSG("Error reading verbose from the configuration file\n");
                 return false;
             }
+        } else if (count_knobs.find(param) != count_knobs.end()) {
+            // Page walk or cuckoo walk cache geometry.
+            if (!read_count_knob(param, count_knobs[param], "the configuration file"))
+                return false;
+        } else if (way_knobs.find(param) != way_knobs.end()) {
+            // ECPT or CWT ways per page size.
+            if (!read_way_knob(param, way_knobs[param], "the configuration file"))
+                return false;
+        } else if (policy_knobs.find(param) != policy_knobs.end()) {
+            // Page walk or cuckoo walk cache replacement policy.
+            if (!(fin >> *policy_knobs[param])) {
+                ERRMSG("Error reading %s from the configuration file\n", param.c_str());
+                return false;
+            }
         } else {
             // A cache unit.
             cache_params_t cache;
@@ -266,7 +285,9 @@ config_reader_t::configure_cache(cache_params_t &cache)
             }
         } else if (param == "replace_policy") {
             // Cache replacement policy: REPLACE_POLICY_LRU (default),
-            // REPLACE_POLICY_LFU or REPLACE_POLICY_FIFO.
+            // REPLACE_POLICY_LFU, REPLACE_POLICY_FIFO, one of the RRIP family
+            // REPLACE_POLICY_SRRIP, REPLACE_POLICY_BRRIP or REPLACE_POLICY_DRRIP,
+            // REPLACE_POLICY_SHIP or REPLACE_POLICY_HAWKEYE.
             if (!(fin >> cache.replace_policy)) {
                 ERRMSG("Error reading cache replace_policy from "
                        "the configuration file\n");
@@ -275,19 +296,28 @@ config_reader_t::configure_cache(cache_params_t &cache)
             if (cache.replace_policy != REPLACE_POLICY_NON_SPECIFIED &&
                 cache.replace_policy != REPLACE_POLICY_LRU &&
                 cache.replace_policy != REPLACE_POLICY_LFU &&
-                cache.replace_policy != REPLACE_POLICY_FIFO) {
+                cache.replace_policy != REPLACE_POLICY_FIFO &&
+                cache.replace_policy != REPLACE_POLICY_SRRIP &&
+                cache.replace_policy != REPLACE_POLICY_BRRIP &&
+                cache.replace_policy != REPLACE_POLICY_DRRIP &&
+                cache.replace_policy != REPLACE_POLICY_SHIP &&
+                cache.replace_policy != REPLACE_POLICY_HAWKEYE) {
                 ERRMSG("Unknown replacement policy: %s\n", cache.replace_policy.c_str());
                 return false;
             }
         } else if (param == "prefetcher") {
-            // Type of prefetcher: PREFETCH_POLICY_NEXTLINE
-            // or PREFETCH_POLICY_NONE.
+            // Type of prefetcher: PREFETCH_POLICY_NEXTLINE,
+            // PREFETCH_POLICY_STRIDE, PREFETCH_POLICY_STREAM,
+            // PREFETCH_POLICY_SPATIAL or PREFETCH_POLICY_NONE.
             if (!(fin >> cache.prefetcher)) {
                 ERRMSG("Error reading cache prefetcher from "
                        "the configuration file\n");
                 return false;
             }
             if (cache.prefetcher != PREFETCH_POLICY_NEXTLINE &&
+                cache.prefetcher != PREFETCH_POLICY_STRIDE &&
+                cache.prefetcher != PREFETCH_POLICY_STREAM &&
+                cache.prefetcher != PREFETCH_POLICY_SPATIAL &&
                 cache.prefetcher != PREFETCH_POLICY_NONE) {
                 ERRMSG("Unknown prefetcher type: %s\n", cache.prefetcher.c_str());
                 return false;
@@ -396,6 +426,268 @@ config_reader_t::check_cache_config(int num_cores,
     return true;
 }
 
+bool
+config_reader_t::configure_sweep(const std::string &sweep_file,
+                                 const cache_simulator_knobs_t &base_knobs,
+                                 const tlb_simulator_knobs_t &base_tlb_knobs,
+                                 std::vector<sweep_config_t> &configs)
+{
+    fin.open(sweep_file);
+    if (!fin.is_open()) {
+        ERRMSG("Failed to open the sweep file '%s'\n", sweep_file.c_str());
+        return false;
+    }
+
+    while (!fin.eof()) {
+        std::string param;
+        if (!(fin >> ws >> param)) {
+            ERRMSG("Unable to read from the sweep file\n");
+            return false;
+        }
+
+        if (param == "//") {
+            // A comment.
+            if (!getline(fin, param)) {
+                ERRMSG("Comment expected but not found\n");
+                return false;
+            }
+        } else {
+            // A configuration block.
+            sweep_config_t config;
+            config.name = param;
+            config.knobs = base_knobs;
+            config.tlb_knobs = base_tlb_knobs;
+            for (const auto &existing : configs) {
+                if (existing.name == config.name) {
+                    ERRMSG("Duplicate sweep configuration name '%s'\n",
+                           config.name.c_str());
+                    return false;
+                }
+            }
+            if (!configure_sweep_point(config))
+                return false;
+            config.knobs.config_name = config.name;
+            configs.push_back(config);
+        }
+
+        if (!(fin >> ws)) {
+            ERRMSG("Unable to read from the sweep file\n");
+            return false;
+        }
+    }
+
+    if (configs.empty()) {
+        ERRMSG("The sweep file '%s' lists no configurations\n", sweep_file.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool
+config_reader_t::configure_sweep_point(sweep_config_t &config)
+{
+    // The knobs a sweep may vary, keyed by their command-line option names.
+    std::map<std::string, unsigned int *> count_knobs = {
+        { "TLB_L1I_entries", &config.tlb_knobs.TLB_L1I_entries },
+        { "TLB_L1I_assoc", &config.tlb_knobs.TLB_L1I_assoc },
+        { "TLB_L1D_entries", &config.tlb_knobs.TLB_L1D_entries },
+        { "TLB_L1D_assoc", &config.tlb_knobs.TLB_L1D_assoc },
+        { "TLB_L2_entries", &config.tlb_knobs.TLB_L2_entries },
+        { "TLB_L2_assoc", &config.tlb_knobs.TLB_L2_assoc },
+        { "L1I_assoc", &config.knobs.L1I_assoc },
+        { "L1D_assoc", &config.knobs.L1D_assoc },
+        { "L2_assoc", &config.knobs.L2_assoc },
+        { "LL_assoc", &config.knobs.LL_assoc },
+    };
+    std::map<std::string, unsigned int *> way_knobs = {
+        { "pt_partition_ways", &config.knobs.pt_partition_ways },
+        { "pt_priority_levels", &config.knobs.pt_priority_levels },
+        { "prefetch_degree", &config.knobs.prefetch_degree },
+        { "issue_window", &config.knobs.issue_window },
+        { "page_walkers", &config.knobs.page_walkers },
+        { "contention_L1", &config.knobs.contention_L1 },
+        { "contention_LLC", &config.knobs.contention_LLC },
+        { "interference_stride", &config.knobs.interference_stride },
+        { "interference_seed", &config.knobs.interference_seed },
+    };
+    std::map<std::string, std::string *> policy_knobs = {
+        { "replace_policy", &config.knobs.replace_policy },
+        { "L1I_replace", &config.knobs.L1I_replace },
+        { "L1D_replace", &config.knobs.L1D_replace },
+        { "L2_replace", &config.knobs.L2_replace },
+        { "LL_replace", &config.knobs.LL_replace },
+        { "TLB_replace_policy", &config.tlb_knobs.TLB_replace_policy },
+        { "TLB_L1I_replace", &config.tlb_knobs.TLB_L1I_replace },
+        { "TLB_L1D_replace", &config.tlb_knobs.TLB_L1D_replace },
+        { "TLB_L2_replace", &config.tlb_knobs.TLB_L2_replace },
+        { "pt_cache_policy", &config.knobs.pt_cache_policy },
+        { "data_prefetcher", &config.knobs.data_prefetcher },
+        { "tlb_prefetcher", &config.knobs.tlb_prefetcher },
+        { "pt_policy_caches", &config.knobs.pt_policy_caches },
+        { "timing_params", &config.knobs.timing_params },
+        { "interference", &config.knobs.interference_source },
+        { "interference_trace", &config.knobs.interference_trace },
+        { "synthetic_page_size", &config.knobs.synthetic_page_size },
+        { "translation_scheme", &config.knobs.translation_scheme },
+    };
+    get_walk_cache_knobs(config.knobs, count_knobs, way_knobs, policy_knobs);
+    std::map<std::string, uint64_t *> size_knobs = {
+        { "L1I_size", &config.knobs.L1I_size },
+        { "L1D_size", &config.knobs.L1D_size },
+        { "L2_size", &config.knobs.L2_size },
+        { "LL_size", &config.knobs.LL_size },
+        { "interference_working_set", &config.knobs.interference_working_set },
+    };
+    std::map<std::string, bool *> bool_knobs = {
+        { "mmu_to_l2", &config.knobs.mmu_to_l2 },
+        { "pt_bypass_l1", &config.knobs.pt_bypass_l1 },
+        { "coherence", &config.knobs.coherence },
+        { "pte_write_shootdown", &config.knobs.pte_write_shootdown },
+        { "timing_model", &config.knobs.timing_model },
+        { "pwc_asplos_config", &config.knobs.pwc_asplos_config },
+        { "TLB_page_sizes", &config.tlb_knobs.TLB_page_sizes },
+        { "synthetic_page_tables", &config.knobs.synthetic_page_tables },
+    };
+
+    char c;
+    if (!(fin >> ws >> c)) {
+        ERRMSG("Unable to read from the sweep file\n");
+        return false;
+    }
+    if (c != '{') {
+        ERRMSG("Expected '{' before the params of configuration %s\n",
+               config.name.c_str());
+        return false;
+    }
+
+    while (!fin.eof()) {
+        std::string param;
+        if (!(fin >> ws >> param)) {
+            ERRMSG("Unable to read from the sweep file\n");
+            return false;
+        }
+
+        if (param == "}") {
+            return true;
+        } else if (param == "//") {
+            // A comment.
+            if (!getline(fin, param)) {
+                ERRMSG("Comment expected but not found\n");
+                return false;
+            }
+        } else if (count_knobs.find(param) != count_knobs.end()) {
+            if (!read_count_knob(param, count_knobs[param],
+                                 "configuration " + config.name))
+                return false;
+        } else if (way_knobs.find(param) != way_knobs.end()) {
+            if (!read_way_knob(param, way_knobs[param], "configuration " + config.name))
+                return false;
+        } else if (policy_knobs.find(param) != policy_knobs.end()) {
+            if (!(fin >> *policy_knobs[param])) {
+                ERRMSG("Error reading %s of configuration %s\n", param.c_str(),
+                       config.name.c_str());
+                return false;
+            }
+        } else if (size_knobs.find(param) != size_knobs.end()) {
+            std::string size_str;
+            if (!(fin >> size_str)) {
+                ERRMSG("Error reading %s of configuration %s\n", param.c_str(),
+                       config.name.c_str());
+                return false;
+            }
+            uint64_t *value = size_knobs[param];
+            if (!convert_string_to_size(size_str, *value) || *value == 0 ||
+                !IS_POWER_OF_2(*value)) {
+                ERRMSG("%s (%s) of configuration %s must be >0 and a power of 2\n",
+                       param.c_str(), size_str.c_str(), config.name.c_str());
+                return false;
+            }
+        } else if (bool_knobs.find(param) != bool_knobs.end()) {
+            std::string bool_val;
+            if (!(fin >> bool_val)) {
+                ERRMSG("Error reading %s of configuration %s\n", param.c_str(),
+                       config.name.c_str());
+                return false;
+            }
+            *bool_knobs[param] = is_true(bool_val);
+        } else {
+            ERRMSG("Unknown sweep setting '%s' in configuration %s\n", param.c_str(),
+                   config.name.c_str());
+            return false;
+        }
+
+        if (!(fin >> ws)) {
+            ERRMSG("Unable to read from the sweep file\n");
+            return false;
+        }
+    }
+
+    ERRMSG("Expected '}' at the end of configuration %s\n", config.name.c_str());
+    return false;
+}
+
+void
+config_reader_t::get_walk_cache_knobs(cache_simulator_knobs_t &knobs,
+                                      std::map<std::string, unsigned int *> &count_knobs,
+                                      std::map<std::string, unsigned int *> &way_knobs,
+                                      std::map<std::string, std::string *> &policy_knobs)
+{
+    count_knobs["PWC_PGD_entries"] = &knobs.PWC_PGD_entries;
+    count_knobs["PWC_PGD_assoc"] = &knobs.PWC_PGD_assoc;
+    count_knobs["PWC_PUD_entries"] = &knobs.PWC_PUD_entries;
+    count_knobs["PWC_PUD_assoc"] = &knobs.PWC_PUD_assoc;
+    count_knobs["PWC_PMD_entries"] = &knobs.PWC_PMD_entries;
+    count_knobs["PWC_PMD_assoc"] = &knobs.PWC_PMD_assoc;
+    count_knobs["CWC_PUD_entries"] = &knobs.CWC_PUD_entries;
+    count_knobs["CWC_PUD_assoc"] = &knobs.CWC_PUD_assoc;
+    count_knobs["CWC_PMD_entries"] = &knobs.CWC_PMD_entries;
+    count_knobs["CWC_PMD_assoc"] = &knobs.CWC_PMD_assoc;
+    way_knobs["ECPT_4K_ways"] = &knobs.ECPT_4K_ways;
+    way_knobs["ECPT_2M_ways"] = &knobs.ECPT_2M_ways;
+    way_knobs["ECPT_1G_ways"] = &knobs.ECPT_1G_ways;
+    way_knobs["CWT_2M_ways"] = &knobs.CWT_2M_ways;
+    way_knobs["CWT_1G_ways"] = &knobs.CWT_1G_ways;
+    policy_knobs["PWC_PGD_replace"] = &knobs.PWC_PGD_replace;
+    policy_knobs["PWC_PUD_replace"] = &knobs.PWC_PUD_replace;
+    policy_knobs["PWC_PMD_replace"] = &knobs.PWC_PMD_replace;
+    policy_knobs["CWC_PUD_replace"] = &knobs.CWC_PUD_replace;
+    policy_knobs["CWC_PMD_replace"] = &knobs.CWC_PMD_replace;
+}
+
+bool
+config_reader_t::read_count_knob(const std::string &param, unsigned int *value,
+                                 const std::string &where)
+{
+    if (!(fin >> *value)) {
+        ERRMSG("Error reading %s of %s\n", param.c_str(), where.c_str());
+        return false;
+    }
+    if (*value == 0 || !IS_POWER_OF_2(*value)) {
+        ERRMSG("%s (%u) of %s must be >0 and a power of 2\n", param.c_str(), *value,
+               where.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool
+config_reader_t::read_way_knob(const std::string &param, unsigned int *value,
+                               const std::string &where)
+{
+    // Way counts need not be powers of 2: the trace's ECPT has 3 4KB ways.
+    int ways;
+    if (!(fin >> ways)) {
+        ERRMSG("Error reading %s of %s\n", param.c_str(), where.c_str());
+        return false;
+    }
+    if (ways < 0) {
+        ERRMSG("%s (%d) of %s must be >=0\n", param.c_str(), ways, where.c_str());
+        return false;
+    }
+    *value = (unsigned int)ways;
+    return true;
+}
+
 // XXX: This function is a duplicate of
 //      droption_t<bytesize_t>::convert_from_string
 //      Consider sharing the function using a single copy.
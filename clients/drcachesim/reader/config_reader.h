@@ -40,10 +40,12 @@
 #include <fstream>
 #include <map>
 #include <string>
+#include <vector>
 
 #include "../common/options.h"
 #include "../simulator/cache.h"
 #include "../simulator/cache_simulator_create.h"
+#include "../simulator/tlb_simulator_create.h"
 
 using namespace std;
 
@@ -90,6 +92,15 @@ struct cache_params_t {
     std::string miss_file;
 };
 
+// One point of a configuration sweep: a full set of knobs for an
+// independent cache simulator instance.
+struct sweep_config_t {
+    // Configuration's name. Each configuration must have a unique name.
+    std::string name;
+    cache_simulator_knobs_t knobs;
+    tlb_simulator_knobs_t tlb_knobs;
+};
+
 class config_reader_t {
 public:
     config_reader_t();
@@ -97,6 +108,13 @@ public:
     bool
     configure(const std::string &config_file, cache_simulator_knobs_t &knobs,
               std::map<std::string, cache_params_t> &caches);
+    // Reads a sweep file.  Every configuration listed in it starts from
+    // the base knobs and overrides the knobs named in its block.
+    bool
+    configure_sweep(const std::string &sweep_file,
+                    const cache_simulator_knobs_t &base_knobs,
+                    const tlb_simulator_knobs_t &base_tlb_knobs,
+                    std::vector<sweep_config_t> &configs);
 
 private:
     std::ifstream fin;
@@ -104,6 +122,24 @@ private:
     bool
     configure_cache(cache_params_t &cache);
     bool
+    configure_sweep_point(sweep_config_t &config);
+    // Maps the names of the page walk cache, cuckoo walk cache and ECPT way
+    // knobs, accepted both in a configuration file and in a sweep file, to
+    // their fields in knobs.
+    void
+    get_walk_cache_knobs(cache_simulator_knobs_t &knobs,
+                         std::map<std::string, unsigned int *> &count_knobs,
+                         std::map<std::string, unsigned int *> &way_knobs,
+                         std::map<std::string, std::string *> &policy_knobs);
+    // Read the value of a knob; where names the file or configuration it
+    // belongs to in error messages.
+    bool
+    read_count_knob(const std::string &param, unsigned int *value,
+                    const std::string &where);
+    bool
+    read_way_knob(const std::string &param, unsigned int *value,
+                  const std::string &where);
+    bool
     check_cache_config(int num_cores, std::map<std::string, cache_params_t> &caches_map);
     bool
     convert_string_to_size(const std::string &s, uint64_t &size);
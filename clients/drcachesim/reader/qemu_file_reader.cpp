@@ -32,42 +32,121 @@
 
 #include <assert.h>
 #include <cstdint>
-#include <fstream>
 #include <iostream>
+#include <string.h>
 #include <string>
 #include "qemu_file_reader.h"
+#include "qemu_trace_format.h"
 #include "../common/memref.h"
 #include "../common/utils.h"
 
+#ifdef UNIX
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
 #ifdef VERBOSE
 #    include <iostream>
 #endif
 
+// Records read per refill in buffered mode.
+#define QEMU_BUFFER_RECORDS (1 << 16)
+// Distance kept prefetched ahead of the current record in mapped mode.
+#define QEMU_READAHEAD_WINDOW (64ULL << 20)
+
 qemu_file_reader_t::qemu_file_reader_t()
+    : file(NULL)
+    , record_size(0)
+    , container(NULL)
+    , map_base(NULL)
+    , map_size(0)
+    , map_offset(0)
+    , map_advised(0)
+    , map_dropped(0)
+    , buffer_pos(0)
+    , buffer_end(0)
+    , n_ref(0)
+    , n_inst(0)
 {
-    /* Empty. */
+    memset(&entry_copy, 0, sizeof(entry_copy));
 }
 
 qemu_file_reader_t::qemu_file_reader_t(const char *file_name, int verbosity, trans_arch a,
                                        int max_ref, int64_t max_inst)
-    : fstream(file_name, std::ifstream::binary)
+    : file(fopen(file_name, "rb"))
+    , record_size(a == RADIX ? sizeof(radix_trans_info) : sizeof(ecpt_trans_info))
+    , container(NULL)
+    , map_base(NULL)
+    , map_size(0)
+    , map_offset(0)
+    , map_advised(0)
+    , map_dropped(0)
+    , buffer_pos(0)
+    , buffer_end(0)
     , verbose(verbosity)
     , arch(a)
     , max_ref(max_ref)
     , max_inst(max_inst)
+    , n_ref(0)
+    , n_inst(0)
 {
     std::cout << "creating qemu_file_reader_t for " << file_name 
                 << " with verbosity " << verbosity 
                 << " and arch " << a 
                 << " and max_ref " << max_ref
                 << " and max_inst " << max_inst << std::endl;
+    // The parsers only fill in the fields of their format (e.g., a radix walk
+    // leaves the ECPT auxiliaries alone), so start from a clean entry.
+    memset(&entry_copy, 0, sizeof(entry_copy));
+    if (file == NULL)
+        return;
+    if (open_container())
+        return;
+    if (!map_file())
+        buffer.resize(QEMU_BUFFER_RECORDS * record_size);
+}
+
+// Switches to container mode if the input is a container.  Returns whether it
+// is one; on a bad container the file is closed so that init() fails.
+bool
+qemu_file_reader_t::open_container()
+{
+#ifdef HAS_ZLIB
+    if (!qemu_trace_is_container(file))
+        return false;
+    container = new qemu_trace_container_t(file, arch);
+    std::string error;
+    if (!container->open(error)) {
+        ERRMSG("Failed to open QEMU trace container: %s\n", error.c_str());
+        delete container;
+        container = NULL;
+        fclose(file);
+        file = NULL;
+    }
+    return true;
+#else
+    long start = ftell(file);
+    char magic[QEMU_TRACE_MAGIC_SIZE];
+    bool match = start >= 0 && fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+        memcmp(magic, QEMU_TRACE_MAGIC, sizeof(magic)) == 0;
+    clearerr(file);
+    if (start >= 0)
+        fseek(file, start, SEEK_SET);
+    if (!match)
+        return false;
+    ERRMSG("QEMU trace containers require zlib support\n");
+    fclose(file);
+    file = NULL;
+    return true;
+#endif
 }
 
 bool
 qemu_file_reader_t::init()
 {
     at_eof = false;
-    if (!fstream)
+    if (file == NULL)
         return false;
     // trace_entry_t *first_entry = read_next_entry();
     // if (first_entry == NULL)
@@ -83,11 +162,144 @@ qemu_file_reader_t::init()
 
 qemu_file_reader_t::~qemu_file_reader_t()
 {
-    fstream.close();
+#ifdef HAS_ZLIB
+    delete container;
+#endif
+#ifdef UNIX
+    if (map_base != NULL)
+        munmap((void *)map_base, map_size);
+#endif
+    if (file != NULL)
+        fclose(file);
+}
+
+// Maps a regular trace file.  Returns false if the input cannot be mapped, in
+// which case the buffered mode is used.
+bool
+qemu_file_reader_t::map_file()
+{
+#ifdef UNIX
+    struct stat st;
+    if (fstat(fileno(file), &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0)
+        return false;
+    void *base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+    if (base == MAP_FAILED)
+        return false;
+    map_base = (const uint8_t *)base;
+    map_size = st.st_size;
+    madvise(base, map_size, MADV_SEQUENTIAL);
+    advise_readahead();
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Keeps the window ahead of the current record prefetched and drops the pages
+// we are done with, so that multi-GB traces do not pin their whole mapping.
+void
+qemu_file_reader_t::advise_readahead()
+{
+#ifdef UNIX
+    if (map_offset + QEMU_READAHEAD_WINDOW / 2 < map_advised)
+        return;
+    size_t page_mask = ~((size_t)sysconf(_SC_PAGESIZE) - 1);
+    size_t start = map_advised;
+    size_t end = map_offset + QEMU_READAHEAD_WINDOW;
+    if (end > map_size)
+        end = map_size;
+    if (end > start) {
+        size_t aligned_start = start & page_mask;
+        madvise((void *)(map_base + aligned_start), end - aligned_start, MADV_WILLNEED);
+        map_advised = end;
+    }
+    size_t done = map_offset & page_mask;
+    if (done > map_dropped + QEMU_READAHEAD_WINDOW) {
+        madvise((void *)(map_base + map_dropped), done - map_dropped, MADV_DONTNEED);
+        map_dropped = done;
+    }
+#endif
+}
+
+// Moves the unread tail of the buffer to its front and fills the rest.
+// Returns false on a read error.
+bool
+qemu_file_reader_t::refill_buffer()
+{
+    size_t left = buffer_end - buffer_pos;
+    memmove(buffer.data(), buffer.data() + buffer_pos, left);
+    buffer_pos = 0;
+    buffer_end = left;
+    while (buffer_end < buffer.size()) {
+        size_t got = fread(buffer.data() + buffer_end, 1, buffer.size() - buffer_end, file);
+        if (got == 0)
+            break;
+        buffer_end += got;
+    }
+    return !ferror(file);
+}
+
+// Returns the next whole record in place, or NULL at the end of the trace.
+// The header of the record after it, or 0 if there is none, is returned in
+// next_header.
+const uint8_t *
+qemu_file_reader_t::next_record(uint8_t *next_header)
+{
+    const uint8_t *record;
+#ifdef HAS_ZLIB
+    if (container != NULL)
+        return container->next_record(next_header);
+#endif
+    if (map_base != NULL) {
+        if (map_offset + record_size > map_size)
+            return NULL;
+        record = map_base + map_offset;
+        map_offset += record_size;
+        *next_header = map_offset + record_size <= map_size ? map_base[map_offset] : 0;
+        advise_readahead();
+        return record;
+    }
+    if (buffer_end - buffer_pos < 2 * record_size && !feof(file) && !refill_buffer())
+        return NULL;
+    if (buffer_end - buffer_pos < record_size)
+        return NULL;
+    record = buffer.data() + buffer_pos;
+    buffer_pos += record_size;
+    *next_header =
+        buffer_end - buffer_pos >= record_size ? buffer[buffer_pos] : 0;
+    return record;
+}
+
+bool
+qemu_file_reader_t::skip_records(uint64_t num_records)
+{
+    if (file == NULL)
+        return false;
+    // Skipped records still count against max_ref, which bounds the window
+    // from the start of the trace.
+    n_ref += num_records;
+#ifdef HAS_ZLIB
+    if (container != NULL)
+        return container->seek(num_records);
+#endif
+    if (map_base != NULL) {
+        uint64_t avail = (map_size - map_offset) / record_size;
+        map_offset += (num_records < avail ? num_records : avail) * record_size;
+        if (map_advised < map_offset)
+            map_advised = map_offset;
+        advise_readahead();
+        return true;
+    }
+    uint8_t next_header;
+    for (uint64_t i = 0; i < num_records; i++) {
+        if (next_record(&next_header) == NULL)
+            break;
+    }
+    return !ferror(file);
 }
 
 static void
-print_leaves_helper(uint64_t *leaves, int n)
+print_leaves_helper(const uint64_t *leaves, int n)
 {
     printf("[");
     for (int i = 0; i < n; i++) {
@@ -109,7 +321,7 @@ qemu_file_reader_t::print_entry_copy(trace_entry_t &entry)
 }
 
 void
-qemu_file_reader_t::print_radix_trans_info(radix_trans_info &record)
+qemu_file_reader_t::print_radix_trans_info(const radix_trans_info &record)
 {
     if (verbose >= 2) {
         if (record.header == BIN_RECORD_TYPE_MEM) {
@@ -135,7 +347,7 @@ qemu_file_reader_t::print_radix_trans_info(radix_trans_info &record)
 }
 
 void
-qemu_file_reader_t::print_ecpt_trans_info(ecpt_trans_info &record)
+qemu_file_reader_t::print_ecpt_trans_info(const ecpt_trans_info &record)
 {
     if (verbose >= 2) {
         if (record.header == BIN_RECORD_TYPE_MEM) {
@@ -184,7 +396,7 @@ get_entry_type(uint8_t header, uint8_t access_rw, trace_entry_t &entry)
 
 #define MIN(a, b) (((a) < (b)) ? (a) : (b))
 int
-qemu_file_reader_t::parse_qemu_line_radix(radix_trans_info &info)
+qemu_file_reader_t::parse_qemu_line_radix(const radix_trans_info &info)
 {
     print_radix_trans_info(info);
 
@@ -199,6 +411,7 @@ qemu_file_reader_t::parse_qemu_line_radix(radix_trans_info &info)
     entry_copy.phys_addr = info.paddr;
 
     entry_copy.pgtable_results.paddr = info.paddr;
+    entry_copy.pgtable_results.cpu = info.access_cpu;
     int i = 0;
     for (; i < MIN(MAX_MEMREF_STEPS, PAGE_TABLE_LEAVES); i++) {
         if (info.leaves[i] != 0) {
@@ -217,7 +430,7 @@ qemu_file_reader_t::parse_qemu_line_radix(radix_trans_info &info)
 }
 
 int
-qemu_file_reader_t::parse_qemu_line_ecpt(ecpt_trans_info &info)
+qemu_file_reader_t::parse_qemu_line_ecpt(const ecpt_trans_info &info)
 {
     print_ecpt_trans_info(info);
 
@@ -232,6 +445,7 @@ qemu_file_reader_t::parse_qemu_line_ecpt(ecpt_trans_info &info)
     entry_copy.phys_addr = info.paddr;
 
     entry_copy.pgtable_results.paddr = info.paddr;
+    entry_copy.pgtable_results.cpu = info.access_cpu;
     int i = 0;
 
     for (; i < ECPT_TABLE_LEAVES; i++) {
@@ -263,77 +477,58 @@ qemu_file_reader_t::set_entry_non_memory(uint8_t curr_header, uint8_t next_heade
         curr_header == BIN_RECORD_TYPE_FEC && next_header == BIN_RECORD_TYPE_FEC;
 }
 
-static int64_t n_ref = 0;
-static int64_t n_inst = 0;
 trace_entry_t *
 qemu_file_reader_t::read_next_entry()
 {
-    radix_trans_info radix_info = { 0 };
-    radix_trans_info radix_info_next = { 0 };
-    ecpt_trans_info ecpt_info = { 0 };
-    ecpt_trans_info ecpt_info_next = { 0 };
-
     if (max_ref != -1 && n_ref++ >= max_ref) {
         return NULL;
     }
 
-    if (fstream) {
-
-        if (arch == RADIX) {
-            fstream.read((char *)&radix_info, sizeof(radix_info));
-            if (fstream) {
-                std::streampos originalPos = fstream.tellg();
-                fstream.read((char *)&radix_info_next, sizeof(radix_info_next));
-                fstream.seekg(originalPos);
-            }
-
-            if (this->parse_qemu_line_radix(radix_info) < 0) {
-                return NULL;
-            }
-
-            this->set_entry_non_memory(radix_info.header, radix_info_next.header);
-        } else {
-            fstream.read((char *)&ecpt_info, sizeof(ecpt_info));
-
-            if (fstream) {
-                std::streampos originalPos = fstream.tellg();
-                fstream.read((char *)&ecpt_info_next, sizeof(ecpt_info_next));
-                fstream.seekg(originalPos);
-            }
-
-            if (this->parse_qemu_line_ecpt(ecpt_info) < 0) {
-                return NULL;
-            }
+    uint8_t next_header;
+    const uint8_t *record = next_record(&next_header);
+    if (record == NULL) {
+#ifdef HAS_ZLIB
+        // A chunk that cannot be read or decompressed is not the end of the
+        // trace, even though the container stops returning records.
+        if (container != NULL && container->failed())
+            ERRMSG("Failed to read a chunk of the QEMU trace container\n");
+#endif
+        return NULL;
+    }
 
-            this->set_entry_non_memory(ecpt_info.header, ecpt_info_next.header);
+    if (arch == RADIX) {
+        const radix_trans_info &radix_info = *(const radix_trans_info *)record;
+        if (this->parse_qemu_line_radix(radix_info) < 0) {
+            return NULL;
         }
 
-        if (entry_copy.type == TRACE_TYPE_INSTR) {
-            n_inst++;
-            if (max_inst != -1 && n_inst > max_inst) {
-                return NULL;
-            }
+        this->set_entry_non_memory(radix_info.header, next_header);
+    } else {
+        const ecpt_trans_info &ecpt_info = *(const ecpt_trans_info *)record;
+        if (this->parse_qemu_line_ecpt(ecpt_info) < 0) {
+            return NULL;
         }
 
-        return &entry_copy;
+        this->set_entry_non_memory(ecpt_info.header, next_header);
+    }
 
-    } else {
-        return NULL;
+    if (entry_copy.type == TRACE_TYPE_INSTR) {
+        n_inst++;
+        if (max_inst != -1 && n_inst > max_inst) {
+            return NULL;
+        }
     }
+
+    return &entry_copy;
 }
 
 bool
 qemu_file_reader_t::is_complete()
 {
-    if (!fstream)
+    // Only a mapped file can be checked without consuming it.
+    if (map_base == NULL || map_size < sizeof(trace_entry_t))
         return false;
-    bool res = false;
-    std::streampos pos = fstream.tellg();
-    fstream.seekg(-(int)sizeof(trace_entry_t), fstream.end);
-    // Avoid reaching eof b/c we can't seek away from it.
-    if (fstream.read((char *)&entry_copy.type, sizeof(entry_copy.type)) &&
-        entry_copy.type == TRACE_TYPE_FOOTER)
-        res = true;
-    fstream.seekg(pos);
-    return res;
+    const trace_entry_t *last =
+        (const trace_entry_t *)(map_base + map_size - sizeof(trace_entry_t));
+    return last->type == TRACE_TYPE_FOOTER;
 }
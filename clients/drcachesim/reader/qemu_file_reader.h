@@ -38,7 +38,8 @@
 #ifndef _QEMU_FILE_READER_H_
 #define _QEMU_FILE_READER_H_ 1
 
-#include <fstream>
+#include <stdio.h>
+#include <vector>
 #include "reader.h"
 #include "../common/memref.h"
 #include "../common/trace_entry.h"
@@ -98,6 +99,14 @@ enum trans_arch {
     ECPT
 };
 
+class qemu_trace_container_t;
+
+// Reads the fixed-size records written by QEMU.  Regular files are memory
+// mapped and walked in place; anything that cannot be mapped (e.g., a pipe)
+// is read through a large buffer.  Files in the compressed container format
+// (see qemu_trace_format.h) are decoded chunk by chunk.  In every case the
+// header of the record after the current one, needed by
+// set_entry_non_memory(), is available without any extra read.
 class qemu_file_reader_t : public reader_t {
 public:
     qemu_file_reader_t();
@@ -108,28 +117,55 @@ public:
     init();
     virtual bool
     is_complete();
+    // Moves past the first num_records records without parsing them.  Must be
+    // called before init().  Containers and mapped files seek directly.  The
+    // skipped records count towards max_ref.
+    bool
+    skip_records(uint64_t num_records);
 
 protected:
     virtual trace_entry_t *
     read_next_entry();
 
 private:
-    int parse_qemu_line_radix(radix_trans_info & info);
-    int parse_qemu_line_ecpt(ecpt_trans_info & info);
+    int parse_qemu_line_radix(const radix_trans_info & info);
+    int parse_qemu_line_ecpt(const ecpt_trans_info & info);
 
     void print_entry_copy(trace_entry_t & entry);
     
-    void print_radix_trans_info(radix_trans_info & info);
-    void print_ecpt_trans_info(ecpt_trans_info & info);
+    void print_radix_trans_info(const radix_trans_info & info);
+    void print_ecpt_trans_info(const ecpt_trans_info & info);
 
     void set_entry_non_memory(uint8_t curr_header, uint8_t next_header);
 
-    std::ifstream fstream;
+    bool open_container();
+    bool map_file();
+    void advise_readahead();
+    bool refill_buffer();
+    const uint8_t *next_record(uint8_t *next_header);
+
+    FILE *file;
+    size_t record_size;
+    // Container mode.
+    qemu_trace_container_t *container;
+    // Mapped mode.
+    const uint8_t *map_base;
+    size_t map_size;
+    size_t map_offset;
+    size_t map_advised; // End of the range already handed to readahead.
+    size_t map_dropped; // End of the range already released.
+    // Buffered mode.
+    std::vector<uint8_t> buffer;
+    size_t buffer_pos;
+    size_t buffer_end;
+
     trace_entry_t entry_copy;
     int verbose;
     trans_arch arch;
     int64_t max_ref;
     int64_t max_inst;
+    int64_t n_ref;
+    int64_t n_inst;
 };
 
 #endif /* _QEMU_FILE_READER_H_ */
@@ -0,0 +1,442 @@
+/* **********************************************************
+ * Copyright (c) 2016-2017 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+#include <algorithm>
+#include <string.h>
+#include <thread>
+#include <zlib.h>
+#include "qemu_trace_format.h"
+
+// Upper bound on the chunks being decompressed ahead of the reader.
+#define QEMU_TRACE_MAX_DECODE_DEPTH 8
+
+namespace {
+
+// Fields of the previous record of one CPU, which the next record of that
+// CPU is delta-encoded against.
+struct cpu_delta_state_t {
+    uint64_t vaddr;
+    uint64_t paddr;
+    uint64_t pte;
+    uint64_t leaves[ECPT_TABLE_LEAVES];
+    uint64_t cwt_leaves[ECPT_CWT_LEAVES];
+};
+
+class delta_encoder_t {
+public:
+    explicit delta_encoder_t(std::vector<uint8_t> &out_)
+        : out(out_)
+    {
+    }
+    void
+    put_byte(uint8_t val)
+    {
+        out.push_back(val);
+    }
+    void
+    put_varint(uint64_t val)
+    {
+        while (val >= 0x80) {
+            out.push_back((uint8_t)(val | 0x80));
+            val >>= 7;
+        }
+        out.push_back((uint8_t)val);
+    }
+    void
+    put_delta(uint64_t val, uint64_t &prev)
+    {
+        int64_t delta = (int64_t)(val - prev);
+        prev = val;
+        put_varint(((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+    }
+
+private:
+    std::vector<uint8_t> &out;
+};
+
+class delta_decoder_t {
+public:
+    delta_decoder_t(const uint8_t *in_, size_t size)
+        : in(in_)
+        , end(in_ + size)
+        , ok(true)
+    {
+    }
+    uint8_t
+    get_byte()
+    {
+        if (in >= end) {
+            ok = false;
+            return 0;
+        }
+        return *in++;
+    }
+    uint64_t
+    get_varint()
+    {
+        uint64_t val = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (in >= end) {
+                ok = false;
+                return 0;
+            }
+            uint8_t byte = *in++;
+            val |= (uint64_t)(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+                return val;
+        }
+        ok = false;
+        return 0;
+    }
+    uint64_t
+    get_delta(uint64_t &prev)
+    {
+        uint64_t zigzag = get_varint();
+        prev += (zigzag >> 1) ^ (~(zigzag & 1) + 1);
+        return prev;
+    }
+    bool
+    good() const
+    {
+        return ok && in == end;
+    }
+
+private:
+    const uint8_t *in;
+    const uint8_t *end;
+    bool ok;
+};
+
+cpu_delta_state_t &
+state_for_cpu(std::vector<cpu_delta_state_t> &states, uint16_t cpu)
+{
+    if (cpu >= states.size()) {
+        cpu_delta_state_t zero;
+        memset(&zero, 0, sizeof(zero));
+        states.resize(cpu + 1, zero);
+    }
+    return states[cpu];
+}
+
+template <typename T>
+void
+encode_common(delta_encoder_t &enc, const T &rec, cpu_delta_state_t &state)
+{
+    enc.put_byte(rec.header);
+    enc.put_byte(rec.access_rw);
+    enc.put_varint(rec.access_cpu);
+    enc.put_varint(rec.access_sz);
+    enc.put_delta(rec.vaddr, state.vaddr);
+    enc.put_delta(rec.paddr, state.paddr);
+    enc.put_delta(rec.pte, state.pte);
+}
+
+template <typename T>
+bool
+decode_common(delta_decoder_t &dec, T &rec, std::vector<cpu_delta_state_t> &states,
+              cpu_delta_state_t *&state)
+{
+    rec.header = dec.get_byte();
+    rec.access_rw = dec.get_byte();
+    uint64_t cpu = dec.get_varint();
+    if (cpu > UINT16_MAX)
+        return false;
+    rec.access_cpu = (uint16_t)cpu;
+    rec.access_sz = (uint32_t)dec.get_varint();
+    state = &state_for_cpu(states, rec.access_cpu);
+    rec.vaddr = dec.get_delta(state->vaddr);
+    rec.paddr = dec.get_delta(state->paddr);
+    rec.pte = dec.get_delta(state->pte);
+    return true;
+}
+
+} // namespace
+
+size_t
+qemu_trace_record_size(trans_arch arch)
+{
+    return arch == RADIX ? sizeof(radix_trans_info) : sizeof(ecpt_trans_info);
+}
+
+bool
+qemu_trace_compress_chunk(trans_arch arch, const uint8_t *records, size_t num_records,
+                          int level, std::vector<uint8_t> &out, uint32_t &encoded_size)
+{
+    std::vector<uint8_t> encoded;
+    encoded.reserve(num_records * 32);
+    delta_encoder_t enc(encoded);
+    std::vector<cpu_delta_state_t> states;
+    size_t record_size = qemu_trace_record_size(arch);
+    for (size_t i = 0; i < num_records; i++) {
+        const uint8_t *raw = records + i * record_size;
+        if (arch == RADIX) {
+            const radix_trans_info &rec = *(const radix_trans_info *)raw;
+            cpu_delta_state_t &state = state_for_cpu(states, rec.access_cpu);
+            encode_common(enc, rec, state);
+            for (int j = 0; j < PAGE_TABLE_LEAVES; j++)
+                enc.put_delta(rec.leaves[j], state.leaves[j]);
+        } else {
+            const ecpt_trans_info &rec = *(const ecpt_trans_info *)raw;
+            cpu_delta_state_t &state = state_for_cpu(states, rec.access_cpu);
+            encode_common(enc, rec, state);
+            for (int j = 0; j < ECPT_TABLE_LEAVES; j++)
+                enc.put_delta(rec.leaves[j], state.leaves[j]);
+            for (int j = 0; j < ECPT_CWT_LEAVES; j++)
+                enc.put_delta(rec.cwt_leaves[j], state.cwt_leaves[j]);
+            enc.put_varint(rec.selected_ecpt_way);
+            enc.put_byte(rec.pud_header);
+            enc.put_byte(rec.pmd_header);
+        }
+    }
+    encoded_size = (uint32_t)encoded.size();
+    uLongf compressed_size = compressBound(encoded.size());
+    out.resize(compressed_size);
+    if (compress2(out.data(), &compressed_size, encoded.data(), encoded.size(), level) !=
+        Z_OK)
+        return false;
+    out.resize(compressed_size);
+    return true;
+}
+
+bool
+qemu_trace_decompress_chunk(trans_arch arch, const qemu_trace_chunk_t &chunk,
+                            const uint8_t *compressed, uint8_t *records)
+{
+    std::vector<uint8_t> encoded(chunk.encoded_size);
+    uLongf encoded_size = chunk.encoded_size;
+    if (uncompress(encoded.data(), &encoded_size, compressed, chunk.compressed_size) !=
+            Z_OK ||
+        encoded_size != chunk.encoded_size)
+        return false;
+    delta_decoder_t dec(encoded.data(), encoded.size());
+    std::vector<cpu_delta_state_t> states;
+    size_t record_size = qemu_trace_record_size(arch);
+    // Padding bytes are not stored: clear them so decoded records are stable.
+    memset(records, 0, chunk.num_records * record_size);
+    for (uint32_t i = 0; i < chunk.num_records; i++) {
+        uint8_t *raw = records + i * record_size;
+        cpu_delta_state_t *state;
+        if (arch == RADIX) {
+            radix_trans_info &rec = *(radix_trans_info *)raw;
+            if (!decode_common(dec, rec, states, state))
+                return false;
+            for (int j = 0; j < PAGE_TABLE_LEAVES; j++)
+                rec.leaves[j] = dec.get_delta(state->leaves[j]);
+        } else {
+            ecpt_trans_info &rec = *(ecpt_trans_info *)raw;
+            if (!decode_common(dec, rec, states, state))
+                return false;
+            for (int j = 0; j < ECPT_TABLE_LEAVES; j++)
+                rec.leaves[j] = dec.get_delta(state->leaves[j]);
+            for (int j = 0; j < ECPT_CWT_LEAVES; j++)
+                rec.cwt_leaves[j] = dec.get_delta(state->cwt_leaves[j]);
+            rec.selected_ecpt_way = (uint16_t)dec.get_varint();
+            rec.pud_header = dec.get_byte();
+            rec.pmd_header = dec.get_byte();
+        }
+    }
+    return dec.good();
+}
+
+bool
+qemu_trace_is_container(FILE *file)
+{
+    long start = ftell(file);
+    if (start < 0)
+        return false;
+    char magic[QEMU_TRACE_MAGIC_SIZE];
+    bool match = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+        memcmp(magic, QEMU_TRACE_MAGIC, sizeof(magic)) == 0;
+    clearerr(file);
+    if (fseek(file, start, SEEK_SET) != 0)
+        return false;
+    return match;
+}
+
+static std::vector<uint8_t>
+decode_chunk(trans_arch arch, qemu_trace_chunk_t chunk, std::vector<uint8_t> compressed)
+{
+    std::vector<uint8_t> records(chunk.num_records * qemu_trace_record_size(arch));
+    if (!qemu_trace_decompress_chunk(arch, chunk, compressed.data(), records.data()))
+        records.clear();
+    return records;
+}
+
+qemu_trace_container_t::qemu_trace_container_t(FILE *f, trans_arch a)
+    : file(f)
+    , arch(a)
+    , record_size(qemu_trace_record_size(a))
+    , next_read(0)
+    , cur_chunk(0)
+    , pos(0)
+    , error(false)
+{
+    unsigned int cpus = std::thread::hardware_concurrency();
+    decode_depth = std::max(2U, std::min(cpus, (unsigned int)QEMU_TRACE_MAX_DECODE_DEPTH));
+    memset(&header, 0, sizeof(header));
+}
+
+qemu_trace_container_t::~qemu_trace_container_t()
+{
+    drain();
+}
+
+bool
+qemu_trace_container_t::open(std::string &error_msg)
+{
+    if (fseek(file, 0, SEEK_SET) != 0 || fread(&header, sizeof(header), 1, file) != 1) {
+        error_msg = "cannot read the container header";
+        return false;
+    }
+    if (memcmp(header.magic, QEMU_TRACE_MAGIC, QEMU_TRACE_MAGIC_SIZE) != 0 ||
+        header.version != QEMU_TRACE_VERSION) {
+        error_msg = "unknown container version";
+        return false;
+    }
+    if (header.arch != (uint32_t)arch || header.record_size != record_size) {
+        error_msg = "container records do not match the -arch option";
+        return false;
+    }
+    // Check the index against the file before sizing it from the header, so a
+    // corrupt header cannot ask for an arbitrarily large allocation.
+    if (fseek(file, 0, SEEK_END) != 0) {
+        error_msg = "cannot read the chunk index";
+        return false;
+    }
+    long file_size = ftell(file);
+    if (file_size < 0 || header.index_offset < sizeof(header) ||
+        header.index_offset > (uint64_t)file_size ||
+        header.num_chunks > ((uint64_t)file_size - header.index_offset) /
+                sizeof(qemu_trace_chunk_t) ||
+        (header.num_chunks == 0 && header.num_records != 0)) {
+        error_msg = "chunk index does not fit in the file";
+        return false;
+    }
+    index.resize(header.num_chunks);
+    if (fseek(file, header.index_offset, SEEK_SET) != 0 ||
+        fread(index.data(), sizeof(qemu_trace_chunk_t), index.size(), file) !=
+            index.size()) {
+        error_msg = "cannot read the chunk index";
+        return false;
+    }
+    if (!seek(0)) {
+        error_msg = "cannot read the first chunk";
+        return false;
+    }
+    return true;
+}
+
+// Waits for and discards the chunks being decoded ahead.
+void
+qemu_trace_container_t::drain()
+{
+    while (!pending.empty()) {
+        pending.front().wait();
+        pending.pop_front();
+    }
+}
+
+// Reads the compressed bytes of the next chunk and starts decoding it.
+void
+qemu_trace_container_t::queue_decode()
+{
+    const qemu_trace_chunk_t &chunk = index[next_read++];
+    std::vector<uint8_t> compressed(chunk.compressed_size);
+    if (fseek(file, chunk.offset, SEEK_SET) != 0 ||
+        fread(compressed.data(), 1, compressed.size(), file) != compressed.size())
+        compressed.clear();
+    pending.push_back(
+        std::async(std::launch::async, decode_chunk, arch, chunk, std::move(compressed)));
+}
+
+// Makes the oldest decoded chunk the current one, keeping the decode queue
+// full.  Returns false at the end of the trace or on a corrupt chunk.
+bool
+qemu_trace_container_t::load_next_chunk()
+{
+    while (pending.size() < decode_depth && next_read < index.size())
+        queue_decode();
+    if (pending.empty()) {
+        cur_chunk = index.size();
+        records.clear();
+        pos = 0;
+        return false;
+    }
+    records = pending.front().get();
+    pending.pop_front();
+    cur_chunk = next_read - pending.size() - 1;
+    pos = 0;
+    if (records.size() != index[cur_chunk].num_records * record_size) {
+        error = true;
+        return false;
+    }
+    // Refill the slot just freed.
+    if (next_read < index.size())
+        queue_decode();
+    return true;
+}
+
+bool
+qemu_trace_container_t::seek(uint64_t record)
+{
+    drain();
+    records.clear();
+    pos = 0;
+    if (record >= header.num_records) {
+        next_read = cur_chunk = index.size();
+        return true;
+    }
+    // The last chunk whose first record is not past the target.
+    std::vector<qemu_trace_chunk_t>::const_iterator it = std::upper_bound(
+        index.begin(), index.end(), record,
+        [](uint64_t rec, const qemu_trace_chunk_t &chunk) {
+            return rec < chunk.first_record;
+        });
+    next_read = it - index.begin() - 1;
+    if (!load_next_chunk())
+        return false;
+    pos = (record - index[cur_chunk].first_record) * record_size;
+    return true;
+}
+
+const uint8_t *
+qemu_trace_container_t::next_record(uint8_t *next_header)
+{
+    if (pos + record_size > records.size() && (error || !load_next_chunk()))
+        return NULL;
+    const uint8_t *record = records.data() + pos;
+    pos += record_size;
+    *next_header =
+        pos + record_size <= records.size() ? records[pos] : index[cur_chunk].next_header;
+    return record;
+}
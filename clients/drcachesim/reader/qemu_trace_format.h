@@ -0,0 +1,166 @@
+/* **********************************************************
+ * Copyright (c) 2016-2017 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+/* qemu_trace_format: a compressed, chunked container for the page-walk traces
+ * written by QEMU.
+ *
+ * The raw .bin traces are packed radix_trans_info or ecpt_trans_info structs.
+ * The container stores the same records in chunks of a fixed number of records.
+ * Inside a chunk every field except the header bytes is delta-encoded against
+ * the previous record of the same CPU, as a zigzag varint, and the result is
+ * compressed with zlib.  The delta state restarts at each chunk, so chunks can
+ * be decoded independently and in parallel.  An index at the end of the file
+ * locates every chunk and the number of its first record, which allows seeking
+ * to any record without decoding what precedes it.
+ *
+ * Layout: qemu_trace_header_t, the compressed chunks, then num_chunks
+ * qemu_trace_chunk_t entries at index_offset.  All fields are in host byte
+ * order, as in the raw traces.
+ */
+
+#ifndef _QEMU_TRACE_FORMAT_H_
+#define _QEMU_TRACE_FORMAT_H_ 1
+
+#include <stdint.h>
+#include <stdio.h>
+#include <deque>
+#include <future>
+#include <string>
+#include <vector>
+#include "qemu_file_reader.h"
+
+#define QEMU_TRACE_MAGIC "QPWTRACE"
+#define QEMU_TRACE_MAGIC_SIZE 8
+#define QEMU_TRACE_VERSION 1
+#define QEMU_TRACE_DEFAULT_CHUNK_RECORDS (1 << 16)
+
+struct qemu_trace_header_t {
+    char magic[QEMU_TRACE_MAGIC_SIZE];
+    uint32_t version;
+    uint32_t arch;          // trans_arch of the records.
+    uint32_t record_size;   // Size of one raw record.
+    uint32_t chunk_records; // Records per chunk; only the last chunk may hold fewer.
+    uint64_t num_records;
+    uint64_t num_chunks;
+    uint64_t index_offset;  // File offset of the chunk index.
+};
+
+struct qemu_trace_chunk_t {
+    uint64_t offset;       // File offset of the compressed chunk.
+    uint64_t first_record; // Number of the chunk's first record in the trace.
+    uint32_t compressed_size;
+    uint32_t encoded_size; // Size of the delta-encoded chunk before compression.
+    uint32_t num_records;
+    uint8_t next_header;   // Header of the next chunk's first record, 0 if none.
+    uint8_t padding[3];
+};
+
+/* Returns the size of one raw record of the given architecture. */
+size_t
+qemu_trace_record_size(trans_arch arch);
+
+/* Delta-encodes and compresses num_records raw records into out.  The size of
+ * the intermediate encoding is returned in encoded_size.  Returns false if
+ * compression fails.
+ */
+bool
+qemu_trace_compress_chunk(trans_arch arch, const uint8_t *records, size_t num_records,
+                          int level, std::vector<uint8_t> &out, uint32_t &encoded_size);
+
+/* Reverses qemu_trace_compress_chunk() for the chunk described by chunk, whose
+ * compressed bytes are in compressed.  records must have room for
+ * chunk.num_records raw records.  Returns false if the chunk is corrupt.
+ */
+bool
+qemu_trace_decompress_chunk(trans_arch arch, const qemu_trace_chunk_t &chunk,
+                            const uint8_t *compressed, uint8_t *records);
+
+/* Returns whether file starts with the container magic.  The file position is
+ * restored.  Inputs that cannot be repositioned are never containers.
+ */
+bool
+qemu_trace_is_container(FILE *file);
+
+// Hands out the raw records of a container file in order.  The chunks after
+// the current one are decompressed on other threads while the current one is
+// consumed, and seek() jumps to any record through the chunk index.
+class qemu_trace_container_t {
+public:
+    qemu_trace_container_t(FILE *file, trans_arch arch);
+    ~qemu_trace_container_t();
+    // Reads the header and the chunk index.  On failure, error describes why.
+    bool
+    open(std::string &error);
+    // Positions the container so that the next record returned is number
+    // record.  Returns false if a chunk cannot be read.
+    bool
+    seek(uint64_t record);
+    // Returns the next record, or NULL at the end of the trace or on a read
+    // error (see failed()).  The header of the record after it, or 0 if there
+    // is none, is returned in next_header.
+    const uint8_t *
+    next_record(uint8_t *next_header);
+    bool
+    failed() const
+    {
+        return error;
+    }
+    uint64_t
+    num_records() const
+    {
+        return header.num_records;
+    }
+
+private:
+    void
+    queue_decode();
+    bool
+    load_next_chunk();
+    void
+    drain();
+
+    FILE *file;
+    trans_arch arch;
+    size_t record_size;
+    unsigned int decode_depth;
+    qemu_trace_header_t header;
+    std::vector<qemu_trace_chunk_t> index;
+    size_t next_read;  // Next chunk to read and hand to a decoder.
+    size_t cur_chunk;  // Chunk held in records, or index.size() if none.
+    std::deque<std::future<std::vector<uint8_t>>> pending;
+    std::vector<uint8_t> records;
+    size_t pos;
+    bool error;
+};
+
+#endif /* _QEMU_TRACE_FORMAT_H_ */
@@ -36,6 +36,7 @@
 #include "../common/utils.h"
 #include "cache_simulator_create.h"
 #include "tlb_simulator_create.h"
+#include "checkpoint.h"
 /* XXX i#2006: we include these here for now but it's undecided whether they
  * should be separated and this should only include
  * cache-simulation-based tools.
@@ -47,6 +48,7 @@
 #include "../tools/opcode_mix_create.h"
 #include "../tools/view_create.h"
 #include "../tracer/raw2trace.h"
+#include "../reader/config_reader.h"
 #include <fstream>
 #include <iostream>
 
@@ -86,6 +88,39 @@ get_module_file_path()
     return module_file_path;
 }
 
+/* QEMU traces are made of fixed-size records, so analyzer_multi_t applies
+ * -skip_refs by seeking the reader and the simulators must not skip again.
+ */
+static uint64_t
+get_simulator_skip_refs()
+{
+    if (!op_qemu_mem_trace.get_value().empty())
+        return 0;
+    return op_skip_refs.get_value();
+}
+
+/* A run restoring a -checkpoint_in resumes the trace after the references the
+ * checkpoint covers, skipped ones included.  A QEMU trace is seeked there by
+ * analyzer_multi_t; other traces are skipped by the simulator.
+ */
+static uint64_t
+get_cache_simulator_skip_refs()
+{
+    uint64_t refs;
+    std::string error;
+    if (op_checkpoint_in.get_value().empty() || !op_qemu_mem_trace.get_value().empty() ||
+        !checkpoint_trace_refs(op_checkpoint_in.get_value(), &refs, error))
+        return get_simulator_skip_refs();
+    return refs;
+}
+
+/* QEMU traces record the issuing CPU of each access but no thread ids. */
+static bool
+get_simulator_core_from_access_cpu()
+{
+    return !op_qemu_mem_trace.get_value().empty() && op_core_from_access_cpu.get_value();
+}
+
 /* Get the cache simulator knobs used by the cache simulator
  * and the cache miss analyzer.
  */
@@ -106,17 +141,56 @@ get_cache_simulator_knobs()
     knobs->LL_miss_file = op_LL_miss_file.get_value();
     knobs->contention_L1 = op_contention_L1.get_value(); 
     knobs->contention_LLC = op_contention_LLC.get_value(); 
+    knobs->interference_source = op_interference.get_value();
+    knobs->interference_trace = op_interference_trace.get_value();
+    knobs->interference_working_set = op_interference_working_set.get_value();
+    knobs->interference_stride = op_interference_stride.get_value();
+    knobs->interference_seed = op_interference_seed.get_value();
     knobs->pt_dump_filename = op_pt_dump_file.get_value(); 
     knobs->pt_ranges_file = op_pt_ranges_file.get_value(); 
     knobs->num_ranges = op_num_ranges.get_value(); 
     knobs->replace_policy = op_replace_policy.get_value();
+    knobs->L1I_replace = op_L1I_replace.get_value();
+    knobs->L1D_replace = op_L1D_replace.get_value();
+    knobs->L2_replace = op_L2_replace.get_value();
+    knobs->LL_replace = op_LL_replace.get_value();
     knobs->data_prefetcher = op_data_prefetcher.get_value();
-    knobs->skip_refs = op_skip_refs.get_value();
+    knobs->prefetch_degree = op_prefetch_degree.get_value();
+    knobs->prefetch_late_refs = op_prefetch_late_refs.get_value();
+    knobs->tlb_prefetcher = op_tlb_prefetcher.get_value();
+    knobs->skip_refs = get_cache_simulator_skip_refs();
     knobs->warmup_refs = op_warmup_refs.get_value();
     knobs->warmup_fraction = op_warmup_fraction.get_value();
     knobs->sim_refs = op_sim_refs.get_value();
+    knobs->warmup_functional = op_warmup_functional.get_value();
+    knobs->interval_refs = op_interval_refs.get_value();
+    knobs->interval_instrs = op_interval_instrs.get_value();
+    knobs->interval_file = op_interval_file.get_value();
+    knobs->latency_model = op_latency_model.get_value();
+    knobs->walk_latencies = op_walk_latencies.get_value();
+    knobs->ecpt_parallel_cwc = op_ecpt_parallel_cwc.get_value();
+    knobs->cwt_backfill_overlap = op_cwt_backfill_overlap.get_value();
+    knobs->timing_model = op_timing_model.get_value();
+    knobs->timing_params = op_timing_params.get_value();
+    knobs->issue_window = op_issue_window.get_value();
+    knobs->page_walkers = op_page_walkers.get_value();
+    knobs->miss_ratio_curves = op_miss_ratio_curves.get_value();
+    knobs->mrc_max_entries = op_mrc_max_entries.get_value();
+    knobs->mrc_assocs = op_mrc_assocs.get_value();
+    knobs->mrc_sample_sets = op_mrc_sample_sets.get_value();
+    knobs->checkpoint_out = op_checkpoint_out.get_value();
+    knobs->checkpoint_in = op_checkpoint_in.get_value();
+    knobs->sample_period = op_sample_period.get_value();
+    knobs->sample_window = op_sample_window.get_value();
+    knobs->sample_warmup = op_sample_warmup.get_value();
+    knobs->sample_skip = op_sample_skip.get_value();
+    knobs->sample_error = op_sample_error.get_value();
+    knobs->sample_confidence = op_sample_confidence.get_value();
     knobs->verbose = op_verbose.get_value();
     knobs->cpu_scheduling = op_cpu_scheduling.get_value();
+    knobs->core_from_access_cpu = get_simulator_core_from_access_cpu();
+    knobs->sim_threads = op_sim_threads.get_value();
+    knobs->epoch_refs = op_epoch_refs.get_value();
     
     if (op_trans_arch.get_value() == "radix") {
         knobs->arch = RADIX;
@@ -128,7 +202,37 @@ get_cache_simulator_knobs()
     knobs->ecpt_early_return = op_ecpt_early_return.get_value();
     knobs->ecpt_cache_correct_only = op_ecpt_cache_correct_only.get_value();
     knobs->mmu_to_l2 = op_mmu_to_l2.get_value();
+    knobs->pt_cache_policy = op_pt_cache_policy.get_value();
+    knobs->pt_policy_caches = op_pt_policy_caches.get_value();
+    knobs->pt_partition_ways = op_pt_partition_ways.get_value();
+    knobs->pt_priority_levels = op_pt_priority_levels.get_value();
+    knobs->pt_bypass_l1 = op_pt_bypass_l1.get_value();
+    knobs->coherence = op_coherence.get_value();
+    knobs->pte_write_shootdown = op_pte_write_shootdown.get_value();
     knobs->pwc_asplos_config = op_pwc_asplos_config.get_value();
+    knobs->PWC_PGD_entries = op_PWC_PGD_entries.get_value();
+    knobs->PWC_PGD_assoc = op_PWC_PGD_assoc.get_value();
+    knobs->PWC_PGD_replace = op_PWC_PGD_replace.get_value();
+    knobs->PWC_PUD_entries = op_PWC_PUD_entries.get_value();
+    knobs->PWC_PUD_assoc = op_PWC_PUD_assoc.get_value();
+    knobs->PWC_PUD_replace = op_PWC_PUD_replace.get_value();
+    knobs->PWC_PMD_entries = op_PWC_PMD_entries.get_value();
+    knobs->PWC_PMD_assoc = op_PWC_PMD_assoc.get_value();
+    knobs->PWC_PMD_replace = op_PWC_PMD_replace.get_value();
+    knobs->CWC_PUD_entries = op_CWC_PUD_entries.get_value();
+    knobs->CWC_PUD_assoc = op_CWC_PUD_assoc.get_value();
+    knobs->CWC_PUD_replace = op_CWC_PUD_replace.get_value();
+    knobs->CWC_PMD_entries = op_CWC_PMD_entries.get_value();
+    knobs->CWC_PMD_assoc = op_CWC_PMD_assoc.get_value();
+    knobs->CWC_PMD_replace = op_CWC_PMD_replace.get_value();
+    knobs->ECPT_4K_ways = op_ECPT_4K_ways.get_value();
+    knobs->ECPT_2M_ways = op_ECPT_2M_ways.get_value();
+    knobs->ECPT_1G_ways = op_ECPT_1G_ways.get_value();
+    knobs->CWT_2M_ways = op_CWT_2M_ways.get_value();
+    knobs->CWT_1G_ways = op_CWT_1G_ways.get_value();
+    knobs->synthetic_page_tables = op_synthetic_page_tables.get_value();
+    knobs->synthetic_page_size = op_synthetic_page_size.get_value();
+    knobs->translation_scheme = op_translation_scheme.get_value();
 
     return knobs;
 }
@@ -146,13 +250,34 @@ get_tlb_simulator_knobs()
     knobs->TLB_L1D_assoc = op_TLB_L1D_assoc.get_value();
     knobs->TLB_L2_entries = op_TLB_L2_entries.get_value();
     knobs->TLB_L2_assoc = op_TLB_L2_assoc.get_value();
+    knobs->TLB_page_sizes = op_TLB_page_sizes.get_value();
+    knobs->TLB_L1I_2M_entries = op_TLB_L1I_2M_entries.get_value();
+    knobs->TLB_L1I_2M_assoc = op_TLB_L1I_2M_assoc.get_value();
+    knobs->TLB_L1I_1G_entries = op_TLB_L1I_1G_entries.get_value();
+    knobs->TLB_L1I_1G_assoc = op_TLB_L1I_1G_assoc.get_value();
+    knobs->TLB_L1D_2M_entries = op_TLB_L1D_2M_entries.get_value();
+    knobs->TLB_L1D_2M_assoc = op_TLB_L1D_2M_assoc.get_value();
+    knobs->TLB_L1D_1G_entries = op_TLB_L1D_1G_entries.get_value();
+    knobs->TLB_L1D_1G_assoc = op_TLB_L1D_1G_assoc.get_value();
+    knobs->TLB_L2_2M_entries = op_TLB_L2_2M_entries.get_value();
+    knobs->TLB_L2_2M_assoc = op_TLB_L2_2M_assoc.get_value();
+    knobs->TLB_L2_1G_entries = op_TLB_L2_1G_entries.get_value();
+    knobs->TLB_L2_1G_assoc = op_TLB_L2_1G_assoc.get_value();
     knobs->TLB_replace_policy = op_TLB_replace_policy.get_value();
-    knobs->skip_refs = op_skip_refs.get_value();
+    knobs->TLB_L1I_replace = op_TLB_L1I_replace.get_value();
+    knobs->TLB_L1D_replace = op_TLB_L1D_replace.get_value();
+    knobs->TLB_L2_replace = op_TLB_L2_replace.get_value();
+    knobs->skip_refs = get_simulator_skip_refs();
     knobs->warmup_refs = op_warmup_refs.get_value();
     knobs->warmup_fraction = op_warmup_fraction.get_value();
     knobs->sim_refs = op_sim_refs.get_value();
     knobs->verbose = op_verbose.get_value();
     knobs->cpu_scheduling = op_cpu_scheduling.get_value();
+    knobs->core_from_access_cpu = get_simulator_core_from_access_cpu();
+    knobs->miss_ratio_curves = op_miss_ratio_curves.get_value();
+    knobs->mrc_max_entries = op_mrc_max_entries.get_value();
+    knobs->mrc_assocs = op_mrc_assocs.get_value();
+    knobs->mrc_sample_sets = op_mrc_sample_sets.get_value();
     return knobs;
 }
 
@@ -184,13 +309,30 @@ drmemtrace_analysis_tool_create()
         knobs.TLB_L1D_assoc = op_TLB_L1D_assoc.get_value();
         knobs.TLB_L2_entries = op_TLB_L2_entries.get_value();
         knobs.TLB_L2_assoc = op_TLB_L2_assoc.get_value();
+        knobs.TLB_page_sizes = op_TLB_page_sizes.get_value();
+        knobs.TLB_L1I_2M_entries = op_TLB_L1I_2M_entries.get_value();
+        knobs.TLB_L1I_2M_assoc = op_TLB_L1I_2M_assoc.get_value();
+        knobs.TLB_L1I_1G_entries = op_TLB_L1I_1G_entries.get_value();
+        knobs.TLB_L1I_1G_assoc = op_TLB_L1I_1G_assoc.get_value();
+        knobs.TLB_L1D_2M_entries = op_TLB_L1D_2M_entries.get_value();
+        knobs.TLB_L1D_2M_assoc = op_TLB_L1D_2M_assoc.get_value();
+        knobs.TLB_L1D_1G_entries = op_TLB_L1D_1G_entries.get_value();
+        knobs.TLB_L1D_1G_assoc = op_TLB_L1D_1G_assoc.get_value();
+        knobs.TLB_L2_2M_entries = op_TLB_L2_2M_entries.get_value();
+        knobs.TLB_L2_2M_assoc = op_TLB_L2_2M_assoc.get_value();
+        knobs.TLB_L2_1G_entries = op_TLB_L2_1G_entries.get_value();
+        knobs.TLB_L2_1G_assoc = op_TLB_L2_1G_assoc.get_value();
         knobs.TLB_replace_policy = op_TLB_replace_policy.get_value();
-        knobs.skip_refs = op_skip_refs.get_value();
+        knobs.TLB_L1I_replace = op_TLB_L1I_replace.get_value();
+        knobs.TLB_L1D_replace = op_TLB_L1D_replace.get_value();
+        knobs.TLB_L2_replace = op_TLB_L2_replace.get_value();
+        knobs.skip_refs = get_simulator_skip_refs();
         knobs.warmup_refs = op_warmup_refs.get_value();
         knobs.warmup_fraction = op_warmup_fraction.get_value();
         knobs.sim_refs = op_sim_refs.get_value();
         knobs.verbose = op_verbose.get_value();
         knobs.cpu_scheduling = op_cpu_scheduling.get_value();
+        knobs.core_from_access_cpu = get_simulator_core_from_access_cpu();
         return tlb_simulator_create(knobs);
     } else if (op_simulator_type.get_value() == HISTOGRAM) {
         return histogram_tool_create(op_line_size.get_value(), op_report_top.get_value(),
@@ -228,3 +370,43 @@ drmemtrace_analysis_tool_create()
         return nullptr;
     }
 }
+
+bool
+drmemtrace_analysis_sweep_create(std::vector<analysis_tool_t *> &tools)
+{
+    if (op_simulator_type.get_value() != CPU_CACHE) {
+        ERRMSG("Usage error: -sweep_file is only supported by the " CPU_CACHE
+               " simulator.\n");
+        return false;
+    }
+    if (!op_config_file.get_value().empty()) {
+        ERRMSG("Usage error: -sweep_file and -config_file are mutually exclusive.\n");
+        return false;
+    }
+    tlb_simulator_knobs_t *tlb_knobs = get_tlb_simulator_knobs();
+    cache_simulator_knobs_t *knobs = get_cache_simulator_knobs();
+    std::vector<sweep_config_t> configs;
+    config_reader_t config_reader;
+    bool res =
+        config_reader.configure_sweep(op_sweep_file.get_value(), *knobs, *tlb_knobs, configs);
+    delete knobs;
+    delete tlb_knobs;
+    if (!res)
+        return false;
+    for (const auto &config : configs) {
+        analysis_tool_t *tool = cache_simulator_create(config.knobs, config.tlb_knobs);
+        if (tool == NULL || !*tool) {
+            if (tool != NULL) {
+                ERRMSG("Failed to create configuration %s: %s\n", config.name.c_str(),
+                       tool->get_error_string().c_str());
+                delete tool;
+            }
+            for (analysis_tool_t *created : tools)
+                delete created;
+            tools.clear();
+            return false;
+        }
+        tools.push_back(tool);
+    }
+    return true;
+}
@@ -49,14 +49,6 @@ cache_t::init(int associativity_, int line_size_, int total_size,
                                   prefetcher_, inclusive_, children_);
 }
 
-void
-cache_t::init_blocks()
-{
-    for (int i = 0; i < num_blocks; i++) {
-        blocks[i] = new cache_line_t;
-    }
-}
-
 cache_result_t
 cache_t::request(const memref_t &memref_in)
 {
@@ -75,10 +67,13 @@ cache_t::flush(const memref_t &memref)
     for (; tag <= final_tag; ++tag) {
         int block_idx = compute_block_idx(tag);
         for (int way = 0; way < associativity; ++way) {
-            if (get_caching_device_block(block_idx, way).tag == tag) {
-                get_caching_device_block(block_idx, way).tag = TAG_INVALID;
-                // Xref cache_block_t constructor about why we set counter to 0.
-                get_caching_device_block(block_idx, way).counter = 0;
+            if (tags[block_idx + way] == tag) {
+                tags[block_idx + way] = TAG_INVALID;
+                // Xref caching_device_t::init() about why we set counter to 0.
+                counters[block_idx + way] = 0;
+                prefetch_fills[block_idx + way] = 0;
+                if (type_policy != NULL)
+                    type_policy->invalidate(block_idx + way);
             }
         }
     }
@@ -37,7 +37,6 @@
 #define _CACHE_H_ 1
 
 #include "caching_device.h"
-#include "cache_line.h"
 #include "cache_stats.h"
 
 class cache_t : public caching_device_t {
@@ -54,10 +53,27 @@ public:
 
     virtual void
     flush(const memref_t &memref);
+};
+
+// A cache with a replacement policy that keeps per-cache state, like the RRIP
+// family, SHiP and Hawkeye.
+template <typename policy_t> class policy_cache_t : public cache_t {
+public:
+    virtual cache_result_t
+    request(const memref_t &memref)
+    {
+        return request_with_policy(memref, policy);
+    }
 
 protected:
     virtual void
-    init_blocks();
+    init_blocks()
+    {
+        cache_t::init_blocks();
+        policy.init(blocks_per_set, associativity, counters.data());
+    }
+
+    policy_t policy;
 };
 
 #endif /* _CACHE_H_ */
@@ -32,12 +32,6 @@
 
 #include "cache_fifo.h"
 
-// For the FIFO/Round-Robin implementation, all the cache blocks in a set are organized
-// as a FIFO. The counters of a set of blocks simulate the replacement pointer.
-// The counter of the victim block is 1, and others are 0.
-// While replacing happens, the victim block will be replaced and its counter will
-// be cleared. The counter of the next block will be set to 1.
-
 bool
 cache_fifo_t::init(int associativity_, int block_size_, int total_size,
                    caching_device_t *parent_, caching_device_stats_t *stats_,
@@ -54,33 +48,13 @@ cache_fifo_t::init(int associativity_, int block_size_, int total_size,
 
     // Create a replacement pointer for each set, and
     // initialize it to point to the first block.
-    for (int i = 0; i < blocks_per_set; i++) {
-        get_caching_device_block(i << assoc_bits, 0).counter = 1;
-    }
+    fifo_policy_t::init(blocks_per_set, associativity, counters.data());
     return true;
 }
 
-void
-cache_fifo_t::access_update(int block_idx, int way)
-{
-    // Since the FIFO replacement policy is independent of cache hit,
-    // we do not need to do anything here.
-    return;
-}
-
-int
-cache_fifo_t::replace_which_way(int block_idx)
+cache_result_t
+cache_fifo_t::request(const memref_t &memref)
 {
-    // We replace the block whose counter is 1.
-    for (int i = 0; i < associativity; i++) {
-        if (get_caching_device_block(block_idx, i).counter == 1) {
-            // clear the counter of the victim block
-            get_caching_device_block(block_idx, i).counter = 0;
-            // set the next block as victim
-            get_caching_device_block(block_idx, (i + 1) & (associativity - 1)).counter =
-                1;
-            return i;
-        }
-    }
-    return -1;
+    fifo_policy_t policy;
+    return request_with_policy(memref, policy);
 }
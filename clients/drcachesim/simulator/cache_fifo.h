@@ -38,6 +38,59 @@
 
 #include "cache.h"
 
+// For the FIFO/Round-Robin implementation, all the cache blocks in a set are organized
+// as a FIFO. The counters of a set of blocks simulate the replacement pointer.
+// The counter of the victim block is 1, and others are 0.
+// While replacing happens, the victim block will be replaced and its counter will
+// be cleared. The counter of the next block will be set to 1.
+struct fifo_policy_t {
+    static inline void
+    init(int num_sets, int associativity, int *counters)
+    {
+        // Point the replacement pointer of each set at its first block.
+        for (int set = 0; set < num_sets; set++)
+            counters[set * associativity] = 1;
+    }
+    static inline void
+    access_update(int set, const addr_t *tags, int *counters, int associativity, int way,
+                  const memref_t &memref)
+    {
+        // Since the FIFO replacement policy is independent of cache hit,
+        // we do not need to do anything here.
+    }
+    static inline int
+    replace_which_way(int set, const addr_t *tags, int *counters, int associativity,
+                      int first_way, int end_way, const memref_t &memref)
+    {
+        // We replace the block whose counter is 1.
+        for (int i = first_way; i < end_way; i++) {
+            if (counters[i] == 1) {
+                // clear the counter of the victim block
+                counters[i] = 0;
+                // set the next block as victim
+                counters[(i + 1) & (associativity - 1)] = 1;
+                return i;
+            }
+        }
+        // A set has a single replacement pointer.  When it is in another
+        // partition we fill an invalid block, or else the partition's first.
+        for (int i = first_way; i < end_way; i++) {
+            if (tags[i] == TAG_INVALID)
+                return i;
+        }
+        return first_way;
+    }
+    static inline void
+    insert_update(int set, const addr_t *tags, int *counters, int associativity, int way,
+                  const memref_t &memref)
+    {
+    }
+    static inline void
+    promote(int set, const addr_t *tags, int *counters, int associativity, int way)
+    {
+    }
+};
+
 class cache_fifo_t : public cache_t {
 public:
     virtual bool
@@ -45,11 +98,8 @@ public:
          caching_device_stats_t *stats, prefetcher_t *prefetcher, bool inclusive = false,
          const std::vector<caching_device_t *> &children = {});
 
-protected:
-    virtual void
-    access_update(int line_idx, int way);
-    virtual int
-    replace_which_way(int line_idx);
+    virtual cache_result_t
+    request(const memref_t &memref);
 };
 
 #endif /* _CACHE_FIFO_H_ */
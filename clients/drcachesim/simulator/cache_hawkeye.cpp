@@ -0,0 +1,162 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+#include "cache_hawkeye.h"
+
+void
+hawkeye_policy_t::init(int num_sets, int associativity_, int *counters)
+{
+    associativity = associativity_;
+    history_length = HAWKEYE_HISTORY_FACTOR * associativity;
+    // Sample every set of small devices, like TLBs and walk caches.
+    int stride = num_sets / HAWKEYE_SAMPLED_SETS;
+    if (stride < 1)
+        stride = 1;
+    sampled_index.assign(num_sets, -1);
+    for (int set = 0; set < num_sets; set += stride) {
+        sampled_index[set] = (int)optgen_sets.size();
+        optgen_sets.push_back(optgen_set_t());
+        optgen_sets.back().time = 0;
+        optgen_sets.back().occupancy.assign(history_length, 0);
+    }
+    // Predictions start weakly friendly.
+    predictor.assign(1 << HAWKEYE_SIGNATURE_BITS, (HAWKEYE_COUNTER_MAX + 1) / 2);
+    signatures.assign(num_sets * associativity, 0);
+}
+
+void
+hawkeye_policy_t::train(unsigned int signature, bool friendly)
+{
+    if (friendly && predictor[signature] < HAWKEYE_COUNTER_MAX)
+        predictor[signature]++;
+    else if (!friendly && predictor[signature] > 0)
+        predictor[signature]--;
+}
+
+void
+hawkeye_policy_t::optgen_access(optgen_set_t &sampled, addr_t tag, unsigned int signature)
+{
+    uint64_t now = sampled.time++;
+    sampled.occupancy[now % history_length] = 0;
+    auto it = sampled.last_access.find(tag);
+    if (it != sampled.last_access.end()) {
+        uint64_t last = it->second.time;
+        // OPT hits if it has room for the block over its whole usage interval.
+        bool opt_hit = now - last < (uint64_t)history_length;
+        for (uint64_t t = last; opt_hit && t < now; t++) {
+            if (sampled.occupancy[t % history_length] >= associativity)
+                opt_hit = false;
+        }
+        if (opt_hit) {
+            for (uint64_t t = last; t < now; t++)
+                sampled.occupancy[t % history_length]++;
+        }
+        train(it->second.signature, opt_hit);
+        it->second.time = now;
+        it->second.signature = signature;
+        return;
+    }
+    optgen_entry_t entry = { now, signature };
+    sampled.last_access[tag] = entry;
+    // Forget the tags too old for OPT to keep, which it missed.
+    if (sampled.last_access.size() > 2 * (size_t)history_length) {
+        for (it = sampled.last_access.begin(); it != sampled.last_access.end();) {
+            if (now - it->second.time >= (uint64_t)history_length) {
+                train(it->second.signature, false);
+                it = sampled.last_access.erase(it);
+            } else
+                ++it;
+        }
+    }
+}
+
+void
+hawkeye_policy_t::access(int set, const addr_t *tags, int *counters, int associativity,
+                         int way, const memref_t &memref)
+{
+    unsigned int signature = replacement_signature(memref, HAWKEYE_SIGNATURE_BITS);
+    if (sampled_index[set] >= 0)
+        optgen_access(optgen_sets[sampled_index[set]], tags[way], signature);
+    signatures[set * associativity + way] = (uint16_t)signature;
+}
+
+void
+hawkeye_policy_t::access_update(int set, const addr_t *tags, int *counters,
+                                int associativity, int way, const memref_t &memref)
+{
+    access(set, tags, counters, associativity, way, memref);
+    bool friendly = predictor[signatures[set * associativity + way]] >=
+        (HAWKEYE_COUNTER_MAX + 1) / 2;
+    counters[way] = friendly ? 0 : HAWKEYE_RRPV_MAX;
+}
+
+int
+hawkeye_policy_t::replace_which_way(int set, const addr_t *tags, int *counters,
+                                    int associativity, int first_way, int end_way,
+                                    const memref_t &memref)
+{
+    int max_rrpv = -1;
+    int max_way = first_way;
+    for (int way = first_way; way < end_way; ++way) {
+        if (tags[way] == TAG_INVALID)
+            return way;
+        if (counters[way] == HAWKEYE_RRPV_MAX)
+            return way;
+        if (counters[way] > max_rrpv) {
+            max_rrpv = counters[way];
+            max_way = way;
+        }
+    }
+    // Evicting a block predicted friendly means the prediction was wrong.
+    train(signatures[set * associativity + max_way], false);
+    return max_way;
+}
+
+void
+hawkeye_policy_t::insert_update(int set, const addr_t *tags, int *counters,
+                                int associativity, int way, const memref_t &memref)
+{
+    access(set, tags, counters, associativity, way, memref);
+    bool friendly = predictor[signatures[set * associativity + way]] >=
+        (HAWKEYE_COUNTER_MAX + 1) / 2;
+    if (!friendly) {
+        counters[way] = HAWKEYE_RRPV_MAX;
+        return;
+    }
+    for (int other = 0; other < associativity; ++other) {
+        if (other != way && tags[other] != TAG_INVALID &&
+            counters[other] < HAWKEYE_RRPV_MAX - 1)
+            counters[other]++;
+    }
+    counters[way] = 0;
+}
@@ -0,0 +1,115 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+/* cache_hawkeye: a Hawkeye-style replacement policy.
+ */
+
+#ifndef _CACHE_HAWKEYE_H_
+#define _CACHE_HAWKEYE_H_ 1
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+#include "caching_device.h"
+
+// Hawkeye (Jain and Lin, ISCA 2016) learns from Belady's optimal policy.  On
+// a sample of the sets, OPTgen replays the accesses and works out whether OPT
+// would have kept each block until its reuse.  That trains a table of
+// saturating counters per signature (see replacement_signature()), which
+// predicts whether a new block is cache-friendly or cache-averse.  Friendly
+// blocks are inserted with a counter (an RRPV) of 0 and age as others are
+// inserted; averse blocks are inserted at HAWKEYE_RRPV_MAX and evicted first.
+class hawkeye_policy_t {
+public:
+    void
+    init(int num_sets, int associativity, int *counters);
+    void
+    access_update(int set, const addr_t *tags, int *counters, int associativity, int way,
+                  const memref_t &memref);
+    int
+    replace_which_way(int set, const addr_t *tags, int *counters, int associativity,
+                      int first_way, int end_way, const memref_t &memref);
+    void
+    insert_update(int set, const addr_t *tags, int *counters, int associativity, int way,
+                  const memref_t &memref);
+    void
+    promote(int set, const addr_t *tags, int *counters, int associativity, int way)
+    {
+        counters[way] = 0;
+    }
+
+protected:
+    static const int HAWKEYE_RRPV_MAX = 7;
+    static const int HAWKEYE_SIGNATURE_BITS = 13;
+    static const uint8_t HAWKEYE_COUNTER_MAX = 7;
+    static const int HAWKEYE_SAMPLED_SETS = 64;
+    // OPTgen looks this many accesses times the associativity back.
+    static const int HAWKEYE_HISTORY_FACTOR = 8;
+
+    struct optgen_entry_t {
+        uint64_t time;
+        unsigned int signature;
+    };
+    // The OPTgen state of a sampled set.
+    struct optgen_set_t {
+        uint64_t time;
+        // How many blocks OPT holds at each of the last history_length
+        // accesses, indexed by time modulo history_length.
+        std::vector<uint16_t> occupancy;
+        // The last access to each recently used tag.
+        std::unordered_map<addr_t, optgen_entry_t> last_access;
+    };
+
+    // Replays an access to a sampled set, training the predictor on whether
+    // OPT would have hit the previous access to the same tag.
+    void
+    optgen_access(optgen_set_t &sampled, addr_t tag, unsigned int signature);
+    void
+    train(unsigned int signature, bool friendly);
+    // Updates the prediction state of an access, hit or fill.
+    void
+    access(int set, const addr_t *tags, int *counters, int associativity, int way,
+           const memref_t &memref);
+
+    int associativity;
+    int history_length;
+    // The index in optgen_sets of each set, or -1 if it is not sampled.
+    std::vector<int> sampled_index;
+    std::vector<optgen_set_t> optgen_sets;
+    std::vector<uint8_t> predictor;
+    // The signature of the last access to each block.
+    std::vector<uint16_t> signatures;
+};
+
+#endif /* _CACHE_HAWKEYE_H_ */
@@ -32,44 +32,9 @@
 
 #include "cache_lru.h"
 
-// For LRU implementation, we use the cache line counter to represent
-// how recently a cache line is accessed.
-// The count value 0 means the most recent access, and the cache line with the
-// highest counter value will be picked for replacement in replace_which_way.
-
-void
-cache_lru_t::access_update(int line_idx, int way)
-{
-    int cnt = get_caching_device_block(line_idx, way).counter;
-    // Optimization: return early if it is a repeated access.
-    if (cnt == 0)
-        return;
-    // We inc all the counters that are not larger than cnt for LRU.
-    for (int i = 0; i < associativity; ++i) {
-        if (i != way && get_caching_device_block(line_idx, i).counter <= cnt)
-            get_caching_device_block(line_idx, i).counter++;
-    }
-    // Clear the counter for LRU.
-    get_caching_device_block(line_idx, way).counter = 0;
-}
-
-int
-cache_lru_t::replace_which_way(int line_idx)
+cache_result_t
+cache_lru_t::request(const memref_t &memref)
 {
-    // We implement LRU by picking the slot with the largest counter value.
-    int max_counter = 0;
-    int max_way = 0;
-    for (int way = 0; way < associativity; ++way) {
-        if (get_caching_device_block(line_idx, way).tag == TAG_INVALID) {
-            max_way = way;
-            break;
-        }
-        if (get_caching_device_block(line_idx, way).counter > max_counter) {
-            max_counter = get_caching_device_block(line_idx, way).counter;
-            max_way = way;
-        }
-    }
-    // Set to non-zero for later access_update optimization on repeated access
-    get_caching_device_block(line_idx, max_way).counter = 1;
-    return max_way;
+    lru_policy_t policy;
+    return request_with_policy(memref, policy);
 }
@@ -38,12 +38,67 @@
 
 #include "cache.h"
 
+// For LRU implementation, we use the cache line counter to represent
+// how recently a cache line is accessed.
+// The count value 0 means the most recent access, and the cache line with the
+// highest counter value will be picked for replacement in replace_which_way.
+struct lru_policy_t {
+    static inline void
+    init(int num_sets, int associativity, int *counters)
+    {
+    }
+    static inline void
+    access_update(int set, const addr_t *tags, int *counters, int associativity, int way,
+                  const memref_t &memref)
+    {
+        int cnt = counters[way];
+        // Optimization: return early if it is a repeated access.
+        if (cnt == 0)
+            return;
+        // We inc all the counters that are not larger than cnt for LRU.
+        // This includes counters[way] itself, which we clear right after.
+        lru_age(counters, associativity, cnt);
+        // Clear the counter for LRU.
+        counters[way] = 0;
+    }
+    static inline int
+    replace_which_way(int set, const addr_t *tags, int *counters, int associativity,
+                      int first_way, int end_way, const memref_t &memref)
+    {
+        // We implement LRU by picking the slot with the largest counter value.
+        int max_counter = 0;
+        int max_way = first_way;
+        for (int way = first_way; way < end_way; ++way) {
+            if (tags[way] == TAG_INVALID) {
+                max_way = way;
+                break;
+            }
+            if (counters[way] > max_counter) {
+                max_counter = counters[way];
+                max_way = way;
+            }
+        }
+        // Set to non-zero for later access_update optimization on repeated access
+        counters[max_way] = 1;
+        return max_way;
+    }
+    static inline void
+    insert_update(int set, const addr_t *tags, int *counters, int associativity, int way,
+                  const memref_t &memref)
+    {
+        access_update(set, tags, counters, associativity, way, memref);
+    }
+    static inline void
+    promote(int set, const addr_t *tags, int *counters, int associativity, int way)
+    {
+        // New blocks are already the most recently used.
+    }
+};
+
 class cache_lru_t : public cache_t {
-protected:
-    virtual void
-    access_update(int line_idx, int way);
-    virtual int
-    replace_which_way(int line_idx);
+public:
+    virtual cache_result_t
+    request(const memref_t &memref);
 };
 
 #endif /* _CACHE_LRU_H_ */
@@ -0,0 +1,226 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+/* cache_rrip: re-reference interval prediction replacement policies.
+ */
+
+#ifndef _CACHE_RRIP_H_
+#define _CACHE_RRIP_H_ 1
+
+#include <stdint.h>
+#include <vector>
+
+#include "caching_device.h"
+
+// For RRIP (Jaleel et al., ISCA 2010), the counter of a block is its 2-bit
+// re-reference prediction value (RRPV): 0 predicts a near re-reference and
+// RRIP_RRPV_MAX a distant one.  A hit predicts a near re-reference, and the
+// victim is a block predicted distant, aging the whole set until one is.
+#define RRIP_RRPV_MAX 3
+
+static inline int
+rrip_victim(const addr_t *tags, int *counters, int first_way, int end_way, int rrpv_max)
+{
+    int max_rrpv = 0;
+    int max_way = first_way;
+    for (int way = first_way; way < end_way; ++way) {
+        if (tags[way] == TAG_INVALID)
+            return way;
+        if (counters[way] > max_rrpv) {
+            max_rrpv = counters[way];
+            max_way = way;
+        }
+    }
+    // Aging the set until a block reaches rrpv_max adds the same amount to
+    // every counter, and the first block to get there is the oldest one.
+    if (max_rrpv < rrpv_max) {
+        for (int way = first_way; way < end_way; ++way)
+            counters[way] += rrpv_max - max_rrpv;
+    }
+    return max_way;
+}
+
+// How new blocks are inserted:
+// - RRIP_STATIC (SRRIP) predicts a long re-reference interval for every new block.
+// - RRIP_BIMODAL (BRRIP) predicts a distant one but for one fill in
+//   RRIP_BIMODAL_THROTTLE, which resists thrashing.
+// - RRIP_DYNAMIC (DRRIP) duels the two on leader sets and has the other
+//   sets follow the one that misses less.
+enum rrip_insertion_t { RRIP_STATIC, RRIP_BIMODAL, RRIP_DYNAMIC };
+
+template <rrip_insertion_t insertion> class rrip_policy_t {
+public:
+    void
+    init(int num_sets_, int associativity, int *counters)
+    {
+        num_sets = num_sets_;
+        // With too few sets to have followers every set leads.
+        leader_stride = num_sets / RRIP_DUEL_LEADERS;
+        if (leader_stride < 2)
+            leader_stride = 2;
+        psel = RRIP_PSEL_MAX / 2;
+        bimodal_fills = 0;
+    }
+    void
+    access_update(int set, const addr_t *tags, int *counters, int associativity, int way,
+                  const memref_t &memref)
+    {
+        counters[way] = 0;
+    }
+    int
+    replace_which_way(int set, const addr_t *tags, int *counters, int associativity,
+                      int first_way, int end_way, const memref_t &memref)
+    {
+        if (insertion == RRIP_DYNAMIC) {
+            // A miss in a leader set counts against its insertion policy.
+            int leader = set % leader_stride;
+            if (leader == 0 && psel < RRIP_PSEL_MAX)
+                psel++;
+            else if (leader == 1 && psel > 0)
+                psel--;
+        }
+        return rrip_victim(tags, counters, first_way, end_way, RRIP_RRPV_MAX);
+    }
+    void
+    insert_update(int set, const addr_t *tags, int *counters, int associativity, int way,
+                  const memref_t &memref)
+    {
+        counters[way] = bimodal(set) ? bimodal_rrpv() : RRIP_RRPV_MAX - 1;
+    }
+    void
+    promote(int set, const addr_t *tags, int *counters, int associativity, int way)
+    {
+        counters[way] = 0;
+    }
+
+protected:
+    static const int RRIP_DUEL_LEADERS = 32;
+    static const int RRIP_PSEL_MAX = 1023;
+    static const int RRIP_BIMODAL_THROTTLE = 32;
+
+    // Whether a fill in set is inserted the BRRIP way.
+    inline bool
+    bimodal(int set) const
+    {
+        if (insertion != RRIP_DYNAMIC)
+            return insertion == RRIP_BIMODAL;
+        int leader = set % leader_stride;
+        if (leader <= 1)
+            return leader == 1;
+        // SRRIP leaders missing more than the BRRIP ones push psel up.
+        return psel > RRIP_PSEL_MAX / 2;
+    }
+    inline int
+    bimodal_rrpv()
+    {
+        // A deterministic throttle keeps runs reproducible.
+        if (++bimodal_fills == RRIP_BIMODAL_THROTTLE) {
+            bimodal_fills = 0;
+            return RRIP_RRPV_MAX - 1;
+        }
+        return RRIP_RRPV_MAX;
+    }
+
+    int num_sets;
+    int leader_stride;
+    int psel;
+    int bimodal_fills;
+};
+
+typedef rrip_policy_t<RRIP_STATIC> srrip_policy_t;
+typedef rrip_policy_t<RRIP_BIMODAL> brrip_policy_t;
+typedef rrip_policy_t<RRIP_DYNAMIC> drrip_policy_t;
+
+// SHiP (Wu et al., MICRO 2011) inserts with SRRIP but predicts a distant
+// re-reference for blocks whose signature (see replacement_signature()) has
+// seen its blocks evicted without a hit.  A table of saturating counters per
+// signature learns this: a hit increments the counter of the block's
+// signature and the eviction of a block that was never hit decrements it.
+class ship_policy_t {
+public:
+    void
+    init(int num_sets, int associativity, int *counters)
+    {
+        // Counters start weakly reused so that a cold table does not bypass.
+        shct.assign(1 << SHIP_SIGNATURE_BITS, 1);
+        signatures.assign(num_sets * associativity, 0);
+        reused.assign(num_sets * associativity, 0);
+    }
+    void
+    access_update(int set, const addr_t *tags, int *counters, int associativity, int way,
+                  const memref_t &memref)
+    {
+        int block = set * associativity + way;
+        counters[way] = 0;
+        reused[block] = 1;
+        if (shct[signatures[block]] < SHIP_COUNTER_MAX)
+            shct[signatures[block]]++;
+    }
+    int
+    replace_which_way(int set, const addr_t *tags, int *counters, int associativity,
+                      int first_way, int end_way, const memref_t &memref)
+    {
+        int way = rrip_victim(tags, counters, first_way, end_way, RRIP_RRPV_MAX);
+        int block = set * associativity + way;
+        if (tags[way] != TAG_INVALID && !reused[block] && shct[signatures[block]] > 0)
+            shct[signatures[block]]--;
+        return way;
+    }
+    void
+    insert_update(int set, const addr_t *tags, int *counters, int associativity, int way,
+                  const memref_t &memref)
+    {
+        int block = set * associativity + way;
+        unsigned int signature = replacement_signature(memref, SHIP_SIGNATURE_BITS);
+        signatures[block] = (uint16_t)signature;
+        reused[block] = 0;
+        counters[way] = shct[signature] == 0 ? RRIP_RRPV_MAX : RRIP_RRPV_MAX - 1;
+    }
+    void
+    promote(int set, const addr_t *tags, int *counters, int associativity, int way)
+    {
+        counters[way] = 0;
+    }
+
+protected:
+    static const int SHIP_SIGNATURE_BITS = 14;
+    static const uint8_t SHIP_COUNTER_MAX = 7;
+
+    // The signature history counter table.
+    std::vector<uint8_t> shct;
+    // The signature each block was filled by and whether it has been hit since.
+    std::vector<uint16_t> signatures;
+    std::vector<uint8_t> reused;
+};
+
+#endif /* _CACHE_RRIP_H_ */
@@ -47,8 +47,6 @@ const unsigned int PWC_ASSOC_ASPLOS_CONFIG[] = { 4, 4, 4};
 const unsigned int PWC_SIZE_ASPLOS_CONFIG[] = { PWC_ENTRY_SIZE * 32, PWC_ENTRY_SIZE * 32, PWC_ENTRY_SIZE * 32};
 
 #define CWC_ENTRY_SIZE 1
-const unsigned int CWC_ASSOC[] = { 2, 16};
-const unsigned int CWC_SIZE[] = { CWC_ENTRY_SIZE * 2, CWC_ENTRY_SIZE * 16};
 
 
 
@@ -59,8 +57,10 @@ const unsigned int CWC_SIZE[] = { CWC_ENTRY_SIZE * 2, CWC_ENTRY_SIZE * 16};
 #define SIMULATOR_HEARTBEAT_FREQ 22 //Log of number of meminsts to process between two simulator hearbeats
 
 
+#include <algorithm>
 #include <iostream>
 #include <iterator>
+#include <sstream>
 #include <string>
 #include <assert.h>
 #include <limits.h>
@@ -76,12 +76,16 @@ const unsigned int CWC_SIZE[] = { CWC_ENTRY_SIZE * 2, CWC_ENTRY_SIZE * 16};
 #include "cache.h"
 #include "cache_lru.h"
 #include "cache_fifo.h"
+#include "cache_hawkeye.h"
+#include "cache_rrip.h"
 #include "cache_simulator.h"
+#include "page_walker.h"
 #include "droption.h"
 
 #include <cstdio>
 #include <inttypes.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define IN_SET(set, key) (set.find(key) != set.end())
 
@@ -109,15 +113,38 @@ cache_simulator_t::cache_simulator_t(const cache_simulator_knobs_t &knobs_, cons
     , l2_caches(NULL)
     , pw_caches(NULL)
     , cwc_caches(NULL)
+    , tlb_sim(NULL)
+    , snoop_filter(NULL)
+    , num_request(0)
+    , num_request_shifted(0)
+    , num_not_found(0)
+    , num_range_found(0)
+    , num_range_not_found(0)
+    , interval_out(NULL)
+    , interval_measuring(false)
+    , interval_index(0)
+    , interval_first_ref(0)
+    , interval_num_refs(0)
+    , interval_num_instrs(0)
     , is_warmed_up(false)
+    , functional_warmup(false)
+    , sample_phase(SAMPLE_DETAILED)
 {
     // XXX i#1703: get defaults from hardware being run on.
+    knob_core_from_cpu = knobs.core_from_access_cpu;
+
+    // Create TLB(s).  The TLBs only see the references we did not skip, so
+    // they must not skip any themselves.
+    tlb_simulator_knobs_t tlb_knobs = tlb_knobs_;
+    tlb_knobs.skip_refs = 0;
+    tlb_sim = new tlb_simulator_t(tlb_knobs);
+    if (!*tlb_sim) {
+        error_string = tlb_sim->get_error_string();
+        success = false;
+        return;
+    }
 
-    // Create TLB(s)
-    tlb_sim = new tlb_simulator_t(tlb_knobs_);
-
-    /* initialize random seed: */
-    srand (42);
+    memset(ins_fetched, 0, sizeof(ins_fetched));
 
     /* comment this out first to have the simulator run */
 /**/
@@ -171,16 +198,43 @@ cache_simulator_t::cache_simulator_t(const cache_simulator_knobs_t &knobs_, cons
     //*********************************************************
 
     // This configuration allows for one shared LLC only.
-    cache_t *llc = create_cache(knobs.replace_policy);
+    cache_t *llc = create_cache(level_replace_policy(knobs.LL_replace));
     llc1 = llc;
     if (llc == NULL) {
         success = false;
         return;
     }
 
-    if (knobs.data_prefetcher != PREFETCH_POLICY_NEXTLINE &&
-        knobs.data_prefetcher != PREFETCH_POLICY_NONE) {
-        // Unknown value.
+    if (!valid_prefetcher(knobs.data_prefetcher)) {
+        error_string = "Usage error: unknown -data_prefetcher " + knobs.data_prefetcher +
+            ".  Choose from " PREFETCH_POLICY_NEXTLINE ", " PREFETCH_POLICY_STRIDE
+            ", " PREFETCH_POLICY_STREAM ", " PREFETCH_POLICY_SPATIAL
+            " and " PREFETCH_POLICY_NONE ".";
+        success = false;
+        return;
+    }
+    if ((knobs.coherence || knobs.pte_write_shootdown) &&
+        (knobs.sim_threads > 1 || knobs.epoch_refs > 0)) {
+        error_string = "Usage error: -coherence and -pte_write_shootdown need "
+                       "-sim_threads 1 and -epoch_refs 0.";
+        success = false;
+        return;
+    }
+    if (knobs.timing_model && (knobs.sim_threads > 1 || knobs.epoch_refs > 0)) {
+        error_string =
+            "Usage error: -timing_model needs -sim_threads 1 and -epoch_refs 0.";
+        success = false;
+        return;
+    }
+    if (knobs.pte_write_shootdown && knobs.arch != RADIX) {
+        error_string = "Usage error: -pte_write_shootdown is only for -arch radix.";
+        success = false;
+        return;
+    }
+    if (knobs.tlb_prefetcher != PREFETCH_POLICY_NONE &&
+        (knobs.tlb_prefetcher != TLB_PREFETCH_POLICY_SEQUENTIAL || knobs.arch != RADIX)) {
+        error_string = "Usage error: -tlb_prefetcher must be " PREFETCH_POLICY_NONE
+                       " or, for -arch radix, " TLB_PREFETCH_POLICY_SEQUENTIAL ".";
         success = false;
         return;
     }
@@ -204,17 +258,17 @@ cache_simulator_t::cache_simulator_t(const cache_simulator_knobs_t &knobs_, cons
     l1_dcaches = new cache_t *[knobs.num_cores];
     l2_caches =  new cache_t *[knobs.num_cores];
     for (unsigned int i = 0; i < knobs.num_cores; i++) {
-        l2_caches[i] = create_cache(knobs.replace_policy);
+        l2_caches[i] = create_cache(level_replace_policy(knobs.L2_replace));
         if (l2_caches[i] == NULL) {
             success = false;
             return;
         }
-        l1_icaches[i] = create_cache(knobs.replace_policy);
+        l1_icaches[i] = create_cache(level_replace_policy(knobs.L1I_replace));
         if (l1_icaches[i] == NULL) {
             success = false;
             return;
         }
-        l1_dcaches[i] = create_cache(knobs.replace_policy);
+        l1_dcaches[i] = create_cache(level_replace_policy(knobs.L1D_replace));
         if (l1_dcaches[i] == NULL) {
             success = false;
             return;
@@ -240,9 +294,7 @@ cache_simulator_t::cache_simulator_t(const cache_simulator_knobs_t &knobs_, cons
             !l1_dcaches[i]->init(knobs.L1D_assoc, (int)knobs.line_size,
                                  (int)knobs.L1D_size, l2_caches[i],
                                  new cache_stats_t("", warmup_enabled),
-                                 knobs.data_prefetcher == PREFETCH_POLICY_NEXTLINE
-                                     ? new prefetcher_t((int)knobs.line_size)
-                                     : nullptr)) {
+                                 create_prefetcher(knobs.data_prefetcher))) {
             error_string = "Usage error: failed to initialize L1 and L2 caches.  Ensure sizes "
                            "and associativity are powers of 2 "
                            "and that the total sizes are multiples of the line size.";
@@ -258,65 +310,94 @@ cache_simulator_t::cache_simulator_t(const cache_simulator_knobs_t &knobs_, cons
         all_caches[cache_name] = l1_dcaches[i];
     }
 
-    if (knobs.arch == RADIX) {
-        pw_caches =  new cache_t *[NUM_PWC];
-        const unsigned int *PWC_ASSOC;
-        const unsigned int *PWC_SIZE;
-        if (knobs.pwc_asplos_config) {
-            PWC_ASSOC = &PWC_ASSOC_ASPLOS_CONFIG[0];
-            PWC_SIZE = &PWC_SIZE_ASPLOS_CONFIG[0];
-        } else {
-            PWC_ASSOC = &PWC_ASSOC_ARM[0];
-            PWC_SIZE = &PWC_SIZE_ARM[0];
+    if (!init_type_policies()) {
+        success = false;
+        return;
+    }
+
+    // Each core's L2 is kept inclusive of its L1s, so that the directory
+    // tracking the L2s covers every private copy.
+    if (knobs.coherence) {
+        snoop_filter = new snoop_filter_t;
+        if (!snoop_filter->init(std::vector<caching_device_t *>(
+                l2_caches, l2_caches + knobs.num_cores))) {
+            error_string = "Usage error: -coherence supports up to 64 cores.";
+            success = false;
+            return;
+        }
+        for (unsigned int i = 0; i < knobs.num_cores; i++) {
+            l2_caches[i]->set_inclusive(true, { l1_icaches[i], l1_dcaches[i] });
+            l2_caches[i]->set_snoop_filter(snoop_filter, i, true);
+            l1_dcaches[i]->set_snoop_filter(snoop_filter, i, false);
         }
+    }
 
+    for (auto &caches_it : all_caches)
+        caches_it.second->set_prefetch_late_refs(knobs.prefetch_late_refs);
+    tlb_sim->set_prefetch_late_refs(knobs.prefetch_late_refs);
+    if (knobs.tlb_prefetcher == TLB_PREFETCH_POLICY_SEQUENTIAL)
+        tlb_prefetch_pages.assign(knobs.num_cores * TLB_PREFETCH_HISTORY, 0);
 
-        for (unsigned int i = 0; i < NUM_PWC; i++) {
-            pw_caches[i] = create_cache(knobs.replace_policy);
-            if (pw_caches[i] == NULL) {
-                success = false;
-                return;
-            }
+    if (!init_walk_caches(warmup_enabled)) {
+        success = false;
+        return;
+    }
 
-            std::cerr << "Initialising PW cache with size: " << PWC_SIZE[i]
-                    << " with assoc: " << PWC_ASSOC[i]
-                    << " with line size: " << knobs.line_size << std::endl;
-            
-            if (!pw_caches[i]->init (PWC_ASSOC[i], PWC_ENTRY_SIZE,
-                                    PWC_SIZE[i], NULL,
-                                    new cache_stats_t("", warmup_enabled))) {
-                error_string = "Usage error: failed to initialize PW caches.  Ensure sizes "
-                            "and associativity are powers of 2 "
-                            "and that the total sizes are multiples of the line size.";
-                success = false;
-                return;
-            }
-        }
+    if (!interval_init()) {
+        success = false;
+        return;
     }
 
-    if (knobs.arch == ECPT) {
-        cwc_caches = new cache_t *[NUM_CWC];
+    // Sampling measures the walks' cycles too.
+    if ((knobs.latency_model || knobs.sample_period > 0) &&
+        !walk_latency.init(knobs.walk_latencies, knobs.ecpt_parallel_cwc,
+                           knobs.cwt_backfill_overlap, error_string)) {
+        success = false;
+        return;
+    }
 
-        for (unsigned int i = 0; i < NUM_CWC; i++) {
-            cwc_caches[i] = create_cache(knobs.replace_policy);
-            if (cwc_caches[i] == NULL) {
-                success = false;
-                return;
-            }
+    if ((knobs.contention_L1 != 0 || knobs.contention_LLC != 0) && !init_interference()) {
+        success = false;
+        return;
+    }
 
-            std::cerr << "Initialising CWC cache with size: " << CWC_SIZE[i]
-                    << " with assoc: " << CWC_ASSOC[i] << std::endl;
-            
-            if (!cwc_caches[i]->init (CWC_ASSOC[i], CWC_ENTRY_SIZE,
-                                    CWC_SIZE[i], NULL,
-                                    new cache_stats_t("", warmup_enabled))) {
-                error_string = "Usage error: failed to initialize PW caches.  Ensure sizes "
-                            "and associativity are powers of 2 "
-                            "and that the total sizes are multiples of the line size.";
-                success = false;
-                return;
-            }
-        }
+    if (!init_page_walker()) {
+        success = false;
+        return;
+    }
+
+    if (knobs.timing_model &&
+        !timing_model.init(knobs.timing_params, knobs.num_cores, knobs.line_size,
+                           knobs.issue_window, knobs.page_walkers, knobs.arch == ECPT,
+                           knobs.mmu_to_l2, knobs.ecpt_parallel_cwc,
+                           knobs.cwt_backfill_overlap, error_string)) {
+        success = false;
+        return;
+    }
+
+    if (!checkpoint_init()) {
+        success = false;
+        return;
+    }
+
+    if (knobs.sample_period > 0 &&
+        (knobs.warmup_refs > 0 || knobs.warmup_fraction > 0.0)) {
+        error_string = "Usage error: -sample_period cannot be combined with "
+                       "-warmup_refs or -warmup_fraction: its functional warming "
+                       "replaces them.";
+        success = false;
+        return;
+    }
+    if (!sampler.init(knobs.sample_period, knobs.sample_window, knobs.sample_warmup,
+                      knobs.sample_skip, knobs.sample_error, knobs.sample_confidence,
+                      error_string)) {
+        success = false;
+        return;
+    }
+
+    if ((knobs.sim_threads > 1 || knobs.epoch_refs > 0) && !epoch_init(tlb_knobs)) {
+        success = false;
+        return;
     }
 }
 
@@ -324,9 +405,28 @@ cache_simulator_t::cache_simulator_t(const std::string &config_file)
     : simulator_t()
     , l1_icaches(NULL)
     , l1_dcaches(NULL)
+    , l2_caches(NULL)
     , pw_caches(NULL)
+    , cwc_caches(NULL)
+    , tlb_sim(NULL)
+    , snoop_filter(NULL)
+    , num_request(0)
+    , num_request_shifted(0)
+    , num_not_found(0)
+    , num_range_found(0)
+    , num_range_not_found(0)
+    , interval_out(NULL)
+    , interval_measuring(false)
+    , interval_index(0)
+    , interval_first_ref(0)
+    , interval_num_refs(0)
+    , interval_num_instrs(0)
     , is_warmed_up(false)
+    , functional_warmup(false)
+    , sample_phase(SAMPLE_DETAILED)
 {
+    memset(ins_fetched, 0, sizeof(ins_fetched));
+
     std::map<std::string, cache_params_t> cache_params;
     config_reader_t config_reader;
     if (!config_reader.configure(config_file, knobs, cache_params)) {
@@ -339,12 +439,15 @@ cache_simulator_t::cache_simulator_t(const std::string &config_file)
     init_knobs(knobs.num_cores, knobs.skip_refs, knobs.warmup_refs, knobs.warmup_fraction,
                knobs.sim_refs, knobs.cpu_scheduling, knobs.verbose);
 
-    if (knobs.data_prefetcher != PREFETCH_POLICY_NEXTLINE &&
-        knobs.data_prefetcher != PREFETCH_POLICY_NONE) {
+    if (!valid_prefetcher(knobs.data_prefetcher)) {
         // Unknown prefetcher type.
         success = false;
         return;
     }
+    if (!init_page_walker()) {
+        success = false;
+        return;
+    }
 
     bool warmup_enabled = ((knobs.warmup_refs > 0) || (knobs.warmup_fraction > 0.0));
 
@@ -412,9 +515,7 @@ cache_simulator_t::cache_simulator_t(const std::string &config_file)
         if (!cache->init((int)cache_config.assoc, (int)knobs.line_size,
                          (int)cache_config.size, parent,
                          new cache_stats_t(cache_config.miss_file, warmup_enabled),
-                         cache_config.prefetcher == PREFETCH_POLICY_NEXTLINE
-                             ? new prefetcher_t((int)knobs.line_size)
-                             : nullptr,
+                         create_prefetcher(cache_config.prefetcher),
                          cache_config.inclusive, children)) {
             error_string = "Usage error: failed to initialize the cache " + cache_name;
             success = false;
@@ -447,6 +548,231 @@ cache_simulator_t::cache_simulator_t(const std::string &config_file)
             other_caches[cache_name] = cache;
         }
     }
+
+    for (auto &caches_it : all_caches)
+        caches_it.second->set_prefetch_late_refs(knobs.prefetch_late_refs);
+
+    if (!init_walk_caches(warmup_enabled)) {
+        success = false;
+        return;
+    }
+}
+
+type_policy_t *
+cache_simulator_t::create_type_policy(bool bypass_leaf)
+{
+    if (knobs.pt_cache_policy == PT_CACHE_POLICY_PARTITION)
+        return new pt_partition_policy_t(knobs.pt_partition_ways, bypass_leaf);
+    if (knobs.pt_cache_policy == PT_CACHE_POLICY_PRIORITY)
+        return new pt_priority_policy_t(knobs.pt_priority_levels, bypass_leaf);
+    return new type_policy_t(bypass_leaf);
+}
+
+// Attaches a type policy to each cache level listed in -pt_policy_caches,
+// and to the L1D caches when leaf page table lines bypass them.
+bool
+cache_simulator_t::init_type_policies()
+{
+    bool on_l1d = false, on_l2 = false, on_llc = false;
+    if (!knobs.pt_cache_policy.empty()) {
+        if (knobs.pt_cache_policy != PT_CACHE_POLICY_SHARE &&
+            knobs.pt_cache_policy != PT_CACHE_POLICY_PARTITION &&
+            knobs.pt_cache_policy != PT_CACHE_POLICY_PRIORITY) {
+            error_string = "Usage error: -pt_cache_policy must be " PT_CACHE_POLICY_SHARE
+                           ", " PT_CACHE_POLICY_PARTITION " or " PT_CACHE_POLICY_PRIORITY ".";
+            return false;
+        }
+        if (knobs.pt_cache_policy == PT_CACHE_POLICY_PRIORITY &&
+            (knobs.pt_priority_levels == 0 || knobs.pt_priority_levels > 4)) {
+            error_string = "Usage error: -pt_priority_levels must be 1 to 4.";
+            return false;
+        }
+        std::stringstream levels(knobs.pt_policy_caches);
+        std::string level;
+        while (std::getline(levels, level, ',')) {
+            if (level == "L1D")
+                on_l1d = true;
+            else if (level == "L2")
+                on_l2 = true;
+            else if (level == "LLC")
+                on_llc = true;
+            else {
+                error_string = "Usage error: unknown cache '" + level +
+                    "' in -pt_policy_caches.  Choose from L1D, L2 and LLC.";
+                return false;
+            }
+        }
+    }
+    if (knobs.pt_bypass_l1 && knobs.mmu_to_l2) {
+        error_string = "Usage error: -pt_bypass_l1 has no effect with -mmu_to_l2.";
+        return false;
+    }
+    std::vector<std::pair<cache_t *, type_policy_t *>> attach;
+    if (on_llc)
+        attach.push_back(std::make_pair(llc1, create_type_policy(false)));
+    for (unsigned int i = 0; i < knobs.num_cores; i++) {
+        if (on_l2)
+            attach.push_back(std::make_pair(l2_caches[i], create_type_policy(false)));
+        if (on_l1d || knobs.pt_bypass_l1) {
+            type_policy_t *policy = on_l1d ? create_type_policy(knobs.pt_bypass_l1)
+                                           : new type_policy_t(true);
+            attach.push_back(std::make_pair(l1_dcaches[i], policy));
+        }
+    }
+    bool ok = true;
+    for (auto &it : attach) {
+        if (ok && !it.first->set_type_policy(it.second)) {
+            error_string = "Usage error: -pt_partition_ways must leave at least one way "
+                           "to both page table and other lines in each cache of "
+                           "-pt_policy_caches.";
+            ok = false;
+        }
+        if (it.first->get_type_policy() != it.second)
+            delete it.second;
+    }
+    return ok;
+}
+
+// Creates the per-core page walk caches for radix or cuckoo walk caches for
+// ECPT, sized by the walk cache knobs.
+bool
+cache_simulator_t::init_walk_caches(bool warmup_enabled)
+{
+    if (knobs.arch == RADIX) {
+        // Each core has its own PWCs: core c's level i PWC is
+        // pw_caches[c * NUM_PWC + i].
+        pw_caches = new cache_t *[knobs.num_cores * NUM_PWC];
+        // A level whose -PWC_* entries or assoc is left at 0 takes the value of
+        // the preset picked by -pwc_asplos_config, and an empty replacement
+        // policy the -replace_policy one.
+        const unsigned int *preset_assoc =
+            knobs.pwc_asplos_config ? PWC_ASSOC_ASPLOS_CONFIG : PWC_ASSOC_ARM;
+        const unsigned int *preset_size =
+            knobs.pwc_asplos_config ? PWC_SIZE_ASPLOS_CONFIG : PWC_SIZE_ARM;
+        const unsigned int knob_entries[NUM_PWC] = { knobs.PWC_PGD_entries,
+                                                     knobs.PWC_PUD_entries,
+                                                     knobs.PWC_PMD_entries };
+        const unsigned int knob_assoc[NUM_PWC] = { knobs.PWC_PGD_assoc,
+                                                   knobs.PWC_PUD_assoc,
+                                                   knobs.PWC_PMD_assoc };
+        const std::string knob_replace[NUM_PWC] = { knobs.PWC_PGD_replace,
+                                                    knobs.PWC_PUD_replace,
+                                                    knobs.PWC_PMD_replace };
+        unsigned int PWC_ASSOC[NUM_PWC];
+        unsigned int PWC_SIZE[NUM_PWC];
+        std::string PWC_REPLACE[NUM_PWC];
+        for (unsigned int i = 0; i < NUM_PWC; i++) {
+            PWC_ASSOC[i] = knob_assoc[i] != 0 ? knob_assoc[i] : preset_assoc[i];
+            PWC_SIZE[i] =
+                knob_entries[i] != 0 ? PWC_ENTRY_SIZE * knob_entries[i] : preset_size[i];
+            PWC_REPLACE[i] = level_replace_policy(knob_replace[i]);
+        }
+
+        for (unsigned int j = 0; j < knobs.num_cores * NUM_PWC; j++) {
+            unsigned int i = j % NUM_PWC;
+            pw_caches[j] = create_cache(PWC_REPLACE[i]);
+            if (pw_caches[j] == NULL) {
+                return false;
+            }
+
+            if (j < NUM_PWC) {
+                std::cerr << "Initialising PW cache with size: " << PWC_SIZE[i]
+                          << " with assoc: " << PWC_ASSOC[i]
+                          << " with line size: " << knobs.line_size << std::endl;
+            }
+
+            if (!pw_caches[j]->init (PWC_ASSOC[i], PWC_ENTRY_SIZE,
+                                    PWC_SIZE[i], NULL,
+                                    new cache_stats_t("", warmup_enabled))) {
+                error_string = "Usage error: failed to initialize PW caches.  Ensure the "
+                               "-PWC_* entries and associativity are powers of 2 and "
+                               "that the entries are a multiple of the associativity.";
+                return false;
+            }
+        }
+    }
+
+    if (knobs.arch == ECPT) {
+        if (knobs.ECPT_4K_ways == 0) {
+            error_string = "Usage error: -ECPT_4K_ways must be at least 1.";
+            return false;
+        }
+        // The trace records one step per ECPT way, 4KB ways first.
+        if (knobs.ECPT_4K_ways + knobs.ECPT_2M_ways + knobs.ECPT_1G_ways >
+            ECPT_TABLE_LEAVES) {
+            error_string = "Usage error: -ECPT_4K_ways, -ECPT_2M_ways and -ECPT_1G_ways "
+                           "add up to more ECPT steps than a trace record holds (" +
+                std::to_string(ECPT_TABLE_LEAVES) + ").";
+            return false;
+        }
+        // The trace records the CWT entries of the 2MB ways then of the 1GB ones.
+        if (knobs.CWT_2M_ways + knobs.CWT_1G_ways > MAX_AUX_INFO) {
+            error_string = "Usage error: -CWT_2M_ways and -CWT_1G_ways add up to more "
+                           "CWT steps than a trace record holds (" +
+                std::to_string(MAX_AUX_INFO) + ").";
+            return false;
+        }
+
+        // Per-core CWCs, laid out like pw_caches.
+        cwc_caches = new cache_t *[knobs.num_cores * NUM_CWC];
+        const unsigned int CWC_ASSOC[NUM_CWC] = { knobs.CWC_PUD_assoc,
+                                                  knobs.CWC_PMD_assoc };
+        const unsigned int CWC_SIZE[NUM_CWC] = { CWC_ENTRY_SIZE * knobs.CWC_PUD_entries,
+                                                 CWC_ENTRY_SIZE * knobs.CWC_PMD_entries };
+        const std::string CWC_REPLACE[NUM_CWC] = {
+            level_replace_policy(knobs.CWC_PUD_replace),
+            level_replace_policy(knobs.CWC_PMD_replace)
+        };
+
+        for (unsigned int j = 0; j < knobs.num_cores * NUM_CWC; j++) {
+            unsigned int i = j % NUM_CWC;
+            cwc_caches[j] = create_cache(CWC_REPLACE[i]);
+            if (cwc_caches[j] == NULL) {
+                return false;
+            }
+
+            if (j < NUM_CWC) {
+                std::cerr << "Initialising CWC cache with size: " << CWC_SIZE[i]
+                          << " with assoc: " << CWC_ASSOC[i] << std::endl;
+            }
+
+            if (!cwc_caches[j]->init (CWC_ASSOC[i], CWC_ENTRY_SIZE,
+                                    CWC_SIZE[i], NULL,
+                                    new cache_stats_t("", warmup_enabled))) {
+                error_string = "Usage error: failed to initialize CW caches.  Ensure the "
+                               "-CWC_* entries and associativity are powers of 2 and "
+                               "that the entries are a multiple of the associativity.";
+                return false;
+            }
+        }
+    }
+    if (knobs.miss_ratio_curves)
+        return init_walk_curves();
+    return true;
+}
+
+bool
+cache_simulator_t::init_walk_curves()
+{
+    unsigned int levels = knobs.arch == RADIX ? NUM_PWC : NUM_CWC;
+    cache_t **caches = knobs.arch == RADIX ? pw_caches : cwc_caches;
+    for (unsigned int i = 0; i < levels; i++) {
+        std::vector<unsigned int> assocs;
+        if (!miss_ratio_curve_t::parse_assocs(knobs.mrc_assocs,
+                                              caches[i]->get_associativity(),
+                                              knobs.mrc_max_entries, assocs,
+                                              error_string))
+            return false;
+        for (unsigned int c = 0; c < knobs.num_cores; c++) {
+            miss_ratio_curve_t *curve = new miss_ratio_curve_t;
+            walk_curves.push_back(curve);
+            if (!curve->init(knobs.mrc_max_entries, assocs, knobs.mrc_sample_sets,
+                             error_string))
+                return false;
+            caches[c * levels + i]->set_miss_ratio_curve(curve);
+        }
+    }
+    return true;
 }
 
 cache_simulator_t::~cache_simulator_t()
@@ -455,6 +781,7 @@ cache_simulator_t::~cache_simulator_t()
         cache_t *cache = caches_it.second;
         delete cache->get_stats();
         delete cache->get_prefetcher();
+        delete cache->get_type_policy();
         delete cache;
     }
 
@@ -473,6 +800,14 @@ cache_simulator_t::~cache_simulator_t()
     if (cwc_caches != NULL) {
         delete[] cwc_caches;
     }
+    delete tlb_sim;
+    delete snoop_filter;
+    for (miss_ratio_curve_t *curve : walk_curves)
+        delete curve;
+    if (interval_out != NULL)
+        fclose(interval_out);
+    for (auto proxy : llc_proxies)
+        delete proxy;
 }
 
 uint64_t
@@ -481,26 +816,57 @@ cache_simulator_t::remaining_sim_refs() const
     return knobs.sim_refs;
 }
 
-static uint64_t num_request = 0;
-static uint64_t num_not_found = 0;
-static uint64_t num_request_shifted = 0;
-
-static uint64_t num_range_found = 0;
-static uint64_t num_range_not_found = 0;
+// Sets up the interference of -contention_L1 and -contention_LLC.
+bool
+cache_simulator_t::init_interference()
+{
+    if (!interference.init(knobs.interference_source, knobs.interference_trace, knobs.arch,
+                           knobs.interference_working_set, knobs.interference_stride,
+                           knobs.interference_seed, error_string))
+        return false;
+    llc1->track_interference();
+    for (unsigned int i = 0; i < knobs.num_cores; i++) {
+        l1_dcaches[i]->track_interference();
+        l2_caches[i]->track_interference();
+    }
+    return true;
+}
 
-cache_result_t issue_contention_request(cache_t* to_cache, trace_type_t type) {
-  addr_t raddr = rand() & ((1L << (NUM_PAGE_TABLE_LEVELS * NUM_PAGE_OFFSET_BITS)) - 1); //Generate a random addess
-  memref_t cont_req_memref; 
-  cont_req_memref.data.type = type;
-  cont_req_memref.data.addr = raddr;
-  cont_req_memref.data.size = 1; //Set size 1 byte
-  cache_result_t res = to_cache->request(cont_req_memref);
-  return res;
+// Injects the requests of the co-runner after a reference of core that
+// search_res served: into the core's L1D at -contention_L1 and, if the
+// reference reached the LLC, into the LLC at -contention_LLC.  Both rates are
+// in hundredths of a request per reference.
+void
+cache_simulator_t::inject_interference(int core, cache_result_t search_res)
+{
+    if (knobs.contention_L1 == 0 && knobs.contention_LLC == 0)
+        return;
+    memref_t req;
+    memset(&req, 0, sizeof(req));
+    req.data.size = 1;
+    unsigned int num = interference.num_requests(knobs.contention_L1);
+    for (unsigned int i = 0; i < num; i++) {
+        req.data.type = TRACE_TYPE_CONT_L1;
+        req.data.addr = interference.next_addr();
+        cache_result_t res = l1_dcaches[core]->request(req);
+        if (knobs.verbose >= 2)
+            std::cerr << "Contention L1: res" << res << std::endl;
+    }
+    if (knobs.contention_LLC == 0 || (search_res != FOUND_LLC && search_res != NOT_FOUND))
+        return;
+    num = interference.num_requests(knobs.contention_LLC);
+    for (unsigned int i = 0; i < num; i++) {
+        req.data.type = TRACE_TYPE_CONT_LLC;
+        req.data.addr = interference.next_addr();
+        cache_result_t res = llc1->request(req);
+        if (knobs.verbose >= 2)
+            std::cerr << "Contention LLC: res" << res << std::endl;
+    }
 }
 
 void cache_simulator_t::print_page_walk_res(page_walk_hm_result_t & page_walk_res, int pwc_hit_level, int pgwalk_steps) 
 {
-    std::vector<std::string> page_walk_res_str {
+    static const std::vector<std::string> page_walk_res_str {
         "MEMORY"
         , "L1"
         , "L2"
@@ -524,7 +890,7 @@ void cache_simulator_t::print_page_walk_res(page_walk_hm_result_t & page_walk_re
 }
 void cache_simulator_t::print_page_walk_res_ecpt(page_walk_hm_result_t & page_walk_res, std::set<uint32_t> & ways_to_visit) 
 {
-    std::vector<std::string> page_walk_res_str {
+    static const std::vector<std::string> page_walk_res_str {
         "MEMORY"
         , "L1"
         , "L2"
@@ -553,7 +919,7 @@ void cache_simulator_t::print_page_walk_res_ecpt(page_walk_hm_result_t & page_wa
 
 
 void cache_simulator_t::print_page_walk_stats(page_walk_hm_result_t & page_walk_res) {
-    std::vector<std::string> page_walk_res_str {
+    static const std::vector<std::string> page_walk_res_str {
         "MEMORY"
         , "L1"
         , "L2"
@@ -634,11 +1000,12 @@ void cache_simulator_t::stats_memref(const memref_t &memref) {
 
 #define VIRTUAL_ADDR_MASK (0x0000fffffffff000ULL)
 unsigned int
-cache_simulator_t::visit_pwc(uint64_t full_vaddr, uint64_t pgwalk_steps)
+cache_simulator_t::visit_pwc(uint64_t full_vaddr, uint64_t pgwalk_steps, int core)
 {
     cache_result_t pwc_search_res = NOT_FOUND;
     unsigned int pwc_hit_level = 0;
     memref_t pwc_check_memref;
+    memset(&pwc_check_memref, 0, sizeof(pwc_check_memref));
     pwc_check_memref.data.type = TRACE_TYPE_READ;
 
     /**
@@ -663,7 +1030,7 @@ cache_simulator_t::visit_pwc(uint64_t full_vaddr, uint64_t pgwalk_steps)
              ((NUM_PAGE_TABLE_LEVELS - pwc_level) * NUM_PAGE_INDEX_BITS));
         pwc_check_memref.data.size = 1;
                 
-        pwc_search_res = pw_caches[pwc_level - 1]->request(pwc_check_memref);
+        pwc_search_res = pw_caches[core * NUM_PWC + pwc_level - 1]->request(pwc_check_memref);
         
         // if found, memorize the pwc_level and stop searching
         if (knobs.verbose >= 2) {
@@ -684,25 +1051,67 @@ cache_simulator_t::visit_pwc(uint64_t full_vaddr, uint64_t pgwalk_steps)
 bool
 cache_simulator_t::process_memref(const memref_t &memref)
 {
-    if (knobs.arch == RADIX) {
-        return this->process_memref_radix(memref);
-    } else if (knobs.arch == ECPT) {
-        return this->process_memref_ecpt(memref);
-    } else {
-        std::cerr << "Unknown architecture " << knobs.arch << std::endl;
+    return (this->*process_fn)(memref);
+}
+
+template <typename walker_t>
+bool
+cache_simulator_t::process_translation(const memref_t &memref)
+{
+    sim_ref_t ref;
+    if (!schedule_memref(memref, ref))
         return false;
+    if (ref.simulate && ref.perf_res.cached_ifb) {
+        record_memref(ref);
+    } else if (ref.simulate && !llc_proxies.empty() &&
+               (type_is_instr(memref.instr.type) ||
+                memref.instr.type == TRACE_TYPE_PREFETCH_INSTR ||
+                memref.data.type == TRACE_TYPE_READ ||
+                memref.data.type == TRACE_TYPE_WRITE ||
+                type_is_prefetch(memref.data.type))) {
+        epoch_core_refs[ref.core].push_back((uint32_t)epoch_refs.size());
+        epoch_refs.push_back(ref);
+        retire_memref(ref);
+        if (epoch_refs.size() >= knobs.epoch_refs)
+            drain_epoch();
+    } else if (ref.simulate) {
+        // Anything else, such as a flush, may touch shared state: it is
+        // simulated on its own after the pending references.
+        drain_epoch();
+        if (!simulate_translation<walker_t>(ref))
+            return false;
+        record_memref(ref);
+        retire_memref(ref);
+    }
+    if (interval_out != NULL)
+        interval_memref(memref);
+    if (sampler.window_complete()) {
+        // The window's references are all counted before it is closed.
+        drain_epoch();
+        if (sampler.end_window() && knobs.verbose >= 0) {
+            std::cerr << "Sampling error bound met after reference " << num_request
+                      << std::endl;
+        }
     }
+    return true;
 }
 
+// The in-order part of simulating a reference: skipping, warmup and
+// simulation counts, core assignment, the instruction fetch buffer and the
+// TLB simulator's own bookkeeping.  Sets ref.simulate if the reference is to
+// be simulated by simulate_memref().
 bool
-cache_simulator_t::process_memref_radix(const memref_t &memref)
+cache_simulator_t::schedule_memref(const memref_t &memref, sim_ref_t &ref)
 {
+    ref.simulate = false;
     num_request++;
     num_request_shifted++;
 
     if ((num_request_shifted >> SIMULATOR_HEARTBEAT_FREQ) > 0) {
       num_request_shifted = 0;
-      std::cerr << "Heartbeat. " << num_request << " references processed.\n";
+      std::cerr << "Heartbeat. " << knobs.config_name
+                << (knobs.config_name.empty() ? "" : ": ") << num_request
+                << " references processed.\n";
     //   print_results();
     }
 
@@ -732,6 +1141,14 @@ cache_simulator_t::process_memref_radix(const memref_t &memref)
         return true;
     }
 
+    // Sampling drops the skipped references and, once the error bound is met,
+    // all the others.
+    if (sampler.enabled()) {
+        sample_phase = sampler.next();
+        if (sample_phase == SAMPLE_SKIP || sample_phase == SAMPLE_DONE)
+            return true;
+    }
+
     // Both warmup and simulated references are simulated.
 
     if (!simulator_t::process_memref(memref)) {
@@ -754,11 +1171,14 @@ cache_simulator_t::process_memref_radix(const memref_t &memref)
         return true;
     }
     
-    print_memref(memref);
-    stats_memref(memref);
-    // We use a static scheduling of threads to cores, as it is
-    // not practical to measure which core each thread actually
-    // ran on for each memref.
+    // Functional warmup only updates cache, TLB and PWC state.
+    functional_warmup = in_functional_warmup();
+    if (!functional_warmup) {
+        print_memref(memref);
+        stats_memref(memref);
+    }
+    // Threads are statically scheduled to cores, or for QEMU traces each
+    // reference runs on the core of the CPU that issued it.
     int core;
 
     if (knobs.verbose >= 3) {
@@ -766,67 +1186,49 @@ cache_simulator_t::process_memref_radix(const memref_t &memref)
         std::cerr << "last_core " << last_core << "\n";
     }
 
-    if (memref.data.tid == last_thread)
-        core = last_core;
-    else {
-        core = core_for_thread(memref.data.tid);
-        last_thread = memref.data.tid;
-        last_core = core;
-    }
+    core = core_for_memref(memref);
 
     if (knobs.verbose >= 3) {
         std::cerr << "core "<< core << "\n";
     }
     
-    perf_result_t perf_res = {0};
+    ref.memref = memref;
+    ref.core = core;
+    ref.functional_warmup = functional_warmup;
+    ref.sampled = sampler.enabled() && sample_phase == SAMPLE_MEASURE;
+    ref.walked = false;
+    ref.record = false;
+    ref.backfill_cycles = 0;
+
+    perf_result_t &perf_res = ref.perf_res;
+    perf_res = {0};
     perf_res.core = core;
 
-    uint64_t addr;
-
-    uint64_t virtual_page_addr = 0;
-    uint64_t page_offset = 0;
-    uint64_t instrs_type = 0;
-
+    _memref_pgtable_results *pgtable_results = NULL;
+    addr_t vaddr = 0;
     if (type_is_instr(memref.instr.type) || memref.instr.type == TRACE_TYPE_PREFETCH_INSTR) {
-      addr              = memref.instr.addr;
-      virtual_page_addr = memref.instr.addr >> NUM_PAGE_OFFSET_BITS;
-      page_offset       = memref.instr.addr & ((1 << NUM_PAGE_OFFSET_BITS) - 1);
-      instrs_type       = 1;
-      perf_res.is_inst = 1;
-    } else if (memref.data.type == TRACE_TYPE_READ || memref.data.type == TRACE_TYPE_WRITE || type_is_prefetch(memref.data.type)) {
-      addr              = memref.data.addr;
-      virtual_page_addr = memref.data.addr >> NUM_PAGE_OFFSET_BITS;
-      page_offset       = memref.data.addr & ((1 << NUM_PAGE_OFFSET_BITS) - 1);
-      instrs_type       = 2;
-      perf_res.is_inst = 0;
+        pgtable_results = &ref.memref.instr.pgtable_results;
+        vaddr = memref.instr.addr;
+        perf_res.is_inst = 1;
+    } else if (memref.data.type == TRACE_TYPE_READ || memref.data.type == TRACE_TYPE_WRITE ||
+               type_is_prefetch(memref.data.type)) {
+        pgtable_results = &ref.memref.data.pgtable_results;
+        vaddr = memref.data.addr;
+    } else if (memref.flush.type == TRACE_TYPE_INSTR_FLUSH ||
+               memref.flush.type == TRACE_TYPE_DATA_FLUSH) {
+        pgtable_results = &ref.memref.flush.pgtable_results;
+        vaddr = memref.flush.addr;
+    }
+    ref.walk_success = false;
+    if (pgtable_results != NULL) {
+        // The built page tables replace the walk the trace recorded.
+        if (page_tables.enabled())
+            page_tables.translate(memref.data.pid, vaddr, *pgtable_results);
+        ref.walk_success = pgtable_results->success;
+        perf_res.is_non_memory_exec = pgtable_results->is_non_memory;
     }
 
-    /* virtual_full_page_addr is the virtual address without page offset */
-    uint64_t virtual_full_page_addr = virtual_page_addr << NUM_PAGE_OFFSET_BITS;
-
-    
-
-    memref_t new_memref; 
-    new_memref = memref;
-    new_memref.marker.type = memref.marker.type;
-    new_memref.marker.pid = memref.marker.pid;
-    new_memref.marker.tid = memref.marker.tid;
-    // page_table_t::iterator it = page_table.find(virtual_full_page_addr);
-    // if found 
-    // if (it != page_table.end()) {
-      
-    /* TODO: now we don't have to process page table dump */
-    uint64_t pgwalk_steps = 0;
-    int walk_success = 0;
-
-
-    if (type_is_instr(memref.instr.type) || memref.instr.type == TRACE_TYPE_PREFETCH_INSTR) {
-        // new_memref.instr.addr = physical_page_addr + page_offset;
-        new_memref.instr.addr = memref.instr.pgtable_results.paddr;
-        pgwalk_steps = memref.instr.pgtable_results.num_steps;
-        walk_success = memref.instr.pgtable_results.success;
-        perf_res.is_non_memory_exec = memref.instr.pgtable_results.is_non_memory;
-
+    if (perf_res.is_inst) {
         uint64_t ins_line = memref.instr.addr & FRONTEND_FETCH_MASK;
 
         if (knobs.verbose >= 2) {
@@ -838,100 +1240,267 @@ cache_simulator_t::process_memref_radix(const memref_t &memref)
             perf_res.cached_ifb = 1;
             perf_res.tlb_hit = 0;
             perf_res.data_cache = ZERO;
+            ref.record = true;
+            ref.simulate = true;
 
             if (knobs.verbose >= 2) {
                 std::cerr << "perf_res.cached_ifb " << perf_res.cached_ifb << "\n";
             }
-
-            if (IN_SET(this->perf_to_cnt, perf_res)) {
-                this->perf_to_cnt[perf_res]++;
-            } else {
-                this->perf_to_cnt[perf_res] = 1;
-            }
-
             return true;
         }
-        
+
         if (knobs.verbose >= 2) {
             std::cerr << "perf_res.cached_ifb " << perf_res.cached_ifb << "\n";
         }
 
         ins_fetched[core] = ins_line;
-
-    } else if (memref.data.type == TRACE_TYPE_READ || memref.data.type == TRACE_TYPE_WRITE || type_is_prefetch(memref.data.type)) {
-        // new_memref.data.addr  = physical_page_addr + page_offset;
-        new_memref.data.addr = memref.data.pgtable_results.paddr;
-        pgwalk_steps = memref.data.pgtable_results.num_steps;
-        walk_success = memref.data.pgtable_results.success;
-        perf_res.is_non_memory_exec = memref.data.pgtable_results.is_non_memory;
-    } else if (memref.flush.type == TRACE_TYPE_INSTR_FLUSH || memref.flush.type == TRACE_TYPE_DATA_FLUSH) {
-        pgwalk_steps = memref.flush.pgtable_results.num_steps;
-        walk_success = memref.flush.pgtable_results.success;
-        perf_res.is_non_memory_exec = memref.flush.pgtable_results.is_non_memory;
     }
 
     // issue a TLB request will also refill the TLB
     // we only refill it when the page walk is successful
-    bool is_TLB_hit = false;
-    if (walk_success) {
-        std::pair<bool, bool> res = tlb_sim->process_memref_tlb(memref);
-        is_TLB_hit = res.second;
-        if (knobs.verbose >= 2) {
-            std::cerr << __FUNCTION__ << " Received TLB result: " << is_TLB_hit << std::endl;
+    // References without a walk, such as a thread exit, and references the TLB
+    // simulator does not simulate count as hits.
+    ref.tlb_core = -1;
+    ref.tlb_hit = true;
+    ref.tlb_warmup_done = false;
+    if (ref.walk_success) {
+        if (!tlb_sim->schedule_memref_tlb(memref, &ref.tlb_core, &ref.tlb_warmup_done))
+            ref.tlb_core = -1;
+    }
+    ref.simulate = true;
+    return true;
+}
+
+// The size of the page a radix walk of pgwalk_steps levels maps: a walk ends
+// at the PMD for a 2MB page and at the PUD for a 1GB one.
+static tlb_page_size_t
+radix_walk_page_size(uint64_t pgwalk_steps)
+{
+    if (pgwalk_steps == NUM_PAGE_TABLE_LEVELS - 1)
+        return TLB_PAGE_2MB;
+    if (pgwalk_steps == NUM_PAGE_TABLE_LEVELS - 2)
+        return TLB_PAGE_1GB;
+    return TLB_PAGE_4KB;
+}
+
+// The sequential TLB prefetcher: when a data access moves on to the page
+// after one of the last TLB_PREFETCH_HISTORY pages the core accessed, the
+// translation of the page after it is prefetched into the L2 TLB.  If it was
+// missing, its walk only reads the leaf entry, which is the next one in the
+// current walk's leaf page table page: the upper levels are the current
+// walk's.  When that entry would be in another page table page its address is
+// unknown, and nothing is prefetched.
+void
+cache_simulator_t::prefetch_next_translation(const memref_t &memref,
+                                             const addr_t *walk_steps,
+                                             uint64_t pgwalk_steps, int tlb_core, int core)
+{
+    addr_t page = memref.data.addr >> NUM_PAGE_OFFSET_BITS;
+    addr_t *history = &tlb_prefetch_pages[core * TLB_PREFETCH_HISTORY];
+    bool sequential = false;
+    for (int i = 0; i < TLB_PREFETCH_HISTORY; i++) {
+        if (history[i] == page)
+            return;
+        if (history[i] + 1 == page)
+            sequential = true;
+    }
+    for (int i = TLB_PREFETCH_HISTORY - 1; i > 0; i--)
+        history[i] = history[i - 1];
+    history[0] = page;
+    // Only 4KB pages, which take a full walk.
+    if (!sequential || pgwalk_steps != NUM_PAGE_TABLE_LEVELS)
+        return;
+    addr_t leaf = walk_steps[NUM_PAGE_TABLE_LEVELS - 1];
+    addr_t next_leaf = leaf + sizeof(uint64_t);
+    if ((next_leaf >> NUM_PAGE_OFFSET_BITS) != (leaf >> NUM_PAGE_OFFSET_BITS))
+        return;
+    memref_t prefetch = memref;
+    prefetch.data.type = TRACE_TYPE_HARDWARE_PREFETCH;
+    prefetch.data.addr = (page + 1) << NUM_PAGE_OFFSET_BITS;
+    prefetch.data.size = 1;
+    if (!tlb_sim->prefetch_tlb(prefetch, tlb_core))
+        return;
+    memref_t walk_memref;
+    memset(&walk_memref, 0, sizeof(walk_memref));
+    walk_memref.data.type = TRACE_TYPE_HARDWARE_PREFETCH;
+    walk_memref.data.addr = next_leaf;
+    walk_memref.data.size = 1;
+    if (knobs.mmu_to_l2)
+        l2_caches[core]->request(walk_memref);
+    else
+        l1_dcaches[core]->request(walk_memref);
+}
+
+void
+cache_simulator_t::record_pte_mappings(addr_t vaddr, const addr_t *walk_steps,
+                                       uint64_t pgwalk_steps)
+{
+    for (unsigned int level = 1; level <= pgwalk_steps; level++) {
+        int span_bits =
+            NUM_PAGE_OFFSET_BITS + (NUM_PAGE_TABLE_LEVELS - level) * NUM_PAGE_INDEX_BITS;
+        pte_mappings[walk_steps[level - 1] & ~(addr_t)(sizeof(uint64_t) - 1)] =
+            pte_mapping_t { vaddr & ~(((addr_t)1 << span_bits) - 1), level };
+    }
+}
+
+// A write to a page table entry a walk read changes the translation of every
+// address it maps.  As the kernel would, every core drops the TLB entries for
+// them and the page walk cache entries at its level and below; the next
+// access to them walks again.  The entry is assumed to still map the same
+// addresses afterwards, as only its contents change.
+void
+cache_simulator_t::check_pte_write(const memref_t &memref)
+{
+    addr_t first = memref.data.addr & ~(addr_t)(sizeof(uint64_t) - 1);
+    for (addr_t entry = first; entry < memref.data.addr + memref.data.size;
+         entry += sizeof(uint64_t)) {
+        auto it = pte_mappings.find(entry);
+        if (it == pte_mappings.end())
+            continue;
+        const pte_mapping_t &mapping = it->second;
+        int span_bits = NUM_PAGE_OFFSET_BITS +
+            (NUM_PAGE_TABLE_LEVELS - mapping.level) * NUM_PAGE_INDEX_BITS;
+        addr_t start = mapping.vaddr;
+        addr_t end = start + ((addr_t)1 << span_bits) - 1;
+        shootdown_stats.pte_writes++;
+        shootdown_stats.tlb_entries += tlb_sim->shootdown(start, end);
+        for (unsigned int c = 0; c < knobs.num_cores; c++) {
+            for (unsigned int pwc_level = mapping.level; pwc_level <= NUM_PWC; pwc_level++) {
+                int shift = NUM_PAGE_OFFSET_BITS +
+                    (NUM_PAGE_TABLE_LEVELS - pwc_level) * NUM_PAGE_INDEX_BITS;
+                shootdown_stats.pwc_entries +=
+                    pw_caches[c * NUM_PWC + pwc_level - 1]->invalidate_range(
+                        (start & VIRTUAL_ADDR_MASK) >> shift,
+                        (end & VIRTUAL_ADDR_MASK) >> shift, INVALIDATION_COHERENCE);
+            }
         }
     }
+}
 
-    perf_res.tlb_hit = is_TLB_hit;
-    // process TLB miss
-    if (!is_TLB_hit) {
-      if (knobs.verbose >= 2) {
-        std::cerr << "TLB miss \n";
-      }
-          
-      // reset page walk trajectory path 
-      page_walk_res.clear();// Accumulates sources for each access during a page walk
+tlb_page_size_t
+radix_walker_t::page_size(const sim_ref_t &ref, addr_t vpage,
+                          const _memref_pgtable_results &results)
+{
+    return radix_walk_page_size(results.num_steps);
+}
 
-      // BEGIN PAGE WALK
-      // PT levels are counted from the root of the radix tree
-      //  Check PWCs
-      /* get pwc hit level */
-      unsigned int pwc_hit_level = visit_pwc(virtual_full_page_addr, pgwalk_steps);
+void
+radix_walker_t::walk(sim_ref_t &ref, addr_t vpage, const _memref_pgtable_results &results)
+{
+    int core = ref.core;
+    uint64_t pgwalk_steps = results.num_steps;
+    const addr_t *walk_steps = results.steps;
 
-      for (unsigned int level_host = 1; level_host <= NUM_PAGE_TABLE_LEVELS; level_host++) {
-        if (level_host < pwc_hit_level) {
-          // ignore these levels as they are bypassed due to PWC hit
-          // if skipped due to a PWC hit, indicate ZERO_LAT
-          page_walk_res.push_back(ZERO);
+    // Accumulates sources for each access during a page walk
+    page_walk_hm_result_t page_walk_res;
 
-        } else if (level_host == pwc_hit_level) {
-          // if found in the PWC, indicate PWC_LAT
-          page_walk_res.push_back(PWC);
+    // BEGIN PAGE WALK
+    // PT levels are counted from the root of the radix tree
+    //  Check PWCs
+    /* get pwc hit level */
+    unsigned int pwc_hit_level = sim.visit_pwc(vpage, pgwalk_steps, core);
 
-        } else if (level_host > pwc_hit_level) {
-          // if not found in the PWC, then make a memory req
-          if (level_host <= pgwalk_steps) {
-            make_request(page_walk_res, TRACE_TYPE[level_host], memref.data.pgtable_results.steps[level_host - 1], core);
-          } else {
-            /* huge page last level skipped */
+    for (unsigned int level_host = 1; level_host <= NUM_PAGE_TABLE_LEVELS; level_host++) {
+        if (level_host < pwc_hit_level) {
+            // ignore these levels as they are bypassed due to PWC hit
+            // if skipped due to a PWC hit, indicate ZERO_LAT
             page_walk_res.push_back(ZERO);
-          }
+        } else if (level_host == pwc_hit_level) {
+            // if found in the PWC, indicate PWC_LAT
+            page_walk_res.push_back(PWC);
+        } else if (level_host > pwc_hit_level) {
+            // if not found in the PWC, then make a memory req
+            if (level_host <= pgwalk_steps) {
+                sim.make_request(page_walk_res, TRACE_TYPE[level_host],
+                                 walk_steps[level_host - 1], core);
+            } else {
+                /* huge page last level skipped */
+                page_walk_res.push_back(ZERO);
+            }
         }
-      }
-
-       print_page_walk_res(page_walk_res, pwc_hit_level, pgwalk_steps);
-        perf_res.pgwalk_res = page_walk_res;
-
-      // Update page walk trajectory statistics
-      hm_full_statistic_t::iterator it = hm_full_statistic.find(page_walk_res);
-      if (it != hm_full_statistic.end()) {
-        it->second++;
-      } else {
-        hm_full_statistic.insert(std::make_pair(page_walk_res, 1));
-      }
     }
 
-    /* search result for data paddr */
-    cache_result_t search_res;
+    sim.print_page_walk_res(page_walk_res, pwc_hit_level, pgwalk_steps);
+    ref.perf_res.pgwalk_res = page_walk_res;
+    if (sim.knobs.pte_write_shootdown && results.success)
+        sim.record_pte_mappings(vpage, walk_steps, pgwalk_steps);
+}
+
+uint64_t
+radix_walker_t::walk_cycles(const cache_simulator_t &sim, const perf_result_t &perf_res,
+                            uint64_t finish_cycles)
+{
+    return sim.walk_latency.radix_walk(perf_res.pgwalk_res);
+}
+
+// The walk of the references without one.
+static _memref_pgtable_results no_pgtable_results;
+
+// Simulates a reference: its TLB lookup, walker_t's walk on a miss and its
+// access to the caches.
+template <typename walker_t>
+bool
+cache_simulator_t::simulate_translation(sim_ref_t &ref)
+{
+    const memref_t &memref = ref.memref;
+    int core = ref.core;
+    perf_result_t &perf_res = ref.perf_res;
+    walker_t walker(*this);
+
+    uint64_t virtual_page_addr = 0;
+    memref_t new_memref = memref;
+    // The walk is at a different offset in memref.instr than in memref.data.
+    const _memref_pgtable_results *pgtable_results = &no_pgtable_results;
+    if (type_is_instr(memref.instr.type) || memref.instr.type == TRACE_TYPE_PREFETCH_INSTR) {
+        virtual_page_addr = memref.instr.addr >> NUM_PAGE_OFFSET_BITS;
+        pgtable_results = &memref.instr.pgtable_results;
+        new_memref.instr.addr = pgtable_results->paddr;
+    } else if (memref.data.type == TRACE_TYPE_READ || memref.data.type == TRACE_TYPE_WRITE ||
+               type_is_prefetch(memref.data.type)) {
+        virtual_page_addr = memref.data.addr >> NUM_PAGE_OFFSET_BITS;
+        pgtable_results = &memref.data.pgtable_results;
+        new_memref.data.addr = pgtable_results->paddr;
+    } else if (memref.flush.type == TRACE_TYPE_INSTR_FLUSH ||
+               memref.flush.type == TRACE_TYPE_DATA_FLUSH) {
+        pgtable_results = &memref.flush.pgtable_results;
+    }
+    /* virtual_full_page_addr is the virtual address without page offset */
+    uint64_t virtual_full_page_addr = virtual_page_addr << NUM_PAGE_OFFSET_BITS;
+    int walk_success = pgtable_results->success;
+
+    // issue a TLB request will also refill the TLB
+    // we only refill it when the page walk is successful
+    bool is_TLB_hit = ref.tlb_hit;
+    if (ref.tlb_core >= 0) {
+        is_TLB_hit = tlb_sim->lookup_tlb(
+            memref, ref.tlb_core,
+            walker.page_size(ref, virtual_full_page_addr, *pgtable_results));
+        if (knobs.verbose >= 2) {
+            std::cerr << __FUNCTION__ << " Received TLB result: " << is_TLB_hit << std::endl;
+        }
+    }
+
+    perf_res.tlb_hit = is_TLB_hit;
+    // process TLB miss
+    if (!is_TLB_hit) {
+        if (knobs.verbose >= 2) {
+            std::cerr << "TLB miss \n";
+        }
+        walker.walk(ref, virtual_full_page_addr, *pgtable_results);
+        // Page walk trajectory statistics are updated by record_memref().
+        ref.walked = true;
+    }
+
+    if (!tlb_prefetch_pages.empty() && walk_success && ref.tlb_core >= 0 &&
+        (memref.data.type == TRACE_TYPE_READ || memref.data.type == TRACE_TYPE_WRITE)) {
+        prefetch_next_translation(memref, pgtable_results->steps,
+                                  pgtable_results->num_steps, ref.tlb_core, core);
+    }
+
+    /* search result for data paddr */
+    cache_result_t search_res = NOT_FOUND;
+    // Only a real L1I or L1D access is followed by injected interference.
+    bool l1_accessed = false;
     if (walk_success) {
         if (type_is_instr(new_memref.instr.type) ||
             new_memref.instr.type == TRACE_TYPE_PREFETCH_INSTR) {
@@ -945,6 +1514,7 @@ cache_simulator_t::process_memref_radix(const memref_t &memref)
                         << new_memref.instr.size << "\n";
             }
             search_res = l1_icaches[core]->request(new_memref);
+            l1_accessed = true;
             perf_res.data_cache = search_res;
         } else if (new_memref.data.type == TRACE_TYPE_READ ||
                 new_memref.data.type == TRACE_TYPE_WRITE ||
@@ -961,7 +1531,10 @@ cache_simulator_t::process_memref_radix(const memref_t &memref)
                         << (void *)new_memref.data.addr << " x" << new_memref.data.size << "\n";
             }
             search_res = l1_dcaches[core]->request(new_memref);
+            l1_accessed = true;
             perf_res.data_cache = search_res;
+            if (new_memref.data.type == TRACE_TYPE_WRITE && !pte_mappings.empty())
+                check_pte_write(new_memref);
         } else if (new_memref.flush.type == TRACE_TYPE_INSTR_FLUSH) {
             if (knobs.verbose >= 3) {
                 std::cerr << "::" << new_memref.data.pid << "." << new_memref.data.tid << ":: "
@@ -992,81 +1565,13 @@ cache_simulator_t::process_memref_radix(const memref_t &memref)
             return false;
         }
 
-        if (IN_SET(this->perf_to_cnt, perf_res)) {
-            this->perf_to_cnt[perf_res]++;
-        } else {
-            this->perf_to_cnt[perf_res] = 1;
-        }
-     
-        // Simulate contetnion in caches 
-        // Firstly, simulate conetion in LLC
-        if (op_contention_L1.get_value() != 0) {
-        unsigned int num_req_expected = op_contention_L1.get_value(); //This is an expected number of L1 contention 
-                                                            //requests (multiplied by 100 and roundedd to integer, 
-                                                            //for example, value 560 would correspond to 5.6 requests on
-                                                            //average) 
-        if (num_req_expected >= 100) { //If more than one trashing request expected
-            unsigned int req_count = 0;
-            for(; (req_count+100) <= num_req_expected; req_count+=100) {
-            cache_result_t res = issue_contention_request(l1_dcaches[core], TRACE_TYPE_CONT_L1);
-            if (knobs.verbose >= 2) {
-                std::cerr << "Contention L1: res" << res << std::endl;
-            }
-            }
-            num_req_expected = num_req_expected - req_count;
-        }
-        if (num_req_expected >= 0) {
-            unsigned int draw_a_dice = rand() % 100; //To achieve an expected num_req sent this req probabalistically 
-            if (num_req_expected >= draw_a_dice) {
-            cache_result_t res = issue_contention_request(l1_dcaches[core], TRACE_TYPE_CONT_L1);
-            if (knobs.verbose >= 2) {
-                std::cerr << "Contention L1: res" << res << std::endl;
-            }
-            }
-        }
-        } //end if L1 contention
+        if (ref.walked)
+            ref.backfill_cycles = walker.finish(ref, *pgtable_results);
 
+        ref.record = true;
 
-        //Secondly, simulate contention in LLC
-        if ((op_contention_LLC.get_value() != 0) && 
-        ((search_res == FOUND_LLC) || (search_res == NOT_FOUND))) { //Only make a request if LLC was accessed
-            unsigned int num_req_expected = op_contention_LLC.get_value(); 
-            if (num_req_expected >= 100) { //If more than one request expected
-                unsigned int req_count = 0;
-                for(; (req_count+100) <= num_req_expected; req_count+=100) {
-                    cache_result_t res = issue_contention_request(llc1, TRACE_TYPE_CONT_LLC);
-                    if (knobs.verbose >= 2) {
-                        std::cerr << "Contention L1: res" << res << std::endl;
-                    }
-                }
-                num_req_expected = num_req_expected - req_count;
-            }
-            if (num_req_expected >= 0) {
-                unsigned int draw_a_dice = rand() % 100; //To achieve an expected num_req sent this req probabalistically 
-                if (num_req_expected >= draw_a_dice) {
-                    cache_result_t res = issue_contention_request(llc1, TRACE_TYPE_CONT_LLC);
-                    if (knobs.verbose >= 2) {
-                        std::cerr << "Contention L1: res" << res << std::endl;
-                    }
-                }
-            }
-        } //end if LLC contention
-    
-    }
-
-    // reset cache stats when warming up is completed
-    if (!is_warmed_up && check_warmed_up()) {
-        for (auto &cache_it : all_caches) {
-            cache_t *cache = cache_it.second;
-            cache->get_stats()->reset();
-        }
-        if (knobs.verbose >= 0) {
-            std::cerr << "Cache simulation warmed up\n";
-        }
-        //clear the hm_statistic_map
-        hm_full_statistic.clear(); 
-    } else {
-        knobs.sim_refs--;
+        if (l1_accessed)
+            inject_interference(core, search_res);
     }
 
     return true;
@@ -1098,23 +1603,20 @@ cache_simulator_t::process_memref_radix(const memref_t &memref)
 #define VADDR_TO_CWT_VPN_2MB(x)  (VADDR_TO_PAGE_NUM_2MB(x) >> CWT_CLUSTER_NBITS)
 #define VADDR_TO_CWT_VPN_1GB(x)  (VADDR_TO_PAGE_NUM_1GB(x) >> CWT_CLUSTER_NBITS)
 
-#define ECPT_4K_WAY 3
-#define ECPT_2M_WAY 3
-#define ECPT_1G_WAY 0
-#define ECPT_4K_WAY_START 0
-#define ECPT_4K_WAY_END (ECPT_4K_WAY_START + ECPT_4K_WAY)
-#define ECPT_2M_WAY_START (ECPT_4K_WAY_START + ECPT_4K_WAY)
-#define ECPT_2M_WAY_END (ECPT_2M_WAY_START + ECPT_2M_WAY)
-#define ECPT_1G_WAY_START (ECPT_2M_WAY_START + ECPT_2M_WAY)
-#define ECPT_1G_WAY_END (ECPT_1G_WAY_START + ECPT_1G_WAY)
+// The ECPT ways hold the 4KB entries first, then the 2MB and the 1GB ones.  The
+// number of ways of each page size comes from the -ECPT_<4K|2M|1G>_ways knobs.
+#define ECPT_4K_WAY_START(k) 0
+#define ECPT_4K_WAY_END(k) (ECPT_4K_WAY_START(k) + (k).ECPT_4K_ways)
+#define ECPT_2M_WAY_START(k) ECPT_4K_WAY_END(k)
+#define ECPT_2M_WAY_END(k) (ECPT_2M_WAY_START(k) + (k).ECPT_2M_ways)
+#define ECPT_1G_WAY_START(k) ECPT_2M_WAY_END(k)
+#define ECPT_1G_WAY_END(k) (ECPT_1G_WAY_START(k) + (k).ECPT_1G_ways)
 
 
-#define CWT_2MB_N_WAY 2
-#define CWT_1GB_N_WAY 2
-
-bool cache_simulator_t::__cwc_query(uint64_t cwc_vpn, uint32_t cwc_idx)
+bool cache_simulator_t::__cwc_query(uint64_t cwc_vpn, uint32_t cwc_idx, int core)
 {
     memref_t cwc_check_memref;
+    memset(&cwc_check_memref, 0, sizeof(cwc_check_memref));
     cwc_check_memref.data.type = TRACE_TYPE_READ;
     cwc_check_memref.data.addr = cwc_vpn;
     /* Since we initialize each line with size of 1 */
@@ -1122,7 +1624,7 @@ bool cache_simulator_t::__cwc_query(uint64_t cwc_vpn, uint32_t cwc_idx)
 
     cache_result_t search_res = NOT_FOUND;
 
-    search_res = cwc_caches[cwc_idx]->request(cwc_check_memref);
+    search_res = cwc_caches[core * NUM_CWC + cwc_idx]->request(cwc_check_memref);
 
     if (knobs.verbose >= 2) {
         printf("addr %lx cwc_idx %d search_res %d\n",
@@ -1132,19 +1634,19 @@ bool cache_simulator_t::__cwc_query(uint64_t cwc_vpn, uint32_t cwc_idx)
     return search_res == FOUND_L1;
 }
 
-bool cache_simulator_t::pud_cwc_query(uint64_t full_vaddr)
+bool cache_simulator_t::pud_cwc_query(uint64_t full_vaddr, int core)
 {
     uint64_t cwc_vpn = VADDR_TO_CWT_VPN_1GB(full_vaddr);
     uint32_t cwc_idx = PUD_CWC_IDX;
-    return __cwc_query(cwc_vpn, cwc_idx);
+    return __cwc_query(cwc_vpn, cwc_idx, core);
 }
 
 
-bool cache_simulator_t::pmd_cwc_query(uint64_t full_vaddr)
+bool cache_simulator_t::pmd_cwc_query(uint64_t full_vaddr, int core)
 {
     uint64_t cwc_vpn = VADDR_TO_CWT_VPN_2MB(full_vaddr);
     uint32_t cwc_idx = PMD_CWC_IDX;
-    return __cwc_query(cwc_vpn, cwc_idx);
+    return __cwc_query(cwc_vpn, cwc_idx, core);
 }
 
 /**
@@ -1155,14 +1657,15 @@ bool cache_simulator_t::pmd_cwc_query(uint64_t full_vaddr)
  * @param page_size 
  * @return uint64_t 
  */
-static uint32_t relative_way_to_abs_ecpt_way(uint32_t relative_way, uint64_t page_size)
+static uint32_t relative_way_to_abs_ecpt_way(const cache_simulator_knobs_t &knobs,
+                                             uint32_t relative_way, uint64_t page_size)
 {
     if (page_size == PAGE_SIZE_4KB) {
         return relative_way;
     } else if (page_size == PAGE_SIZE_2MB) {
-        return relative_way + ECPT_4K_WAY_END;
+        return relative_way + ECPT_4K_WAY_END(knobs);
     } else if (page_size == PAGE_SIZE_1GB) {
-        return relative_way + ECPT_2M_WAY_END;
+        return relative_way + ECPT_2M_WAY_END(knobs);
     } else {
         return 0;
     }
@@ -1175,9 +1678,10 @@ static void fill_ways_range(uint32_t start, uint32_t end, std::set<uint32_t> & w
     }
 }
 
-static void get_ecpt_all_ways(std::set<uint32_t> & ways_to_visit)
+static void get_ecpt_all_ways(const cache_simulator_knobs_t &knobs,
+                              std::set<uint32_t> & ways_to_visit)
 {
-    fill_ways_range(0, ECPT_1G_WAY_END, ways_to_visit);
+    fill_ways_range(0, ECPT_1G_WAY_END(knobs), ways_to_visit);
 }
 
 hit_info_t cwc_fill_finish_helper(hit_info_t hit_res, uint64_t addr, cwt_header_t pud_cwc_res,
@@ -1204,21 +1708,21 @@ hit_info_t cwc_fill_finish_helper(hit_info_t hit_res, uint64_t addr, cwt_header_
 
 hit_info_t cache_simulator_t::visit_cwc(uint64_t full_vaddr,
                              const _memref_pgtable_results &pgtable_result,
-                             std::set<uint32_t> &ways_to_visit)
+                             std::set<uint32_t> &ways_to_visit, int core)
 {   
     hit_info_t hit_res = {false, false};
     cwt_header_t pmd_cwc_res = {0};
     cwt_header_t pud_cwc_res = {0};
 
 
-    bool pud_cwc_hit = pud_cwc_query(full_vaddr);
+    bool pud_cwc_hit = pud_cwc_query(full_vaddr, core);
     pud_cwc_res = pgtable_result.aux_info.pud_header;
     hit_res.pud_hit = pud_cwc_hit;
 
     if (pud_cwc_hit) {
         if (pud_cwc_res.present_1GB) {
-            uint32_t abs_way =
-                relative_way_to_abs_ecpt_way(pud_cwc_res.way_in_ecpt, PAGE_SIZE_1GB);
+            uint32_t abs_way = relative_way_to_abs_ecpt_way(
+                knobs, pud_cwc_res.way_in_ecpt, PAGE_SIZE_1GB);
 
             ways_to_visit.insert(abs_way);
             return cwc_fill_finish_helper(hit_res, full_vaddr, pud_cwc_res, pmd_cwc_res,
@@ -1229,38 +1733,43 @@ hit_info_t cache_simulator_t::visit_cwc(uint64_t full_vaddr,
         /* PUD 4K only */
         if (!!pud_cwc_res.present_4KB && !pud_cwc_res.present_2MB) {
             // fill_4K_ways_range(is_kernel, possible_ways, n_ways);
-            fill_ways_range(ECPT_4K_WAY_START, ECPT_4K_WAY_END, ways_to_visit);
+            fill_ways_range(ECPT_4K_WAY_START(knobs), ECPT_4K_WAY_END(knobs),
+                            ways_to_visit);
             return cwc_fill_finish_helper(hit_res, full_vaddr, pud_cwc_res, pmd_cwc_res,
                                     knobs.verbose, ways_to_visit);
         }
     }
 
-    bool pmd_cwc_hit = pmd_cwc_query(full_vaddr);
+    bool pmd_cwc_hit = pmd_cwc_query(full_vaddr, core);
     pmd_cwc_res = pgtable_result.aux_info.pmd_header;
     hit_res.pmd_hit = pmd_cwc_hit;
 
     if (pmd_cwc_hit) {
         if (pmd_cwc_res.present_2MB) {
-            uint32_t abs_way = relative_way_to_abs_ecpt_way(pmd_cwc_res.way_in_ecpt,PAGE_SIZE_2MB);
+            uint32_t abs_way = relative_way_to_abs_ecpt_way(
+                knobs, pmd_cwc_res.way_in_ecpt, PAGE_SIZE_2MB);
             ways_to_visit.insert(abs_way);
         }
 
         if (pmd_cwc_res.present_4KB) {
-            fill_ways_range(ECPT_4K_WAY_START, ECPT_4K_WAY_END, ways_to_visit);
+            fill_ways_range(ECPT_4K_WAY_START(knobs), ECPT_4K_WAY_END(knobs),
+                            ways_to_visit);
         }
 
     } else {
         if (pud_cwc_hit && pud_cwc_res.present_2MB) {
-            fill_ways_range(ECPT_2M_WAY_START, ECPT_2M_WAY_END, ways_to_visit);
+            fill_ways_range(ECPT_2M_WAY_START(knobs), ECPT_2M_WAY_END(knobs),
+                            ways_to_visit);
         }
 
         if (pud_cwc_hit && pud_cwc_res.present_4KB) {
-            fill_ways_range(ECPT_4K_WAY_START, ECPT_4K_WAY_END, ways_to_visit);
+            fill_ways_range(ECPT_4K_WAY_START(knobs), ECPT_4K_WAY_END(knobs),
+                            ways_to_visit);
         }
     }
 
     if (!pmd_cwc_hit && !pud_cwc_hit) {
-        get_ecpt_all_ways(ways_to_visit);
+        get_ecpt_all_ways(knobs, ways_to_visit);
     }
 
     if (!IN_SET(ways_to_visit, pgtable_result.aux_info.selected_ecpt_way)) {
@@ -1268,7 +1777,7 @@ hit_info_t cache_simulator_t::visit_cwc(uint64_t full_vaddr,
             printf("Selected way %d not in ways to visit\n",
                     pgtable_result.aux_info.selected_ecpt_way);
         }
-        get_ecpt_all_ways(ways_to_visit);
+        get_ecpt_all_ways(knobs, ways_to_visit);
     }
 
     return cwc_fill_finish_helper(hit_res, full_vaddr, pud_cwc_res, pmd_cwc_res,
@@ -1280,13 +1789,16 @@ void cache_simulator_t::cwt_back_fill_one_way(page_walk_hm_result_t & res, uint6
     make_request(res, TRACE_TYPE_PE2, cwt_entry_addr, core);
 }
 
-void cache_simulator_t::cwt_back_fill(hit_info_t hit_info,
+// Refetches the CWT entries missed in the CWCs.  Returns the cycles the walk
+// waits for them under the latency model.
+uint64_t cache_simulator_t::cwt_back_fill(hit_info_t hit_info,
                                  const _memref_pgtable_results &pgtable_result, int core)
 {
+    page_walk_hm_result_t pmd_cwt_fetch_res;
+    page_walk_hm_result_t pud_cwt_fetch_res;
 
     if (!hit_info.pmd_hit) {
-        page_walk_hm_result_t pmd_cwt_fetch_res;
-        for (uint32_t i = 0; i < CWT_2MB_N_WAY; i++) {
+        for (uint32_t i = 0; i < knobs.CWT_2M_ways; i++) {
             assert(i < pgtable_result.aux_info.n_cwt_steps);
             cwt_back_fill_one_way(pmd_cwt_fetch_res, pgtable_result.aux_info.cwt_steps[i],
                                   core);
@@ -1298,8 +1810,8 @@ void cache_simulator_t::cwt_back_fill(hit_info_t hit_info,
     }
 
     if (!hit_info.pud_hit) {
-        page_walk_hm_result_t pud_cwt_fetch_res;
-        for (uint32_t i = CWT_2MB_N_WAY; i < CWT_2MB_N_WAY + CWT_1GB_N_WAY; i++) {
+        for (uint32_t i = knobs.CWT_2M_ways; i < knobs.CWT_2M_ways + knobs.CWT_1G_ways;
+             i++) {
             assert(i < pgtable_result.aux_info.n_cwt_steps);
             cwt_back_fill_one_way(pud_cwt_fetch_res, pgtable_result.aux_info.cwt_steps[i],
                                   core);
@@ -1309,442 +1821,473 @@ void cache_simulator_t::cwt_back_fill(hit_info_t hit_info,
         }
         print_page_walk_stats(pud_cwt_fetch_res);
     }
+
+    if (!knobs.latency_model)
+        return 0;
+    return walk_latency.cwt_backfill(pmd_cwt_fetch_res, pud_cwt_fetch_res);
 }
 
-bool
-cache_simulator_t::process_memref_ecpt(const memref_t &memref)
+// The size of the page an ECPT walk found, from the way holding the entry.
+static tlb_page_size_t
+ecpt_walk_page_size(const cache_simulator_knobs_t &knobs,
+                    const _memref_pgtable_results &pgtable_results)
 {
-    num_request++;
-    num_request_shifted++;
-
-    if ((num_request_shifted >> SIMULATOR_HEARTBEAT_FREQ) > 0) {
-        num_request_shifted = 0;
-        std::cerr << "Heartbeat. " << num_request << " references processed.\n";
-        // print_results();
-    }
+    uint32_t way = pgtable_results.aux_info.selected_ecpt_way;
+    if (way >= ECPT_2M_WAY_START(knobs) && way < ECPT_2M_WAY_END(knobs))
+        return TLB_PAGE_2MB;
+    if (way >= ECPT_1G_WAY_START(knobs) && way < ECPT_1G_WAY_END(knobs))
+        return TLB_PAGE_1GB;
+    return TLB_PAGE_4KB;
+}
 
-    if (knobs.skip_refs > 0) {
-        knobs.skip_refs--;
-        return true;
-    }
+tlb_page_size_t
+ecpt_walker_t::page_size(const sim_ref_t &ref, addr_t vpage,
+                         const _memref_pgtable_results &results)
+{
+    return ecpt_walk_page_size(sim.knobs, results);
+}
 
-    // If no warmup is specified and we have simulated sim_refs then
-    // we are done.
-    if ((knobs.warmup_refs == 0 && knobs.warmup_fraction == 0.0) && knobs.sim_refs == 0) {
-        if (knobs.verbose >= 3) {
-            std::cerr << "No warmup, but have simulation refs -> Done " << memref.data.pid
-                      << "." << memref.data.tid << ":: "
-                      << "marker type " << memref.marker.marker_type << " value "
-                      << memref.marker.marker_value << "\n";
-        }
-        return true;
-    }
+void
+ecpt_walker_t::walk(sim_ref_t &ref, addr_t vpage, const _memref_pgtable_results &results)
+{
+    int core = ref.core;
 
-    // The references after warmup and simulated ones are dropped.
-    if (check_warmed_up() && knobs.sim_refs == 0) {
-        if (knobs.verbose >= 3) {
-            std::cerr << "The references after warmup and simulated ones are dropped "
-                      << memref.data.pid << "." << memref.data.tid << ":: "
-                      << "marker type " << memref.marker.marker_type << " value "
-                      << memref.marker.marker_value << "\n";
-        }
-        return true;
-    }
+    // Accumulates sources for each access during a page walk
+    page_walk_hm_result_t page_walk_res;
 
-    // Both warmup and simulated references are simulated.
+    std::set<uint32_t> ways_to_visit;
+    hit_info = sim.visit_cwc(vpage, results, ways_to_visit, core);
 
-    if (!simulator_t::process_memref(memref)) {
-        if (knobs.verbose >= 3) {
-            std::cerr << "Both warmup and simulated references are simulated "
-                      << memref.data.pid << "." << memref.data.tid << ":: "
-                      << "marker type " << memref.marker.marker_type << " value "
-                      << memref.marker.marker_value << "\n";
-        }
-        return false;
-    }
+    for (uint32_t i = 0; i < ECPT_TABLE_LEAVES; i++) {
+        if (IN_SET(ways_to_visit, i)) {
+            uint64_t pgtable_addr = results.steps[i];
 
-    if (memref.marker.type == TRACE_TYPE_MARKER) {
-        // We ignore markers before we ask core_for_thread, to avoid asking
-        // too early on a timestamp marker.
-        if (knobs.verbose >= 3) {
-            std::cerr << "::" << memref.data.pid << "." << memref.data.tid << ":: "
-                      << "marker type " << memref.marker.marker_type << " value "
-                      << memref.marker.marker_value << "\n";
+            if (sim.knobs.ecpt_cache_correct_only) {
+                /* In case, we want to implement Jovan's optimization where you only load the correct entry to cache + early return */
+                if (i == results.aux_info.selected_ecpt_way) {
+                    // only touch the effective one
+                    sim.make_request(page_walk_res, TRACE_TYPE_PE1, pgtable_addr, core);
+                } else {
+                    page_walk_res.push_back(ZERO);
+                }
+            } else {
+                if (pgtable_addr != 0) {
+                    sim.make_request(page_walk_res, TRACE_TYPE_PE1, pgtable_addr, core);
+                } else {
+                    page_walk_res.push_back(ZERO);
+                }
+            }
+        } else {
+            page_walk_res.push_back(ZERO);
         }
-        return true;
     }
 
-    print_memref(memref);
-    stats_memref(memref);
-    // We use a static scheduling of threads to cores, as it is
-    // not practical to measure which core each thread actually
-    // ran on for each memref.
-    int core;
+    sim.print_page_walk_res_ecpt(page_walk_res, ways_to_visit);
+    ref.perf_res.pgwalk_res = page_walk_res;
 
-    if (knobs.verbose >= 3) {
-        std::cerr << "last_thread " << last_thread << " memref.data.tid "
-                  << memref.data.tid << "\n";
-        std::cerr << "last_core " << last_core << "\n";
-    }
+    if (sim.knobs.ecpt_early_return && !ref.functional_warmup)
+        ref.perf_res.ecpt_selected_way = results.aux_info.selected_ecpt_way;
+}
 
-    if (memref.data.tid == last_thread)
-        core = last_core;
-    else {
-        core = core_for_thread(memref.data.tid);
-        last_thread = memref.data.tid;
-        last_core = core;
-    }
+uint64_t
+ecpt_walker_t::finish(sim_ref_t &ref, const _memref_pgtable_results &results)
+{
+    // back fill CWT
+    return sim.cwt_back_fill(hit_info, results, ref.core);
+}
 
-    if (knobs.verbose >= 3) {
-        std::cerr << "core " << core << "\n";
-    }
+uint64_t
+ecpt_walker_t::walk_cycles(const cache_simulator_t &sim, const perf_result_t &perf_res,
+                           uint64_t finish_cycles)
+{
+    // finish_cycles is the wait for the CWT back-fill.
+    return sim.walk_latency.ecpt_walk(perf_res.pgwalk_res, sim.knobs.ecpt_early_return,
+                                      perf_res.ecpt_selected_way) +
+        finish_cycles;
+}
 
-    perf_result_t perf_res = {0};
-    perf_res.core = core;
+// The size of a page of page_table_builder_t's own schemes, whose walks do not
+// tell it.
+static tlb_page_size_t
+built_page_size(page_table_builder_t &page_tables, const memref_t &memref, addr_t vpage,
+                const _memref_pgtable_results &results)
+{
+    if (!results.success)
+        return TLB_PAGE_4KB;
+    unsigned int shift = page_tables.page_shift(memref.data.pid, vpage);
+    if (shift == PAGE_SHIFT_1GB)
+        return TLB_PAGE_1GB;
+    if (shift == PAGE_SHIFT_2MB)
+        return TLB_PAGE_2MB;
+    return TLB_PAGE_4KB;
+}
 
-    uint64_t addr;
+tlb_page_size_t
+hashed_walker_t::page_size(const sim_ref_t &ref, addr_t vpage,
+                           const _memref_pgtable_results &results)
+{
+    return built_page_size(sim.page_tables, ref.memref, vpage, results);
+}
 
-    uint64_t virtual_page_addr = 0;
-    uint64_t page_offset = 0;
-    uint64_t instrs_type = 0;
+void
+hashed_walker_t::walk(sim_ref_t &ref, addr_t vpage, const _memref_pgtable_results &results)
+{
+    page_walk_hm_result_t page_walk_res;
+    for (unsigned int i = 0; i < results.num_steps; i++)
+        sim.make_request(page_walk_res, TRACE_TYPE_PE4, results.steps[i], ref.core);
+    sim.print_page_walk_res(page_walk_res, 0, results.num_steps);
+    ref.perf_res.pgwalk_res = page_walk_res;
+}
 
-    if (type_is_instr(memref.instr.type) ||
-        memref.instr.type == TRACE_TYPE_PREFETCH_INSTR) {
-        addr = memref.instr.addr;
-        virtual_page_addr = memref.instr.addr >> NUM_PAGE_OFFSET_BITS;
-        page_offset = memref.instr.addr & ((1 << NUM_PAGE_OFFSET_BITS) - 1);
-        instrs_type = 1;
+uint64_t
+hashed_walker_t::walk_cycles(const cache_simulator_t &sim, const perf_result_t &perf_res,
+                             uint64_t finish_cycles)
+{
+    return sim.walk_latency.serial_walk(perf_res.pgwalk_res);
+}
 
-        perf_res.is_inst = 1;
-    } else if (memref.data.type == TRACE_TYPE_READ ||
-               memref.data.type == TRACE_TYPE_WRITE ||
-               type_is_prefetch(memref.data.type)) {
-        addr = memref.data.addr;
-        virtual_page_addr = memref.data.addr >> NUM_PAGE_OFFSET_BITS;
-        page_offset = memref.data.addr & ((1 << NUM_PAGE_OFFSET_BITS) - 1);
-        instrs_type = 2;
-        perf_res.is_inst = 0;
-    }
+tlb_page_size_t
+flattened_walker_t::page_size(const sim_ref_t &ref, addr_t vpage,
+                              const _memref_pgtable_results &results)
+{
+    return built_page_size(sim.page_tables, ref.memref, vpage, results);
+}
 
-    /* virtual_full_page_addr is the virtual address without page offset */
-    uint64_t virtual_full_page_addr = virtual_page_addr << NUM_PAGE_OFFSET_BITS;
+void
+flattened_walker_t::walk(sim_ref_t &ref, addr_t vpage,
+                         const _memref_pgtable_results &results)
+{
+    // The merged nodes stand for the PUD and the PTE levels.
+    page_walk_hm_result_t page_walk_res;
+    for (unsigned int i = 0; i < results.num_steps; i++) {
+        sim.make_request(page_walk_res, i == 0 ? TRACE_TYPE_PE2 : TRACE_TYPE_PE4,
+                         results.steps[i], ref.core);
+    }
+    sim.print_page_walk_res(page_walk_res, 0, results.num_steps);
+    ref.perf_res.pgwalk_res = page_walk_res;
+}
 
-    memref_t new_memref;
-    new_memref = memref;
-    new_memref.marker.type = memref.marker.type;
-    new_memref.marker.pid = memref.marker.pid;
-    new_memref.marker.tid = memref.marker.tid;
-    // page_table_t::iterator it = page_table.find(virtual_full_page_addr);
-    // if found
-    // if (it != page_table.end()) {
-
-    /* TODO: now we don't have to process page table dump */
-    uint64_t pgwalk_steps = 0;
-    int walk_success = 0;
-    _memref_pgtable_results pgtable_results;
-
-    if (type_is_instr(memref.instr.type) ||
-        memref.instr.type == TRACE_TYPE_PREFETCH_INSTR) {
-        // new_memref.instr.addr = physical_page_addr + page_offset;
-        new_memref.instr.addr = memref.instr.pgtable_results.paddr;
-        pgwalk_steps = memref.instr.pgtable_results.num_steps;
-        walk_success = memref.instr.pgtable_results.success;
+uint64_t
+flattened_walker_t::walk_cycles(const cache_simulator_t &sim, const perf_result_t &perf_res,
+                                uint64_t finish_cycles)
+{
+    return sim.walk_latency.serial_walk(perf_res.pgwalk_res);
+}
 
-        pgtable_results = memref.instr.pgtable_results;
+// The smaller of the guest's page and the host's.
+tlb_page_size_t
+nested_walker_t::page_size(const sim_ref_t &ref, addr_t vpage,
+                           const _memref_pgtable_results &results)
+{
+    tlb_page_size_t guest = radix_walk_page_size(results.num_steps);
+    unsigned int host_shift = sim.page_tables.host_page_shift();
+    tlb_page_size_t host = host_shift == PAGE_SHIFT_1GB
+        ? TLB_PAGE_1GB
+        : (host_shift == PAGE_SHIFT_2MB ? TLB_PAGE_2MB : TLB_PAGE_4KB);
+    return guest < host ? guest : host;
+}
 
-        uint64_t ins_line = memref.instr.addr & FRONTEND_FETCH_MASK;
+// Walks the host tables for gpa into host_res, NUM_PAGE_TABLE_LEVELS steps, and
+// returns its host physical address.
+addr_t
+nested_walker_t::host_walk(addr_t gpa, page_walk_hm_result_t &host_res, int core)
+{
+    addr_t steps[PAGE_TABLE_LEAVES];
+    addr_t hpa;
+    unsigned int num_steps = sim.page_tables.host_walk(gpa, steps, hpa);
+    for (unsigned int level = 1; level <= NUM_PAGE_TABLE_LEVELS; level++) {
+        if (level <= num_steps)
+            sim.make_request(host_res, TRACE_TYPE[level], steps[level - 1], core);
+        else
+            host_res.push_back(ZERO);
+    }
+    return hpa;
+}
 
-        if (knobs.verbose >= 2) {
-            printf("ins_line %lx ins_fetched[%d] %lx\n", ins_line, core, ins_fetched[core]);
+void
+nested_walker_t::walk(sim_ref_t &ref, addr_t vpage, const _memref_pgtable_results &results)
+{
+    int core = ref.core;
+    uint64_t pgwalk_steps = results.num_steps;
+    page_walk_hm_result_t page_walk_res;
+    page_walk_hm_result_t host_res;
+
+    // The page walk caches hold guest entries, which skip their host walks too.
+    unsigned int pwc_hit_level = sim.visit_pwc(vpage, pgwalk_steps, core);
+    for (unsigned int level = 1; level <= NUM_PAGE_TABLE_LEVELS; level++) {
+        if (level < pwc_hit_level || level > pgwalk_steps) {
+            page_walk_res.push_back(ZERO);
+        } else if (level == pwc_hit_level) {
+            page_walk_res.push_back(PWC);
+        } else {
+            addr_t hpa = host_walk(results.steps[level - 1], host_res, core);
+            sim.make_request(page_walk_res, TRACE_TYPE[level], hpa, core);
+            continue;
         }
+        for (unsigned int i = 0; i < NUM_PAGE_TABLE_LEVELS; i++)
+            host_res.push_back(ZERO);
+    }
+    host_walk(results.steps[PAGE_TABLE_LEAVES], host_res, core);
+    page_walk_res.append(host_res);
 
-        if (ins_fetched[core] == ins_line) {
-            /* no need for ifetch TLB */
-            perf_res.cached_ifb = 1;
-            perf_res.is_non_memory_exec = pgtable_results.is_non_memory;
-            perf_res.tlb_hit = 0;
-            perf_res.data_cache = ZERO;
+    sim.print_page_walk_res(page_walk_res, pwc_hit_level, pgwalk_steps);
+    ref.perf_res.pgwalk_res = page_walk_res;
+}
 
-            if (knobs.verbose >= 2) {
-                std::cerr << "perf_res.cached_ifb " << perf_res.cached_ifb << "\n";
-            }
+// The guest steps, which come first, are charged like a radix walk's, PWC
+// probes included; the host walks that follow are read one after the other.
+uint64_t
+nested_walker_t::walk_cycles(const cache_simulator_t &sim, const perf_result_t &perf_res,
+                             uint64_t finish_cycles)
+{
+    const page_walk_hm_result_t &walk = perf_res.pgwalk_res;
+    page_walk_hm_result_t guest;
+    page_walk_hm_result_t host;
+    for (unsigned int i = 0; i < walk.size(); i++) {
+        if (i < NUM_PAGE_TABLE_LEVELS)
+            guest.push_back(walk[i]);
+        else
+            host.push_back(walk[i]);
+    }
+    return sim.walk_latency.radix_walk(guest) + sim.walk_latency.serial_walk(host);
+}
 
-            if (IN_SET(this->perf_to_cnt, perf_res)) {
-                this->perf_to_cnt[perf_res]++;
-            } else {
-                this->perf_to_cnt[perf_res] = 1;
-            }
+bool
+cache_simulator_t::simulate_memref(sim_ref_t &ref)
+{
+    return (this->*simulate_fn)(ref);
+}
 
-            return true;
+// Picks the page walker of -translation_scheme and sets up the page tables it
+// walks, if the trace does not record them.
+bool
+cache_simulator_t::init_page_walker()
+{
+    page_table_scheme_t scheme;
+    if (knobs.arch != RADIX && knobs.arch != ECPT) {
+        error_string = "Usage error: unknown -arch " + std::to_string(knobs.arch) + ".";
+        return false;
+    }
+    if (knobs.translation_scheme.empty() ||
+        knobs.translation_scheme ==
+            (knobs.arch == RADIX ? TRANSLATION_SCHEME_RADIX : TRANSLATION_SCHEME_ECPT)) {
+        scheme = knobs.arch == RADIX ? SCHEME_RADIX : SCHEME_ECPT;
+    } else if (knobs.translation_scheme == TRANSLATION_SCHEME_HASHED) {
+        scheme = SCHEME_HASHED;
+    } else if (knobs.translation_scheme == TRANSLATION_SCHEME_FLATTENED) {
+        scheme = SCHEME_FLATTENED;
+    } else if (knobs.translation_scheme == TRANSLATION_SCHEME_NESTED) {
+        scheme = SCHEME_NESTED;
+    } else {
+        error_string = "Usage error: unknown -translation_scheme " +
+            knobs.translation_scheme + ".  Choose from the -arch of the trace, "
+            TRANSLATION_SCHEME_HASHED ", " TRANSLATION_SCHEME_FLATTENED " and "
+            TRANSLATION_SCHEME_NESTED ".";
+        return false;
+    }
+    if (scheme != SCHEME_RADIX && scheme != SCHEME_ECPT) {
+        // The new schemes use the radix page walk caches, if any, and their
+        // tables only exist built.
+        if (knobs.arch != RADIX || !knobs.synthetic_page_tables) {
+            error_string = "Usage error: -translation_scheme " + knobs.translation_scheme +
+                " needs -arch radix and -synthetic_page_tables.";
+            return false;
         }
-        
-        if (knobs.verbose >= 2) {
-            std::cerr << "perf_res.cached_ifb " << perf_res.cached_ifb << "\n";
+        if (knobs.pte_write_shootdown || knobs.tlb_prefetcher != PREFETCH_POLICY_NONE) {
+            error_string = "Usage error: -pte_write_shootdown and -tlb_prefetcher need "
+                           "the radix -translation_scheme.";
+            return false;
         }
-
-        ins_fetched[core] = ins_line;
-    } else if (memref.data.type == TRACE_TYPE_READ ||
-               memref.data.type == TRACE_TYPE_WRITE ||
-               type_is_prefetch(memref.data.type)) {
-        // new_memref.data.addr  = physical_page_addr + page_offset;
-        new_memref.data.addr = memref.data.pgtable_results.paddr;
-        pgwalk_steps = memref.data.pgtable_results.num_steps;
-        walk_success = memref.data.pgtable_results.success;
-
-        pgtable_results = memref.data.pgtable_results;
-    } else if (memref.flush.type == TRACE_TYPE_INSTR_FLUSH ||
-               memref.flush.type == TRACE_TYPE_DATA_FLUSH) {
-        pgwalk_steps = memref.flush.pgtable_results.num_steps;
-        walk_success = memref.flush.pgtable_results.success;
-
-        pgtable_results = memref.flush.pgtable_results;
     }
 
-    perf_res.is_non_memory_exec = pgtable_results.is_non_memory;
-    // issue a TLB request will also refill the TLB
-    // we only refill it when the page walk is successful
-    bool is_TLB_hit = false;
-    if (walk_success) {
-        std::pair<bool, bool> res = tlb_sim->process_memref_tlb(memref);
-        is_TLB_hit = res.second;
-        if (knobs.verbose >= 2) {
-            std::cerr << __FUNCTION__ << " Received TLB result: " << is_TLB_hit
-                      << std::endl;
+    if (knobs.synthetic_page_tables) {
+        // The tables are rebuilt from the start of the trace.
+        if (!knobs.checkpoint_in.empty() || !knobs.checkpoint_out.empty()) {
+            error_string = "Usage error: -synthetic_page_tables cannot be combined with "
+                           "-checkpoint_in or -checkpoint_out.";
+            return false;
         }
+        if (!page_tables.init(knobs.arch, scheme, knobs.synthetic_page_size,
+                              knobs.ECPT_4K_ways, knobs.ECPT_2M_ways, knobs.ECPT_1G_ways,
+                              knobs.CWT_2M_ways, knobs.CWT_1G_ways, error_string))
+            return false;
     }
 
-    hit_info_t hit_info = {false, false};
-
-    perf_res.tlb_hit = is_TLB_hit;
-
-    // process TLB miss
-    if (!is_TLB_hit) {
-        if (knobs.verbose >= 2) {
-            std::cerr << "TLB miss \n";
-        }
-
-        // reset page walk trajectory path
-        page_walk_res.clear(); // Accumulates sources for each access during a page walk
-
-        std::set<uint32_t> ways_to_visit;
-        hit_info = visit_cwc(virtual_full_page_addr, pgtable_results, ways_to_visit);
-
-        for (uint32_t i = 0; i < ECPT_TABLE_LEAVES; i++) {
-            if (IN_SET(ways_to_visit, i)) {
-                uint64_t pgtable_addr = pgtable_results.steps[i];
-                
-
-                if (knobs.ecpt_cache_correct_only) {
-                    /* In case, we want to implement Jovan's optimization where you only load the correct entry to cache + early return */
-                    if (i == pgtable_results.aux_info.selected_ecpt_way) {
-                        // only touch the effective one
-                        make_request(page_walk_res, TRACE_TYPE_PE1, pgtable_addr, core);
-                    } else {
-                        page_walk_res.push_back(ZERO);
-                    }
-                } else {
-                    if (pgtable_addr != 0) {
-                        make_request(page_walk_res, TRACE_TYPE_PE1, pgtable_addr, core);
-                    } else {
-                        page_walk_res.push_back(ZERO);
-                    }
-                }
-
-            } else {
-                page_walk_res.push_back(ZERO);
-            }
-        }
+    switch (scheme) {
+    case SCHEME_RADIX:
+        process_fn = &cache_simulator_t::process_translation<radix_walker_t>;
+        simulate_fn = &cache_simulator_t::simulate_translation<radix_walker_t>;
+        walk_cycles_fn = &radix_walker_t::walk_cycles;
+        break;
+    case SCHEME_ECPT:
+        process_fn = &cache_simulator_t::process_translation<ecpt_walker_t>;
+        simulate_fn = &cache_simulator_t::simulate_translation<ecpt_walker_t>;
+        walk_cycles_fn = &ecpt_walker_t::walk_cycles;
+        break;
+    case SCHEME_HASHED:
+        process_fn = &cache_simulator_t::process_translation<hashed_walker_t>;
+        simulate_fn = &cache_simulator_t::simulate_translation<hashed_walker_t>;
+        walk_cycles_fn = &hashed_walker_t::walk_cycles;
+        break;
+    case SCHEME_FLATTENED:
+        process_fn = &cache_simulator_t::process_translation<flattened_walker_t>;
+        simulate_fn = &cache_simulator_t::simulate_translation<flattened_walker_t>;
+        walk_cycles_fn = &flattened_walker_t::walk_cycles;
+        break;
+    case SCHEME_NESTED:
+        process_fn = &cache_simulator_t::process_translation<nested_walker_t>;
+        simulate_fn = &cache_simulator_t::simulate_translation<nested_walker_t>;
+        walk_cycles_fn = &nested_walker_t::walk_cycles;
+        break;
+    }
+    return true;
+}
 
-        print_page_walk_res_ecpt(page_walk_res, ways_to_visit);
-        perf_res.pgwalk_res = page_walk_res;
+// Sets up -sim_threads and -epoch_refs: each core's private caches, TLBs and
+// walk caches are simulated by one worker thread, and the shared LLC is only
+// updated between epochs of -epoch_refs references (see llc_epoch_proxy_t).
+bool
+cache_simulator_t::epoch_init(const tlb_simulator_knobs_t &tlb_knobs)
+{
+    // The TLBs are only per-worker if the TLB simulator maps cores the same way.
+    if (!knobs.core_from_access_cpu || !tlb_knobs.core_from_access_cpu) {
+        error_string = "Usage error: -sim_threads and -epoch_refs need the per-CPU "
+                       "references of a QEMU trace (-core_from_access_cpu).";
+        return false;
+    }
+    if (tlb_knobs.num_cores != knobs.num_cores) {
+        error_string = "Usage error: -sim_threads and -epoch_refs need as many TLB "
+                       "cores as cores.";
+        return false;
+    }
+    if (knobs.contention_L1 != 0 || knobs.contention_LLC != 0 ||
+        knobs.interval_refs > 0 || knobs.interval_instrs > 0) {
+        error_string = "Usage error: -sim_threads and -epoch_refs cannot be combined "
+                       "with -contention_L1, -contention_LLC or -interval_*.";
+        return false;
+    }
+    // -sim_threads alone uses epochs of 16K references.
+    if (knobs.epoch_refs == 0)
+        knobs.epoch_refs = 16384;
+    for (unsigned int i = 0; i < knobs.num_cores; i++)
+        llc_proxies.push_back(new llc_epoch_proxy_t(llc1));
+    epoch_core_refs.resize(knobs.num_cores);
+    epoch_refs.reserve(knobs.epoch_refs);
+    unsigned int num_workers = std::min(knobs.sim_threads, knobs.num_cores);
+    epoch_workers.start(num_workers, [this](unsigned int worker) { epoch_work(worker); });
+    return true;
+}
 
-        // Update page walk trajectory statistics
-        hm_full_statistic_t::iterator it = hm_full_statistic.find(page_walk_res);
-        if (it != hm_full_statistic.end()) {
-            it->second++;
-        } else {
-            hm_full_statistic.insert(std::make_pair(page_walk_res, 1));
+// Simulates the pending references of the cores owned by worker.
+void
+cache_simulator_t::epoch_work(unsigned int worker)
+{
+    for (unsigned int core = worker; core < knobs.num_cores;
+         core += epoch_workers.size()) {
+        for (uint32_t idx : epoch_core_refs[core]) {
+            sim_ref_t &ref = epoch_refs[idx];
+            // Only instruction and data references are queued, which cannot fail.
+            simulate_memref(ref);
+            ref.llc_log_end = llc_proxies[core]->log_size();
         }
+    }
+}
 
-        if (knobs.ecpt_early_return) {
-            auto res_way_pair = std::make_pair(page_walk_res, (uint64_t) pgtable_results.aux_info.selected_ecpt_way);
-
-            auto with_way_it = hm_full_stats_with_way.find(res_way_pair);
-            if (with_way_it != hm_full_stats_with_way.end()) {
-                with_way_it->second++;
-            } else {
-                hm_full_stats_with_way.insert(std::make_pair(res_way_pair, 1));
-            }
+// Simulates the pending references, one thread per group of cores, then
+// applies their LLC accesses and counts their results in trace order.
+void
+cache_simulator_t::drain_epoch()
+{
+    if (epoch_refs.empty())
+        return;
+    for (unsigned int i = 0; i < knobs.num_cores; i++)
+        l2_caches[i]->set_parent(llc_proxies[i]);
+    epoch_workers.run();
+    for (unsigned int i = 0; i < knobs.num_cores; i++)
+        l2_caches[i]->set_parent(llc1);
 
-            perf_res.ecpt_selected_way = pgtable_results.aux_info.selected_ecpt_way;
-        }
-        
-    }   
+    std::vector<size_t> log_pos(knobs.num_cores, 0);
+    for (const sim_ref_t &ref : epoch_refs) {
+        llc_proxies[ref.core]->replay(&log_pos[ref.core], ref.llc_log_end);
+        record_memref(ref);
+    }
+    for (unsigned int i = 0; i < knobs.num_cores; i++) {
+        llc_proxies[i]->clear_log();
+        epoch_core_refs[i].clear();
+    }
+    epoch_refs.clear();
+}
 
-    /* search result for data paddr */
-    cache_result_t search_res;
-    if (walk_success) {
-        std::vector<std::string> page_walk_res_str {
-            "MEMORY"
-            , "L1"
-            , "L2"
-            , "LLC"
-            , "WRONG"
-            , "RANGE_HIT"
-            , "RANGE_MISS"
-            , "PWC"
-            , "ZERO"
-        };
+// Counts the results of a simulated reference.
+void
+cache_simulator_t::record_memref(const sim_ref_t &ref)
+{
+    functional_warmup = ref.functional_warmup;
+    if (ref.walked) {
+        record_page_walk(ref.perf_res.pgwalk_res);
+        if (knobs.arch == ECPT && knobs.ecpt_early_return && !functional_warmup) {
+            hm_full_stats_with_way.add(page_walk_with_way_t(
+                ref.perf_res.pgwalk_res, (uint64_t)ref.perf_res.ecpt_selected_way));
+        }
+    }
+    if (ref.record)
+        record_perf_result(ref.perf_res, ref.backfill_cycles);
+    if (ref.sampled && ref.record) {
+        const perf_result_t &perf_res = ref.perf_res;
+        sampler.measure(perf_res.is_inst, !perf_res.tlb_hit && !perf_res.cached_ifb,
+                        walk_cycles(perf_res, ref.backfill_cycles));
+    }
+    if (knobs.timing_model) {
+        if (ref.record && !functional_warmup)
+            record_timing(ref);
+        timing_ref.walk.clear();
+    }
+}
 
-        if (type_is_instr(new_memref.instr.type) ||
-            new_memref.instr.type == TRACE_TYPE_PREFETCH_INSTR) {
-            if (knobs.verbose >= 2) {
-                std::cerr << "Go to L1I\n";
-            }
-            
-            search_res = l1_icaches[core]->request(new_memref);
-            perf_res.data_cache = search_res;
-            
-            if (knobs.verbose >= 3) {
-                std::cerr << "Go to L1I\n";
-                std::cerr << "::" << new_memref.data.pid << "." << new_memref.data.tid
-                          << ":: "
-                          << " @" << (void *)new_memref.instr.addr << " instr x"
-                          << new_memref.instr.size 
-                          << "search_res" << page_walk_res_str[search_res]  << "\n";
-            }
-        } else if (new_memref.data.type == TRACE_TYPE_READ ||
-                   new_memref.data.type == TRACE_TYPE_WRITE ||
-                   // We may potentially handle prefetches differently.
-                   // TRACE_TYPE_PREFETCH_INSTR is handled above.
-                   type_is_prefetch(new_memref.data.type)) {
-            if (knobs.verbose >= 2) {
-                std::cerr << "Go to L1D\n";
-            }
-            
-            search_res = l1_dcaches[core]->request(new_memref);
-            perf_res.data_cache = search_res;
-            
-            if (knobs.verbose >= 3) {
-                std::cerr << "::" << new_memref.data.pid << "." << new_memref.data.tid
-                          << ":: "
-                          << " @" << (void *)new_memref.data.pc << " "
-                          << trace_type_names[new_memref.data.type] << " "
-                          << (void *)new_memref.data.addr << " x" << new_memref.data.size
-                          << "search_res" << page_walk_res_str[search_res]  << "\n";
-            }
-        } else if (new_memref.flush.type == TRACE_TYPE_INSTR_FLUSH) {
-            if (knobs.verbose >= 3) {
-                std::cerr << "::" << new_memref.data.pid << "." << new_memref.data.tid
-                          << ":: "
-                          << " @" << (void *)new_memref.data.pc << " iflush "
-                          << (void *)new_memref.data.addr << " x" << new_memref.data.size
-                          << "\n";
-            }
-            l1_icaches[core]->flush(new_memref);
-        } else if (new_memref.flush.type == TRACE_TYPE_DATA_FLUSH) {
-            if (knobs.verbose >= 3) {
-                std::cerr << "::" << new_memref.data.pid << "." << new_memref.data.tid
-                          << ":: "
-                          << " @" << (void *)new_memref.data.pc << " dflush "
-                          << (void *)new_memref.data.addr << " x" << new_memref.data.size
-                          << "\n";
-            }
-            l1_dcaches[core]->flush(new_memref);
-        } else if (new_memref.exit.type == TRACE_TYPE_THREAD_EXIT) {
-            handle_thread_exit(new_memref.exit.tid);
-            last_thread = 0;
-        } else if (new_memref.marker.type == TRACE_TYPE_INSTR_NO_FETCH) {
-            // Just ignore.
-            if (knobs.verbose >= 3) {
-                std::cerr << "::" << new_memref.data.pid << "." << new_memref.data.tid
-                          << ":: "
-                          << " @" << (void *)new_memref.instr.addr
-                          << " non-fetched instr x" << new_memref.instr.size << "\n";
-            }
-        } else {
-            std::cout << __FILE__ << " " << __func__ << std::endl;
-            error_string =
-                "Unhandled memref type " + std::to_string(new_memref.data.type);
-            return false;
-        }
+// Times a simulated reference from the levels that served its walk steps,
+// logged by make_request(), and its access.
+void
+cache_simulator_t::record_timing(const sim_ref_t &ref)
+{
+    const memref_t &memref = ref.memref;
+    const perf_result_t &perf_res = ref.perf_res;
+    const _memref_pgtable_results *pgtable_results = NULL;
+    if (perf_res.is_inst)
+        pgtable_results = &memref.instr.pgtable_results;
+    else if (memref.data.type == TRACE_TYPE_READ || memref.data.type == TRACE_TYPE_WRITE ||
+             type_is_prefetch(memref.data.type))
+        pgtable_results = &memref.data.pgtable_results;
+    timing_ref.fetch_buffer_hit = perf_res.cached_ifb;
+    timing_ref.is_inst = perf_res.is_inst;
+    timing_ref.walked = ref.walked;
+    timing_ref.pwc_probes = 0;
+    for (unsigned int i = 0; ref.walked && knobs.arch == RADIX && i < NUM_PWC; i++) {
+        if (perf_res.pgwalk_res.size() > i && perf_res.pgwalk_res[i] == PWC)
+            timing_ref.pwc_probes = NUM_PWC - i;
+    }
+    timing_ref.selected_way = -1;
+    if (knobs.arch == ECPT && knobs.ecpt_early_return && pgtable_results != NULL)
+        timing_ref.selected_way = (int)pgtable_results->aux_info.selected_ecpt_way;
+    timing_ref.accessed = pgtable_results != NULL && ref.walk_success;
+    if (timing_ref.accessed) {
+        timing_ref.addr = pgtable_results->paddr;
+        timing_ref.res = perf_res.data_cache;
+    }
+    timing_model.reference(ref.core, timing_ref);
+}
 
-        if (IN_SET(this->perf_to_cnt, perf_res)) {
-            this->perf_to_cnt[perf_res]++;
-        } else {
-            this->perf_to_cnt[perf_res] = 1;
-        }
-
-        if (!is_TLB_hit) {
-            // back fill CWT
-            cwt_back_fill(hit_info, pgtable_results, core);
-        }
-
-        // Simulate contetnion in caches
-        // Firstly, simulate conetion in LLC
-        if (op_contention_L1.get_value() != 0) {
-            unsigned int num_req_expected =
-                op_contention_L1
-                    .get_value(); // This is an expected number of L1 contention
-                                  // requests (multiplied by 100 and roundedd to integer,
-                                  // for example, value 560 would correspond to 5.6
-                                  // requests on average)
-            if (num_req_expected >= 100) { // If more than one trashing request expected
-                unsigned int req_count = 0;
-                for (; (req_count + 100) <= num_req_expected; req_count += 100) {
-                    cache_result_t res =
-                        issue_contention_request(l1_dcaches[core], TRACE_TYPE_CONT_L1);
-                    if (knobs.verbose >= 2) {
-                        std::cerr << "Contention L1: res" << res << std::endl;
-                    }
-                }
-                num_req_expected = num_req_expected - req_count;
-            }
-            if (num_req_expected >= 0) {
-                unsigned int draw_a_dice = rand() %
-                    100; // To achieve an expected num_req sent this req probabalistically
-                if (num_req_expected >= draw_a_dice) {
-                    cache_result_t res =
-                        issue_contention_request(l1_dcaches[core], TRACE_TYPE_CONT_L1);
-                    if (knobs.verbose >= 2) {
-                        std::cerr << "Contention L1: res" << res << std::endl;
-                    }
-                }
-            }
-        } // end if L1 contention
-
-        // Secondly, simulate contention in LLC
-        if ((op_contention_LLC.get_value() != 0) &&
-            ((search_res == FOUND_LLC) ||
-             (search_res == NOT_FOUND))) { // Only make a request if LLC was accessed
-            unsigned int num_req_expected = op_contention_LLC.get_value();
-            if (num_req_expected >= 100) { // If more than one request expected
-                unsigned int req_count = 0;
-                for (; (req_count + 100) <= num_req_expected; req_count += 100) {
-                    cache_result_t res =
-                        issue_contention_request(llc1, TRACE_TYPE_CONT_LLC);
-                    if (knobs.verbose >= 2) {
-                        std::cerr << "Contention L1: res" << res << std::endl;
-                    }
-                }
-                num_req_expected = num_req_expected - req_count;
-            }
-            if (num_req_expected >= 0) {
-                unsigned int draw_a_dice = rand() %
-                    100; // To achieve an expected num_req sent this req probabalistically
-                if (num_req_expected >= draw_a_dice) {
-                    cache_result_t res =
-                        issue_contention_request(llc1, TRACE_TYPE_CONT_LLC);
-                    if (knobs.verbose >= 2) {
-                        std::cerr << "Contention L1: res" << res << std::endl;
-                    }
-                }
-            }
-        } // end if LLC contention
+// Ends the TLB and cache warmup or counts a simulated reference.  Statistics
+// are only reset once the pending references have been simulated.
+void
+cache_simulator_t::retire_memref(const sim_ref_t &ref)
+{
+    if (ref.tlb_warmup_done) {
+        drain_epoch();
+        tlb_sim->reset_stats();
     }
-
     // reset cache stats when warming up is completed
     if (!is_warmed_up && check_warmed_up()) {
+        drain_epoch();
         for (auto &cache_it : all_caches) {
             cache_t *cache = cache_it.second;
             cache->get_stats()->reset();
@@ -1752,14 +2295,18 @@ cache_simulator_t::process_memref_ecpt(const memref_t &memref)
         if (knobs.verbose >= 0) {
             std::cerr << "Cache simulation warmed up\n";
         }
+        if (checkpoint.is_open())
+            save_checkpoint();
         // clear the hm_statistic_map
         hm_full_statistic.clear();
         hm_full_stats_with_way.clear();
+        walk_latency.reset();
+        timing_model.reset();
+        for (miss_ratio_curve_t *curve : walk_curves)
+            curve->reset();
     } else {
         knobs.sim_refs--;
     }
-
-    return true;
 }
 
 /**
@@ -1779,6 +2326,42 @@ static cache_result_t process_hit_level(cache_result_t search_res, int start_lev
     }
 }
 
+// Counts one classified reference.  Skipped during functional warmup.
+// backfill_cycles is the ECPT walk's wait for its CWT back-fill.
+void
+cache_simulator_t::record_perf_result(const perf_result_t &perf_res,
+                                      uint64_t backfill_cycles)
+{
+    if (functional_warmup)
+        return;
+    perf_to_cnt.add(perf_res);
+    if (knobs.latency_model) {
+        bool walked = !perf_res.tlb_hit && !perf_res.cached_ifb;
+        walk_latency.record(perf_res.cached_ifb, walked,
+                            walk_cycles(perf_res, backfill_cycles), perf_res.data_cache);
+    }
+}
+
+uint64_t
+cache_simulator_t::walk_cycles(const perf_result_t &perf_res,
+                               uint64_t backfill_cycles) const
+{
+    if (perf_res.tlb_hit || perf_res.cached_ifb)
+        return 0;
+    return walk_cycles_fn(*this, perf_res, backfill_cycles);
+}
+
+// Counts one page walk trajectory.  Skipped during functional warmup.
+void
+cache_simulator_t::record_page_walk(const page_walk_hm_result_t &page_walk_res)
+{
+    if (functional_warmup)
+        return;
+    hm_full_statistic.add(page_walk_res);
+    if (interval_out != NULL)
+        interval_walks.add(page_walk_res);
+}
+
 void cache_simulator_t::make_request(page_walk_hm_result_t& page_walk_res, 
                                      trace_type_t type, 
                                      long long unsigned int pgtable_addr, /* phys addr of the page table */
@@ -1798,6 +2381,8 @@ void cache_simulator_t::make_request(page_walk_hm_result_t& page_walk_res,
     << std::endl;
   }
   memref_t page_walk_memref; 
+  // Zeroed so that no field a replacement policy reads, like the PC, is garbage.
+  memset(&page_walk_memref, 0, sizeof(page_walk_memref));
 
   page_walk_memref.data.type = type;
   // int offset_in_pt_page = ( 
@@ -1818,6 +2403,15 @@ void cache_simulator_t::make_request(page_walk_hm_result_t& page_walk_res,
         search_res = process_hit_level(search_res, 0);
     }
 
+  if (knobs.timing_model) {
+      timing_model_t::walk_access_kind_t kind = timing_model_t::TIMING_WALK_STEP;
+      if (knobs.arch == ECPT) {
+          kind = type == TRACE_TYPE_PE2 ? timing_model_t::TIMING_CWT_BACKFILL
+                                        : timing_model_t::TIMING_ECPT_PROBE;
+      }
+      timing_ref.walk.push_back(timing_model_t::walk_access_t {
+          pgtable_addr, search_res, kind, (unsigned int)page_walk_res.size() });
+  }
   page_walk_res.push_back((search_res));
   if (knobs.verbose >= 2) {
     printf("page_walk_res.back() %d\n", page_walk_res.back());
@@ -1837,6 +2431,109 @@ void cache_simulator_t::make_request(page_walk_hm_result_t& page_walk_res,
   return;
 }
 
+bool
+cache_simulator_t::checkpoint_init()
+{
+    if (!knobs.checkpoint_in.empty() && !knobs.checkpoint_out.empty()) {
+        error_string = "Usage error: -checkpoint_in and -checkpoint_out cannot be "
+                       "combined.";
+        return false;
+    }
+    if (!knobs.checkpoint_in.empty())
+        return restore_checkpoint();
+    if (knobs.checkpoint_out.empty())
+        return true;
+    if (knobs.warmup_refs == 0 && knobs.warmup_fraction == 0.0) {
+        error_string = "Usage error: -checkpoint_out needs -warmup_refs or "
+                       "-warmup_fraction.";
+        return false;
+    }
+    checkpoint_path = knobs.checkpoint_out;
+    if (!knobs.config_name.empty())
+        checkpoint_path += "." + knobs.config_name;
+    return checkpoint.open(checkpoint_path, error_string);
+}
+
+// The caches of a checkpoint, named, in a fixed order.  The TLB simulator
+// adds its own.
+std::vector<std::pair<std::string, caching_device_t *>>
+cache_simulator_t::checkpoint_devices() const
+{
+    std::vector<std::pair<std::string, caching_device_t *>> devices(all_caches.begin(),
+                                                                    all_caches.end());
+    std::sort(devices.begin(), devices.end());
+    for (unsigned int c = 0; c < knobs.num_cores; c++) {
+        std::string core = "core " + std::to_string(c);
+        if (knobs.arch == RADIX) {
+            for (unsigned int i = 0; i < NUM_PWC; i++) {
+                devices.push_back(std::make_pair(core + " PWC " + std::to_string(i),
+                                                 pw_caches[c * NUM_PWC + i]));
+            }
+        } else {
+            for (unsigned int i = 0; i < NUM_CWC; i++) {
+                devices.push_back(std::make_pair(core + " CWC " + std::to_string(i),
+                                                 cwc_caches[c * NUM_CWC + i]));
+            }
+        }
+    }
+    return devices;
+}
+
+// Called once the warmup completes, with every pending reference simulated.
+void
+cache_simulator_t::save_checkpoint()
+{
+    checkpoint_header_t header;
+    header.arch = knobs.arch;
+    header.num_cores = knobs.num_cores;
+    header.trace_refs = num_request;
+    checkpoint.write_header(header);
+    checkpoint.write_vector(
+        std::vector<uint64_t>(ins_fetched, ins_fetched + knobs.num_cores));
+    for (auto &it : checkpoint_devices())
+        it.second->save_state(checkpoint, it.first);
+    tlb_sim->save_checkpoint(checkpoint);
+    std::string error;
+    if (checkpoint.close(error)) {
+        std::cerr << "Wrote checkpoint " << checkpoint_path << " after reference "
+                  << num_request << std::endl;
+    } else
+        std::cerr << error << std::endl;
+}
+
+bool
+cache_simulator_t::restore_checkpoint()
+{
+    checkpoint_reader_t in;
+    checkpoint_header_t header;
+    if (!in.open(knobs.checkpoint_in, &header, error_string))
+        return false;
+    if (header.arch != (uint32_t)knobs.arch || header.num_cores != knobs.num_cores) {
+        error_string = "Usage error: the checkpoint was taken with another -arch or "
+                       "-num_cores.";
+        return false;
+    }
+    std::vector<uint64_t> fetched;
+    if (!in.read_vector(fetched, knobs.num_cores)) {
+        error_string = "Failed to read checkpoint file " + knobs.checkpoint_in;
+        return false;
+    }
+    std::copy(fetched.begin(), fetched.end(), ins_fetched);
+    for (auto &it : checkpoint_devices()) {
+        if (!it.second->restore_state(in, it.first, error_string))
+            return false;
+    }
+    if (!tlb_sim->restore_checkpoint(in, error_string) || !in.close(error_string))
+        return false;
+    // The reader resumes after the references the checkpoint covers.
+    is_warmed_up = true;
+    knobs.warmup_refs = 0;
+    knobs.warmup_fraction = 0.0;
+    std::cerr << "Restored checkpoint " << knobs.checkpoint_in << ": resuming after "
+              << "reference " << header.trace_refs << std::endl;
+    return true;
+}
+
 // Return true if the number of warmup references have been executed or if
 // specified fraction of the llcaches has been loaded. Also return true if the
 // cache has already been warmed up. When there are multiple last level caches
@@ -1878,9 +2575,153 @@ cache_simulator_t::check_warmed_up()
     return false;
 }
 
+// Names of cache_result_t values in page walk trajectories.
+static const char *const cache_result_names[] = {
+    "MEMORY", "L1", "L2", "LLC", "WRONG", "RANGE_HIT", "RANGE_MISS", "PWC", "ZERO"
+};
+
+// Opens -interval_file and lists the devices whose counters it reports.
+bool
+cache_simulator_t::interval_init()
+{
+    if (knobs.interval_file.empty()) {
+        if (knobs.interval_refs > 0 || knobs.interval_instrs > 0) {
+            error_string = "Usage error: -interval_refs and -interval_instrs require "
+                           "-interval_file.";
+            return false;
+        }
+        return true;
+    }
+    if (knobs.interval_refs == 0 && knobs.interval_instrs == 0) {
+        error_string = "Usage error: -interval_file requires -interval_refs or "
+                       "-interval_instrs.";
+        return false;
+    }
+    std::string path = knobs.interval_file;
+    if (!knobs.config_name.empty())
+        path += "." + knobs.config_name;
+    interval_out = fopen(path.c_str(), "w");
+    if (interval_out == NULL) {
+        error_string = "Failed to open interval file " + path;
+        return false;
+    }
+
+    for (unsigned int i = 0; i < knobs.num_cores; i++) {
+        std::string core = "core" + std::to_string(i) + ".";
+        interval_devices.push_back({ core + "ITLB", tlb_sim->get_itlb(i), 0, 0 });
+        interval_devices.push_back({ core + "DTLB", tlb_sim->get_dtlb(i), 0, 0 });
+        interval_devices.push_back({ core + "L2TLB", tlb_sim->get_lltlb(i), 0, 0 });
+        interval_devices.push_back({ core + "L1I", l1_icaches[i], 0, 0 });
+        interval_devices.push_back({ core + "L1D", l1_dcaches[i], 0, 0 });
+        interval_devices.push_back({ core + "L2", l2_caches[i], 0, 0 });
+        if (knobs.arch == RADIX) {
+            for (unsigned int j = 0; j < NUM_PWC; j++) {
+                interval_devices.push_back(
+                    { core + "PWC" + std::to_string(j), pw_caches[i * NUM_PWC + j], 0, 0 });
+            }
+        } else if (knobs.arch == ECPT) {
+            for (unsigned int j = 0; j < NUM_CWC; j++) {
+                interval_devices.push_back(
+                    { core + "CWC" + std::to_string(j), cwc_caches[i * NUM_CWC + j], 0, 0 });
+            }
+        }
+    }
+    interval_devices.push_back({ "LLC", llc1, 0, 0 });
+
+    // Without warmup, measurement starts with the first reference.
+    if (knobs.warmup_refs == 0 && knobs.warmup_fraction == 0.0) {
+        interval_measuring = true;
+        interval_begin();
+    }
+    return true;
+}
+
+void
+cache_simulator_t::interval_begin()
+{
+    for (auto &dev : interval_devices) {
+        dev.hits = dev.device->get_stats()->get_hits();
+        dev.misses = dev.device->get_stats()->get_misses();
+    }
+    interval_walks.clear();
+    interval_first_ref += interval_num_refs;
+    interval_num_refs = 0;
+    interval_num_instrs = 0;
+}
+
+// Called after each reference has been simulated.
+void
+cache_simulator_t::interval_memref(const memref_t &memref)
+{
+    if (!interval_measuring) {
+        // The reference that completes warmup is not measured: the stats were
+        // reset after it was simulated.
+        if (is_warmed_up) {
+            interval_measuring = true;
+            interval_begin();
+        }
+        return;
+    }
+    if (knobs.sim_refs == 0 || memref.marker.type == TRACE_TYPE_MARKER)
+        return;
+    interval_num_refs++;
+    if (type_is_instr(memref.instr.type))
+        interval_num_instrs++;
+    if ((knobs.interval_refs > 0 && interval_num_refs >= knobs.interval_refs) ||
+        (knobs.interval_instrs > 0 && interval_num_instrs >= knobs.interval_instrs)) {
+        interval_write();
+        interval_index++;
+        interval_begin();
+    }
+}
+
+void
+cache_simulator_t::interval_write()
+{
+    fprintf(interval_out,
+            "{\"interval\":%" PRIu64 ",\"first_ref\":%" PRIu64 ",\"refs\":%" PRIu64
+            ",\"instrs\":%" PRIu64 ",\"stats\":{",
+            interval_index, interval_first_ref, interval_num_refs, interval_num_instrs);
+    const char *sep = "";
+    for (const auto &dev : interval_devices) {
+        int_least64_t hits = dev.device->get_stats()->get_hits();
+        int_least64_t misses = dev.device->get_stats()->get_misses();
+        int_least64_t base_hits = dev.hits;
+        int_least64_t base_misses = dev.misses;
+        // A device whose stats were reset during the interval (the TLBs
+        // finish their own warmup separately) counts from the reset.
+        if (hits < base_hits || misses < base_misses) {
+            base_hits = 0;
+            base_misses = 0;
+        }
+        fprintf(interval_out, "%s\"%s\":[%" PRId64 ",%" PRId64 "]", sep,
+                dev.name.c_str(), (int64_t)(hits - base_hits),
+                (int64_t)(misses - base_misses));
+        sep = ",";
+    }
+    fprintf(interval_out, "},\"walks\":{");
+    auto walks = interval_walks.entries();
+    std::sort(walks.begin(), walks.end());
+    sep = "";
+    for (const auto &walk : walks) {
+        fprintf(interval_out, "%s\"", sep);
+        for (unsigned int i = 0; i < walk.first.size(); i++) {
+            fprintf(interval_out, "%s%s", i == 0 ? "" : ",",
+                    cache_result_names[walk.first[i]]);
+        }
+        fprintf(interval_out, "\":%" PRIu64, walk.second);
+        sep = ",";
+    }
+    fprintf(interval_out, "}}\n");
+}
+
 bool
 cache_simulator_t::print_results()
 {
+    drain_epoch();
+    if (!knobs.config_name.empty()) {
+        std::cerr << "Sweep configuration: " << knobs.config_name << std::endl;
+    }
     tlb_sim->print_results();
     std::cerr << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << std::endl;
     std::cerr << "Cache simulation results:" << std::endl;
@@ -1893,8 +2734,12 @@ cache_simulator_t::print_results()
                 l1_icaches[i]->get_stats()->print_stats("    ");
                 std::cerr << "  L1D stats:" << std::endl;
                 l1_dcaches[i]->get_stats()->print_stats("    ");
+                if (l1_dcaches[i]->get_type_policy() != NULL)
+                    l1_dcaches[i]->get_type_policy()->print_stats("    ");
                 std::cerr << "  L2 stats:" << std::endl;
                 l2_caches[i]->get_stats()->print_stats("    ");
+                if (l2_caches[i]->get_type_policy() != NULL)
+                    l2_caches[i]->get_type_policy()->print_stats("    ");
             } else {
                 std::cerr << "  unified L1 stats:" << std::endl;
                 l1_icaches[i]->get_stats()->print_stats("    ");
@@ -1911,23 +2756,50 @@ cache_simulator_t::print_results()
     for (auto &caches_it : llcaches) {
         std::cerr << caches_it.first << " stats:" << std::endl;
         caches_it.second->get_stats()->print_stats("    ");
+        if (caches_it.second->get_type_policy() != NULL)
+            caches_it.second->get_type_policy()->print_stats("    ");
     }
 
 
-    if (knobs.arch == ECPT) {
-        // Print CWC stats.
-        for (unsigned int i = 0; i < NUM_CWC; i++) {
-            std::cerr << " CWC " << i << " stats:" << std::endl;
-            cwc_caches[i]->get_stats()->print_stats("    ");
+    if (snoop_filter != NULL) {
+        std::cerr << "Coherence directory stats:" << std::endl;
+        snoop_filter->print_stats("    ");
+    }
+    if (knobs.pte_write_shootdown) {
+        std::cerr << "PTE write shootdowns:" << std::endl;
+        std::cerr << "    PTE writes: " << shootdown_stats.pte_writes << std::endl;
+        std::cerr << "    TLB entries invalidated: " << shootdown_stats.tlb_entries
+                  << std::endl;
+        std::cerr << "    PWC entries invalidated: " << shootdown_stats.pwc_entries
+                  << std::endl;
+    }
+
+    // Print the CWC or PWC stats of each core that ran.
+    for (unsigned int c = 0; c < knobs.num_cores; c++) {
+        if (thread_ever_counts[c] == 0)
+            continue;
+        if (knobs.arch == ECPT) {
+            for (unsigned int i = 0; i < NUM_CWC; i++) {
+                std::cerr << " Core #" << c << " CWC " << i << " stats:" << std::endl;
+                cwc_caches[c * NUM_CWC + i]->get_stats()->print_stats("    ");
+            }
         }
-    } 
-    
-    if (knobs.arch == RADIX) {
-        // Print PWC stats.
-        
-        for (unsigned int i = 0; i < NUM_PWC; i++) {
-            std::cerr << " PWC " << i << " stats:" << std::endl;
-            pw_caches[i]->get_stats()->print_stats("    ");
+        if (knobs.arch == RADIX) {
+            for (unsigned int i = 0; i < NUM_PWC; i++) {
+                std::cerr << " Core #" << c << " PWC " << i << " stats:" << std::endl;
+                pw_caches[c * NUM_PWC + i]->get_stats()->print_stats("    ");
+            }
+        }
+    }
+    if (knobs.miss_ratio_curves) {
+        unsigned int levels = knobs.arch == RADIX ? NUM_PWC : NUM_CWC;
+        for (unsigned int i = 0; i < levels; i++) {
+            std::vector<miss_ratio_curve_t *> level_curves;
+            for (unsigned int c = 0; c < knobs.num_cores; c++)
+                level_curves.push_back(walk_curves[i * knobs.num_cores + c]);
+            std::cerr << " " << (knobs.arch == RADIX ? "PWC " : "CWC ") << i
+                      << " LRU miss ratio curve, all cores:" << std::endl;
+            miss_ratio_curve_t::print_curves(level_curves, "    ");
         }
     }
     
@@ -1956,22 +2828,11 @@ cache_simulator_t::print_results()
               << "num_range_not_found : " << num_range_not_found << std::endl;
     std::cerr << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << std::endl;
 
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wwrite-strings" 
-    char *print_hm_stats[] =
-    {
-        "MEMORY"
-        , "L1"
-        , "L2"
-        , "LLC"
-        , "WRONG"
-        , "RANGE_HIT"
-        , "RANGE_MISS"
-        , "PWC"
-        , "ZERO"
-    };
-#pragma GCC diagnostic pop 
-    for (hm_full_statistic_t::iterator it = hm_full_statistic.begin(); it != hm_full_statistic.end(); it++) {
+    const char *const *print_hm_stats = cache_result_names;
+    // The histograms are unordered: sort them as the maps they replace were.
+    auto walks = hm_full_statistic.entries();
+    std::sort(walks.begin(), walks.end());
+    for (auto it = walks.begin(); it != walks.end(); it++) {
       for(unsigned int i = 0; i < it->first.size(); i++) {
         std::cerr << print_hm_stats[it->first[i]] << ",";
       }
@@ -1980,9 +2841,10 @@ cache_simulator_t::print_results()
 
     if (knobs.arch == ECPT) {
         std::cerr << "~~~~~~ full stats with way ~~~~~~" << std::endl;
-        for (hm_full_stats_with_way_t::iterator it = hm_full_stats_with_way.begin();
-            it != hm_full_stats_with_way.end(); it++) {
-            page_walk_hm_result_t walk_res = it->first.first;
+        auto walks_with_way = hm_full_stats_with_way.entries();
+        std::sort(walks_with_way.begin(), walks_with_way.end());
+        for (auto it = walks_with_way.begin(); it != walks_with_way.end(); it++) {
+            const page_walk_hm_result_t &walk_res = it->first.first;
             uint64_t way = it->first.second;
             for (unsigned int i = 0; i < walk_res.size(); i++) {
                 std::cerr << print_hm_stats[walk_res[i]] << ",";
@@ -1995,8 +2857,10 @@ cache_simulator_t::print_results()
     }
 
     std::cerr << "~~~~~~ detailed perf stats ~~~~~~" << std::endl;
-    for (auto it = perf_to_cnt.begin(); it != perf_to_cnt.end(); it++) {
-        perf_result_t perf_res = it->first;
+    auto perf_results = perf_to_cnt.entries();
+    std::sort(perf_results.begin(), perf_results.end());
+    for (auto it = perf_results.begin(); it != perf_results.end(); it++) {
+        const perf_result_t &perf_res = it->first;
         std::cerr << "core=" << perf_res.core << ",is_inst=" << perf_res.is_inst
             << ",is_non_memory_exec=" << perf_res.is_non_memory_exec 
             <<",cached_ifb=" << perf_res.cached_ifb
@@ -2011,6 +2875,29 @@ cache_simulator_t::print_results()
         std::cerr << "\t" << it->second << std::endl;
     }
 
+    if (knobs.latency_model)
+        walk_latency.print_results();
+    if (knobs.timing_model)
+        timing_model.print_results();
+    if (sampler.enabled()) {
+        std::cerr << "Sampling results:" << std::endl;
+        sampler.print_results("    ");
+    }
+    if (page_tables.enabled()) {
+        std::cerr << "Synthetic page tables:" << std::endl;
+        page_tables.print_results("    ");
+    }
+
+    if (interval_out != NULL && interval_measuring && interval_num_refs > 0) {
+        interval_write();
+        fflush(interval_out);
+    }
+    if (checkpoint.is_open()) {
+        checkpoint.discard();
+        std::cerr << "No checkpoint written to " << checkpoint_path
+                  << ": the warmup did not complete." << std::endl;
+    }
+
     return true;
 }
 
@@ -2024,9 +2911,51 @@ cache_simulator_t::create_cache(const std::string &policy)
         return new cache_t;
     if (policy == REPLACE_POLICY_FIFO) // set to FIFO
         return new cache_fifo_t;
+    if (policy == REPLACE_POLICY_SRRIP)
+        return new policy_cache_t<srrip_policy_t>;
+    if (policy == REPLACE_POLICY_BRRIP)
+        return new policy_cache_t<brrip_policy_t>;
+    if (policy == REPLACE_POLICY_DRRIP)
+        return new policy_cache_t<drrip_policy_t>;
+    if (policy == REPLACE_POLICY_SHIP)
+        return new policy_cache_t<ship_policy_t>;
+    if (policy == REPLACE_POLICY_HAWKEYE)
+        return new policy_cache_t<hawkeye_policy_t>;
 
     // undefined replacement policy
     ERRMSG("Usage error: undefined replacement policy. "
-           "Please choose " REPLACE_POLICY_LRU " or " REPLACE_POLICY_LFU ".\n");
+           "Please choose " REPLACE_POLICY_LRU ", " REPLACE_POLICY_LFU
+           ", " REPLACE_POLICY_FIFO ", " REPLACE_POLICY_SRRIP ", " REPLACE_POLICY_BRRIP
+           ", " REPLACE_POLICY_DRRIP ", " REPLACE_POLICY_SHIP " or "
+           REPLACE_POLICY_HAWKEYE ".\n");
     return NULL;
 }
+
+bool
+cache_simulator_t::valid_prefetcher(const std::string &prefetcher)
+{
+    return prefetcher == PREFETCH_POLICY_NEXTLINE || prefetcher == PREFETCH_POLICY_STRIDE ||
+        prefetcher == PREFETCH_POLICY_STREAM || prefetcher == PREFETCH_POLICY_SPATIAL ||
+        prefetcher == PREFETCH_POLICY_NONE;
+}
+
+prefetcher_t *
+cache_simulator_t::create_prefetcher(const std::string &prefetcher)
+{
+    int line_size = (int)knobs.line_size;
+    if (prefetcher == PREFETCH_POLICY_NEXTLINE)
+        return new prefetcher_t(line_size);
+    if (prefetcher == PREFETCH_POLICY_STRIDE)
+        return new stride_prefetcher_t(line_size, (int)knobs.prefetch_degree);
+    if (prefetcher == PREFETCH_POLICY_STREAM)
+        return new stream_prefetcher_t(line_size, (int)knobs.prefetch_degree);
+    if (prefetcher == PREFETCH_POLICY_SPATIAL)
+        return new spatial_prefetcher_t(line_size);
+    return nullptr;
+}
+
+std::string
+cache_simulator_t::level_replace_policy(const std::string &level_policy) const
+{
+    return level_policy.empty() ? knobs.replace_policy : level_policy;
+}
@@ -48,8 +48,17 @@
 #include <unordered_map>
 
 #include "tlb_simulator.h"
+#include "flat_histogram.h"
+#include "walk_latency.h"
+#include "timing_model.h"
+#include "interference.h"
+#include "sampler.h"
+#include "page_table_builder.h"
+#include "llc_epoch_proxy.h"
+#include "epoch_workers.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
 
 struct hit_info_t {
@@ -61,7 +70,22 @@ struct hit_info_t {
 #define FRONTEND_FETCH_MASK (~(FRONTEND_FETCH_SIZE - 1))
 #define MAX_CPU_COUNT 64
 
+class page_walker_t;
+class radix_walker_t;
+class ecpt_walker_t;
+class hashed_walker_t;
+class flattened_walker_t;
+class nested_walker_t;
+
 class cache_simulator_t : public simulator_t {
+    // The translation schemes: see page_walker.h.
+    friend class page_walker_t;
+    friend class radix_walker_t;
+    friend class ecpt_walker_t;
+    friend class hashed_walker_t;
+    friend class flattened_walker_t;
+    friend class nested_walker_t;
+
 public:
     // This constructor is used when the cache hierarchy is configured
     // using a set of knobs. It assumes a 2-level cache hierarchy with
@@ -80,6 +104,13 @@ public:
     virtual bool
     print_results();
 
+    // With -sample_period, once the sampling error bound is met.
+    virtual bool
+    is_done()
+    {
+        return sampler.is_done();
+    }
+
     // Exposed to make it easy to test
     bool
     check_warmed_up();
@@ -90,6 +121,25 @@ protected:
     // Create a cache_t object with a specific replacement policy.
     virtual cache_t *
     create_cache(const std::string &policy);
+    static bool
+    valid_prefetcher(const std::string &prefetcher);
+    // Create the data prefetcher of a cache, or nullptr for none.
+    prefetcher_t *
+    create_prefetcher(const std::string &prefetcher);
+    // The policy of a level whose own policy knob is level_policy.
+    std::string
+    level_replace_policy(const std::string &level_policy) const;
+    // Create the per-core page walk or cuckoo walk caches.
+    bool
+    init_walk_caches(bool warmup_enabled);
+    // Attaches the -miss_ratio_curves of each walk cache level.
+    bool
+    init_walk_curves();
+    // Attach the page-table-aware policies of -pt_cache_policy.
+    bool
+    init_type_policies();
+    type_policy_t *
+    create_type_policy(bool bypass_leaf);
 
     cache_simulator_knobs_t knobs;
 
@@ -99,13 +149,21 @@ protected:
     cache_t **l1_dcaches;
     cache_t **l2_caches;
     cache_t  *llc1;
+    // Per-core page walk caches (radix) and cuckoo walk caches (ECPT),
+    // NUM_PWC or NUM_CWC levels per core.
     cache_t **pw_caches;
 
     cache_t **cwc_caches;
+    // With -miss_ratio_curves, those of the requests of each walk cache: level
+    // i of core c is walk_curves[i * num_cores + c].
+    std::vector<miss_ratio_curve_t *> walk_curves;
 
     //TLB(s)
     tlb_simulator_t *tlb_sim;
 
+    // With -coherence, the directory keeping the cores' L2 caches coherent.
+    snoop_filter_t *snoop_filter;
+
     struct page_table_info_t {
       long long unsigned int VA;
       long long unsigned int PE1;
@@ -164,14 +222,108 @@ protected:
     typedef std::vector<range_info_t> range_table_t;
     range_table_t range_table;
   
-    typedef std::vector<cache_result_t> page_walk_hm_result_t;
-    typedef std::map< page_walk_hm_result_t, uint64_t> hm_full_statistic_t;
+    // The cache_result_t of each step of a page walk.  Steps are packed 4 bits
+    // each, so a trajectory is copied, hashed and compared as two integers and
+    // never allocates.  The longest walk is a nested one, of 24 steps.
+    struct page_walk_hm_result_t {
+        static const unsigned int MAX_STEPS = 32;
+
+        page_walk_hm_result_t()
+            : bits { 0, 0 }
+            , len(0)
+        {
+        }
+        void
+        push_back(cache_result_t res)
+        {
+            assert(len < MAX_STEPS);
+            bits[len / 16] |= (uint64_t)res << (4 * (len % 16));
+            len++;
+        }
+        void
+        append(const page_walk_hm_result_t &other)
+        {
+            for (unsigned int i = 0; i < other.len; i++)
+                push_back(other[i]);
+        }
+        void
+        clear()
+        {
+            bits[0] = 0;
+            bits[1] = 0;
+            len = 0;
+        }
+        size_t
+        size() const
+        {
+            return len;
+        }
+        cache_result_t
+        operator[](size_t i) const
+        {
+            return (cache_result_t)((bits[i / 16] >> (4 * (i % 16))) & 0xf);
+        }
+        cache_result_t
+        back() const
+        {
+            return (*this)[len - 1];
+        }
+        bool
+        operator==(const page_walk_hm_result_t &other) const
+        {
+            return bits[0] == other.bits[0] && bits[1] == other.bits[1] &&
+                len == other.len;
+        }
+        bool
+        operator!=(const page_walk_hm_result_t &other) const
+        {
+            return !(*this == other);
+        }
+        // Lexicographic, like the std::vector this replaces, so that results
+        // print in the same order.
+        bool
+        operator<(const page_walk_hm_result_t &other) const
+        {
+            for (unsigned int i = 0; i < len && i < other.len; i++) {
+                if ((*this)[i] != other[i])
+                    return (*this)[i] < other[i];
+            }
+            return len < other.len;
+        }
+        size_t
+        hash() const
+        {
+            return flat_histogram_mix(bits[0] ^ ((uint64_t)len << 59) ^
+                                      (bits[1] * 0x9e3779b97f4a7c15ULL));
+        }
+
+        uint64_t bits[2];
+        uint32_t len;
+    };
+    static_assert(ZERO < 16, "page walk steps are packed in 4 bits");
+
+    struct page_walk_hash_t {
+        size_t
+        operator()(const page_walk_hm_result_t &res) const
+        {
+            return res.hash();
+        }
+    };
+    typedef flat_histogram_t<page_walk_hm_result_t, page_walk_hash_t> hm_full_statistic_t;
 
     /* <result, selected_way -> frequency> */
-    typedef std::map<std::pair<page_walk_hm_result_t, uint64_t>, uint64_t> hm_full_stats_with_way_t;
+    typedef std::pair<page_walk_hm_result_t, uint64_t> page_walk_with_way_t;
+    struct page_walk_with_way_hash_t {
+        size_t
+        operator()(const page_walk_with_way_t &key) const
+        {
+            return key.first.hash() ^ flat_histogram_mix(key.second);
+        }
+    };
+    typedef flat_histogram_t<page_walk_with_way_t, page_walk_with_way_hash_t>
+        hm_full_stats_with_way_t;
 
     hm_full_statistic_t hm_full_statistic;
-    page_walk_hm_result_t page_walk_res;
     hm_full_stats_with_way_t hm_full_stats_with_way;
 
 
@@ -216,22 +368,121 @@ protected:
 
         return data_cache < other.data_cache;
       }
+
+      bool operator==(const perf_result_t & other) const {
+        return core == other.core && is_inst == other.is_inst &&
+            cached_ifb == other.cached_ifb &&
+            is_non_memory_exec == other.is_non_memory_exec &&
+            tlb_hit == other.tlb_hit && pgwalk_res == other.pgwalk_res &&
+            ecpt_selected_way == other.ecpt_selected_way &&
+            data_cache == other.data_cache;
+      }
     };
 
-    std::map<perf_result_t, uint64_t> perf_to_cnt;
+    struct perf_result_hash_t {
+      size_t operator()(const perf_result_t & res) const {
+        uint64_t fields = ((uint64_t)res.core << 32) | ((uint64_t)res.ecpt_selected_way << 8) |
+            ((uint64_t)res.data_cache << 4) | (res.is_inst << 3) |
+            (res.cached_ifb << 2) | (res.is_non_memory_exec << 1) | res.tlb_hit;
+        return res.pgwalk_res.hash() ^ flat_histogram_mix(fields);
+      }
+    };
 
-    bool process_memref_radix(const memref_t &memref);
-    bool process_memref_ecpt(const memref_t &memref);
+    flat_histogram_t<perf_result_t, perf_result_hash_t> perf_to_cnt;
+    void record_perf_result(const perf_result_t &perf_res, uint64_t backfill_cycles = 0);
+    // The walk_latency_t cycles of the page walk of a reference, 0 if none.
+    uint64_t walk_cycles(const perf_result_t &perf_res, uint64_t backfill_cycles) const;
+    void record_page_walk(const page_walk_hm_result_t &page_walk_res);
+
+    // A reference on its way through process_memref(): schedule_memref() fills
+    // in how to simulate it, simulate_memref() runs it on the core's caches,
+    // TLBs and walk caches, record_memref() counts the outcome and
+    // retire_memref() does the warmup and simulation bookkeeping.
+    struct sim_ref_t {
+        memref_t memref;
+        bool simulate;
+        int core;
+        bool functional_warmup;
+        // Whether the reference is in a -sample_period measurement window.
+        bool sampled;
+        bool walk_success;
+        // The core whose TLBs are searched, or -1 to use tlb_hit as is.
+        int tlb_core;
+        bool tlb_hit;
+        bool tlb_warmup_done;
+
+        perf_result_t perf_res;
+        uint64_t backfill_cycles;
+        // Whether perf_res is counted and whether it holds a page walk.
+        bool record;
+        bool walked;
+        // End of the reference's accesses in its core's llc_proxies log.
+        size_t llc_log_end;
+    };
+    bool schedule_memref(const memref_t &memref, sim_ref_t &ref);
+    bool simulate_memref(sim_ref_t &ref);
+    // process_memref(), simulate_memref() and walk_cycles() for one page
+    // walker, chosen by init_page_walker().
+    template <typename walker_t>
+    bool process_translation(const memref_t &memref);
+    template <typename walker_t>
+    bool simulate_translation(sim_ref_t &ref);
+    bool init_page_walker();
+    bool (cache_simulator_t::*process_fn)(const memref_t &memref);
+    bool (cache_simulator_t::*simulate_fn)(sim_ref_t &ref);
+    uint64_t (*walk_cycles_fn)(const cache_simulator_t &sim, const perf_result_t &perf_res,
+                               uint64_t finish_cycles);
+    void prefetch_next_translation(const memref_t &memref, const addr_t *walk_steps,
+                                   uint64_t pgwalk_steps, int tlb_core, int core);
+    // The last distinct pages each core's data accesses touched, for the
+    // sequential TLB prefetcher, or empty without it.
+    static const int TLB_PREFETCH_HISTORY = 4;
+    std::vector<addr_t> tlb_prefetch_pages;
+    // With -pte_write_shootdown, the page table entries the walks read, by
+    // physical address, with the level of each and the first virtual address
+    // it maps.  A write to one shoots down the translations and page walk
+    // cache entries it covers on every core.
+    struct pte_mapping_t {
+        addr_t vaddr;
+        unsigned int level;
+    };
+    std::unordered_map<addr_t, pte_mapping_t> pte_mappings;
+    struct shootdown_stats_t {
+        shootdown_stats_t()
+            : pte_writes(0)
+            , tlb_entries(0)
+            , pwc_entries(0)
+        {
+        }
+        uint64_t pte_writes;
+        uint64_t tlb_entries;
+        uint64_t pwc_entries;
+    };
+    shootdown_stats_t shootdown_stats;
+    void record_pte_mappings(addr_t vaddr, const addr_t *walk_steps, uint64_t pgwalk_steps);
+    void check_pte_write(const memref_t &memref);
+    void record_memref(const sim_ref_t &ref);
+    void retire_memref(const sim_ref_t &ref);
+
+    // Parallel simulation (-sim_threads): instruction and data references are
+    // queued per core in epoch_refs and simulated by drain_epoch().
+    std::vector<sim_ref_t> epoch_refs;
+    std::vector<std::vector<uint32_t>> epoch_core_refs;
+    std::vector<llc_epoch_proxy_t *> llc_proxies;
+    epoch_workers_t epoch_workers;
+    bool epoch_init(const tlb_simulator_knobs_t &tlb_knobs);
+    void epoch_work(unsigned int worker);
+    void drain_epoch();
 
     hit_info_t visit_cwc(uint64_t full_vaddr, const _memref_pgtable_results &pgtable_result,
-              std::set<uint32_t> &ways_to_visit);
-    bool __cwc_query(uint64_t cwc_vpn, uint32_t cwc_idx);
-    bool pud_cwc_query(uint64_t full_vaddr);
-    bool pmd_cwc_query(uint64_t full_vaddr);
+              std::set<uint32_t> &ways_to_visit, int core);
+    bool __cwc_query(uint64_t cwc_vpn, uint32_t cwc_idx, int core);
+    bool pud_cwc_query(uint64_t full_vaddr, int core);
+    bool pmd_cwc_query(uint64_t full_vaddr, int core);
 
-    unsigned int visit_pwc(uint64_t full_vaddr, uint64_t pgwalk_steps);
+    unsigned int visit_pwc(uint64_t full_vaddr, uint64_t pgwalk_steps, int core);
     void cwt_back_fill_one_way(page_walk_hm_result_t & res, uint64_t cwt_entry_addr, int core);
-    void cwt_back_fill(hit_info_t hit_info, const _memref_pgtable_results &pgtable_result, int core);
+    uint64_t cwt_back_fill(hit_info_t hit_info, const _memref_pgtable_results &pgtable_result, int core);
 
     // void make_request(page_walk_hm_result_t& page_walk_res, trace_type_t type, long long unsigned int base_addr, long long unsigned int addr_to_find, int level, int core);
     void make_request(page_walk_hm_result_t& page_walk_res, trace_type_t type, long long unsigned int pgtable_addr, int core);
@@ -251,8 +502,75 @@ protected:
     std::unordered_map<std::string, cache_t *> all_caches;   // All caches.
 
     uint64_t ins_fetched[MAX_CPU_COUNT];
+
+    uint64_t num_request;
+    uint64_t num_request_shifted;
+    uint64_t num_not_found;
+    uint64_t num_range_found;
+    uint64_t num_range_not_found;
+
+    // The co-runner's requests injected by -contention_L1 and -contention_LLC.
+    interference_t interference;
+    bool init_interference();
+    void inject_interference(int core, cache_result_t search_res);
+
+    // The walks of -synthetic_page_tables and of the -translation_scheme
+    // schemes no trace records.
+    page_table_builder_t page_tables;
+
+    // Periodic statistics written to -interval_file.  Device counters are
+    // snapshotted at the start of each interval and the deltas are written at
+    // its end; trajectories are also counted into interval_walks.
+    struct interval_device_t {
+        std::string name;
+        caching_device_t *device;
+        int_least64_t hits;
+        int_least64_t misses;
+    };
+    FILE *interval_out;
+    bool interval_measuring;
+    uint64_t interval_index;
+    uint64_t interval_first_ref;
+    uint64_t interval_num_refs;
+    uint64_t interval_num_instrs;
+    std::vector<interval_device_t> interval_devices;
+    hm_full_statistic_t interval_walks;
+
+    // Translation latency model (-latency_model).
+    walk_latency_t walk_latency;
+    // Cycle-approximate timing model (-timing_model).  The walk steps of the
+    // reference being simulated are logged by make_request().
+    timing_model_t timing_model;
+    timing_model_t::timing_ref_t timing_ref;
+    void record_timing(const sim_ref_t &ref);
+    bool interval_init();
+    void interval_begin();
+    void interval_memref(const memref_t &memref);
+    void interval_write();
+    // The warm state of the structures: written to -checkpoint_out once the
+    // warmup completes, or read from -checkpoint_in in place of the warmup.
+    checkpoint_writer_t checkpoint;
+    std::string checkpoint_path;
+    bool checkpoint_init();
+    std::vector<std::pair<std::string, caching_device_t *>> checkpoint_devices() const;
+    void save_checkpoint();
+    bool restore_checkpoint();
 private:
     bool is_warmed_up;
+    // Set for each reference processed while -warmup_functional is warming
+    // up the caches: only cache, TLB and PWC state is updated.
+    bool functional_warmup;
+    bool
+    in_functional_warmup() const
+    {
+        if (sampler.enabled())
+            return sample_phase == SAMPLE_FUNCTIONAL;
+        return knobs.warmup_functional && !is_warmed_up &&
+            (knobs.warmup_refs > 0 || knobs.warmup_fraction > 0.0);
+    }
+    // The -sample_period schedule and the phase of the last reference.
+    sampler_t sampler;
+    sample_phase_t sample_phase;
 };
 
 #endif /* _CACHE_SIMULATOR_H_ */
@@ -64,18 +64,93 @@ struct cache_simulator_knobs_t {
         , LL_assoc(16)
         , LL_miss_file("")
         , replace_policy("LRU")
+        , L1I_replace("")
+        , L1D_replace("")
+        , L2_replace("")
+        , LL_replace("")
         , data_prefetcher("nextline")
+        , prefetch_degree(2)
+        , prefetch_late_refs(16)
+        , tlb_prefetcher("none")
         , skip_refs(0)
         , warmup_refs(0)
         , warmup_fraction(0.0)
         , sim_refs(1ULL << 63)
+        , warmup_functional(false)
+        , interval_refs(0)
+        , interval_instrs(0)
+        , interval_file("")
+        , latency_model(false)
+        , walk_latencies("")
+        , ecpt_parallel_cwc(true)
+        , cwt_backfill_overlap(true)
+        , timing_model(false)
+        , timing_params("")
+        , issue_window(1)
+        , page_walkers(1)
+        , miss_ratio_curves(false)
+        , mrc_max_entries(4096)
+        , mrc_assocs("")
+        , mrc_sample_sets(1)
+        , checkpoint_out("")
+        , checkpoint_in("")
+        , sample_period(0)
+        , sample_window(10000)
+        , sample_warmup(2000)
+        , sample_skip(0)
+        , sample_error(0.03)
+        , sample_confidence(0.997)
         , cpu_scheduling(false)
+        , core_from_access_cpu(false)
+        , sim_threads(1)
+        , epoch_refs(0)
         , verbose(0)
         , pt_dump_filename("")
         , pt_ranges_file("")
         , num_ranges(16)
         , contention_L1(0)
         , contention_LLC(0)
+        , interference_source("uniform")
+        , interference_trace("")
+        , interference_working_set(1ULL << 31)
+        , interference_stride(64)
+        , interference_seed(42)
+        , arch(RADIX)
+        , ecpt_early_return(true)
+        , ecpt_cache_correct_only(false)
+        , mmu_to_l2(false)
+        , pt_cache_policy("")
+        , pt_policy_caches("LLC")
+        , pt_partition_ways(2)
+        , pt_priority_levels(4)
+        , pt_bypass_l1(false)
+        , coherence(false)
+        , pte_write_shootdown(false)
+        , pwc_asplos_config(false)
+        , PWC_PGD_entries(0)
+        , PWC_PGD_assoc(0)
+        , PWC_PGD_replace("")
+        , PWC_PUD_entries(0)
+        , PWC_PUD_assoc(0)
+        , PWC_PUD_replace("")
+        , PWC_PMD_entries(0)
+        , PWC_PMD_assoc(0)
+        , PWC_PMD_replace("")
+        , CWC_PUD_entries(2)
+        , CWC_PUD_assoc(2)
+        , CWC_PUD_replace("")
+        , CWC_PMD_entries(16)
+        , CWC_PMD_assoc(16)
+        , CWC_PMD_replace("")
+        , ECPT_4K_ways(3)
+        , ECPT_2M_ways(3)
+        , ECPT_1G_ways(0)
+        , CWT_2M_ways(2)
+        , CWT_1G_ways(2)
+        , synthetic_page_tables(false)
+        , synthetic_page_size("4K")
+        , translation_scheme("")
+        , config_name("")
     {
     }
     unsigned int num_cores;
@@ -90,25 +165,123 @@ struct cache_simulator_knobs_t {
     unsigned int LL_assoc;
     std::string LL_miss_file;
     std::string replace_policy;
+    // Per-level replacement policies; empty uses replace_policy.
+    std::string L1I_replace;
+    std::string L1D_replace;
+    std::string L2_replace;
+    std::string LL_replace;
     std::string data_prefetcher;
+    unsigned int prefetch_degree;
+    uint64_t prefetch_late_refs;
+    std::string tlb_prefetcher;
     uint64_t skip_refs;
     uint64_t warmup_refs;
     double warmup_fraction;
     uint64_t sim_refs;
+    bool warmup_functional;
+    uint64_t interval_refs;
+    uint64_t interval_instrs;
+    std::string interval_file;
+    bool latency_model;
+    std::string walk_latencies;
+    bool ecpt_parallel_cwc;
+    bool cwt_backfill_overlap;
+    // Cycle-approximate timing of the hierarchy, with each core's references
+    // issued in a window of issue_window and walked by page_walkers walkers.
+    bool timing_model;
+    std::string timing_params;
+    unsigned int issue_window;
+    unsigned int page_walkers;
+    // LRU miss ratio curves of each walk cache level: see miss_ratio_curve_t.
+    bool miss_ratio_curves;
+    unsigned int mrc_max_entries;
+    std::string mrc_assocs;
+    unsigned int mrc_sample_sets;
+    // Where to write the warm state once the warmup completes, or to read it
+    // from instead of warming up.
+    std::string checkpoint_out;
+    std::string checkpoint_in;
+    // SMARTS-style sampling: every sample_period references, sample_skip are
+    // not simulated, sample_warmup precede the sample_window measured ones and
+    // the rest only warm the structures.  The simulation stops once every
+    // metric is within sample_error at sample_confidence.  See sampler_t.
+    uint64_t sample_period;
+    uint64_t sample_window;
+    uint64_t sample_warmup;
+    uint64_t sample_skip;
+    double sample_error;
+    double sample_confidence;
     bool cpu_scheduling;
+    bool core_from_access_cpu;
+    unsigned int sim_threads;
+    uint64_t epoch_refs;
     unsigned int verbose;
     std::string pt_dump_filename;
     std::string pt_ranges_file;
     unsigned int num_ranges;
+    // Interference requests per reference, in hundredths, injected into the
+    // L1D and the LLC, and where their addresses come from.
     unsigned int contention_L1;
     unsigned int contention_LLC;
+    std::string interference_source;
+    std::string interference_trace;
+    uint64_t interference_working_set;
+    unsigned int interference_stride;
+    unsigned int interference_seed;
 
     trans_arch arch;
     bool ecpt_early_return;
     bool ecpt_cache_correct_only;
 
     bool mmu_to_l2;
+    // Page-table-aware policy of the caches in pt_policy_caches, empty for
+    // none, and whether leaf page table lines bypass the L1D.
+    std::string pt_cache_policy;
+    std::string pt_policy_caches;
+    unsigned int pt_partition_ways;
+    unsigned int pt_priority_levels;
+    bool pt_bypass_l1;
+    // A MESI directory over the cores' L2 caches, and TLB shootdowns and page
+    // walk cache invalidations on writes to page table entries.
+    bool coherence;
+    bool pte_write_shootdown;
     bool pwc_asplos_config;
+    // Page walk cache geometry per radix level.  0 entries or assoc takes the
+    // -pwc_asplos_config preset and an empty policy takes replace_policy.
+    unsigned int PWC_PGD_entries;
+    unsigned int PWC_PGD_assoc;
+    std::string PWC_PGD_replace;
+    unsigned int PWC_PUD_entries;
+    unsigned int PWC_PUD_assoc;
+    std::string PWC_PUD_replace;
+    unsigned int PWC_PMD_entries;
+    unsigned int PWC_PMD_assoc;
+    std::string PWC_PMD_replace;
+    // Cuckoo walk cache geometry.
+    unsigned int CWC_PUD_entries;
+    unsigned int CWC_PUD_assoc;
+    std::string CWC_PUD_replace;
+    unsigned int CWC_PMD_entries;
+    unsigned int CWC_PMD_assoc;
+    std::string CWC_PMD_replace;
+    // ECPT and CWT ways per page size.  These must match the layout the
+    // trace was recorded with.
+    unsigned int ECPT_4K_ways;
+    unsigned int ECPT_2M_ways;
+    unsigned int ECPT_1G_ways;
+    unsigned int CWT_2M_ways;
+    unsigned int CWT_1G_ways;
+    // Walk page tables built from the trace's addresses instead of the walks
+    // it records: see page_table_builder_t.
+    bool synthetic_page_tables;
+    std::string synthetic_page_size;
+    // The translation scheme of the TLB misses, empty for arch's: see
+    // page_walker_t.
+    std::string translation_scheme;
+
+    // Name of the configuration when several are simulated in one pass
+    // (see -sweep_file).  Empty for a regular single-configuration run.
+    std::string config_name;
 };
 
 /** Creates an instance of a cache simulator with a 3-level hierarchy and TLBs. */
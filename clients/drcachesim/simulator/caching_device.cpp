@@ -36,126 +36,34 @@
 #include "prefetcher.h"
 #include "../common/utils.h"
 #include <assert.h>
+#include <typeinfo>
 
 #include <iostream>
 
 
-cache_result_t got_from_parent(cache_result_t cur) {
-  if (cur != NOT_FOUND) {
-    cur = static_cast<cache_result_t>(static_cast<int>(cur) + 1);
-  }
-  return cur;
-}
-
-
 caching_device_t::caching_device_t()
-    : blocks(NULL)
+    : num_requests(0)
+    , prefetch_late_refs(0)
     , stats(NULL)
     , prefetcher(NULL)
+    , snoop_filter(NULL)
+    , snoop_id(0)
+    , coherent(false)
+    , type_policy(NULL)
+    , curve(NULL)
 {
     /* Empty. */
 }
 
 caching_device_t::~caching_device_t()
 {
-    if (blocks == NULL)
-        return;
-    for (int i = 0; i < num_blocks; i++)
-        delete blocks[i];
-    delete[] blocks;
 }
 
 cache_result_t
-caching_device_t::request(const memref_t &memref_in) {
-    // Unfortunately we need to make a copy for our loop so we can pass
-    // the right data struct to the parent and stats collectors.
-    memref_t memref;
-    // std::cerr << "Received addr: " << std::hex << memref_in.data.addr << std::dec << std::endl; 
-    // We support larger sizes to improve the IPC perf.
-    // This means that one memref could touch multiple blocks.
-    // We treat each block separately for statistics purposes.
-    addr_t final_addr = memref_in.data.addr + memref_in.data.size - 1 /*avoid overflow*/;
-    addr_t final_tag = compute_tag(final_addr);
-    addr_t tag = compute_tag(memref_in.data.addr);
-
-    cache_result_t res = NOT_FOUND;
-
-    // Optimization: check last tag if single-block
-    if (tag == final_tag && tag == last_tag) {
-        // Make sure last_tag is properly in sync.
-        assert(tag != TAG_INVALID &&
-               tag == get_caching_device_block(last_block_idx, last_way).tag);
-        stats->access(memref_in, true /*hit*/);
-        if (parent != NULL)
-            parent->stats->child_access(memref_in, true);
-        access_update(last_block_idx, last_way);
-        res = FOUND_L1;
-        return res;
-    }
-
-    memref = memref_in;
-    for (; tag <= final_tag; ++tag) {
-        int way;
-        int block_idx = compute_block_idx(tag);
-        bool missed = false;
-
-        if (tag + 1 <= final_tag)
-            memref.data.size = ((tag + 1) << block_size_bits) - memref.data.addr;
-
-        for (way = 0; way < associativity; ++way) {
-            // printf ("Tag: %lx, Block: %d, Way: %d block_tag %lx\n", tag, block_idx, way, get_caching_device_block(block_idx, way).tag);
-            if (get_caching_device_block(block_idx, way).tag == tag) {
-                stats->access(memref, true /*hit*/);
-                res = FOUND_L1;
-                if (parent != NULL)
-                    parent->stats->child_access(memref, true);
-                break;
-            }
-        }
-        if (way == associativity) {
-            stats->access(memref, false /*miss*/);
-            missed = true;
-            // If no parent we assume we get the data from main memory
-            if (parent != NULL) {
-                parent->stats->child_access(memref, false);
-                res = parent->request(memref);
-                res = got_from_parent(res);
-            }
-
-            // FIXME i#1726: coherence policy
-
-            way = replace_which_way(block_idx);
-            // Check if we are inserting a new block, if we are then increment
-            // the block loaded count.
-            if (get_caching_device_block(block_idx, way).tag == TAG_INVALID) {
-                loaded_blocks++;
-            } else if (inclusive && !children.empty()) {
-                for (auto &child : children) {
-                    child->invalidate(get_caching_device_block(block_idx, way).tag);
-                }
-            }
-            get_caching_device_block(block_idx, way).tag = tag;
-        }
-
-        access_update(block_idx, way);
-
-        // Issue a hardware prefetch, if any, before we remember the last tag,
-        // so we remember this line and not the prefetched line.
-        if (missed && !type_is_prefetch(memref.data.type) && prefetcher != nullptr)
-            prefetcher->prefetch(this, memref);
-
-        if (tag + 1 <= final_tag) {
-            addr_t next_addr = (tag + 1) << block_size_bits;
-            memref.data.addr = next_addr;
-            memref.data.size = final_addr - next_addr + 1 /*undo the -1*/;
-        }
-
-        // Optimization: remember last tag
-        last_tag = tag;
-        last_way = way;
-        last_block_idx = block_idx;
-    }
-    return res;
+caching_device_t::request(const memref_t &memref_in)
+{
+    lfu_policy_t policy;
+    return request_with_policy(memref_in, policy);
 }
 
 bool
@@ -189,7 +97,12 @@ caching_device_t::init(int associativity_, int block_size_, int num_blocks_,
     stats = stats_;
     prefetcher = prefetcher_;
 
-    blocks = new caching_device_block_t *[num_blocks];
+    tags.assign(num_blocks, TAG_INVALID);
+    // Initializing counters to 0 is just to be safe and to make it easier to
+    // write new replacement algorithms without errors, as we expect any use of
+    // a counter to only occur *after* a valid tag is put in place.
+    counters.assign(num_blocks, 0);
+    prefetch_fills.assign(num_blocks, 0);
     init_blocks();
 
     last_tag = TAG_INVALID; // sentinel
@@ -200,60 +113,115 @@ caching_device_t::init(int associativity_, int block_size_, int num_blocks_,
     return true;
 }
 
+bool
+caching_device_t::set_type_policy(type_policy_t *type_policy_)
+{
+    if (type_policy_ != NULL && !type_policy_->init(associativity, num_blocks))
+        return false;
+    type_policy = type_policy_;
+    return true;
+}
 
-void
-caching_device_t::access_update(int block_idx, int way)
+bool
+caching_device_t::probe(addr_t addr)
 {
-    // We just inc the counter for LFU.  We live with any blip on overflow.
-    get_caching_device_block(block_idx, way).counter++;
+    addr_t tag = compute_tag(addr);
+    int block_idx = compute_block_idx(tag);
+    return find_way(&tags[block_idx], associativity, tag) < associativity;
 }
 
-int
-caching_device_t::replace_which_way(int block_idx)
+void
+caching_device_t::invalidate(const addr_t tag, invalidation_type_t type)
 {
-    // The base caching device class only implements LFU.
-    // A subclass can override this and access_update() to implement
-    // some other scheme.
-    int min_counter = 0; /* avoid "may be used uninitialized" with GCC 4.4.7 */
-    int min_way = 0;
-    for (int way = 0; way < associativity; ++way) {
-        if (get_caching_device_block(block_idx, way).tag == TAG_INVALID) {
-            min_way = way;
-            break;
+    int block_idx = compute_block_idx(tag);
+    int way = find_way(&tags[block_idx], associativity, tag);
+
+    if (way < associativity) {
+        // The directory already dropped the block on a coherence invalidation.
+        if (coherent && type != INVALIDATION_COHERENCE)
+            snoop_filter->snoop_eviction(tag, snoop_id);
+        if (type == INVALIDATION_COHERENCE)
+            coherence_invalidated.insert(tag);
+        tags[block_idx + way] = TAG_INVALID;
+        counters[block_idx + way] = 0;
+        if (prefetch_fills[block_idx + way] != 0) {
+            stats->prefetch_evict();
+            prefetch_fills[block_idx + way] = 0;
+        }
+        if (type_policy != NULL)
+            type_policy->invalidate(block_idx + way);
+        stats->invalidate(type);
+        // Invalidate last_tag if it was this tag.
+        if (last_tag == tag) {
+            last_tag = TAG_INVALID;
         }
-        if (way == 0 || get_caching_device_block(block_idx, way).counter < min_counter) {
-            min_counter = get_caching_device_block(block_idx, way).counter;
-            min_way = way;
+        // Invalidate the block in the children's caches.
+        if (inclusive && !children.empty()) {
+            for (auto &child : children) {
+                child->invalidate(tag, type);
+            }
         }
     }
-    // Clear the counter for LFU.
-    get_caching_device_block(block_idx, min_way).counter = 0;
-    return min_way;
 }
 
 void
-caching_device_t::invalidate(const addr_t tag)
+caching_device_t::save_state(checkpoint_writer_t &out, const std::string &name) const
 {
-    int block_idx = compute_block_idx(tag);
+    out.write_string(name);
+    out.write_u32(associativity);
+    out.write_u32(block_size);
+    out.write_u32(num_blocks);
+    // The dynamic type names the replacement policy.
+    out.write_string(typeid(*this).name());
+    out.write_vector(tags);
+    out.write_vector(counters);
+}
 
-    for (int way = 0; way < associativity; ++way) {
-        auto &cache_block = get_caching_device_block(block_idx, way);
-        if (cache_block.tag == tag) {
-            cache_block.tag = TAG_INVALID;
-            cache_block.counter = 0;
-            stats->invalidate();
-            // Invalidate last_tag if it was this tag.
-            if (last_tag == tag) {
-                last_tag = TAG_INVALID;
-            }
-            // Invalidate the block in the children's caches.
-            if (inclusive && !children.empty()) {
-                for (auto &child : children) {
-                    child->invalidate(tag);
-                }
-            }
-            break;
+bool
+caching_device_t::restore_state(checkpoint_reader_t &in, const std::string &name,
+                                std::string &error)
+{
+    if (in.read_string() != name) {
+        error = "Usage error: the checkpoint has no state for " + name +
+            " where expected: it was taken with another configuration.";
+        return false;
+    }
+    int assoc = in.read_u32();
+    int size = in.read_u32();
+    int blocks = in.read_u32();
+    if (assoc != associativity || size != block_size || blocks != num_blocks) {
+        error = "Usage error: the checkpoint's " + name + " has another geometry.";
+        return false;
+    }
+    bool same_policy = in.read_string() == typeid(*this).name();
+    std::vector<int> saved_counters;
+    if (!in.read_vector(tags, num_blocks) ||
+        !in.read_vector(saved_counters, num_blocks)) {
+        error = "Failed to read the checkpoint's " + name + ".";
+        return false;
+    }
+    if (same_policy)
+        counters = saved_counters;
+    loaded_blocks = 0;
+    for (addr_t tag : tags) {
+        if (tag != TAG_INVALID)
+            loaded_blocks++;
+    }
+    last_tag = TAG_INVALID;
+    return true;
+}
+
+int
+caching_device_t::invalidate_range(addr_t first_tag, addr_t last_tag_, invalidation_type_t type)
+{
+    int count = 0;
+    for (int block = 0; block < num_blocks; block++) {
+        addr_t tag = tags[block];
+        if (tag != TAG_INVALID && tag >= first_tag && tag <= last_tag_) {
+            invalidate(tag, type);
+            count++;
         }
     }
+    return count;
 }
 
@@ -36,17 +36,98 @@
 #ifndef _CACHING_DEVICE_H_
 #define _CACHING_DEVICE_H_ 1
 
+#include <assert.h>
+#include <unordered_set>
 #include <vector>
 
 #include "caching_device_block.h"
+#include "checkpoint.h"
 #include "caching_device_stats.h"
 #include "memref.h"
+#include "miss_ratio_curve.h"
 #include "prefetcher.h"
+#include "snoop_filter.h"
+#include "type_policy.h"
+#include "way_lookup.h"
 
 // Statistics collection is abstracted out into the caching_device_stats_t class.
 
 // Different replacement policies are expected to be implemented by
-// subclassing caching_device_t.
+// subclassing caching_device_t and passing a policy object, like lfu_policy_t
+// below, to request_with_policy().
+
+// Block state is kept per field, in arrays indexed by block_idx + way, so that
+// the tags of a set are contiguous.  A replacement policy works on one set at
+// a time, given its index, tags and counters and the access being made:
+// - init() is called once the blocks are allocated, with every counter 0.
+// - access_update() is called on a hit.
+// - replace_which_way() is called on a miss and picks the way to fill among
+//   [first_way, end_way), which is the whole set unless a type policy (see
+//   type_policy.h) partitions it.
+// - insert_update() is called once the new tag is in the picked way.
+// - promote() gives a block just inserted the retention of one just hit,
+//   without training any predictor on it.
+// Policies without per-device state, like the ones below, use static members.
+
+// Least frequently used, the default: the counter counts accesses.
+struct lfu_policy_t {
+    static inline void
+    init(int num_sets, int associativity, int *counters)
+    {
+    }
+    static inline void
+    access_update(int set, const addr_t *tags, int *counters, int associativity, int way,
+                  const memref_t &memref)
+    {
+        // We just inc the counter for LFU.  We live with any blip on overflow.
+        counters[way]++;
+    }
+    static inline int
+    replace_which_way(int set, const addr_t *tags, int *counters, int associativity,
+                      int first_way, int end_way, const memref_t &memref)
+    {
+        int min_counter = 0; /* avoid "may be used uninitialized" with GCC 4.4.7 */
+        int min_way = first_way;
+        for (int way = first_way; way < end_way; ++way) {
+            if (tags[way] == TAG_INVALID) {
+                min_way = way;
+                break;
+            }
+            if (way == first_way || counters[way] < min_counter) {
+                min_counter = counters[way];
+                min_way = way;
+            }
+        }
+        // Clear the counter for LFU.
+        counters[min_way] = 0;
+        return min_way;
+    }
+    static inline void
+    insert_update(int set, const addr_t *tags, int *counters, int associativity, int way,
+                  const memref_t &memref)
+    {
+        access_update(set, tags, counters, associativity, way, memref);
+    }
+    static inline void
+    promote(int set, const addr_t *tags, int *counters, int associativity, int way)
+    {
+        counters[way]++;
+    }
+};
+
+// The signature that policies predicting reuse per instruction key their
+// predictions by.  QEMU traces carry no data PCs, so without one the 16KB
+// region accessed stands in for it, as in SHiP-Mem.  The request type keeps
+// instruction, data and each page table level's accesses apart.
+static inline unsigned int
+replacement_signature(const memref_t &memref, int bits)
+{
+    addr_t key = type_is_instr(memref.instr.type) ? memref.instr.addr : memref.data.pc;
+    if (key == 0)
+        key = memref.data.addr >> 14;
+    key = (key ^ ((addr_t)memref.data.type << 48)) * 0x9e3779b97f4a7c15ULL;
+    return (unsigned int)(key >> (64 - bits));
+}
 
 // We assume we're only invoked from a single thread of control and do
 // not need to synchronize data access.
@@ -64,7 +145,27 @@ public:
     request(const memref_t &memref);
 
     virtual void
-    invalidate(const addr_t tag);
+    invalidate(const addr_t tag, invalidation_type_t type = INVALIDATION_INCLUSIVE);
+    // Invalidates every block with a tag in [first_tag, last_tag], and returns
+    // how many there were.
+    int
+    invalidate_range(addr_t first_tag, addr_t last_tag, invalidation_type_t type);
+
+    // Returns whether the block holding addr is present, without updating
+    // any replacement or statistics state.
+    bool
+    probe(addr_t addr);
+
+    // Writes the tags and replacement counters of the blocks to a checkpoint,
+    // under name.
+    virtual void
+    save_state(checkpoint_writer_t &out, const std::string &name) const;
+    // Reads what save_state() wrote for name.  The geometry must match.  The
+    // counters are only taken from a device of the same type, that is with
+    // the same replacement policy: any other keeps the tags with fresh
+    // counters.  Other per-block and policy state starts afresh.
+    virtual bool
+    restore_state(checkpoint_reader_t &in, const std::string &name, std::string &error);
 
     caching_device_stats_t *
     get_stats() const
@@ -81,23 +182,84 @@ public:
     {
         return prefetcher;
     }
+    // A prefetched block hit within this many requests of its fill counts
+    // as late.
+    void
+    set_prefetch_late_refs(uint64_t refs)
+    {
+        prefetch_late_refs = refs;
+    }
+    type_policy_t *
+    get_type_policy() const
+    {
+        return type_policy;
+    }
+    // Attaches a policy keyed on request type, after init().  Fails if the
+    // policy does not fit the device's geometry.
+    bool
+    set_type_policy(type_policy_t *type_policy_);
+    // Makes the device report to snoop_filter as its cache id: a coherent
+    // device reports its misses, writes and evictions, any other only its
+    // write hits.
+    void
+    set_snoop_filter(snoop_filter_t *snoop_filter_, int snoop_id_, bool coherent_)
+    {
+        snoop_filter = snoop_filter_;
+        snoop_id = snoop_id_;
+        coherent = coherent_;
+    }
+    void
+    set_inclusive(bool inclusive_, const std::vector<caching_device_t *> &children_)
+    {
+        inclusive = inclusive_;
+        children = children_;
+    }
     caching_device_t *
     get_parent() const
     {
         return parent;
     }
+    void
+    set_parent(caching_device_t *parent_)
+    {
+        parent = parent_;
+    }
+    int
+    get_block_size() const
+    {
+        return block_size;
+    }
+    int
+    get_associativity() const
+    {
+        return associativity;
+    }
     inline double
     get_loaded_fraction() const
     {
         return double(loaded_blocks) / num_blocks;
     }
+    // Counts the blocks of the workload that interference requests evict,
+    // after init().
+    void
+    track_interference()
+    {
+        fill_kinds.assign(num_blocks, FILL_WORKLOAD);
+    }
+    // Feeds the tag of each request to curve, which the caller owns.
+    void
+    set_miss_ratio_curve(miss_ratio_curve_t *curve_)
+    {
+        curve = curve_;
+    }
 
 
 protected:
-    virtual void
-    access_update(int block_idx, int way);
-    virtual int
-    replace_which_way(int block_idx);
+    // The lookup, fill and replacement shared by all caching devices, with the
+    // replacement policy inlined.
+    template <typename policy_t>
+    cache_result_t
+    request_with_policy(const memref_t &memref, policy_t &policy);
 
     inline addr_t
     compute_tag(addr_t addr)
@@ -110,14 +272,61 @@ protected:
         //return (tag & blocks_per_set_mask) << assoc_bits;
         return (tag & blocks_per_set_mask) * associativity;
     }
-    inline caching_device_block_t &
-    get_caching_device_block(int block_idx, int way)
+    // For subclasses to allocate their own per-block state.
+    virtual void
+    init_blocks()
     {
-        return *(blocks[block_idx + way]);
     }
-    // a pure virtual function for subclasses to initialize their own block array
-    virtual void
-    init_blocks() = 0;
+
+    // A miss on a block coherence invalidated is a coherence miss.
+    inline void
+    record_miss(addr_t tag, const memref_t &memref)
+    {
+        if (!coherence_invalidated.empty() && coherence_invalidated.erase(tag) != 0)
+            stats->coherence_miss(memref);
+    }
+
+    // Prefetch accounting for the block at index block: the first demand hit
+    // on a prefetched block makes it useful, and late if it comes within
+    // prefetch_late_refs requests of the fill.
+    inline void
+    record_hit(int block, const memref_t &memref)
+    {
+        if (prefetch_fills[block] != 0 && !type_is_prefetch(memref.data.type)) {
+            stats->prefetch_use(num_requests - prefetch_fills[block] <=
+                                prefetch_late_refs);
+            prefetch_fills[block] = 0;
+        }
+    }
+    // Interference accounting for the block at index block, which a miss of
+    // memref is about to fill, evicting it if valid.
+    inline void
+    record_interference(int block, const memref_t &memref, bool evicting)
+    {
+        if (fill_kinds.empty())
+            return;
+        bool interference = memref.data.type == TRACE_TYPE_CONT_L1 ||
+            memref.data.type == TRACE_TYPE_CONT_LLC;
+        if (evicting && interference && fill_kinds[block] != FILL_INTERFERENCE)
+            stats->interference_evict(fill_kinds[block] == FILL_PAGE_TABLE);
+        if (interference)
+            fill_kinds[block] = FILL_INTERFERENCE;
+        else if (type_is_page_table(memref.data.type))
+            fill_kinds[block] = FILL_PAGE_TABLE;
+        else
+            fill_kinds[block] = FILL_WORKLOAD;
+    }
+    inline void
+    record_fill(int block, const memref_t &memref)
+    {
+        if (prefetch_fills[block] != 0)
+            stats->prefetch_evict();
+        if (type_is_prefetch(memref.data.type)) {
+            prefetch_fills[block] = num_requests;
+            stats->prefetch_fill();
+        } else
+            prefetch_fills[block] = 0;
+    }
 
     int associativity;
     int block_size;
@@ -132,10 +341,21 @@ protected:
     // If true, this device is inclusive of its children.
     bool inclusive;
 
-    // This should be an array of caching_device_block_t pointers, otherwise
-    // an extended block class which has its own member variables cannot be indexed
-    // correctly by base class pointers.
-    caching_device_block_t **blocks;
+    // The tag and replacement counter of each block.
+    std::vector<addr_t> tags;
+    std::vector<int> counters;
+    // The request count at which each block was filled by a prefetch not yet
+    // used, or 0.
+    std::vector<uint64_t> prefetch_fills;
+    // What filled each block, when interference evictions are counted.
+    enum fill_kind_t : uint8_t {
+        FILL_WORKLOAD,
+        FILL_PAGE_TABLE,
+        FILL_INTERFERENCE,
+    };
+    std::vector<uint8_t> fill_kinds;
+    uint64_t num_requests;
+    uint64_t prefetch_late_refs;
     int blocks_per_set;
     // Optimization fields for fast bit operations
     int blocks_per_set_mask;
@@ -144,6 +364,17 @@ protected:
 
     caching_device_stats_t *stats;
     prefetcher_t *prefetcher;
+    // Null unless the device takes part in coherence.
+    snoop_filter_t *snoop_filter;
+    int snoop_id;
+    bool coherent;
+    // The tags of the blocks coherence invalidated and no miss has brought
+    // back yet.
+    std::unordered_set<addr_t> coherence_invalidated;
+    // Null unless blocks are treated differently by request type.
+    type_policy_t *type_policy;
+    // Null unless the miss ratio curves of the requests are taken.
+    miss_ratio_curve_t *curve;
 
     // Optimization: remember last tag
     addr_t last_tag;
@@ -151,4 +382,145 @@ protected:
     int last_block_idx;
 };
 
+// A hit in the parent is one level further away from the requester.
+inline cache_result_t
+got_from_parent(cache_result_t cur)
+{
+    if (cur != NOT_FOUND) {
+        cur = static_cast<cache_result_t>(static_cast<int>(cur) + 1);
+    }
+    return cur;
+}
+
+template <typename policy_t>
+cache_result_t
+caching_device_t::request_with_policy(const memref_t &memref_in, policy_t &policy)
+{
+    // Unfortunately we need to make a copy for our loop so we can pass
+    // the right data struct to the parent and stats collectors.
+    memref_t memref;
+    // We support larger sizes to improve the IPC perf.
+    // This means that one memref could touch multiple blocks.
+    // We treat each block separately for statistics purposes.
+    addr_t final_addr = memref_in.data.addr + memref_in.data.size - 1 /*avoid overflow*/;
+    addr_t final_tag = compute_tag(final_addr);
+    addr_t tag = compute_tag(memref_in.data.addr);
+
+    cache_result_t res = NOT_FOUND;
+    num_requests++;
+
+    if (type_policy != nullptr) {
+        if (type_policy->bypass(memref_in)) {
+            if (parent != NULL)
+                res = got_from_parent(parent->request(memref_in));
+            return res;
+        }
+        type_policy->access();
+    }
+    if (curve != nullptr)
+        curve->access(tag);
+
+    // Optimization: check last tag if single-block
+    if (tag == final_tag && tag == last_tag) {
+        // Make sure last_tag is properly in sync.
+        assert(tag != TAG_INVALID && tag == tags[last_block_idx + last_way]);
+        stats->access(memref_in, true /*hit*/);
+        if (parent != NULL)
+            parent->stats->child_access(memref_in, true);
+        record_hit(last_block_idx + last_way, memref_in);
+        policy.access_update(last_block_idx / associativity, &tags[last_block_idx],
+                             &counters[last_block_idx], associativity, last_way,
+                             memref_in);
+        if (snoop_filter != nullptr && memref_in.data.type == TRACE_TYPE_WRITE)
+            snoop_filter->snoop(tag, snoop_id, true);
+        res = FOUND_L1;
+        return res;
+    }
+
+    memref = memref_in;
+    for (; tag <= final_tag; ++tag) {
+        int way;
+        int block_idx = compute_block_idx(tag);
+        int set = block_idx / associativity;
+        addr_t *set_tags = &tags[block_idx];
+        int *set_counters = &counters[block_idx];
+        bool missed = false;
+
+        if (tag + 1 <= final_tag)
+            memref.data.size = ((tag + 1) << block_size_bits) - memref.data.addr;
+
+        way = find_way(set_tags, associativity, tag);
+        if (way < associativity) {
+            stats->access(memref, true /*hit*/);
+            res = FOUND_L1;
+            if (parent != NULL)
+                parent->stats->child_access(memref, true);
+            record_hit(block_idx + way, memref);
+            policy.access_update(set, set_tags, set_counters, associativity, way, memref);
+            if (snoop_filter != nullptr && memref.data.type == TRACE_TYPE_WRITE)
+                snoop_filter->snoop(tag, snoop_id, true);
+        } else {
+            stats->access(memref, false /*miss*/);
+            record_miss(tag, memref);
+            missed = true;
+            // If no parent we assume we get the data from main memory
+            if (parent != NULL) {
+                parent->stats->child_access(memref, false);
+                res = parent->request(memref);
+                res = got_from_parent(res);
+            }
+
+            // Coherence, if modeled, is kept by the snoop filter on the fill.
+
+            int first_way = 0;
+            int end_way = associativity;
+            if (type_policy != nullptr)
+                type_policy->fill_ways(memref, &first_way, &end_way);
+            way = policy.replace_which_way(set, set_tags, set_counters, associativity,
+                                           first_way, end_way, memref);
+            record_interference(block_idx + way, memref, set_tags[way] != TAG_INVALID);
+            // Check if we are inserting a new block, if we are then increment
+            // the block loaded count.
+            if (set_tags[way] == TAG_INVALID) {
+                loaded_blocks++;
+            } else {
+                if (coherent)
+                    snoop_filter->snoop_eviction(set_tags[way], snoop_id);
+                if (inclusive && !children.empty()) {
+                    for (auto &child : children) {
+                        child->invalidate(set_tags[way]);
+                    }
+                }
+            }
+            if (coherent)
+                snoop_filter->snoop(tag, snoop_id, memref.data.type == TRACE_TYPE_WRITE);
+            set_tags[way] = tag;
+            record_fill(block_idx + way, memref);
+            policy.insert_update(set, set_tags, set_counters, associativity, way, memref);
+            if (type_policy != nullptr) {
+                if (type_policy->insert_with_priority(memref))
+                    policy.promote(set, set_tags, set_counters, associativity, way);
+                type_policy->fill(block_idx + way, memref);
+            }
+        }
+
+        // Issue a hardware prefetch, if any, before we remember the last tag,
+        // so we remember this line and not the prefetched line.
+        if (!type_is_prefetch(memref.data.type) && prefetcher != nullptr)
+            prefetcher->prefetch(this, memref, missed);
+
+        if (tag + 1 <= final_tag) {
+            addr_t next_addr = (tag + 1) << block_size_bits;
+            memref.data.addr = next_addr;
+            memref.data.size = final_addr - next_addr + 1 /*undo the -1*/;
+        }
+
+        // Optimization: remember last tag
+        last_tag = tag;
+        last_way = way;
+        last_block_idx = block_idx;
+    }
+    return res;
+}
+
 #endif /* _CACHING_DEVICE_H_ */
@@ -44,6 +44,15 @@ caching_device_stats_t::caching_device_stats_t(const std::string &miss_file,
     , num_misses(0)
     , num_child_hits(0)
     , num_inclusive_invalidates(0)
+    , num_coherence_invalidates(0)
+    , num_coherence_misses(0)
+    , num_coherence_pt_misses(0)
+    , num_interference_evicts(0)
+    , num_interference_pt_evicts(0)
+    , num_prefetch_fills(0)
+    , num_prefetch_useful(0)
+    , num_prefetch_late(0)
+    , num_prefetch_unused(0)
     , num_hits_at_reset(0)
     , num_misses_at_reset(0)
     , num_child_hits_at_reset(0)
@@ -86,6 +95,10 @@ caching_device_stats_t::access(const memref_t &memref, bool hit)
 //    std::err << "Received " << hit << std::endl;
     // We assume we're single-threaded.
     // We're only computing miss rate so we just inc counters here.
+    // Prefetches are not demand accesses: the blocks they bring in are
+    // counted by prefetch_fill().
+    if (type_is_prefetch(memref.data.type))
+        return;
     if (hit) {
         if (memref.data.type == TRACE_TYPE_CONT_L1) {
           hit_statistics[4]++;
@@ -235,6 +248,66 @@ caching_device_stats_t::print_child_stats(std::string prefix)
     }
 }
 
+void
+caching_device_stats_t::print_prefetch_stats(std::string prefix)
+{
+    if (num_prefetch_fills == 0)
+        return;
+    std::cerr << prefix << std::setw(18) << std::left << "Prefetch fills:" << std::setw(20)
+              << std::right << num_prefetch_fills << std::endl;
+    std::cerr << prefix << std::setw(18) << std::left << "Prefetch useful:"
+              << std::setw(20) << std::right << num_prefetch_useful << std::endl;
+    std::cerr << prefix << std::setw(18) << std::left << "Prefetch late:" << std::setw(20)
+              << std::right << num_prefetch_late << std::endl;
+    std::cerr << prefix << std::setw(18) << std::left << "Prefetch unused:"
+              << std::setw(20) << std::right << num_prefetch_unused << std::endl;
+    // Accuracy is the share of prefetched blocks that were used and coverage
+    // the share of would-be misses that a prefetch turned into hits.
+    std::cerr << prefix << std::setw(18) << std::left << "Prefetch accuracy:"
+              << std::setw(20) << std::fixed << std::setprecision(2) << std::right
+              << ((float)num_prefetch_useful * 100 / num_prefetch_fills) << "%"
+              << std::endl;
+    if (num_prefetch_useful + num_misses > 0) {
+        std::cerr << prefix << std::setw(18) << std::left << "Prefetch coverage:"
+                  << std::setw(20) << std::fixed << std::setprecision(2) << std::right
+                  << ((float)num_prefetch_useful * 100 /
+                      (num_prefetch_useful + num_misses))
+                  << "%" << std::endl;
+    }
+}
+
+void
+caching_device_stats_t::coherence_miss(const memref_t &memref)
+{
+    num_coherence_misses++;
+    if (memref.data.type >= TRACE_TYPE_PE1 && memref.data.type <= TRACE_TYPE_PE4)
+        num_coherence_pt_misses++;
+}
+
+void
+caching_device_stats_t::print_coherence_stats(std::string prefix)
+{
+    if (num_coherence_invalidates == 0 && num_coherence_misses == 0)
+        return;
+    std::cerr << prefix << std::setw(18) << std::left << "Coherence invals:"
+              << std::setw(20) << std::right << num_coherence_invalidates << std::endl;
+    std::cerr << prefix << std::setw(18) << std::left << "Coherence misses:"
+              << std::setw(20) << std::right << num_coherence_misses << std::endl;
+    std::cerr << prefix << std::setw(18) << std::left << "Coherence PT miss:"
+              << std::setw(20) << std::right << num_coherence_pt_misses << std::endl;
+}
+
+void
+caching_device_stats_t::print_interference_stats(std::string prefix)
+{
+    if (num_interference_evicts == 0)
+        return;
+    std::cerr << prefix << std::setw(18) << std::left << "Interf. evictions:"
+              << std::setw(20) << std::right << num_interference_evicts << std::endl;
+    std::cerr << prefix << std::setw(18) << std::left << "Interf. PT evicts:"
+              << std::setw(20) << std::right << num_interference_pt_evicts << std::endl;
+}
+
 void
 caching_device_stats_t::print_stats(std::string prefix)
 {
@@ -245,6 +318,9 @@ caching_device_stats_t::print_stats(std::string prefix)
     print_counts(prefix);
     print_rates(prefix);
     print_child_stats(prefix);
+    print_prefetch_stats(prefix);
+    print_coherence_stats(prefix);
+    print_interference_stats(prefix);
     std::cerr.imbue(std::locale("C")); // Reset to avoid affecting later prints.
 }
 
@@ -258,6 +334,15 @@ caching_device_stats_t::reset()
     num_misses = 0;
     num_child_hits = 0;
     num_inclusive_invalidates = 0;
+    num_coherence_invalidates = 0;
+    num_coherence_misses = 0;
+    num_coherence_pt_misses = 0;
+    num_interference_evicts = 0;
+    num_interference_pt_evicts = 0;
+    num_prefetch_fills = 0;
+    num_prefetch_useful = 0;
+    num_prefetch_late = 0;
+    num_prefetch_unused = 0;
 
     for (uint i = 0; i < PAGE_WALK_STAGES; i++) {
       hit_statistics[i]  = 0;
@@ -266,7 +351,10 @@ caching_device_stats_t::reset()
 }
 
 void
-caching_device_stats_t::invalidate()
+caching_device_stats_t::invalidate(invalidation_type_t type)
 {
-    num_inclusive_invalidates++;
+    if (type == INVALIDATION_COHERENCE)
+        num_coherence_invalidates++;
+    else
+        num_inclusive_invalidates++;
 }
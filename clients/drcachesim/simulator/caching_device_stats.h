@@ -45,6 +45,15 @@
 #endif
 #include "memref.h"
 
+// Why a block was invalidated: to keep an inclusive device inclusive of its
+// children, or to keep the cores' private caches coherent (see
+// snoop_filter.h), which also covers page table writes shooting down
+// translations.
+enum invalidation_type_t {
+    INVALIDATION_INCLUSIVE,
+    INVALIDATION_COHERENCE,
+};
+
 class caching_device_stats_t {
 public:
     explicit caching_device_stats_t(const std::string &miss_file,
@@ -61,20 +70,72 @@ public:
     virtual void
     child_access(const memref_t &memref, bool hit);
 
+    // Called when a prefetch brings a block in, on the first demand hit on
+    // a prefetched block, and when a prefetched block is evicted unused.
+    void
+    prefetch_fill()
+    {
+        num_prefetch_fills++;
+    }
+    void
+    prefetch_use(bool late)
+    {
+        num_prefetch_useful++;
+        if (late)
+            num_prefetch_late++;
+    }
+    void
+    prefetch_evict()
+    {
+        num_prefetch_unused++;
+    }
+
     virtual void
     print_stats(std::string prefix);
 
     virtual void
     reset();
 
+    // Hits and misses since the last reset.
+    int_least64_t
+    get_hits() const
+    {
+        return num_hits;
+    }
+    int_least64_t
+    get_misses() const
+    {
+        return num_misses;
+    }
+    int_least64_t
+    get_prefetch_useful() const
+    {
+        return num_prefetch_useful;
+    }
+
     virtual bool operator!()
     {
         return !success;
     }
 
-    // Process invalidations due to cache inclusions.
+    // Process invalidations due to cache inclusions or coherence.
     virtual void
-    invalidate();
+    invalidate(invalidation_type_t type = INVALIDATION_INCLUSIVE);
+
+    // Called on a miss on a block a coherence invalidation removed, which
+    // would have hit without it.
+    void
+    coherence_miss(const memref_t &memref);
+
+    // Called when an interference request evicts a block of the simulated
+    // workload, which is a page table line if pt_line.
+    void
+    interference_evict(bool pt_line)
+    {
+        num_interference_evicts++;
+        if (pt_line)
+            num_interference_pt_evicts++;
+    }
 
 protected:
     bool success;
@@ -88,6 +149,12 @@ protected:
     print_rates(std::string prefix); // hit/miss rates
     virtual void
     print_child_stats(std::string prefix); // child/total info
+    virtual void
+    print_prefetch_stats(std::string prefix); // prefetch accuracy and coverage
+    virtual void
+    print_coherence_stats(std::string prefix); // coherence invalidations and misses
+    virtual void
+    print_interference_stats(std::string prefix); // interference evictions
 
     virtual void
     dump_miss(const memref_t &memref);
@@ -100,6 +167,22 @@ protected:
     int_least64_t num_child_hits;
 
     int_least64_t num_inclusive_invalidates;
+    int_least64_t num_coherence_invalidates;
+    // Misses on blocks a coherence invalidation removed, and those of page
+    // walks.
+    int_least64_t num_coherence_misses;
+    int_least64_t num_coherence_pt_misses;
+    // Blocks of the workload evicted by interference requests, and those of
+    // them holding page table entries.
+    int_least64_t num_interference_evicts;
+    int_least64_t num_interference_pt_evicts;
+
+    // Prefetched blocks, those a demand access hit, those hit within the
+    // late window of their fill, and those evicted before any demand hit.
+    int_least64_t num_prefetch_fills;
+    int_least64_t num_prefetch_useful;
+    int_least64_t num_prefetch_late;
+    int_least64_t num_prefetch_unused;
 
     // Stats saved when the last reset was called. This helps us get insight
     // into what the stats were when the cache was warmed up.
@@ -0,0 +1,195 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+/* checkpoint: the file holding the warm state of the simulated structures,
+ * so that later runs can skip the warmup (-checkpoint_out, -checkpoint_in).
+ */
+
+#include "checkpoint.h"
+
+// Ends the file, so that a truncated checkpoint is not taken for a whole one.
+#define CHECKPOINT_TRAILER 0x444e4554504b4344ULL // "DCKPTEND"
+
+checkpoint_writer_t::checkpoint_writer_t()
+    : file(NULL)
+    , failed(false)
+{
+}
+
+checkpoint_writer_t::~checkpoint_writer_t()
+{
+    if (file != NULL)
+        fclose(file);
+}
+
+bool
+checkpoint_writer_t::open(const std::string &path_, std::string &error)
+{
+    path = path_;
+    file = fopen(path.c_str(), "wb");
+    if (file == NULL) {
+        error = "Failed to open checkpoint file " + path;
+        return false;
+    }
+    return true;
+}
+
+void
+checkpoint_writer_t::write_header(const checkpoint_header_t &header)
+{
+    write_u64(CHECKPOINT_MAGIC);
+    write_u32(CHECKPOINT_VERSION);
+    write_u32(header.arch);
+    write_u32(header.num_cores);
+    write_u64(header.trace_refs);
+}
+
+void
+checkpoint_writer_t::write(const void *data, size_t size)
+{
+    if (!failed && fwrite(data, 1, size, file) != size)
+        failed = true;
+}
+
+void
+checkpoint_writer_t::write_string(const std::string &value)
+{
+    write_u32((uint32_t)value.size());
+    write(value.data(), value.size());
+}
+
+bool
+checkpoint_writer_t::close(std::string &error)
+{
+    write_u64(CHECKPOINT_TRAILER);
+    if (fclose(file) != 0)
+        failed = true;
+    file = NULL;
+    if (failed) {
+        error = "Failed to write checkpoint file " + path;
+        return false;
+    }
+    return true;
+}
+
+void
+checkpoint_writer_t::discard()
+{
+    fclose(file);
+    file = NULL;
+    remove(path.c_str());
+}
+
+checkpoint_reader_t::checkpoint_reader_t()
+    : file(NULL)
+    , failed(false)
+{
+}
+
+checkpoint_reader_t::~checkpoint_reader_t()
+{
+    if (file != NULL)
+        fclose(file);
+}
+
+bool
+checkpoint_reader_t::open(const std::string &path_, checkpoint_header_t *header,
+                          std::string &error)
+{
+    path = path_;
+    file = fopen(path.c_str(), "rb");
+    if (file == NULL) {
+        error = "Failed to open checkpoint file " + path;
+        return false;
+    }
+    if (read_u64() != CHECKPOINT_MAGIC || read_u32() != CHECKPOINT_VERSION) {
+        error = path + " is not a checkpoint of this simulator version.";
+        return false;
+    }
+    header->arch = read_u32();
+    header->num_cores = read_u32();
+    header->trace_refs = read_u64();
+    if (failed) {
+        error = "Failed to read checkpoint file " + path;
+        return false;
+    }
+    return true;
+}
+
+bool
+checkpoint_reader_t::read(void *data, size_t size)
+{
+    if (!failed && fread(data, 1, size, file) != size)
+        failed = true;
+    return !failed;
+}
+
+std::string
+checkpoint_reader_t::read_string()
+{
+    uint32_t size = read_u32();
+    // Names are short: anything longer is a corrupt file.
+    if (failed || size > 4096) {
+        failed = true;
+        return "";
+    }
+    std::string value(size, '\0');
+    if (size > 0)
+        read(&value[0], size);
+    return value;
+}
+
+bool
+checkpoint_reader_t::close(std::string &error)
+{
+    if (read_u64() != CHECKPOINT_TRAILER || fgetc(file) != EOF)
+        failed = true;
+    fclose(file);
+    file = NULL;
+    if (failed) {
+        error = "Checkpoint file " + path + " is truncated or corrupt.";
+        return false;
+    }
+    return true;
+}
+
+bool
+checkpoint_trace_refs(const std::string &path, uint64_t *refs, std::string &error)
+{
+    checkpoint_reader_t reader;
+    checkpoint_header_t header;
+    if (!reader.open(path, &header, error))
+        return false;
+    *refs = header.trace_refs;
+    return true;
+}
@@ -0,0 +1,165 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+/* checkpoint: the file holding the warm state of the simulated structures,
+ * so that later runs can skip the warmup (-checkpoint_out, -checkpoint_in).
+ */
+
+#ifndef _CHECKPOINT_H_
+#define _CHECKPOINT_H_ 1
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#define CHECKPOINT_MAGIC 0x54504b4354575051ULL // "QPWTCKPT"
+#define CHECKPOINT_VERSION 1
+
+// What comes before the state of the structures.
+struct checkpoint_header_t {
+    uint32_t arch;
+    uint32_t num_cores;
+    // The references the simulator was handed up to the end of the warmup.
+    uint64_t trace_refs;
+};
+
+// A checkpoint is the header, then each structure's state written through
+// caching_device_t::save_state(), in an order only the simulator knows, and
+// a trailer.  Values are written in host byte order.  I/O errors are sticky
+// and reported by close() or ok().
+class checkpoint_writer_t {
+public:
+    checkpoint_writer_t();
+    ~checkpoint_writer_t();
+    bool
+    open(const std::string &path, std::string &error);
+    bool
+    is_open() const
+    {
+        return file != NULL;
+    }
+    void
+    write_header(const checkpoint_header_t &header);
+    void
+    write(const void *data, size_t size);
+    void
+    write_u32(uint32_t value)
+    {
+        write(&value, sizeof(value));
+    }
+    void
+    write_u64(uint64_t value)
+    {
+        write(&value, sizeof(value));
+    }
+    void
+    write_string(const std::string &value);
+    template <typename T>
+    void
+    write_vector(const std::vector<T> &values)
+    {
+        write_u64(values.size());
+        if (!values.empty())
+            write(values.data(), values.size() * sizeof(T));
+    }
+    // Writes the trailer and closes the file.
+    bool
+    close(std::string &error);
+    // Closes and deletes the file, when there is nothing to save.
+    void
+    discard();
+
+private:
+    FILE *file;
+    std::string path;
+    bool failed;
+};
+
+class checkpoint_reader_t {
+public:
+    checkpoint_reader_t();
+    ~checkpoint_reader_t();
+    // Opens path and reads its header.
+    bool
+    open(const std::string &path, checkpoint_header_t *header, std::string &error);
+    bool
+    read(void *data, size_t size);
+    uint32_t
+    read_u32()
+    {
+        uint32_t value = 0;
+        read(&value, sizeof(value));
+        return value;
+    }
+    uint64_t
+    read_u64()
+    {
+        uint64_t value = 0;
+        read(&value, sizeof(value));
+        return value;
+    }
+    std::string
+    read_string();
+    // Reads a vector written by write_vector() of exactly count elements.
+    template <typename T>
+    bool
+    read_vector(std::vector<T> &values, size_t count)
+    {
+        if (read_u64() != count) {
+            failed = true;
+            return false;
+        }
+        values.resize(count);
+        return count == 0 || read(values.data(), count * sizeof(T));
+    }
+    bool
+    ok() const
+    {
+        return !failed;
+    }
+    // Checks the trailer and closes the file.
+    bool
+    close(std::string &error);
+
+private:
+    FILE *file;
+    std::string path;
+    bool failed;
+};
+
+// The trace_refs of the checkpoint at path, for the reader to resume at.
+bool
+checkpoint_trace_refs(const std::string &path, uint64_t *refs, std::string &error);
+
+#endif /* _CHECKPOINT_H_ */
@@ -1,5 +1,5 @@
 /* **********************************************************
- * Copyright (c) 2015 Google, Inc.  All rights reserved.
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
  * **********************************************************/
 
 /*
@@ -30,22 +30,68 @@
  * DAMAGE.
  */
 
-/* cache_line: represents a cache line.
- */
-
-#ifndef _CACHE_LINE_H_
-#define _CACHE_LINE_H_ 1
+#include "epoch_workers.h"
 
-#include "caching_device_block.h"
+epoch_workers_t::epoch_workers_t()
+    : round(0)
+    , pending(0)
+    , exiting(false)
+{
+}
 
-class cache_line_t : public caching_device_block_t {
+epoch_workers_t::~epoch_workers_t()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        exiting = true;
+    }
+    start_cv.notify_all();
+    for (auto &thread : threads)
+        thread.join();
+}
 
-    // Currently, "cache_line_t" is identical to caching_device_block_t; however,
-    // cache_line_t is probably to be extended to have distinct member variables
-    // and functions, e.g., coherency-related ones. Therefore, it is
-    // reasonable to keep two identical classes now rather than use one instead.
+void
+epoch_workers_t::start(unsigned int num_workers,
+                       const std::function<void(unsigned int)> &work_)
+{
+    work = work_;
+    for (unsigned int i = 1; i < num_workers; i++)
+        threads.push_back(std::thread(&epoch_workers_t::thread_loop, this, i));
+}
 
-    // FIXME i#1726: implement cache coherency protocols
-};
+void
+epoch_workers_t::run()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        round++;
+        pending = (unsigned int)threads.size();
+    }
+    start_cv.notify_all();
+    work(0);
+    std::unique_lock<std::mutex> guard(lock);
+    done_cv.wait(guard, [this] { return pending == 0; });
+}
 
-#endif /* _CACHE_LINE_H_ */
+void
+epoch_workers_t::thread_loop(unsigned int id)
+{
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            start_cv.wait(guard, [this, seen] { return exiting || round != seen; });
+            if (exiting)
+                return;
+            seen = round;
+        }
+        work(id);
+        bool last;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            last = --pending == 0;
+        }
+        if (last)
+            done_cv.notify_one();
+    }
+}
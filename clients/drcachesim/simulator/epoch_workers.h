@@ -1,5 +1,5 @@
 /* **********************************************************
- * Copyright (c) 2015 Google, Inc.  All rights reserved.
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
  * **********************************************************/
 
 /*
@@ -30,21 +30,49 @@
  * DAMAGE.
  */
 
-/* tlb_entry: represents a TLB entry.
+/* epoch_workers: a pool of threads that repeatedly run one task in lockstep.
  */
 
-#ifndef _TLB_ENTRY_H_
-#define _TLB_ENTRY_H_ 1
+#ifndef _EPOCH_WORKERS_H_
+#define _EPOCH_WORKERS_H_ 1
 
-#include "caching_device_block.h"
+#include <condition_variable>
+#include <stdint.h>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
 
-class tlb_entry_t : public caching_device_block_t {
+// Runs work(0) .. work(num_workers - 1) concurrently each time run() is
+// called, reusing the same threads.  The calling thread runs work(0).
+class epoch_workers_t {
 public:
-    // process ID to differentiate virtual pages
-    // that have the same VPN but belong to different processes.
-    memref_pid_t pid;
+    epoch_workers_t();
+    ~epoch_workers_t();
 
-    // XXX: support page privilege and MMU-related exceptions
+    void
+    start(unsigned int num_workers, const std::function<void(unsigned int)> &work);
+    // Returns once every worker has finished this round.
+    void
+    run();
+    unsigned int
+    size() const
+    {
+        return (unsigned int)threads.size() + 1;
+    }
+
+private:
+    void
+    thread_loop(unsigned int id);
+
+    std::function<void(unsigned int)> work;
+    std::vector<std::thread> threads;
+    std::mutex lock;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    uint64_t round;
+    unsigned int pending;
+    bool exiting;
 };
 
-#endif /* _TLB_ENTRY_H_ */
+#endif /* _EPOCH_WORKERS_H_ */
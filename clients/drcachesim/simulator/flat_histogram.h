@@ -0,0 +1,132 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* flat_histogram: counts occurrences of small fixed-size keys.
+ */
+
+#ifndef _FLAT_HISTOGRAM_H_
+#define _FLAT_HISTOGRAM_H_ 1
+
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+// An open-addressing hash table from key_t to a count, for histograms that are
+// updated on every reference and only read when printing results.  Slots live
+// in one flat array with linear probing, so an update is a hash and usually a
+// single cache line, with no allocation once the table has grown.  A slot with
+// a zero count is empty.  key_t must be copyable and comparable with ==, and
+// hash_t must be a function object returning a well-mixed size_t.
+template <typename key_t, typename hash_t> class flat_histogram_t {
+public:
+    flat_histogram_t()
+        : num_used(0)
+    {
+        slots.resize(16);
+    }
+    void
+    add(const key_t &key, uint64_t count = 1)
+    {
+        size_t mask = slots.size() - 1;
+        for (size_t i = hash_t()(key) & mask;; i = (i + 1) & mask) {
+            slot_t &slot = slots[i];
+            if (slot.second == 0) {
+                slot.first = key;
+                slot.second = count;
+                // Keep the load factor under 1/2.
+                if (++num_used * 2 > slots.size())
+                    grow();
+                return;
+            }
+            if (slot.first == key) {
+                slot.second += count;
+                return;
+            }
+        }
+    }
+    void
+    clear()
+    {
+        slots.assign(slots.size(), slot_t());
+        num_used = 0;
+    }
+    size_t
+    size() const
+    {
+        return num_used;
+    }
+    // Returns the non-empty entries in no particular order.
+    std::vector<std::pair<key_t, uint64_t>>
+    entries() const
+    {
+        std::vector<std::pair<key_t, uint64_t>> res;
+        res.reserve(num_used);
+        for (const slot_t &slot : slots) {
+            if (slot.second != 0)
+                res.push_back(slot);
+        }
+        return res;
+    }
+
+private:
+    typedef std::pair<key_t, uint64_t> slot_t;
+
+    void
+    grow()
+    {
+        std::vector<slot_t> old(slots.size() * 2);
+        old.swap(slots);
+        num_used = 0;
+        for (const slot_t &slot : old) {
+            if (slot.second != 0)
+                add(slot.first, slot.second);
+        }
+    }
+
+    std::vector<slot_t> slots;
+    size_t num_used;
+};
+
+// Mixes a 64-bit value into a hash (the splitmix64 finalizer).
+inline size_t
+flat_histogram_mix(uint64_t val)
+{
+    val ^= val >> 30;
+    val *= 0xbf58476d1ce4e5b9ULL;
+    val ^= val >> 27;
+    val *= 0x94d049bb133111ebULL;
+    val ^= val >> 31;
+    return (size_t)val;
+}
+
+#endif /* _FLAT_HISTOGRAM_H_ */
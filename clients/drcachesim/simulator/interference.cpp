@@ -0,0 +1,140 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+/* interference: the requests of a co-running workload injected into the
+ * caches (-contention_L1 and -contention_LLC).
+ */
+
+#include "interference.h"
+#include "trace_entry.h"
+
+interference_t::interference_t()
+    : source(INTERFERENCE_UNIFORM)
+    , arch(RADIX)
+    , working_set(0)
+    , stride(0)
+    , random_state(1)
+    , stride_offset(0)
+    , trace(NULL)
+{
+}
+
+interference_t::~interference_t()
+{
+    delete trace;
+}
+
+bool
+interference_t::init(const std::string &source_, const std::string &trace_file_,
+                     trans_arch arch_, uint64_t working_set_, unsigned int stride_,
+                     uint64_t seed, std::string &error)
+{
+    source = source_;
+    trace_file = trace_file_;
+    arch = arch_;
+    working_set = working_set_;
+    stride = stride_;
+    // Mix the seed so that small seeds give unrelated streams; the state must
+    // not be zero.
+    random_state = seed * 0x9e3779b97f4a7c15ULL + 0x6a09e667f3bcc909ULL;
+    if (random_state == 0)
+        random_state = 1;
+    if (source == INTERFERENCE_TRACE) {
+        if (trace_file.empty()) {
+            error = "Usage error: -interference " INTERFERENCE_TRACE
+                    " needs -interference_trace.";
+            return false;
+        }
+        return open_trace(error);
+    }
+    if (source != INTERFERENCE_UNIFORM && source != INTERFERENCE_STRIDE) {
+        error = "Usage error: -interference must be " INTERFERENCE_UNIFORM
+                ", " INTERFERENCE_STRIDE " or " INTERFERENCE_TRACE ".";
+        return false;
+    }
+    if (working_set == 0 || (source == INTERFERENCE_STRIDE && stride == 0)) {
+        error = "Usage error: -interference_working_set and -interference_stride "
+                "must be positive.";
+        return false;
+    }
+    return true;
+}
+
+bool
+interference_t::open_trace(std::string &error)
+{
+    delete trace;
+    trace = new qemu_file_reader_t(trace_file.c_str(), 0, arch, -1, -1);
+    if (!trace->init() || *trace == trace_end) {
+        error = "Usage error: failed to read -interference_trace " + trace_file + ".";
+        return false;
+    }
+    return true;
+}
+
+addr_t
+interference_t::next_addr()
+{
+    if (source == INTERFERENCE_UNIFORM)
+        return next_random() % working_set;
+    if (source == INTERFERENCE_STRIDE) {
+        addr_t addr = stride_offset;
+        stride_offset = (stride_offset + stride) % working_set;
+        return addr;
+    }
+    // Replay the next reference that translated, looping over the trace.  A
+    // trace without any gives address 0.
+    for (bool wrapped = false;;) {
+        if (*trace == trace_end) {
+            std::string error;
+            if (wrapped || !open_trace(error))
+                return 0;
+            wrapped = true;
+        }
+        const memref_t &memref = **trace;
+        addr_t addr = 0;
+        bool found = false;
+        if (type_is_instr(memref.instr.type) && memref.instr.pgtable_results.success) {
+            addr = memref.instr.pgtable_results.paddr;
+            found = true;
+        } else if ((memref.data.type == TRACE_TYPE_READ ||
+                    memref.data.type == TRACE_TYPE_WRITE) &&
+                   memref.data.pgtable_results.success) {
+            addr = memref.data.pgtable_results.paddr;
+            found = true;
+        }
+        ++(*trace);
+        if (found)
+            return addr;
+    }
+}
@@ -0,0 +1,108 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+/* interference: the requests of a co-running workload injected into the
+ * caches (-contention_L1 and -contention_LLC).
+ */
+
+#ifndef _INTERFERENCE_H_
+#define _INTERFERENCE_H_ 1
+
+#include <stdint.h>
+#include <string>
+#include "memref.h"
+#include "../reader/qemu_file_reader.h"
+
+#define INTERFERENCE_UNIFORM "uniform"
+#define INTERFERENCE_STRIDE "stride"
+#define INTERFERENCE_TRACE "trace"
+
+// The addresses come from one of:
+// - uniform: random lines of a working set starting at address 0.
+// - stride: a walk over the working set with a fixed stride, wrapping around.
+// - trace: the physical addresses of the references of another QEMU trace,
+//   replayed from its start again when it ends.
+// All randomness comes from a per-instance generator seeded at init(), so a
+// run is reproducible and several simulators (-sweep_file) do not perturb each
+// other.
+class interference_t {
+public:
+    interference_t();
+    ~interference_t();
+
+    bool
+    init(const std::string &source, const std::string &trace_file, trans_arch arch,
+         uint64_t working_set, unsigned int stride, uint64_t seed, std::string &error);
+
+    // The number of requests to inject for a rate of rate_pct hundredths of a
+    // request per reference: the whole requests and, with the probability of
+    // the remainder, one more.
+    unsigned int
+    num_requests(unsigned int rate_pct)
+    {
+        unsigned int num = rate_pct / 100;
+        if (rate_pct % 100 != 0 && next_random() % 100 < rate_pct % 100)
+            num++;
+        return num;
+    }
+
+    // The address of the next request.
+    addr_t
+    next_addr();
+
+private:
+    // xorshift64*.
+    uint64_t
+    next_random()
+    {
+        random_state ^= random_state >> 12;
+        random_state ^= random_state << 25;
+        random_state ^= random_state >> 27;
+        return random_state * 0x2545f4914f6cdd1dULL;
+    }
+
+    bool
+    open_trace(std::string &error);
+
+    std::string source;
+    std::string trace_file;
+    trans_arch arch;
+    uint64_t working_set;
+    unsigned int stride;
+    uint64_t random_state;
+    addr_t stride_offset;
+    qemu_file_reader_t *trace;
+    qemu_file_reader_t trace_end;
+};
+
+#endif /* _INTERFERENCE_H_ */
@@ -0,0 +1,103 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+#include "llc_epoch_proxy.h"
+
+llc_epoch_proxy_t::llc_epoch_proxy_t(caching_device_t *llc_)
+    : llc(llc_)
+{
+    parent = NULL;
+    stats = new log_stats_t(&log);
+}
+
+llc_epoch_proxy_t::~llc_epoch_proxy_t()
+{
+    delete stats;
+}
+
+llc_epoch_proxy_t::access_t
+llc_epoch_proxy_t::make_access(const memref_t &memref, bool child_access, bool hit)
+{
+    access_t access;
+    access.addr = memref.data.addr;
+    access.pc = memref.data.pc;
+    access.size = (uint32_t)memref.data.size;
+    access.type = (uint16_t)memref.data.type;
+    access.child_access = child_access;
+    access.hit = hit;
+    return access;
+}
+
+cache_result_t
+llc_epoch_proxy_t::request(const memref_t &memref)
+{
+    log.push_back(make_access(memref, false, false));
+    // Like the LLC, which has no parent, report a hit if any block is present.
+    addr_t block_size = llc->get_block_size();
+    addr_t block = memref.data.addr / block_size;
+    addr_t final_block = (memref.data.addr + memref.data.size - 1) / block_size;
+    cache_result_t res = NOT_FOUND;
+    for (; block <= final_block; ++block) {
+        if (llc->probe(block * block_size))
+            res = FOUND_L1;
+    }
+    return res;
+}
+
+void
+llc_epoch_proxy_t::replay(size_t *pos, size_t end)
+{
+    memref_t memref = {};
+    for (; *pos < end; ++*pos) {
+        const access_t &access = log[*pos];
+        memref.data.type = (trace_type_t)access.type;
+        memref.data.addr = access.addr;
+        memref.data.size = access.size;
+        memref.data.pc = access.pc;
+        if (access.child_access)
+            llc->get_stats()->child_access(memref, access.hit);
+        else
+            llc->request(memref);
+    }
+}
+
+llc_epoch_proxy_t::log_stats_t::log_stats_t(std::vector<access_t> *log_)
+    : caching_device_stats_t("")
+    , log(log_)
+{
+}
+
+void
+llc_epoch_proxy_t::log_stats_t::child_access(const memref_t &memref, bool hit)
+{
+    log->push_back(make_access(memref, true, hit));
+}
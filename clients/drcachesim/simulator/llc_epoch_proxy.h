@@ -0,0 +1,109 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* llc_epoch_proxy: stands in for a shared last-level cache while the private
+ * caches of several cores are simulated in parallel.
+ */
+
+#ifndef _LLC_EPOCH_PROXY_H_
+#define _LLC_EPOCH_PROXY_H_ 1
+
+#include <stdint.h>
+#include <vector>
+#include "caching_device.h"
+#include "caching_device_stats.h"
+
+// During a parallel epoch each core's L2 has its own proxy as parent instead
+// of the shared LLC.  The proxy answers lookups from the LLC contents as they
+// were at the start of the epoch and never changes the LLC; instead it logs
+// every access so that they can be replayed on the LLC in trace order once
+// all cores are done.  The outcome therefore only depends on the epoch size,
+// not on how the cores' threads interleave.
+class llc_epoch_proxy_t : public caching_device_t {
+public:
+    explicit llc_epoch_proxy_t(caching_device_t *llc);
+    virtual ~llc_epoch_proxy_t();
+
+    virtual cache_result_t
+    request(const memref_t &memref);
+
+    // Number of accesses logged so far in this epoch.
+    size_t
+    log_size() const
+    {
+        return log.size();
+    }
+    // Applies the logged accesses [*pos, end) to the LLC and advances *pos.
+    void
+    replay(size_t *pos, size_t end);
+    void
+    clear_log()
+    {
+        log.clear();
+    }
+
+protected:
+    virtual void
+    init_blocks()
+    {
+    }
+
+    struct access_t {
+        addr_t addr;
+        addr_t pc;
+        uint32_t size;
+        uint16_t type;
+        // A child_access() from the L2 rather than a request().
+        bool child_access;
+        bool hit;
+    };
+
+    // Records the L2's child_access() calls on what it takes for the LLC's
+    // statistics.
+    class log_stats_t : public caching_device_stats_t {
+    public:
+        explicit log_stats_t(std::vector<access_t> *log);
+        virtual void
+        child_access(const memref_t &memref, bool hit);
+
+    private:
+        std::vector<access_t> *log;
+    };
+
+    static access_t
+    make_access(const memref_t &memref, bool child_access, bool hit);
+
+    caching_device_t *llc;
+    std::vector<access_t> log;
+};
+
+#endif /* _LLC_EPOCH_PROXY_H_ */
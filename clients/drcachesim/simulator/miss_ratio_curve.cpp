@@ -0,0 +1,247 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+/* miss_ratio_curve: single-pass LRU miss ratio curves of a caching device
+ * from the stack distances of its request stream.
+ */
+
+#include "miss_ratio_curve.h"
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include "caching_device_block.h"
+#include "../common/utils.h"
+#include "../tools/reuse_distance.h"
+
+// The distance between the skip list nodes of the fully associative stack.
+// Walk cache and TLB streams mostly reuse recent tags, so short jumps win.
+#define MRC_SKIP_DISTANCE 64
+
+miss_ratio_curve_t::miss_ratio_curve_t()
+    : max_entries(0)
+    , depth(0)
+    , fully_associative(false)
+    , ref_list(nullptr)
+    , full_accesses(0)
+    , num_requests(0)
+{
+}
+
+miss_ratio_curve_t::~miss_ratio_curve_t()
+{
+    delete ref_list;
+}
+
+bool
+miss_ratio_curve_t::init(unsigned int max_entries_, const std::vector<unsigned int> &assocs_,
+                         unsigned int sample_sets, std::string &error)
+{
+    if (!IS_POWER_OF_2(max_entries_) || !IS_POWER_OF_2(sample_sets)) {
+        error = "Usage error: -mrc_max_entries and -mrc_sample_sets must be powers "
+                "of 2.";
+        return false;
+    }
+    max_entries = max_entries_;
+    assocs = assocs_;
+    unsigned int min_assoc = 0;
+    for (unsigned int assoc : assocs) {
+        if (assoc == 0) {
+            fully_associative = true;
+            continue;
+        }
+        if (assoc > depth)
+            depth = assoc;
+        if (min_assoc == 0 || assoc < min_assoc)
+            min_assoc = assoc;
+    }
+    if (fully_associative) {
+        ref_list = new line_ref_list_t(max_entries, MRC_SKIP_DISTANCE, false);
+        full_hits.assign(max_entries, 0);
+    }
+    if (min_assoc == 0)
+        return true;
+    for (unsigned int sets = 1; sets <= max_entries / min_assoc; sets *= 2) {
+        set_group_t group;
+        group.num_sets = sets;
+        group.sample_mask = (sets < sample_sets ? sets : sample_sets) - 1;
+        group.stacks.assign((size_t)sets * depth, TAG_INVALID);
+        group.hits.assign(depth, 0);
+        group.accesses = 0;
+        groups.push_back(group);
+    }
+    return true;
+}
+
+bool
+miss_ratio_curve_t::parse_assocs(const std::string &list, unsigned int default_assoc,
+                                 unsigned int max_entries,
+                                 std::vector<unsigned int> &assocs, std::string &error)
+{
+    assocs.clear();
+    if (list.empty()) {
+        if (default_assoc <= max_entries)
+            assocs.push_back(default_assoc);
+        assocs.push_back(0);
+        return true;
+    }
+    std::stringstream items(list);
+    std::string item;
+    while (std::getline(items, item, ',')) {
+        unsigned int assoc = 0;
+        if (item != "full") {
+            char *end;
+            assoc = (unsigned int)strtoul(item.c_str(), &end, 10);
+            if (item.empty() || *end != '\0' || !IS_POWER_OF_2(assoc) ||
+                assoc > max_entries) {
+                error = "Usage error: invalid associativity '" + item +
+                    "' in -mrc_assocs.  Use powers of 2 up to -mrc_max_entries, or "
+                    "full.";
+                return false;
+            }
+        }
+        assocs.push_back(assoc);
+    }
+    return true;
+}
+
+void
+miss_ratio_curve_t::access(addr_t tag)
+{
+    num_requests++;
+    for (set_group_t &group : groups) {
+        if ((tag & group.sample_mask) != 0)
+            continue;
+        group.accesses++;
+        addr_t *stack = &group.stacks[(tag & (group.num_sets - 1)) * depth];
+        unsigned int dist = 0;
+        while (dist < depth && stack[dist] != tag && stack[dist] != TAG_INVALID)
+            dist++;
+        if (dist < depth && stack[dist] == tag)
+            group.hits[dist]++;
+        else if (dist == depth)
+            dist--;
+        for (; dist > 0; dist--)
+            stack[dist] = stack[dist - 1];
+        stack[0] = tag;
+    }
+    if (!fully_associative)
+        return;
+    full_accesses++;
+    auto it = lines.find(tag);
+    if (it == lines.end()) {
+        line_ref_t *line = new line_ref_t(tag);
+        ref_list->add_to_front(line);
+        lines[tag] = line;
+        return;
+    }
+    int_least64_t dist = ref_list->move_to_front(it->second);
+    if (dist < (int_least64_t)max_entries)
+        full_hits[dist]++;
+}
+
+bool
+miss_ratio_curve_t::get_counts(unsigned int entries, unsigned int assoc, uint64_t *hits,
+                               uint64_t *accesses) const
+{
+    if (entries > max_entries)
+        return false;
+    if (assoc == 0) {
+        if (!fully_associative)
+            return false;
+        for (unsigned int dist = 0; dist < entries; dist++)
+            *hits += full_hits[dist];
+        *accesses += full_accesses;
+        return true;
+    }
+    if (assoc > depth || entries < assoc || entries % assoc != 0)
+        return false;
+    // The group of entries / assoc sets.
+    size_t group = 0;
+    while (group < groups.size() && groups[group].num_sets * assoc < entries)
+        group++;
+    if (group == groups.size() || groups[group].num_sets * assoc != entries)
+        return false;
+    for (unsigned int dist = 0; dist < assoc; dist++)
+        *hits += groups[group].hits[dist];
+    *accesses += groups[group].accesses;
+    return true;
+}
+
+void
+miss_ratio_curve_t::reset()
+{
+    for (set_group_t &group : groups) {
+        group.hits.assign(depth, 0);
+        group.accesses = 0;
+    }
+    full_hits.assign(full_hits.size(), 0);
+    full_accesses = 0;
+    num_requests = 0;
+}
+
+void
+miss_ratio_curve_t::print_curves(const std::vector<miss_ratio_curve_t *> &curves,
+                                 const std::string &prefix)
+{
+    if (curves.empty())
+        return;
+    const miss_ratio_curve_t *first = curves[0];
+    uint64_t requests = 0;
+    for (const miss_ratio_curve_t *curve : curves)
+        requests += curve->num_requests;
+    std::cerr << prefix << std::setw(18) << std::left << "Requests:" << std::setw(20)
+              << std::right << requests << std::endl;
+    std::cerr << prefix << std::setw(10) << "entries";
+    for (unsigned int assoc : first->assocs) {
+        std::cerr << std::setw(12)
+                  << (assoc == 0 ? std::string("full") : "assoc " + std::to_string(assoc));
+    }
+    std::cerr << std::endl;
+    std::cerr << std::fixed << std::setprecision(2);
+    for (unsigned int entries = 1; entries <= first->max_entries; entries *= 2) {
+        std::cerr << prefix << std::setw(10) << entries;
+        for (unsigned int assoc : first->assocs) {
+            uint64_t hits = 0, accesses = 0;
+            for (const miss_ratio_curve_t *curve : curves)
+                curve->get_counts(entries, assoc, &hits, &accesses);
+            if (accesses == 0) {
+                std::cerr << std::setw(12) << "-";
+                continue;
+            }
+            std::cerr << std::setw(11) << (100.0 * (accesses - hits) / accesses) << "%";
+        }
+        std::cerr << std::endl;
+    }
+    std::cerr.unsetf(std::ios::floatfield);
+    std::cerr << std::setprecision(6);
+}
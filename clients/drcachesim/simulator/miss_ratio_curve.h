@@ -0,0 +1,127 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+/* miss_ratio_curve: single-pass LRU miss ratio curves of a caching device
+ * from the stack distances of its request stream.
+ */
+
+#ifndef _MISS_RATIO_CURVE_H_
+#define _MISS_RATIO_CURVE_H_ 1
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "memref.h"
+
+struct line_ref_t;
+struct line_ref_list_t;
+
+// LRU has the inclusion property: a request hits in a structure of N entries
+// exactly when fewer than N distinct tags were requested since the last
+// request for its tag.  One pass over a request stream thus gives the hit
+// ratio of every size at once:
+// - Fully associative: the stack distance over all tags, found with the
+//   skip list of the reuse_distance tool.
+// - Set associative with A ways: for each number of sets S, an LRU stack of
+//   A tags per set.  A request with set distance d hits in every A > d.  With
+//   sample_sets R above 1, only the sets whose index is a multiple of
+//   min(S, R) are tracked, and the ratios are those of their requests.
+// The curves are of the stream the device was actually sent, which for a
+// level behind another depends on the size of that other level.
+class miss_ratio_curve_t {
+public:
+    miss_ratio_curve_t();
+    ~miss_ratio_curve_t();
+
+    // Tracks every power-of-two size up to max_entries for each associativity
+    // in assocs, 0 being fully associative.  All must be powers of 2.
+    bool
+    init(unsigned int max_entries, const std::vector<unsigned int> &assocs,
+         unsigned int sample_sets, std::string &error);
+
+    // Parses the comma-separated associativities of -mrc_assocs, "full" being
+    // fully associative.  An empty list is default_assoc and fully associative.
+    static bool
+    parse_assocs(const std::string &list, unsigned int default_assoc,
+                 unsigned int max_entries, std::vector<unsigned int> &assocs,
+                 std::string &error);
+
+    void
+    access(addr_t tag);
+
+    // Adds the hits and the requests of a structure of entries entries and
+    // associativity assoc.  Returns false if it is not tracked.
+    bool
+    get_counts(unsigned int entries, unsigned int assoc, uint64_t *hits,
+               uint64_t *accesses) const;
+
+    // Clears the counts but keeps the stacks, as at the end of the warmup.
+    void
+    reset();
+
+    // Prints the miss ratio of each size and associativity of the requests of
+    // all of curves, which have the same configuration (one per core).
+    static void
+    print_curves(const std::vector<miss_ratio_curve_t *> &curves,
+                 const std::string &prefix);
+
+protected:
+    // The stacks and counts of one number of sets.
+    struct set_group_t {
+        unsigned int num_sets;
+        // The sets are sampled when their index is a multiple of this.
+        unsigned int sample_mask;
+        // Per set, its most recent tags first, TAG_INVALID when fewer.
+        std::vector<addr_t> stacks;
+        // Requests per set distance below depth, and in total.
+        std::vector<uint64_t> hits;
+        uint64_t accesses;
+    };
+
+    unsigned int max_entries;
+    std::vector<unsigned int> assocs;
+    // The ways kept per set: the largest set-associative associativity.
+    unsigned int depth;
+    std::vector<set_group_t> groups;
+
+    bool fully_associative;
+    line_ref_list_t *ref_list;
+    std::unordered_map<addr_t, line_ref_t *> lines;
+    // Requests per stack distance below max_entries, and in total.
+    std::vector<uint64_t> full_hits;
+    uint64_t full_accesses;
+    uint64_t num_requests;
+};
+
+#endif /* _MISS_RATIO_CURVE_H_ */
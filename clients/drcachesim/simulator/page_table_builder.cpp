@@ -0,0 +1,677 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+
+/* page_table_builder: page tables built from the addresses of a trace, so
+ * that traces without recorded walks drive the page walk simulation
+ * (-synthetic_page_tables) and that translation schemes no trace records can
+ * be simulated (-translation_scheme).
+ */
+
+#include "page_table_builder.h"
+#include <iomanip>
+#include <iostream>
+#include <string.h>
+
+// The data pages not mapped by the trace start at 4GB and the page table pages
+// at 16TB, above any physical address a QEMU trace records.  The host pages of
+// the nested scheme start at 32TB.
+#define SYNTHETIC_DATA_BASE (1ULL << 32)
+#define SYNTHETIC_TABLE_BASE (1ULL << 44)
+#define SYNTHETIC_HOST_BASE (1ULL << 45)
+
+#define PAGE_BITS_4KB 12
+#define VADDR_BITS 48
+#define RADIX_INDEX_BITS 9
+#define PTE_BYTES 8
+
+// An ECPT entry is a line of the PTEs of 8 consecutive pages.
+#define ECPT_CLUSTER_BITS 3
+#define ECPT_ENTRY_BYTES 64
+#define ECPT_INITIAL_ENTRIES 512
+#define ECPT_MAX_KICKS 64
+// The ways of a page size double once this fraction of their entries is used,
+// as elastic cuckoo page tables do, or when an insertion fails.
+#define ECPT_MAX_LOAD 0.6
+// A CWT entry holds the headers of all the 2MB regions of a 1GB region (PMD
+// CWT) or of all the 1GB regions of a 512GB one (PUD CWT), like the walk
+// caches' entries.
+#define CWT_ENTRIES 512
+#define CWT_PMD_REGION_SHIFT 30
+#define CWT_PUD_REGION_SHIFT 39
+// The hashed table has lines of 8 PTEs, like ECPT entries.  An entry is in one
+// of the HASHED_MAX_PROBES lines from the one its key hashes to, and the table
+// doubles when half full or when an entry does not fit.
+#define HASHED_INITIAL_ENTRIES 4096
+#define HASHED_MAX_PROBES 4
+#define HASHED_MAX_LOAD 0.5
+// A flattened node merges two radix levels: 2^18 entries in a 2MB page.
+#define FLATTENED_INDEX_BITS (2 * RADIX_INDEX_BITS)
+
+// The page sizes, in the ECPT way order.
+enum { SIZE_4KB, SIZE_2MB, SIZE_1GB, NUM_SIZES };
+static const unsigned int size_shift[NUM_SIZES] = { 12, 21, 30 };
+
+static unsigned int
+size_index(unsigned int shift)
+{
+    return shift == size_shift[SIZE_1GB] ? SIZE_1GB
+                                         : (shift == size_shift[SIZE_2MB] ? SIZE_2MB : SIZE_4KB);
+}
+
+static addr_t
+canonical(addr_t vaddr)
+{
+    return vaddr & ((1ULL << VADDR_BITS) - 1);
+}
+
+// The entry of key in a hash way of num_entries, a power of 2.
+static uint64_t
+hash_slot(uint64_t key, unsigned int way, uint64_t num_entries)
+{
+    uint64_t x = key + (way + 1) * 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x & (num_entries - 1);
+}
+
+page_table_builder_t::page_table_builder_t()
+    : active(false)
+    , arch(RADIX)
+    , scheme(SCHEME_RADIX)
+    , default_shift(PAGE_BITS_4KB)
+    , num_ways { 0, 0, 0 }
+    , num_cwt_ways { 0, 0 }
+    , next_data(SYNTHETIC_DATA_BASE)
+    , next_table(SYNTHETIC_TABLE_BASE)
+    , next_host(SYNTHETIC_HOST_BASE)
+    , table_bytes(0)
+    , num_grows(0)
+    , last_pid(-1)
+    , last_process(nullptr)
+{
+}
+
+bool
+page_table_builder_t::init(trans_arch arch_, page_table_scheme_t scheme_,
+                           const std::string &page_size, unsigned int ecpt_4K_ways, unsigned int ecpt_2M_ways,
+                           unsigned int ecpt_1G_ways, unsigned int cwt_2M_ways,
+                           unsigned int cwt_1G_ways, std::string &error)
+{
+    if (page_size == SYNTHETIC_PAGE_4K)
+        default_shift = size_shift[SIZE_4KB];
+    else if (page_size == SYNTHETIC_PAGE_2M)
+        default_shift = size_shift[SIZE_2MB];
+    else if (page_size == SYNTHETIC_PAGE_1G)
+        default_shift = size_shift[SIZE_1GB];
+    else {
+        error = "Usage error: -synthetic_page_size must be " SYNTHETIC_PAGE_4K
+                ", " SYNTHETIC_PAGE_2M " or " SYNTHETIC_PAGE_1G ".";
+        return false;
+    }
+    arch = arch_;
+    scheme = scheme_;
+    if (scheme == SCHEME_ECPT) {
+        // The walk reads ECPT_TABLE_LEAVES ways and ECPT_CWT_LEAVES CWT ways
+        // at most, and a CWT header holds a way number of 2 bits.
+        if (ecpt_4K_ways == 0 || ecpt_4K_ways > 4 || ecpt_2M_ways > 4 ||
+            ecpt_1G_ways > 4 ||
+            ecpt_4K_ways + ecpt_2M_ways + ecpt_1G_ways > ECPT_TABLE_LEAVES ||
+            cwt_2M_ways + cwt_1G_ways > ECPT_CWT_LEAVES) {
+            error = "Usage error: -synthetic_page_tables needs 1 to 4 -ECPT_4K_ways, "
+                    "at most 4 ways of each other page size, at most " +
+                std::to_string(ECPT_TABLE_LEAVES) + " ECPT ways and at most " +
+                std::to_string(ECPT_CWT_LEAVES) + " CWT ways.";
+            return false;
+        }
+        num_ways[SIZE_4KB] = ecpt_4K_ways;
+        num_ways[SIZE_2MB] = ecpt_2M_ways;
+        num_ways[SIZE_1GB] = ecpt_1G_ways;
+        num_cwt_ways[0] = cwt_2M_ways;
+        num_cwt_ways[1] = cwt_1G_ways;
+    }
+    if (scheme == SCHEME_NESTED)
+        init_process(host, SCHEME_RADIX);
+    active = true;
+    return true;
+}
+
+addr_t
+page_table_builder_t::alloc_table(uint64_t bytes)
+{
+    addr_t base = next_table;
+    next_table += bytes;
+    table_bytes += bytes;
+    return base;
+}
+
+page_table_builder_t::process_t &
+page_table_builder_t::process(memref_pid_t pid)
+{
+    if (last_process != nullptr && pid == last_pid)
+        return *last_process;
+    auto it = processes.find(pid);
+    if (it == processes.end()) {
+        // The nested scheme's guest tables are radix ones.
+        init_process(processes[pid], scheme == SCHEME_NESTED ? SCHEME_RADIX : scheme);
+        it = processes.find(pid);
+    }
+    last_pid = pid;
+    last_process = &it->second;
+    return it->second;
+}
+
+void
+page_table_builder_t::init_process(process_t &proc, page_table_scheme_t layout)
+{
+    proc.layout = layout;
+    proc.root = 0;
+    proc.hashed_used = 0;
+    if (layout == SCHEME_RADIX) {
+        proc.root = alloc_table(1ULL << PAGE_BITS_4KB);
+    } else if (layout == SCHEME_FLATTENED) {
+        proc.root = alloc_table(PTE_BYTES << FLATTENED_INDEX_BITS);
+    } else if (layout == SCHEME_HASHED) {
+        proc.hashed.base = alloc_table(HASHED_INITIAL_ENTRIES * ECPT_ENTRY_BYTES);
+        proc.hashed.slots.assign(HASHED_INITIAL_ENTRIES, 0);
+    } else {
+        for (unsigned int size = 0; size < NUM_SIZES; size++) {
+            proc.ways[size].resize(num_ways[size]);
+            for (hash_way_t &way : proc.ways[size]) {
+                way.base = alloc_table(ECPT_INITIAL_ENTRIES * ECPT_ENTRY_BYTES);
+                way.slots.assign(ECPT_INITIAL_ENTRIES, 0);
+            }
+        }
+        for (unsigned int i = 0; i < num_cwt_ways[0] + num_cwt_ways[1]; i++)
+            proc.cwt_bases.push_back(alloc_table(CWT_ENTRIES * ECPT_ENTRY_BYTES));
+    }
+}
+
+// The table page at level (1 for the PUD, 3 for the PTE page) covering vaddr.
+addr_t
+page_table_builder_t::radix_table(process_t &proc, unsigned int level, addr_t vaddr)
+{
+    unsigned int covered_bits = VADDR_BITS - RADIX_INDEX_BITS * level;
+    addr_t key = ((addr_t)level << 60) | (canonical(vaddr) >> covered_bits);
+    auto it = proc.tables.find(key);
+    if (it != proc.tables.end())
+        return it->second;
+    addr_t table = alloc_table(1ULL << PAGE_BITS_4KB);
+    proc.tables[key] = table;
+    return table;
+}
+
+// Puts key in an empty entry of one of its ways, moving the keys in the way
+// to their other ways as needed.  Returns false with the key left without an
+// entry in key if that takes too many moves.
+bool
+page_table_builder_t::ecpt_place(process_t &proc, unsigned int size, uint64_t &key)
+{
+    std::vector<hash_way_t> &ways = proc.ways[size];
+    for (unsigned int kick = 0; kick < ECPT_MAX_KICKS; kick++) {
+        for (unsigned int w = 0; w < ways.size(); w++) {
+            uint64_t &slot = ways[w].slots[hash_slot(key, w, ways[w].slots.size())];
+            if (slot == 0) {
+                slot = key + 1;
+                proc.cluster_way[size][key] = w;
+                return true;
+            }
+        }
+        unsigned int w = kick % ways.size();
+        uint64_t &slot = ways[w].slots[hash_slot(key, w, ways[w].slots.size())];
+        uint64_t victim = slot - 1;
+        slot = key + 1;
+        proc.cluster_way[size][key] = w;
+        proc.cluster_way[size].erase(victim);
+        key = victim;
+    }
+    return false;
+}
+
+// Doubles the ways of a page size, in newly allocated table pages, and
+// rehashes their keys.
+void
+page_table_builder_t::ecpt_grow(process_t &proc, unsigned int size)
+{
+    std::vector<uint64_t> keys;
+    keys.reserve(proc.cluster_way[size].size());
+    for (const auto &it : proc.cluster_way[size])
+        keys.push_back(it.first);
+    bool placed;
+    do {
+        num_grows++;
+        proc.cluster_way[size].clear();
+        for (hash_way_t &way : proc.ways[size]) {
+            uint64_t entries = way.slots.size() * 2;
+            way.base = alloc_table(entries * ECPT_ENTRY_BYTES);
+            way.slots.assign(entries, 0);
+        }
+        placed = true;
+        for (uint64_t key : keys) {
+            if (!ecpt_place(proc, size, key)) {
+                placed = false;
+                break;
+            }
+        }
+    } while (!placed);
+}
+
+void
+page_table_builder_t::ecpt_insert(process_t &proc, unsigned int size, uint64_t key)
+{
+    if (proc.cluster_way[size].count(key) > 0)
+        return;
+    const std::vector<hash_way_t> &ways = proc.ways[size];
+    if (proc.cluster_way[size].size() + 1 >
+        ECPT_MAX_LOAD * ways.size() * ways[0].slots.size())
+        ecpt_grow(proc, size);
+    while (!ecpt_place(proc, size, key))
+        ecpt_grow(proc, size);
+}
+
+// The flattened walk of vaddr: the merged PGD and PUD entry, then the merged
+// PMD and PTE one unless the page is a 1GB one.
+void
+page_table_builder_t::flattened_walk(process_t &proc, addr_t vaddr, page_t &page)
+{
+    addr_t va = canonical(vaddr);
+    addr_t index_mask = (1ULL << FLATTENED_INDEX_BITS) - 1;
+    memset(page.steps, 0, sizeof(page.steps));
+    page.steps[0] = proc.root + ((va >> size_shift[SIZE_1GB]) & index_mask) * PTE_BYTES;
+    if (page.size_shift == size_shift[SIZE_1GB])
+        return;
+    addr_t key = (2ULL << 60) | (va >> size_shift[SIZE_1GB]);
+    auto it = proc.tables.find(key);
+    addr_t table;
+    if (it != proc.tables.end())
+        table = it->second;
+    else {
+        table = alloc_table(PTE_BYTES << FLATTENED_INDEX_BITS);
+        proc.tables[key] = table;
+    }
+    addr_t page_va = va & ~((1ULL << page.size_shift) - 1);
+    page.steps[1] = table + ((page_va >> PAGE_BITS_4KB) & index_mask) * PTE_BYTES;
+}
+
+// Puts key in the first empty line of its probes.  Returns false if they are
+// all used.
+bool
+page_table_builder_t::hashed_place(hash_way_t &table, uint64_t key)
+{
+    uint64_t mask = table.slots.size() - 1;
+    uint64_t slot = hash_slot(key, 0, table.slots.size());
+    for (uint64_t probe = 0; probe < HASHED_MAX_PROBES; probe++) {
+        uint64_t &entry = table.slots[(slot + probe) & mask];
+        if (entry == key + 1)
+            return true;
+        if (entry == 0) {
+            entry = key + 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Doubles the hashed table, in newly allocated table pages, and rehashes its
+// keys.
+void
+page_table_builder_t::hashed_grow(process_t &proc)
+{
+    std::vector<uint64_t> keys;
+    keys.reserve(proc.hashed_used);
+    for (uint64_t entry : proc.hashed.slots) {
+        if (entry != 0)
+            keys.push_back(entry - 1);
+    }
+    bool placed;
+    do {
+        num_grows++;
+        uint64_t entries = proc.hashed.slots.size() * 2;
+        proc.hashed.base = alloc_table(entries * ECPT_ENTRY_BYTES);
+        proc.hashed.slots.assign(entries, 0);
+        placed = true;
+        for (uint64_t key : keys) {
+            if (!hashed_place(proc.hashed, key)) {
+                placed = false;
+                break;
+            }
+        }
+    } while (!placed);
+}
+
+void
+page_table_builder_t::hashed_insert(process_t &proc, uint64_t key)
+{
+    if (proc.hashed_used + 1 > HASHED_MAX_LOAD * proc.hashed.slots.size())
+        hashed_grow(proc);
+    while (!hashed_place(proc.hashed, key))
+        hashed_grow(proc);
+    proc.hashed_used++;
+}
+
+// The hashed table key of the cluster of vaddr's page of size.
+static uint64_t
+hashed_key(addr_t vaddr, unsigned int size)
+{
+    return ((uint64_t)size << 60) |
+        (canonical(vaddr) >> (size_shift[size] + ECPT_CLUSTER_BITS));
+}
+
+page_table_builder_t::page_t &
+page_table_builder_t::map_page(process_t &proc, addr_t vaddr,
+                               const _memref_pgtable_results &recorded,
+                               addr_t &next_frame)
+{
+    addr_t vpn = canonical(vaddr) >> PAGE_BITS_4KB;
+    auto it = proc.pages.find(vpn);
+    if (it != proc.pages.end())
+        return it->second;
+
+    // The pages of a huge page mapped earlier are part of it.
+    unsigned int shift = default_shift;
+    if (proc.huge_pages[SIZE_1GB - 1].count(canonical(vaddr) >> size_shift[SIZE_1GB]) > 0)
+        shift = size_shift[SIZE_1GB];
+    else if (proc.huge_pages[SIZE_2MB - 1].count(canonical(vaddr) >> size_shift[SIZE_2MB]) > 0)
+        shift = size_shift[SIZE_2MB];
+    else if (recorded.success) {
+        if (arch == RADIX) {
+            // A walk that stops early ends at a huge page.
+            shift = size_shift[SIZE_4KB] +
+                RADIX_INDEX_BITS * (PAGE_TABLE_LEAVES - recorded.num_steps);
+            if (shift > size_shift[SIZE_1GB])
+                shift = size_shift[SIZE_4KB];
+        } else {
+            unsigned int way = recorded.aux_info.selected_ecpt_way;
+            shift = size_shift[SIZE_4KB];
+            if (way >= num_ways[SIZE_4KB] + num_ways[SIZE_2MB])
+                shift = size_shift[SIZE_1GB];
+            else if (way >= num_ways[SIZE_4KB])
+                shift = size_shift[SIZE_2MB];
+        }
+    }
+    // ECPT maps the pages of a size without ways as 4KB ones.
+    if (proc.layout == SCHEME_ECPT && num_ways[size_index(shift)] == 0)
+        shift = size_shift[SIZE_4KB];
+
+    page_t &page = proc.pages[vpn];
+    page.size_shift = shift;
+    addr_t page_bytes = 1ULL << shift;
+    unsigned int size = size_index(shift);
+    bool new_page = true;
+    if (size == SIZE_4KB) {
+        if (recorded.success)
+            page.paddr = recorded.paddr & ~((1ULL << PAGE_BITS_4KB) - 1);
+        else {
+            page.paddr = next_frame;
+            next_frame += page_bytes;
+        }
+    } else {
+        std::unordered_map<addr_t, addr_t> &huge = proc.huge_pages[size - 1];
+        addr_t huge_vpn = canonical(vaddr) >> shift;
+        auto huge_it = huge.find(huge_vpn);
+        addr_t frame;
+        if (huge_it != huge.end()) {
+            frame = huge_it->second;
+            new_page = false;
+        } else {
+            if (recorded.success)
+                frame = recorded.paddr & ~(page_bytes - 1);
+            else {
+                next_frame = (next_frame + page_bytes - 1) & ~(page_bytes - 1);
+                frame = next_frame;
+                next_frame += page_bytes;
+            }
+            huge[huge_vpn] = frame;
+        }
+        page.paddr = frame + (vaddr & (page_bytes - 1) & ~((1ULL << PAGE_BITS_4KB) - 1));
+    }
+
+    if (proc.layout == SCHEME_RADIX) {
+        addr_t va = canonical(vaddr);
+        unsigned int num_steps = PAGE_TABLE_LEAVES - (shift - size_shift[SIZE_4KB]) /
+            RADIX_INDEX_BITS;
+        addr_t table = proc.root;
+        memset(page.steps, 0, sizeof(page.steps));
+        for (unsigned int level = 0; level < num_steps; level++) {
+            if (level > 0)
+                table = radix_table(proc, level, va);
+            unsigned int index_shift =
+                VADDR_BITS - RADIX_INDEX_BITS * (level + 1);
+            page.steps[level] = table +
+                ((va >> index_shift) & ((1ULL << RADIX_INDEX_BITS) - 1)) * PTE_BYTES;
+        }
+    } else if (proc.layout == SCHEME_FLATTENED) {
+        flattened_walk(proc, vaddr, page);
+    } else if (proc.layout == SCHEME_HASHED) {
+        uint64_t key = hashed_key(vaddr, size);
+        auto cluster = proc.cluster_way[size].find(key);
+        if (cluster == proc.cluster_way[size].end()) {
+            proc.cluster_way[size][key] = 0;
+            hashed_insert(proc, key);
+        }
+    } else if (new_page) {
+        addr_t va = canonical(vaddr);
+        ecpt_insert(proc, size, va >> (shift + ECPT_CLUSTER_BITS));
+        cwt_header_t header;
+        header.byte = proc.region_present[0][va >> size_shift[SIZE_2MB]];
+        if (size == SIZE_4KB)
+            header.present_4KB = 1;
+        else if (size == SIZE_2MB)
+            header.present_2MB = 1;
+        if (size != SIZE_1GB)
+            proc.region_present[0][va >> size_shift[SIZE_2MB]] = header.byte;
+        header.byte = proc.region_present[1][va >> size_shift[SIZE_1GB]];
+        if (size == SIZE_4KB)
+            header.present_4KB = 1;
+        else if (size == SIZE_2MB)
+            header.present_2MB = 1;
+        else
+            header.present_1GB = 1;
+        proc.region_present[1][va >> size_shift[SIZE_1GB]] = header.byte;
+    }
+    return page;
+}
+
+void
+page_table_builder_t::fill_radix(const page_t &page, _memref_pgtable_results &results) const
+{
+    unsigned int num_steps = PAGE_TABLE_LEAVES -
+        (page.size_shift - size_shift[SIZE_4KB]) / RADIX_INDEX_BITS;
+    for (unsigned int i = 0; i < num_steps; i++)
+        results.steps[i] = page.steps[i];
+    results.num_steps = num_steps;
+}
+
+// The lines a hashed walk probes: for each page size up to the page's, from
+// the line the key hashes to up to the one holding it or, for the sizes the
+// page is not, an empty one or the last probe.
+void
+page_table_builder_t::fill_hashed(const process_t &proc, addr_t vaddr,
+                                  _memref_pgtable_results &results) const
+{
+    static_assert(NUM_SIZES * HASHED_MAX_PROBES <= MAX_MEMREF_STEPS,
+                  "a hashed walk fits in the trace's walk");
+    const hash_way_t &table = proc.hashed;
+    uint64_t mask = table.slots.size() - 1;
+    unsigned int step = 0;
+    for (unsigned int size = 0; size < NUM_SIZES; size++) {
+        uint64_t key = hashed_key(vaddr, size);
+        uint64_t slot = hash_slot(key, 0, table.slots.size());
+        bool found = false;
+        for (unsigned int probe = 0; probe < HASHED_MAX_PROBES; probe++) {
+            uint64_t line = (slot + probe) & mask;
+            results.steps[step++] = table.base + line * ECPT_ENTRY_BYTES;
+            found = table.slots[line] == key + 1;
+            if (found || table.slots[line] == 0)
+                break;
+        }
+        if (found)
+            break;
+    }
+    results.num_steps = step;
+}
+
+void
+page_table_builder_t::fill_ecpt(const process_t &proc, const page_t &page, addr_t vaddr,
+                                _memref_pgtable_results &results) const
+{
+    addr_t va = canonical(vaddr);
+    unsigned int step = 0;
+    uint32_t way_start[NUM_SIZES];
+    for (unsigned int size = 0; size < NUM_SIZES; size++) {
+        way_start[size] = step;
+        uint64_t key = va >> (size_shift[size] + ECPT_CLUSTER_BITS);
+        const std::vector<hash_way_t> &ways = proc.ways[size];
+        for (unsigned int w = 0; w < ways.size(); w++) {
+            results.steps[step++] =
+                ways[w].base + hash_slot(key, w, ways[w].slots.size()) * ECPT_ENTRY_BYTES;
+        }
+    }
+    results.num_steps = ECPT_TABLE_LEAVES;
+
+    unsigned int size = size_index(page.size_shift);
+    auto way = proc.cluster_way[size].find(va >> (page.size_shift + ECPT_CLUSTER_BITS));
+    results.aux_info.selected_ecpt_way = (uint16_t)(way_start[size] + way->second);
+
+    unsigned int num_cwt = num_cwt_ways[0] + num_cwt_ways[1];
+    for (unsigned int i = 0; i < num_cwt; i++) {
+        uint64_t key = i < num_cwt_ways[0] ? va >> CWT_PMD_REGION_SHIFT
+                                            : va >> CWT_PUD_REGION_SHIFT;
+        unsigned int w = i < num_cwt_ways[0] ? i : i - num_cwt_ways[0];
+        results.aux_info.cwt_steps[i] =
+            proc.cwt_bases[i] + hash_slot(key, w, CWT_ENTRIES) * ECPT_ENTRY_BYTES;
+    }
+    results.aux_info.n_cwt_steps = num_cwt;
+
+    // The region headers point at the way of the region's huge page.
+    auto pmd = proc.region_present[0].find(va >> size_shift[SIZE_2MB]);
+    if (pmd != proc.region_present[0].end())
+        results.aux_info.pmd_header.byte = pmd->second;
+    if (results.aux_info.pmd_header.present_2MB) {
+        way = proc.cluster_way[SIZE_2MB].find(va >> (size_shift[SIZE_2MB] + ECPT_CLUSTER_BITS));
+        results.aux_info.pmd_header.way_in_ecpt = way->second;
+    }
+    auto pud = proc.region_present[1].find(va >> size_shift[SIZE_1GB]);
+    if (pud != proc.region_present[1].end())
+        results.aux_info.pud_header.byte = pud->second;
+    if (results.aux_info.pud_header.present_1GB) {
+        way = proc.cluster_way[SIZE_1GB].find(va >> (size_shift[SIZE_1GB] + ECPT_CLUSTER_BITS));
+        results.aux_info.pud_header.way_in_ecpt = way->second;
+    }
+}
+
+void
+page_table_builder_t::translate(memref_pid_t pid, addr_t vaddr,
+                                _memref_pgtable_results &results)
+{
+    process_t &proc = process(pid);
+    const page_t &page = map_page(proc, vaddr, results, next_data);
+    _memref_pgtable_results walk;
+    memset(&walk, 0, sizeof(walk));
+    walk.paddr = page.paddr + (vaddr & ((1ULL << PAGE_BITS_4KB) - 1));
+    walk.success = 1;
+    walk.is_non_memory = results.is_non_memory;
+    walk.cpu = results.cpu;
+    if (scheme == SCHEME_ECPT)
+        fill_ecpt(proc, page, vaddr, walk);
+    else if (scheme == SCHEME_HASHED)
+        fill_hashed(proc, vaddr, walk);
+    else
+        fill_radix(page, walk);
+    if (scheme == SCHEME_FLATTENED)
+        walk.num_steps = page.size_shift == size_shift[SIZE_1GB] ? 1 : 2;
+    if (scheme == SCHEME_NESTED) {
+        walk.steps[PAGE_TABLE_LEAVES] = walk.paddr;
+        _memref_pgtable_results none;
+        memset(&none, 0, sizeof(none));
+        const page_t &host_page = map_page(host, walk.paddr, none, next_host);
+        walk.paddr = host_page.paddr + (vaddr & ((1ULL << PAGE_BITS_4KB) - 1));
+    }
+    results = walk;
+}
+
+unsigned int
+page_table_builder_t::page_shift(memref_pid_t pid, addr_t vaddr)
+{
+    process_t &proc = process(pid);
+    auto it = proc.pages.find(canonical(vaddr) >> PAGE_BITS_4KB);
+    if (it == proc.pages.end())
+        return PAGE_BITS_4KB;
+    return it->second.size_shift;
+}
+
+unsigned int
+page_table_builder_t::host_walk(addr_t gpa, addr_t steps[PAGE_TABLE_LEAVES], addr_t &hpa)
+{
+    _memref_pgtable_results none;
+    memset(&none, 0, sizeof(none));
+    const page_t &page = map_page(host, gpa, none, next_host);
+    unsigned int num_steps =
+        PAGE_TABLE_LEAVES - (page.size_shift - size_shift[SIZE_4KB]) / RADIX_INDEX_BITS;
+    for (unsigned int i = 0; i < num_steps; i++)
+        steps[i] = page.steps[i];
+    hpa = page.paddr + (gpa & ((1ULL << PAGE_BITS_4KB) - 1));
+    return num_steps;
+}
+
+void
+page_table_builder_t::print_results(const std::string &prefix) const
+{
+    uint64_t pages = 0;
+    uint64_t huge_pages[2] = { 0, 0 };
+    for (const auto &it : processes) {
+        pages += it.second.pages.size();
+        huge_pages[0] += it.second.huge_pages[0].size();
+        huge_pages[1] += it.second.huge_pages[1].size();
+    }
+    std::cerr << prefix << std::setw(18) << std::left << "Processes:" << std::setw(20)
+              << std::right << processes.size() << std::endl;
+    std::cerr << prefix << std::setw(18) << std::left << "4KB pages touched:"
+              << std::setw(20) << std::right << pages << std::endl;
+    std::cerr << prefix << std::setw(18) << std::left << "2MB pages:" << std::setw(20)
+              << std::right << huge_pages[0] << std::endl;
+    std::cerr << prefix << std::setw(18) << std::left << "1GB pages:" << std::setw(20)
+              << std::right << huge_pages[1] << std::endl;
+    std::cerr << prefix << std::setw(18) << std::left << "Table bytes:" << std::setw(20)
+              << std::right << table_bytes << std::endl;
+    if (scheme == SCHEME_ECPT || scheme == SCHEME_HASHED) {
+        std::cerr << prefix << std::setw(18) << std::left
+                  << (scheme == SCHEME_ECPT ? "ECPT resizes:" : "Table resizes:")
+                  << std::setw(20) << std::right << num_grows << std::endl;
+    }
+    if (scheme == SCHEME_NESTED) {
+        std::cerr << prefix << std::setw(18) << std::left << "Host pages:"
+                  << std::setw(20) << std::right << host.pages.size() << std::endl;
+    }
+}
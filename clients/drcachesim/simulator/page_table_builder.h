@@ -0,0 +1,219 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+
+/* page_table_builder: page tables built from the addresses of a trace, so
+ * that traces without recorded walks drive the page walk simulation
+ * (-synthetic_page_tables) and that translation schemes no trace records can
+ * be simulated (-translation_scheme).
+ */
+
+#ifndef _PAGE_TABLE_BUILDER_H_
+#define _PAGE_TABLE_BUILDER_H_ 1
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "memref.h"
+#include "../reader/qemu_file_reader.h"
+
+#define SYNTHETIC_PAGE_4K "4K"
+#define SYNTHETIC_PAGE_2M "2M"
+#define SYNTHETIC_PAGE_1G "1G"
+
+// The layouts of the tables: the two the traces record and the ones only built
+// here.
+enum page_table_scheme_t {
+    SCHEME_RADIX,
+    SCHEME_ECPT,
+    SCHEME_HASHED,
+    SCHEME_FLATTENED,
+    SCHEME_NESTED,
+};
+
+// Each page of a process is mapped on its first reference, to the physical
+// page the trace shows for it if the trace has a successful walk and otherwise
+// to the next free page of a synthetic physical space.  The walk entries live
+// in page table pages allocated from a separate synthetic region, far above
+// both, as the process' tables grow:
+// - radix: a 4-level tree of 512-entry pages, from which a walk reads one
+//   entry per level down to the leaf of the page's size;
+// - ECPT: per page size, ways of cuckoo hashed entries each covering a cluster
+//   of 8 pages.  All the ways of a size double when they fill up.  The
+//   PMD and PUD cuckoo walk tables (CWTs) are hashed the same way with a
+//   fixed size, and their headers say which page sizes map each 2MB and 1GB
+//   region;
+// - hashed: a single open-addressed table of 8-page clusters of all page
+//   sizes, probed linearly over a few lines, one line per probe, and doubled
+//   when half full or when an entry does not fit.  A walk looks the address up
+//   as a 4KB page first, then as a 2MB and a 1GB one;
+// - flattened: a radix tree whose PGD and PUD and whose PMD and PTE levels are
+//   merged into 2MB pages of 2^18 entries, so that a walk reads 2 entries, 1
+//   for a 1GB page.  A 2MB page has its entry in the merged node, at its first
+//   4KB page;
+// - nested: the radix tables of a guest, whose physical addresses are guest
+//   physical ones, which a host maps with its own radix tables.  translate()
+//   gives the guest walk and the host physical address of the data and the
+//   nested walk looks up each guest physical address with host_walk().
+// Pages keep their mapping and are never unmapped.
+class page_table_builder_t {
+public:
+    page_table_builder_t();
+
+    // arch is the trace's format and scheme the tables' layout.  page_size is
+    // the size of the pages not mapped by the trace, and of the host's pages.
+    // The ECPT way counts must match the simulator's knobs.
+    bool
+    init(trans_arch arch, page_table_scheme_t scheme, const std::string &page_size,
+         unsigned int ecpt_4K_ways,
+         unsigned int ecpt_2M_ways, unsigned int ecpt_1G_ways, unsigned int cwt_2M_ways,
+         unsigned int cwt_1G_ways, std::string &error);
+    bool
+    enabled() const
+    {
+        return active;
+    }
+
+    // Replaces results with the walk of vaddr in process pid, mapping its page
+    // first if needed.  The walk the trace recorded in results, if any, only
+    // supplies the physical address and the page size.
+    // For the nested scheme, the steps are guest physical addresses and
+    // steps[PAGE_TABLE_LEAVES] is the guest physical address of vaddr.
+    void
+    translate(memref_pid_t pid, addr_t vaddr, _memref_pgtable_results &results);
+
+    // The page size shift of vaddr, as translate() mapped it, or that of a 4KB
+    // page if translate() has not seen it (e.g., a flush's address).
+    unsigned int
+    page_shift(memref_pid_t pid, addr_t vaddr);
+    // The nested scheme's host walk of gpa: its steps, of which it returns the
+    // number, and in hpa its host physical address.
+    unsigned int
+    host_walk(addr_t gpa, addr_t steps[PAGE_TABLE_LEAVES], addr_t &hpa);
+    unsigned int
+    host_page_shift() const
+    {
+        return default_shift;
+    }
+
+    void
+    print_results(const std::string &prefix) const;
+
+private:
+    struct page_t {
+        // The physical address of the 4KB page.
+        addr_t paddr;
+        unsigned int size_shift;
+        // The radix or flattened walk, which does not change once the page is
+        // mapped.
+        addr_t steps[PAGE_TABLE_LEAVES];
+    };
+    struct hash_way_t {
+        addr_t base;
+        // The key plus one of each entry, 0 for an empty one.
+        std::vector<uint64_t> slots;
+    };
+    struct process_t {
+        page_table_scheme_t layout;
+        std::unordered_map<addr_t, page_t> pages;
+        // The physical page of each 2MB and 1GB page, by virtual page number.
+        std::unordered_map<addr_t, addr_t> huge_pages[2];
+        // Radix and flattened: the root and the lower table pages, by level
+        // and the virtual address bits above the range a table page covers.
+        addr_t root;
+        std::unordered_map<addr_t, addr_t> tables;
+        // ECPT: the ways of each page size and the way each cluster is in.
+        // The hashed scheme only uses the clusters.
+        std::vector<hash_way_t> ways[3];
+        std::unordered_map<uint64_t, unsigned int> cluster_way[3];
+        std::vector<addr_t> cwt_bases;
+        // The cwt_header_t present bits of each 2MB and 1GB region.
+        std::unordered_map<addr_t, unsigned char> region_present[2];
+        // Hashed: the table, with the number of entries used.
+        hash_way_t hashed;
+        uint64_t hashed_used;
+    };
+
+    process_t &
+    process(memref_pid_t pid);
+    void
+    init_process(process_t &proc, page_table_scheme_t layout);
+    page_t &
+    map_page(process_t &proc, addr_t vaddr, const _memref_pgtable_results &recorded,
+             addr_t &next_frame);
+    addr_t
+    alloc_table(uint64_t bytes);
+    addr_t
+    radix_table(process_t &proc, unsigned int level, addr_t vaddr);
+    void
+    ecpt_insert(process_t &proc, unsigned int size, uint64_t key);
+    bool
+    ecpt_place(process_t &proc, unsigned int size, uint64_t &key);
+    void
+    ecpt_grow(process_t &proc, unsigned int size);
+    void
+    flattened_walk(process_t &proc, addr_t vaddr, page_t &page);
+    bool
+    hashed_place(hash_way_t &table, uint64_t key);
+    void
+    hashed_grow(process_t &proc);
+    void
+    hashed_insert(process_t &proc, uint64_t key);
+    void
+    fill_radix(const page_t &page, _memref_pgtable_results &results) const;
+    void
+    fill_hashed(const process_t &proc, addr_t vaddr, _memref_pgtable_results &results) const;
+    void
+    fill_ecpt(const process_t &proc, const page_t &page, addr_t vaddr,
+              _memref_pgtable_results &results) const;
+
+    bool active;
+    trans_arch arch;
+    page_table_scheme_t scheme;
+    unsigned int default_shift;
+    unsigned int num_ways[3];
+    unsigned int num_cwt_ways[2];
+    addr_t next_data;
+    addr_t next_table;
+    // Nested: the host's tables and next free page.
+    process_t host;
+    addr_t next_host;
+    uint64_t table_bytes;
+    uint64_t num_grows;
+    memref_pid_t last_pid;
+    process_t *last_process;
+    std::unordered_map<memref_pid_t, process_t> processes;
+};
+
+#endif /* _PAGE_TABLE_BUILDER_H_ */
@@ -0,0 +1,182 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+/* page_walker: the translation schemes the cache simulator walks on a TLB miss
+ * (-translation_scheme).
+ */
+
+#ifndef _PAGE_WALKER_H_
+#define _PAGE_WALKER_H_ 1
+
+#include "cache_simulator.h"
+
+#define TRANSLATION_SCHEME_RADIX "radix"
+#define TRANSLATION_SCHEME_ECPT "ecpt"
+#define TRANSLATION_SCHEME_HASHED "hashed"
+#define TRANSLATION_SCHEME_FLATTENED "flattened"
+#define TRANSLATION_SCHEME_NESTED "nested"
+
+// A page walker is the part of simulating a reference that depends on the
+// translation scheme.  cache_simulator_t::simulate_translation() is a template
+// instantiated once per walker, so that its calls below are resolved at
+// compile time instead of by a branch or a virtual call per reference.  A
+// walker lives for one reference and provides:
+// - page_size(): the size of the page the reference's walk maps, for the TLBs;
+// - walk(): the walk of a TLB miss, through the core's walk caches and caches,
+//   whose steps it puts in ref.perf_res.pgwalk_res;
+// - finish(): run after a walk once the reference's access is simulated,
+//   which returns the cycles it adds to the walk.
+// - walk_cycles(): the walk_latency_t cycles of a walk it put in a
+//   perf_result_t, with the cycles finish() added.
+// Adding a scheme takes a walker, its case in cache_simulator_t::
+// init_page_walker() and, unless traces record its walks, its layout in
+// page_table_builder_t.
+class page_walker_t {
+public:
+    typedef cache_simulator_t::sim_ref_t sim_ref_t;
+    typedef cache_simulator_t::page_walk_hm_result_t page_walk_hm_result_t;
+    typedef cache_simulator_t::perf_result_t perf_result_t;
+
+    explicit page_walker_t(cache_simulator_t &sim)
+        : sim(sim)
+    {
+    }
+    uint64_t
+    finish(sim_ref_t &ref, const _memref_pgtable_results &results)
+    {
+        return 0;
+    }
+
+protected:
+    cache_simulator_t &sim;
+};
+
+// The 4-level radix walk the trace records, which ends early at huge pages and
+// skips the levels the page walk caches hold.
+class radix_walker_t : public page_walker_t {
+public:
+    explicit radix_walker_t(cache_simulator_t &sim)
+        : page_walker_t(sim)
+    {
+    }
+    tlb_page_size_t
+    page_size(const sim_ref_t &ref, addr_t vpage, const _memref_pgtable_results &results);
+    void
+    walk(sim_ref_t &ref, addr_t vpage, const _memref_pgtable_results &results);
+    static uint64_t
+    walk_cycles(const cache_simulator_t &sim, const perf_result_t &perf_res,
+                uint64_t finish_cycles);
+};
+
+// The ECPT walk the trace records: the ways the cuckoo walk caches leave are
+// probed, and the cuckoo walk tables are back-filled after CWC misses.
+class ecpt_walker_t : public page_walker_t {
+public:
+    explicit ecpt_walker_t(cache_simulator_t &sim)
+        : page_walker_t(sim)
+        , hit_info { false, false }
+    {
+    }
+    tlb_page_size_t
+    page_size(const sim_ref_t &ref, addr_t vpage, const _memref_pgtable_results &results);
+    void
+    walk(sim_ref_t &ref, addr_t vpage, const _memref_pgtable_results &results);
+    static uint64_t
+    walk_cycles(const cache_simulator_t &sim, const perf_result_t &perf_res,
+                uint64_t finish_cycles);
+    uint64_t
+    finish(sim_ref_t &ref, const _memref_pgtable_results &results);
+
+private:
+    hit_info_t hit_info;
+};
+
+// The walks of page_table_builder_t's hashed tables: the probed lines, read
+// one after the other.
+class hashed_walker_t : public page_walker_t {
+public:
+    explicit hashed_walker_t(cache_simulator_t &sim)
+        : page_walker_t(sim)
+    {
+    }
+    tlb_page_size_t
+    page_size(const sim_ref_t &ref, addr_t vpage, const _memref_pgtable_results &results);
+    void
+    walk(sim_ref_t &ref, addr_t vpage, const _memref_pgtable_results &results);
+    static uint64_t
+    walk_cycles(const cache_simulator_t &sim, const perf_result_t &perf_res,
+                uint64_t finish_cycles);
+};
+
+// The walks of page_table_builder_t's flattened tables, which no walk cache
+// shortens.
+class flattened_walker_t : public page_walker_t {
+public:
+    explicit flattened_walker_t(cache_simulator_t &sim)
+        : page_walker_t(sim)
+    {
+    }
+    tlb_page_size_t
+    page_size(const sim_ref_t &ref, addr_t vpage, const _memref_pgtable_results &results);
+    void
+    walk(sim_ref_t &ref, addr_t vpage, const _memref_pgtable_results &results);
+    static uint64_t
+    walk_cycles(const cache_simulator_t &sim, const perf_result_t &perf_res,
+                uint64_t finish_cycles);
+};
+
+// The two-dimensional walk of page_table_builder_t's nested tables: each guest
+// entry the page walk caches do not skip is read after the host walk of its
+// guest physical address, and the data's guest physical address takes a last
+// host walk.  The walk's result has the guest steps first, like a radix one,
+// then the 4 steps of each host walk.
+class nested_walker_t : public page_walker_t {
+public:
+    explicit nested_walker_t(cache_simulator_t &sim)
+        : page_walker_t(sim)
+    {
+    }
+    tlb_page_size_t
+    page_size(const sim_ref_t &ref, addr_t vpage, const _memref_pgtable_results &results);
+    void
+    walk(sim_ref_t &ref, addr_t vpage, const _memref_pgtable_results &results);
+    static uint64_t
+    walk_cycles(const cache_simulator_t &sim, const perf_result_t &perf_res,
+                uint64_t finish_cycles);
+
+private:
+    addr_t
+    host_walk(addr_t gpa, page_walk_hm_result_t &host_res, int core);
+};
+
+#endif /* _PAGE_WALKER_H_ */
@@ -36,6 +36,9 @@
 #include "caching_device.h"
 #include "../common/memref.h"
 
+// Prefetches stay within the 4KB page of the access.
+#define PREFETCH_PAGE_BITS 12
+
 prefetcher_t::prefetcher_t(int block_size)
     : block_size(block_size)
 {
@@ -43,11 +46,163 @@ prefetcher_t::prefetcher_t(int block_size)
 }
 
 void
-prefetcher_t::prefetch(caching_device_t *cache, const memref_t &memref_in)
+prefetcher_t::issue(caching_device_t *cache, const memref_t &memref_in, addr_t addr)
 {
-    // We implement a simple next-line prefetcher.
     memref_t memref = memref_in;
-    memref.data.addr += block_size;
+    memref.data.addr = addr;
     memref.data.type = TRACE_TYPE_HARDWARE_PREFETCH;
     cache->request(memref);
 }
+
+void
+prefetcher_t::prefetch(caching_device_t *cache, const memref_t &memref_in, bool miss)
+{
+    // We implement a simple next-line prefetcher.
+    if (miss)
+        issue(cache, memref_in, memref_in.data.addr + block_size);
+}
+
+stride_prefetcher_t::stride_prefetcher_t(int block_size, int degree)
+    : prefetcher_t(block_size)
+    , degree(degree)
+{
+    table.assign(STRIDE_TABLE_SIZE, entry_t { 0, 0, 0, 0 });
+}
+
+void
+stride_prefetcher_t::prefetch(caching_device_t *cache, const memref_t &memref, bool miss)
+{
+    if (!trains_on(memref))
+        return;
+    addr_t key = prefetch_key(memref);
+    addr_t addr = memref.data.addr;
+    entry_t &entry = table[(key ^ (key >> 8)) % STRIDE_TABLE_SIZE];
+    if (entry.key != key) {
+        entry = entry_t { key, addr, 0, 0 };
+        return;
+    }
+    int64_t stride = (int64_t)(addr - entry.last_addr);
+    if (stride == 0)
+        return;
+    if (stride == entry.stride) {
+        if (entry.confidence < STRIDE_CONFIDENCE_MAX)
+            entry.confidence++;
+    } else if (entry.confidence > 0) {
+        entry.confidence--;
+    } else {
+        entry.stride = stride;
+    }
+    entry.last_addr = addr;
+    if (entry.confidence < STRIDE_CONFIDENCE_THRESHOLD)
+        return;
+    addr_t last_block = addr / block_size;
+    for (int i = 1; i <= degree; i++) {
+        addr_t target = addr + entry.stride * i;
+        if ((target >> PREFETCH_PAGE_BITS) != (addr >> PREFETCH_PAGE_BITS))
+            break;
+        // Strides below the block size would prefetch the same block again.
+        if (target / block_size == last_block)
+            continue;
+        last_block = target / block_size;
+        issue(cache, memref, last_block * block_size);
+    }
+}
+
+stream_prefetcher_t::stream_prefetcher_t(int block_size, int degree)
+    : prefetcher_t(block_size)
+    , degree(degree)
+    , num_accesses(0)
+{
+    streams.assign(STREAM_TABLE_SIZE, stream_t { 0, 0, 0, 0, 0 });
+}
+
+void
+stream_prefetcher_t::prefetch(caching_device_t *cache, const memref_t &memref, bool miss)
+{
+    if (!trains_on(memref))
+        return;
+    num_accesses++;
+    addr_t page = memref.data.addr >> PREFETCH_PAGE_BITS;
+    int64_t block = (int64_t)(memref.data.addr / block_size);
+    stream_t *stream = nullptr;
+    stream_t *victim = &streams[0];
+    for (stream_t &it : streams) {
+        if (it.last_use != 0 && it.page == page) {
+            stream = &it;
+            break;
+        }
+        if (it.last_use < victim->last_use)
+            victim = &it;
+    }
+    if (stream == nullptr) {
+        *victim = stream_t { page, block, 0, 0, num_accesses };
+        return;
+    }
+    stream->last_use = num_accesses;
+    int64_t delta = block - stream->last_block;
+    if (delta == 0)
+        return;
+    int direction = delta > 0 ? 1 : -1;
+    if (direction == stream->direction)
+        stream->confidence++;
+    else {
+        stream->direction = direction;
+        stream->confidence = 0;
+    }
+    stream->last_block = block;
+    if (stream->confidence < STREAM_CONFIDENCE_THRESHOLD)
+        return;
+    int blocks_per_page = (1 << PREFETCH_PAGE_BITS) / block_size;
+    int64_t page_first = (int64_t)(page << PREFETCH_PAGE_BITS) / block_size;
+    for (int i = 1; i <= degree; i++) {
+        int64_t target = block + direction * i;
+        if (target < page_first || target >= page_first + blocks_per_page)
+            break;
+        issue(cache, memref, (addr_t)target * block_size);
+    }
+}
+
+spatial_prefetcher_t::spatial_prefetcher_t(int block_size)
+    : prefetcher_t(block_size)
+    , num_accesses(0)
+{
+    blocks_per_region = (1 << SPATIAL_REGION_BITS) / block_size;
+    // A footprint is a 64-bit mask.
+    if (blocks_per_region > 64)
+        blocks_per_region = 64;
+    active.assign(SPATIAL_ACTIVE_REGIONS, region_t { 0, 0, 0, 0 });
+    patterns.assign(1 << SPATIAL_PATTERN_BITS, 0);
+}
+
+void
+spatial_prefetcher_t::prefetch(caching_device_t *cache, const memref_t &memref, bool miss)
+{
+    if (!trains_on(memref))
+        return;
+    num_accesses++;
+    addr_t region = memref.data.addr >> SPATIAL_REGION_BITS;
+    int offset = (int)((memref.data.addr & ((1 << SPATIAL_REGION_BITS) - 1)) / block_size);
+    if (offset >= blocks_per_region)
+        return;
+    region_t *victim = &active[0];
+    for (region_t &it : active) {
+        if (it.last_use != 0 && it.region == region) {
+            it.footprint |= 1ULL << offset;
+            it.last_use = num_accesses;
+            return;
+        }
+        if (it.last_use < victim->last_use)
+            victim = &it;
+    }
+    // The least recently used region ends its generation and is learned.
+    if (victim->last_use != 0)
+        patterns[victim->pattern_index] = victim->footprint;
+    unsigned int index = pattern_index(memref, offset);
+    *victim = region_t { region, index, 1ULL << offset, num_accesses };
+    uint64_t footprint = patterns[index] & ~(1ULL << offset);
+    addr_t base = region << SPATIAL_REGION_BITS;
+    for (int i = 0; footprint != 0; i++, footprint >>= 1) {
+        if ((footprint & 1) != 0)
+            issue(cache, memref, base + (addr_t)i * block_size);
+    }
+}
@@ -36,11 +36,21 @@
 #ifndef _PREFETCHER_H_
 #define _PREFETCHER_H_ 1
 
+#include <stdint.h>
+#include <vector>
+
 #include "caching_device.h"
 #include "memref.h"
 
 class caching_device_t;
 
+// A prefetcher is called by its caching device on every demand access, after
+// the lookup, with whether it missed.  The default issues a next-line
+// prefetch on each miss.  The others below track the access stream of data
+// loads and stores only: page table lines are fetched by the page walker,
+// which does not train the core's prefetchers.  They keep their prefetches
+// within the 4KB page of the access, as the cache only sees physical
+// addresses.
 class prefetcher_t {
 public:
     prefetcher_t(int block_size);
@@ -48,10 +58,111 @@ public:
     {
     }
     virtual void
-    prefetch(caching_device_t *cache, const memref_t &memref);
+    prefetch(caching_device_t *cache, const memref_t &memref, bool miss);
+
+protected:
+    // Requests the block at addr from cache as a hardware prefetch.
+    void
+    issue(caching_device_t *cache, const memref_t &memref, addr_t addr);
+    static inline bool
+    trains_on(const memref_t &memref)
+    {
+        return memref.data.type == TRACE_TYPE_READ || memref.data.type == TRACE_TYPE_WRITE;
+    }
 
-private:
     int block_size;
 };
 
+// The key the prefetchers below track an access stream by: the PC of the
+// access or, for QEMU traces which carry no data PCs, its 4KB page.
+static inline addr_t
+prefetch_key(const memref_t &memref)
+{
+    return memref.data.pc != 0 ? memref.data.pc : memref.data.addr >> 12;
+}
+
+// A reference prediction table of the last address and stride of each key
+// (see prefetch_key()).  Once the same stride is seen twice in a row, each
+// access prefetches the next degree strides.
+class stride_prefetcher_t : public prefetcher_t {
+public:
+    stride_prefetcher_t(int block_size, int degree);
+    virtual void
+    prefetch(caching_device_t *cache, const memref_t &memref, bool miss);
+
+protected:
+    static const int STRIDE_TABLE_SIZE = 256;
+    static const int STRIDE_CONFIDENCE_MAX = 3;
+    static const int STRIDE_CONFIDENCE_THRESHOLD = 2;
+
+    struct entry_t {
+        addr_t key;
+        addr_t last_addr;
+        int64_t stride;
+        int confidence;
+    };
+    int degree;
+    std::vector<entry_t> table;
+};
+
+// Tracks the most recent pages accessed one block after another and, once a
+// page has seen STREAM_CONFIDENCE_THRESHOLD accesses in the same direction,
+// prefetches the next degree blocks in that direction.
+class stream_prefetcher_t : public prefetcher_t {
+public:
+    stream_prefetcher_t(int block_size, int degree);
+    virtual void
+    prefetch(caching_device_t *cache, const memref_t &memref, bool miss);
+
+protected:
+    static const int STREAM_TABLE_SIZE = 16;
+    static const int STREAM_CONFIDENCE_THRESHOLD = 2;
+
+    struct stream_t {
+        addr_t page;
+        int64_t last_block;
+        int direction;
+        int confidence;
+        uint64_t last_use;
+    };
+    int degree;
+    uint64_t num_accesses;
+    std::vector<stream_t> streams;
+};
+
+// A spatial memory streaming prefetcher (Somogyi et al., ISCA 2006) on 4KB
+// regions.  While a region is active the blocks accessed in it are recorded.
+// When it leaves the active table its footprint is learned by the PC and
+// offset of the access that started it, or by the offset alone without data
+// PCs.  The next region started the same way prefetches that footprint.
+class spatial_prefetcher_t : public prefetcher_t {
+public:
+    spatial_prefetcher_t(int block_size);
+    virtual void
+    prefetch(caching_device_t *cache, const memref_t &memref, bool miss);
+
+protected:
+    static const int SPATIAL_REGION_BITS = 12;
+    static const int SPATIAL_ACTIVE_REGIONS = 32;
+    static const int SPATIAL_PATTERN_BITS = 12;
+
+    struct region_t {
+        addr_t region;
+        unsigned int pattern_index;
+        uint64_t footprint;
+        uint64_t last_use;
+    };
+    inline unsigned int
+    pattern_index(const memref_t &memref, int offset) const
+    {
+        addr_t key = (memref.data.pc * 64 + offset + 1) * 0x9e3779b97f4a7c15ULL;
+        return (unsigned int)(key >> (64 - SPATIAL_PATTERN_BITS));
+    }
+
+    int blocks_per_region;
+    uint64_t num_accesses;
+    std::vector<region_t> active;
+    std::vector<uint64_t> patterns;
+};
+
 #endif /* _PREFETCHER_H_ */
@@ -0,0 +1,218 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+/* sampler: SMARTS-style systematic sampling of a trace, with confidence
+ * intervals for the translation metrics (-sample_period and related options).
+ */
+
+#include "sampler.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+// The fewest windows the intervals are trusted with, for the sample means to
+// be close enough to normal.
+#define SAMPLE_MIN_WINDOWS 30
+
+sampler_t::sampler_t()
+    : period(0)
+    , window(0)
+    , warmup(0)
+    , skip(0)
+    , measure_start(0)
+    , error_bound(0.0)
+    , confidence(0.0)
+    , z(0.0)
+    , position(0)
+    , window_ended(false)
+    , done(false)
+    , current { 0, 0, 0, 0 }
+{
+}
+
+bool
+sampler_t::init(uint64_t period_, uint64_t window_, uint64_t warmup_, uint64_t skip_,
+                double error_bound_, double confidence_, std::string &error)
+{
+    if (period_ == 0)
+        return true;
+    if (window_ == 0 || skip_ + warmup_ + window_ > period_) {
+        error = "Usage error: -sample_window must be non-zero and -sample_skip, "
+                "-sample_warmup and -sample_window must fit in -sample_period.";
+        return false;
+    }
+    if (error_bound_ < 0.0 || confidence_ <= 0.0 || confidence_ >= 1.0) {
+        error = "Usage error: -sample_error must be at least 0 and "
+                "-sample_confidence between 0 and 1.";
+        return false;
+    }
+    period = period_;
+    window = window_;
+    warmup = warmup_;
+    skip = skip_;
+    measure_start = period - window;
+    error_bound = error_bound_;
+    confidence = confidence_;
+    z = confidence_z(confidence);
+    return true;
+}
+
+bool
+sampler_t::end_window()
+{
+    windows.push_back(current);
+    current = window_t { 0, 0, 0, 0 };
+    window_ended = false;
+    if (error_bound == 0.0 || windows.size() < SAMPLE_MIN_WINDOWS)
+        return false;
+    done = walk_rate().relative_error <= error_bound &&
+        tlb_mpki().relative_error <= error_bound &&
+        walk_latency().relative_error <= error_bound;
+    return done;
+}
+
+// With y and x the numerator and denominator of each window, the estimate is
+// R = sum(y) / sum(x), and its variance that of the residuals y - R * x
+// divided by n * mean(x)^2.
+sample_estimate_t
+sampler_t::estimate(window_field_t numerator, window_field_t denominator,
+                    double scale) const
+{
+    sample_estimate_t estimate = { 0.0, 0.0, 0.0 };
+    double sum_y = 0.0, sum_x = 0.0;
+    for (const window_t &it : windows) {
+        sum_y += it.*numerator;
+        sum_x += it.*denominator;
+    }
+    size_t n = windows.size();
+    if (sum_x == 0.0 || n < 2)
+        return estimate;
+    double ratio = sum_y / sum_x;
+    double residuals = 0.0;
+    for (const window_t &it : windows) {
+        double residual = it.*numerator - ratio * it.*denominator;
+        residuals += residual * residual;
+    }
+    double mean_x = sum_x / n;
+    double variance = residuals / (n - 1) / (n * mean_x * mean_x);
+    estimate.mean = scale * ratio;
+    estimate.half_width = scale * z * std::sqrt(variance);
+    if (estimate.mean > 0.0)
+        estimate.relative_error = estimate.half_width / estimate.mean;
+    return estimate;
+}
+
+sample_estimate_t
+sampler_t::walk_rate() const
+{
+    return estimate(&window_t::walks, &window_t::refs, 100.0);
+}
+
+sample_estimate_t
+sampler_t::tlb_mpki() const
+{
+    return estimate(&window_t::walks, &window_t::instrs, 1000.0);
+}
+
+sample_estimate_t
+sampler_t::walk_latency() const
+{
+    return estimate(&window_t::walk_cycles, &window_t::walks, 1.0);
+}
+
+// The half-width shrinks with the square root of the number of windows.
+uint64_t
+sampler_t::windows_needed() const
+{
+    double worst = std::max(walk_rate().relative_error,
+                            std::max(tlb_mpki().relative_error,
+                                     walk_latency().relative_error));
+    double needed = windows.size() * (worst / error_bound) * (worst / error_bound);
+    return std::max((uint64_t)SAMPLE_MIN_WINDOWS, (uint64_t)std::ceil(needed));
+}
+
+double
+sampler_t::confidence_z(double confidence)
+{
+    // Bisection of erf(z / sqrt(2)) = confidence.
+    double low = 0.0, high = 10.0;
+    for (int i = 0; i < 64; i++) {
+        double mid = (low + high) / 2;
+        if (std::erf(mid / std::sqrt(2.0)) < confidence)
+            low = mid;
+        else
+            high = mid;
+    }
+    return (low + high) / 2;
+}
+
+void
+sampler_t::print_results(const std::string &prefix) const
+{
+    std::cerr << prefix << std::setw(18) << std::left << "Windows:" << std::setw(20)
+              << std::right << windows.size() << std::endl;
+    std::cerr << prefix << std::setw(18) << std::left << "Measured refs:" << std::setw(20)
+              << std::right << windows.size() * window << std::endl;
+    struct {
+        const char *name;
+        sample_estimate_t estimate;
+    } metrics[] = {
+        { "Walks per 100 refs:", walk_rate() },
+        { "TLB MPKI:", tlb_mpki() },
+        { "Cycles per walk:", walk_latency() },
+    };
+    std::cerr << std::fixed << std::setprecision(3);
+    for (const auto &metric : metrics) {
+        std::cerr << prefix << std::setw(18) << std::left << metric.name << std::setw(20)
+                  << std::right << metric.estimate.mean;
+        if (windows.size() >= 2) {
+            std::cerr << " +- " << metric.estimate.half_width << " ("
+                      << std::setprecision(2) << 100.0 * metric.estimate.relative_error
+                      << "%)" << std::setprecision(3);
+        }
+        std::cerr << std::endl;
+    }
+    std::cerr << prefix << "Intervals at " << std::setprecision(1) << 100.0 * confidence
+              << "% confidence." << std::endl;
+    if (done) {
+        std::cerr << prefix << "Stopped early: every metric is within +-"
+                  << 100.0 * error_bound << "%." << std::endl;
+    } else if (error_bound > 0.0 && !windows.empty()) {
+        std::cerr << prefix << "The +-" << 100.0 * error_bound
+                  << "% error bound was not met: it needs about " << windows_needed()
+                  << " windows." << std::endl;
+    }
+    std::cerr.unsetf(std::ios_base::floatfield);
+    std::cerr << std::setprecision(6);
+}
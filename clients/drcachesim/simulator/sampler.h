@@ -0,0 +1,180 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+/* sampler: SMARTS-style systematic sampling of a trace, with confidence
+ * intervals for the translation metrics (-sample_period and related options).
+ */
+
+#ifndef _SAMPLER_H_
+#define _SAMPLER_H_ 1
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// What a reference is used for.  Each period of the trace is made of, in
+// order:
+// - skipped references, which are not simulated at all;
+// - functionally warmed references, which only update the state of the
+//   caches, TLBs and walk caches;
+// - detailed warming references, simulated in full but not measured;
+// - the measurement window.
+// Once the error bound is met, the references left are done and dropped.
+enum sample_phase_t {
+    SAMPLE_SKIP,
+    SAMPLE_FUNCTIONAL,
+    SAMPLE_DETAILED,
+    SAMPLE_MEASURE,
+    SAMPLE_DONE,
+};
+
+// The estimate of a ratio metric from its per-window numerators and
+// denominators, and the half-width of its confidence interval.
+struct sample_estimate_t {
+    double mean;
+    double half_width;
+    // The half-width relative to the mean, 0 when both are 0.
+    double relative_error;
+};
+
+class sampler_t {
+public:
+    sampler_t();
+
+    // A period of 0 leaves sampling off.
+    bool
+    init(uint64_t period, uint64_t window, uint64_t warmup, uint64_t skip,
+         double error_bound, double confidence, std::string &error);
+    bool
+    enabled() const
+    {
+        return period > 0;
+    }
+
+    // Moves the schedule on by one reference and returns its phase.
+    sample_phase_t
+    next()
+    {
+        if (done)
+            return SAMPLE_DONE;
+        uint64_t offset = position++;
+        if (position == period)
+            position = 0;
+        if (offset < skip)
+            return SAMPLE_SKIP;
+        if (offset < measure_start - warmup)
+            return SAMPLE_FUNCTIONAL;
+        if (offset < measure_start)
+            return SAMPLE_DETAILED;
+        current.refs++;
+        window_ended = position == 0;
+        return SAMPLE_MEASURE;
+    }
+    // Whether the last reference next() returned ends a measurement window.
+    bool
+    window_complete() const
+    {
+        return window_ended;
+    }
+    // Counts a measured reference: whether it is an instruction fetch, and if
+    // it missed the TLBs, the cycles of its walk.
+    void
+    measure(bool is_instr, bool tlb_miss, uint64_t walk_cycles)
+    {
+        if (is_instr)
+            current.instrs++;
+        if (tlb_miss) {
+            current.walks++;
+            current.walk_cycles += walk_cycles;
+        }
+    }
+    // Closes the current window.  Returns whether the error bound is now met,
+    // after which next() only returns SAMPLE_DONE.
+    bool
+    end_window();
+    bool
+    is_done() const
+    {
+        return done;
+    }
+
+    // Page walks per 100 references, TLB misses per 1000 instructions and
+    // cycles per walk.
+    sample_estimate_t
+    walk_rate() const;
+    sample_estimate_t
+    tlb_mpki() const;
+    sample_estimate_t
+    walk_latency() const;
+
+    void
+    print_results(const std::string &prefix) const;
+
+    // The normal quantile z of a two-sided confidence level.
+    static double
+    confidence_z(double confidence);
+
+private:
+    struct window_t {
+        uint64_t refs;
+        uint64_t instrs;
+        uint64_t walks;
+        uint64_t walk_cycles;
+    };
+    typedef uint64_t window_t::*window_field_t;
+
+    // The ratio estimator of sum(numerator) / sum(denominator) over the
+    // windows, scaled by scale.
+    sample_estimate_t
+    estimate(window_field_t numerator, window_field_t denominator, double scale) const;
+    // The windows it would take to meet the error bound, from the variation of
+    // the windows so far.
+    uint64_t
+    windows_needed() const;
+
+    uint64_t period;
+    uint64_t window;
+    uint64_t warmup;
+    uint64_t skip;
+    uint64_t measure_start;
+    double error_bound;
+    double confidence;
+    double z;
+    uint64_t position;
+    bool window_ended;
+    bool done;
+    window_t current;
+    std::vector<window_t> windows;
+};
+
+#endif /* _SAMPLER_H_ */
@@ -64,8 +64,10 @@ simulator_t::init_knobs(unsigned int num_cores, uint64_t skip_refs, uint64_t war
     knob_sim_refs = sim_refs;
     knob_cpu_scheduling = cpu_scheduling;
     knob_verbose = verbose;
+    knob_core_from_cpu = false;
     last_thread = 0;
     last_core = 0;
+    last_cpu = -1;
     cpu_counts.resize(knob_num_cores, 0);
     thread_counts.resize(knob_num_cores, 0);
     thread_ever_counts.resize(knob_num_cores, 0);
@@ -149,6 +151,49 @@ simulator_t::core_for_thread(memref_tid_t tid)
     return min_core;
 }
 
+// Maps a CPU id straight onto a core, wrapping around when there are more
+// CPUs than cores.
+int
+simulator_t::core_for_cpu(int cpu)
+{
+    auto exists = cpu2core.find(cpu);
+    if (exists != cpu2core.end())
+        return exists->second;
+    int core = cpu % knob_num_cores;
+    cpu2core[cpu] = core;
+    ++cpu_counts[core];
+    ++thread_ever_counts[core];
+    if (knob_verbose >= 1) {
+        std::cerr << "new cpu " << cpu << " => core " << core
+                  << " (count=" << cpu_counts[core] << ")" << std::endl;
+    }
+    return core;
+}
+
+int
+simulator_t::core_for_memref(const memref_t &memref)
+{
+    if (knob_core_from_cpu) {
+        int cpu = type_is_instr(memref.instr.type) ||
+                memref.instr.type == TRACE_TYPE_INSTR_NO_FETCH
+            ? memref.instr.pgtable_results.cpu
+            : memref.data.pgtable_results.cpu;
+        if (cpu != last_cpu) {
+            last_cpu = cpu;
+            last_core = core_for_cpu(cpu);
+        }
+        return last_core;
+    }
+    // We use a static scheduling of threads to cores, as it is
+    // not practical to measure which core each thread actually
+    // ran on for each memref.
+    if (memref.data.tid != last_thread) {
+        last_core = core_for_thread(memref.data.tid);
+        last_thread = memref.data.tid;
+    }
+    return last_core;
+}
+
 void
 simulator_t::handle_thread_exit(memref_tid_t tid)
 {
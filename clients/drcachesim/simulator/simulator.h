@@ -69,6 +69,10 @@ protected:
     find_emptiest_core(std::vector<int> &counts) const;
     virtual int
     core_for_thread(memref_tid_t tid);
+    int
+    core_for_cpu(int cpu);
+    int
+    core_for_memref(const memref_t &memref);
     virtual void
     handle_thread_exit(memref_tid_t tid);
 
@@ -79,9 +83,14 @@ protected:
     uint64_t knob_sim_refs;
     bool knob_cpu_scheduling;
     unsigned int knob_verbose;
+    // Place each reference on the core of the CPU recorded in its page table
+    // results rather than on the core of its thread.  Used for QEMU traces,
+    // which carry the issuing CPU but no thread ids.
+    bool knob_core_from_cpu;
 
     memref_tid_t last_thread;
     int last_core;
+    int last_cpu;
 
     // For thread mapping to cores:
     std::unordered_map<int, int> cpu2core;
@@ -0,0 +1,139 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+#include "snoop_filter.h"
+#include "caching_device.h"
+#include <iomanip>
+#include <iostream>
+#include <locale>
+
+snoop_filter_t::snoop_filter_t()
+    : num_reads(0)
+    , num_writes(0)
+    , num_upgrades(0)
+    , num_invalidations(0)
+    , num_writebacks(0)
+    , num_dirty_evictions(0)
+{
+}
+
+bool
+snoop_filter_t::init(const std::vector<caching_device_t *> &caches_)
+{
+    // Sharers are kept in a 64-bit mask.
+    if (caches_.empty() || caches_.size() > 64)
+        return false;
+    caches = caches_;
+    return true;
+}
+
+void
+snoop_filter_t::snoop(addr_t tag, int id, bool is_write)
+{
+    uint64_t id_bit = 1ULL << id;
+    auto it = lines.find(tag);
+    if (it == lines.end()) {
+        // Invalid everywhere: the line becomes Exclusive, or Modified.
+        lines.emplace(tag, line_t { id_bit, is_write ? id : -1 });
+        if (is_write)
+            num_writes++;
+        else
+            num_reads++;
+        return;
+    }
+    line_t &line = it->second;
+    if (!is_write) {
+        num_reads++;
+        if (line.owner != -1 && line.owner != id) {
+            num_writebacks++;
+            line.owner = -1;
+        }
+        line.sharers |= id_bit;
+        return;
+    }
+    // Writes to a line already Modified here, the bulk of them, need nothing.
+    if (line.owner == id)
+        return;
+    num_writes++;
+    if (line.owner != -1)
+        num_writebacks++;
+    uint64_t others = line.sharers & ~id_bit;
+    if (others != 0) {
+        if ((line.sharers & id_bit) != 0)
+            num_upgrades++;
+        for (int i = 0; others != 0; i++, others >>= 1) {
+            if ((others & 1) != 0) {
+                caches[i]->invalidate(tag, INVALIDATION_COHERENCE);
+                num_invalidations++;
+            }
+        }
+    }
+    line.sharers = id_bit;
+    line.owner = id;
+}
+
+void
+snoop_filter_t::snoop_eviction(addr_t tag, int id)
+{
+    auto it = lines.find(tag);
+    if (it == lines.end())
+        return;
+    line_t &line = it->second;
+    if (line.owner == id) {
+        num_dirty_evictions++;
+        line.owner = -1;
+    }
+    line.sharers &= ~(1ULL << id);
+    if (line.sharers == 0)
+        lines.erase(it);
+}
+
+void
+snoop_filter_t::print_stats(std::string prefix)
+{
+    std::cerr.imbue(std::locale("")); // Add commas, at least for my locale
+    std::cerr << prefix << std::setw(18) << std::left << "Read requests:" << std::setw(20)
+              << std::right << num_reads << std::endl;
+    std::cerr << prefix << std::setw(18) << std::left << "Write requests:" << std::setw(20)
+              << std::right << num_writes << std::endl;
+    std::cerr << prefix << std::setw(18) << std::left << "Upgrades:" << std::setw(20)
+              << std::right << num_upgrades << std::endl;
+    std::cerr << prefix << std::setw(18) << std::left << "Invalidations:" << std::setw(20)
+              << std::right << num_invalidations << std::endl;
+    std::cerr << prefix << std::setw(18) << std::left << "Writebacks:" << std::setw(20)
+              << std::right << num_writebacks << std::endl;
+    std::cerr << prefix << std::setw(18) << std::left << "Dirty evictions:"
+              << std::setw(20) << std::right << num_dirty_evictions << std::endl;
+    std::cerr << prefix << std::setw(18) << std::left << "Lines tracked:" << std::setw(20)
+              << std::right << lines.size() << std::endl;
+    std::cerr.imbue(std::locale("C")); // Reset to avoid affecting later prints.
+}
@@ -0,0 +1,104 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* snoop_filter: a directory of the lines in the cores' private caches that
+ * keeps them coherent with a MESI protocol.
+ */
+
+#ifndef _SNOOP_FILTER_H_
+#define _SNOOP_FILTER_H_ 1
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "memref.h"
+
+class caching_device_t;
+
+// The directory sits beside the shared LLC and tracks, for every line held
+// by the coherent caches (each core's last private level), which of them
+// hold it and whether one holds it modified.  A line held by one core is
+// Exclusive or Modified, one held by several is Shared, and one absent from
+// the directory is Invalid everywhere.  A write by a core invalidates the
+// line in the other cores' private caches; a read of a line another core has
+// modified writes it back and leaves it Shared.  The directory is full-map:
+// it never runs out of entries, so it causes no invalidations of its own.
+//
+// The coherent caches call it on their misses, writes and evictions; the
+// caches below them only report write hits, since their misses reach the
+// coherent cache.  This requires each coherent cache to be inclusive of the
+// caches below it.
+class snoop_filter_t {
+public:
+    snoop_filter_t();
+
+    // The coherent caches, indexed by the id each passes in.
+    bool
+    init(const std::vector<caching_device_t *> &caches);
+
+    // A read miss (is_write false) or a write of the line tag by cache id.
+    void
+    snoop(addr_t tag, int id, bool is_write);
+    // Cache id evicted the line tag.
+    void
+    snoop_eviction(addr_t tag, int id);
+
+    void
+    print_stats(std::string prefix);
+
+protected:
+    struct line_t {
+        // One bit per coherent cache holding the line.
+        uint64_t sharers;
+        // The cache holding the line modified, or -1.
+        int owner;
+    };
+    std::unordered_map<addr_t, line_t> lines;
+    std::vector<caching_device_t *> caches;
+
+    // The read misses, and the writes that take ownership of a line, which
+    // reach the directory.  Writes to a line already Modified by the writer
+    // do not.
+    int_least64_t num_reads;
+    int_least64_t num_writes;
+    // Writes to a line the writer shares with others.
+    int_least64_t num_upgrades;
+    int_least64_t num_invalidations;
+    // Modified lines written back for another core's request, and on their
+    // eviction.
+    int_least64_t num_writebacks;
+    int_least64_t num_dirty_evictions;
+};
+
+#endif /* _SNOOP_FILTER_H_ */
@@ -0,0 +1,476 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+/* timing_model: a cycle-approximate timing model of the memory hierarchy,
+ * which estimates page walk latency under memory-level parallelism.
+ */
+
+#include "timing_model.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+
+timing_model_t::timing_model_t()
+    : tlb_cycles(1)
+    , pwc_cycles(1)
+    , hash_cycles(2)
+    , pud_cwc_cycles(4)
+    , pmd_cwc_cycles(4)
+    , dram_row_hit_cycles(100)
+    , dram_row_miss_cycles(146)
+    , dram_burst_cycles(4)
+    , dram_banks(16)
+    , dram_row_bytes(8192)
+    , line_size(64)
+    , ecpt(false)
+    , walks_to_l2(false)
+    , parallel_cwc(true)
+    , overlap_backfill(true)
+{
+    // Uncontended hits cost the -latency_model defaults: 4, 14 and 54 cycles,
+    // and 200 for a DRAM row miss.
+    level_cycles[LEVEL_L1] = 4;
+    level_cycles[LEVEL_L2] = 10;
+    level_cycles[LEVEL_LLC] = 40;
+    level_ports[LEVEL_L1] = 2;
+    level_ports[LEVEL_L2] = 1;
+    level_ports[LEVEL_LLC] = 4;
+    level_mshrs[LEVEL_L1] = 8;
+    level_mshrs[LEVEL_L2] = 16;
+    level_mshrs[LEVEL_LLC] = 64;
+    reset();
+}
+
+bool
+timing_model_t::init(const std::string &params, unsigned int num_cores,
+                     unsigned int line_size_, unsigned int issue_window,
+                     unsigned int page_walkers, bool ecpt_, bool walks_to_l2_,
+                     bool parallel_cwc_, bool overlap_backfill_, std::string &error)
+{
+    static const struct {
+        const char *name;
+        uint64_t timing_model_t::*param;
+        bool positive;
+    } names[] = {
+        { "TLB", &timing_model_t::tlb_cycles, false },
+        { "PWC", &timing_model_t::pwc_cycles, false },
+        { "HASH", &timing_model_t::hash_cycles, false },
+        { "PUD_CWC", &timing_model_t::pud_cwc_cycles, false },
+        { "PMD_CWC", &timing_model_t::pmd_cwc_cycles, false },
+        { "DRAM_ROW_HIT", &timing_model_t::dram_row_hit_cycles, false },
+        { "DRAM_ROW_MISS", &timing_model_t::dram_row_miss_cycles, false },
+        { "DRAM_BURST", &timing_model_t::dram_burst_cycles, false },
+        { "DRAM_BANKS", &timing_model_t::dram_banks, true },
+        { "DRAM_ROW_BYTES", &timing_model_t::dram_row_bytes, true },
+    };
+    static const char *const level_names[] = { "L1", "L2", "LLC" };
+    ecpt = ecpt_;
+    walks_to_l2 = walks_to_l2_;
+    parallel_cwc = parallel_cwc_;
+    overlap_backfill = overlap_backfill_;
+    line_size = line_size_;
+    if (issue_window == 0 || page_walkers == 0) {
+        error = "Usage error: -issue_window and -page_walkers must be positive.";
+        return false;
+    }
+
+    std::istringstream list(params);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        if (item.empty())
+            continue;
+        size_t eq = item.find('=');
+        char *end = NULL;
+        unsigned long long value = 0;
+        if (eq != std::string::npos)
+            value = strtoull(item.c_str() + eq + 1, &end, 10);
+        if (eq == std::string::npos || eq + 1 == item.size() || *end != '\0') {
+            error = "Usage error: invalid timing parameter '" + item +
+                "', expected NAME=value";
+            return false;
+        }
+        std::string name = item.substr(0, eq);
+        uint64_t *dest = NULL;
+        bool positive = false;
+        for (const auto &it : names) {
+            if (name == it.name) {
+                dest = &(this->*it.param);
+                positive = it.positive;
+            }
+        }
+        for (int i = LEVEL_L1; i < LEVEL_DRAM; i++) {
+            if (name == level_names[i])
+                dest = &level_cycles[i];
+            else if (name == std::string(level_names[i]) + "_PORTS")
+                dest = &level_ports[i];
+            else if (name == std::string(level_names[i]) + "_MSHRS")
+                dest = &level_mshrs[i];
+            else
+                continue;
+            positive = dest != &level_cycles[i];
+        }
+        if (dest == NULL) {
+            error = "Usage error: unknown timing parameter '" + name + "'";
+            return false;
+        }
+        if (positive && value == 0) {
+            error = "Usage error: timing parameter " + name + " must be positive";
+            return false;
+        }
+        *dest = value;
+    }
+
+    cores.resize(num_cores);
+    for (core_t &core : cores) {
+        init_level(core.l1i, LEVEL_L1);
+        init_level(core.l1d, LEVEL_L1);
+        init_level(core.l2, LEVEL_L2);
+        core.next_issue = 0;
+        core.window.assign(issue_window, 0);
+        core.window_pos = 0;
+        core.walkers.assign(page_walkers, 0);
+    }
+    init_level(llc, LEVEL_LLC);
+    banks.assign(dram_banks, bank_t { ~(addr_t)0, 0 });
+    reset();
+    return true;
+}
+
+void
+timing_model_t::init_level(level_t &level, level_index_t index)
+{
+    level.latency = level_cycles[index];
+    level.num_ports = level_ports[index];
+    level.port_slots.assign(PORT_HORIZON, port_slot_t { 0, 0 });
+    level.mshrs.assign(level_mshrs[index], mshr_t { 0, 0 });
+    reset_level(level);
+}
+
+void
+timing_model_t::reset_level(level_t &level)
+{
+    level.num_accesses = 0;
+    level.port_wait_cycles = 0;
+    level.num_mshr_merges = 0;
+    level.num_mshr_full = 0;
+    level.mshr_wait_cycles = 0;
+}
+
+uint64_t
+timing_model_t::take_port(level_t &level, uint64_t start)
+{
+    for (uint64_t cycle = start;; cycle++) {
+        // A slot last used PORT_HORIZON or more cycles away is reused.
+        port_slot_t &slot = level.port_slots[cycle % PORT_HORIZON];
+        if (slot.cycle != cycle)
+            slot = port_slot_t { cycle, 0 };
+        if (slot.used < level.num_ports) {
+            slot.used++;
+            return cycle;
+        }
+    }
+}
+
+// Looks addr up at levels[index] and below, down to the level that served it,
+// from cycle start.  Returns the cycle the data is back at levels[index].
+uint64_t
+timing_model_t::lookup(level_t *const *levels, level_index_t index, level_index_t served,
+                       addr_t addr, uint64_t start)
+{
+    level_t &level = *levels[index];
+    level.num_accesses++;
+    // Ports are pipelined: each takes a new access every cycle.
+    uint64_t cycle = take_port(level, start);
+    level.port_wait_cycles += cycle - start;
+    cycle += level.latency;
+    if (index == served)
+        return cycle;
+
+    addr_t block = addr / line_size;
+    mshr_t *mshr = &level.mshrs[0];
+    for (mshr_t &it : level.mshrs) {
+        if (it.ready > cycle && it.block == block) {
+            level.num_mshr_merges++;
+            return it.ready;
+        }
+        if (it.ready < mshr->ready)
+            mshr = &it;
+    }
+    if (mshr->ready > cycle) {
+        level.num_mshr_full++;
+        level.mshr_wait_cycles += mshr->ready - cycle;
+        cycle = mshr->ready;
+    }
+    mshr->block = block;
+    index = (level_index_t)(index + 1);
+    uint64_t fill = index == LEVEL_DRAM ? dram_access(addr, cycle)
+                                        : lookup(levels, index, served, addr, cycle);
+    mshr->ready = fill;
+    return fill;
+}
+
+uint64_t
+timing_model_t::dram_access(addr_t addr, uint64_t start)
+{
+    addr_t row = addr / dram_row_bytes;
+    bank_t &bank = banks[row % dram_banks];
+    row /= dram_banks;
+    uint64_t cycle = std::max(start, bank.ready);
+    dram_bank_wait_cycles += cycle - start;
+    num_dram_accesses++;
+    // A row miss first closes the open row and opens the new one, which keeps
+    // the bank busy for longer than a row hit's burst.
+    uint64_t latency = dram_row_hit_cycles;
+    uint64_t busy = dram_burst_cycles;
+    if (bank.open_row == row) {
+        num_dram_row_hits++;
+    } else {
+        latency = dram_row_miss_cycles;
+        if (dram_row_miss_cycles > dram_row_hit_cycles)
+            busy += dram_row_miss_cycles - dram_row_hit_cycles;
+        bank.open_row = row;
+    }
+    bank.ready = cycle + busy;
+    return cycle + latency;
+}
+
+// Times an access served by res that starts at the first level, the L1 or the
+// L2.  res counts levels from the L1.
+uint64_t
+timing_model_t::access(core_t &core, level_t &l1, level_index_t first, cache_result_t res,
+                       addr_t addr, uint64_t start)
+{
+    level_index_t served;
+    if (res == FOUND_L1)
+        served = LEVEL_L1;
+    else if (res == FOUND_L2)
+        served = LEVEL_L2;
+    else if (res == FOUND_LLC)
+        served = LEVEL_LLC;
+    else if (res == NOT_FOUND)
+        served = LEVEL_DRAM;
+    else
+        return start;
+    if (served < first)
+        served = first;
+    level_t *levels[] = { &l1, &core.l2, &llc };
+    return lookup(levels, first, served, addr, start);
+}
+
+uint64_t
+timing_model_t::walk_access(core_t &core, const walk_access_t &step, uint64_t start)
+{
+    return access(core, core.l1d, walks_to_l2 ? LEVEL_L2 : LEVEL_L1, step.res, step.addr,
+                  start);
+}
+
+// Times a page walk that starts at cycle start, once a walker is free.
+uint64_t
+timing_model_t::walk(core_t &core, const timing_ref_t &ref, uint64_t start)
+{
+    std::vector<uint64_t>::iterator walker =
+        std::min_element(core.walkers.begin(), core.walkers.end());
+    uint64_t cycle = std::max(start, *walker);
+    walker_wait_cycles += cycle - start;
+    if (!ecpt) {
+        cycle += pwc_cycles * ref.pwc_probes;
+        for (const walk_access_t &step : ref.walk)
+            cycle = walk_access(core, step, cycle);
+    } else {
+        cycle += hash_cycles;
+        if (parallel_cwc)
+            cycle += std::max(pud_cwc_cycles, pmd_cwc_cycles);
+        else
+            cycle += pud_cwc_cycles + pmd_cwc_cycles;
+        // The ways and the CWT back-fill all go out once the CWCs are looked up.
+        uint64_t all_ways = cycle;
+        uint64_t selected = cycle;
+        bool found_selected = false;
+        uint64_t backfill = cycle;
+        for (const walk_access_t &step : ref.walk) {
+            uint64_t done = walk_access(core, step, cycle);
+            if (step.kind == TIMING_CWT_BACKFILL) {
+                backfill = std::max(backfill, done);
+                continue;
+            }
+            all_ways = std::max(all_ways, done);
+            if ((int)step.step == ref.selected_way) {
+                selected = done;
+                found_selected = true;
+            }
+        }
+        cycle = found_selected ? selected : all_ways;
+        if (!overlap_backfill)
+            cycle = std::max(cycle, backfill);
+    }
+    *walker = cycle;
+    num_walks++;
+    walk_cycles_total += cycle - start;
+    walk_cycles_hist.add(cycle - start);
+    return cycle;
+}
+
+void
+timing_model_t::reference(int core_index, const timing_ref_t &ref)
+{
+    core_t &core = cores[core_index % cores.size()];
+    uint64_t &oldest = core.window[core.window_pos];
+    uint64_t cycle = core.next_issue;
+    if (oldest > cycle) {
+        window_wait_cycles += oldest - cycle;
+        cycle = oldest;
+    }
+    core.next_issue = cycle + 1;
+    if (first_issue > cycle)
+        first_issue = cycle;
+    if (!ref.fetch_buffer_hit) {
+        cycle += tlb_cycles;
+        if (ref.walked)
+            cycle = walk(core, ref, cycle);
+        if (ref.accessed) {
+            cycle = access(core, ref.is_inst ? core.l1i : core.l1d, LEVEL_L1, ref.res,
+                           ref.addr, cycle);
+        }
+    }
+    oldest = cycle;
+    core.window_pos = (core.window_pos + 1) % core.window.size();
+    last_done = std::max(last_done, cycle);
+    num_refs++;
+}
+
+// Clears the statistics.  The state of the hierarchy is kept.
+void
+timing_model_t::reset()
+{
+    for (core_t &core : cores) {
+        reset_level(core.l1i);
+        reset_level(core.l1d);
+        reset_level(core.l2);
+    }
+    reset_level(llc);
+    first_issue = UINT64_MAX;
+    last_done = 0;
+    num_refs = 0;
+    num_walks = 0;
+    walk_cycles_total = 0;
+    walker_wait_cycles = 0;
+    window_wait_cycles = 0;
+    num_dram_accesses = 0;
+    num_dram_row_hits = 0;
+    dram_bank_wait_cycles = 0;
+    walk_cycles_hist.clear();
+}
+
+void
+timing_model_t::print_level(const char *name, const level_t &level) const
+{
+    std::cerr << name << " accesses : " << level.num_accesses << std::endl;
+    std::cerr << name << " port wait cycles : " << level.port_wait_cycles << std::endl;
+    std::cerr << name << " MSHR merges : " << level.num_mshr_merges << std::endl;
+    std::cerr << name << " MSHR full stalls : " << level.num_mshr_full << std::endl;
+    std::cerr << name << " MSHR wait cycles : " << level.mshr_wait_cycles << std::endl;
+}
+
+void
+timing_model_t::print_results() const
+{
+    std::cerr << "~~~~~~ timing model ~~~~~~" << std::endl;
+    std::cerr << "memory references : " << num_refs << std::endl;
+    std::cerr << "page walks : " << num_walks << std::endl;
+    if (num_refs == 0)
+        return;
+    uint64_t cycles = get_cycles();
+    std::ios_base::fmtflags flags = std::cerr.flags();
+    std::streamsize precision = std::cerr.precision();
+    std::cerr << std::fixed << std::setprecision(3);
+    std::cerr << "cycles : " << cycles << std::endl;
+    std::cerr << "cycles per reference : " << (double)cycles / num_refs << std::endl;
+    std::cerr << "issue window wait cycles : " << window_wait_cycles << std::endl;
+    if (num_walks > 0) {
+        std::vector<std::pair<uint64_t, uint64_t>> hist = walk_cycles_hist.entries();
+        std::sort(hist.begin(), hist.end());
+        std::cerr << "avg page walk cycles : " << (double)walk_cycles_total / num_walks
+                  << std::endl;
+        // Nearest-rank percentiles.
+        static const struct {
+            const char *name;
+            uint64_t permille;
+        } percentiles[] = { { "p50", 500 }, { "p90", 900 }, { "p99", 990 },
+                            { "p99.9", 999 } };
+        size_t pos = 0;
+        uint64_t seen = hist[0].second;
+        for (const auto &pct : percentiles) {
+            uint64_t rank = (num_walks * pct.permille + 999) / 1000;
+            while (seen < rank) {
+                pos++;
+                seen += hist[pos].second;
+            }
+            std::cerr << pct.name << " page walk cycles : " << hist[pos].first
+                      << std::endl;
+        }
+        std::cerr << "max page walk cycles : " << hist.back().first << std::endl;
+        std::cerr << "avg page walker wait cycles : "
+                  << (double)walker_wait_cycles / num_walks << std::endl;
+        if (cycles > 0) {
+            std::cerr << "avg page walks in flight : "
+                      << (double)walk_cycles_total / cycles << std::endl;
+        }
+    }
+    std::cerr.flags(flags);
+    std::cerr.precision(precision);
+
+    level_t l1i, l1d, l2;
+    reset_level(l1i);
+    reset_level(l1d);
+    reset_level(l2);
+    for (const core_t &core : cores) {
+        for (const auto &it : { std::make_pair(&l1i, &core.l1i),
+                                std::make_pair(&l1d, &core.l1d),
+                                std::make_pair(&l2, &core.l2) }) {
+            it.first->num_accesses += it.second->num_accesses;
+            it.first->port_wait_cycles += it.second->port_wait_cycles;
+            it.first->num_mshr_merges += it.second->num_mshr_merges;
+            it.first->num_mshr_full += it.second->num_mshr_full;
+            it.first->mshr_wait_cycles += it.second->mshr_wait_cycles;
+        }
+    }
+    print_level("L1I", l1i);
+    print_level("L1D", l1d);
+    print_level("L2", l2);
+    print_level("LLC", llc);
+    std::cerr << "DRAM accesses : " << num_dram_accesses << std::endl;
+    std::cerr << "DRAM row buffer hits : " << num_dram_row_hits << std::endl;
+    std::cerr << "DRAM bank wait cycles : " << dram_bank_wait_cycles << std::endl;
+}
@@ -0,0 +1,250 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+/* timing_model: a cycle-approximate timing model of the memory hierarchy,
+ * which estimates page walk latency under memory-level parallelism.
+ */
+
+#ifndef _TIMING_MODEL_H_
+#define _TIMING_MODEL_H_ 1
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "flat_histogram.h"
+#include "memref.h"
+
+// The functional simulation decides which level serves each page walk step and
+// data access; this model then timestamps them in trace order.  Each core
+// issues one reference per cycle, with at most -issue_window of them in
+// flight (1 is in-order: a reference waits for the previous one), and a TLB
+// miss waits for one of the core's -page_walkers walkers.  An access goes down
+// the levels it missed in: each level takes a port for a cycle, charges its
+// latency and, on a miss, holds an MSHR until the fill returns.  A miss to a
+// block already in flight merges into its MSHR, and a miss finding all MSHRs
+// busy waits for the first one to free up.  The L1s and L2 are per core and
+// the LLC and DRAM are shared.  DRAM has banks with one open row each.
+//
+// Resources only remember when they next become free, so a core whose clock
+// lags behind another's may wait for a reservation that is in its future.
+// Ports are the exception: they are booked per cycle.
+// Prefetches and contention requests are not timed.
+class timing_model_t {
+public:
+    enum walk_access_kind_t {
+        // A radix walk step: each waits for the previous one.
+        TIMING_WALK_STEP,
+        // An ECPT way: all are probed at once.
+        TIMING_ECPT_PROBE,
+        // A CWT entry refetched after a CWC miss, fetched alongside the probes.
+        TIMING_CWT_BACKFILL,
+    };
+    struct walk_access_t {
+        addr_t addr;
+        cache_result_t res;
+        walk_access_kind_t kind;
+        // The index of the step or ECPT way in the walk.
+        unsigned int step;
+    };
+    // What the functional simulation found for one reference.
+    struct timing_ref_t {
+        bool fetch_buffer_hit;
+        bool is_inst;
+        bool walked;
+        // PWCs probed up to the hit; a walk missing them all pays nothing.
+        unsigned int pwc_probes;
+        // The ECPT way the walk returns with, or -1 to wait for all of them.
+        int selected_way;
+        std::vector<walk_access_t> walk;
+        // Whether the reference accessed the caches at addr.
+        bool accessed;
+        addr_t addr;
+        cache_result_t res;
+    };
+
+    timing_model_t();
+
+    // Overrides the default parameters from a "NAME=value,..." list (see
+    // -timing_params).
+    bool
+    init(const std::string &params, unsigned int num_cores, unsigned int line_size,
+         unsigned int issue_window, unsigned int page_walkers, bool ecpt,
+         bool walks_to_l2, bool parallel_cwc, bool overlap_backfill, std::string &error);
+
+    // Times the next reference of core.
+    void
+    reference(int core, const timing_ref_t &ref);
+
+    void
+    reset();
+
+    void
+    print_results() const;
+
+    // The cycles from the first reference's issue to the last completion.
+    uint64_t
+    get_cycles() const
+    {
+        return num_refs == 0 ? 0 : last_done - first_issue;
+    }
+
+private:
+    enum level_index_t {
+        LEVEL_L1,
+        LEVEL_L2,
+        LEVEL_LLC,
+        LEVEL_DRAM,
+    };
+
+    struct mshr_t {
+        addr_t block;
+        uint64_t ready;
+    };
+
+    // The ports taken in one cycle.
+    struct port_slot_t {
+        uint64_t cycle;
+        uint64_t used;
+    };
+
+    struct level_t {
+        uint64_t latency;
+        uint64_t num_ports;
+        // The port use of the next PORT_HORIZON cycles, indexed by cycle.  An
+        // access may start before one issued earlier in trace order, e.g.,
+        // when it waited for no walk, so ports are booked per cycle.
+        std::vector<port_slot_t> port_slots;
+        // The outstanding fill of each MSHR.
+        std::vector<mshr_t> mshrs;
+
+        uint64_t num_accesses;
+        uint64_t port_wait_cycles;
+        uint64_t num_mshr_merges;
+        uint64_t num_mshr_full;
+        uint64_t mshr_wait_cycles;
+    };
+
+    struct bank_t {
+        addr_t open_row;
+        uint64_t ready;
+    };
+
+    struct core_t {
+        level_t l1i;
+        level_t l1d;
+        level_t l2;
+        uint64_t next_issue;
+        // The completion of the last issue_window references, oldest first.
+        std::vector<uint64_t> window;
+        unsigned int window_pos;
+        std::vector<uint64_t> walkers;
+    };
+
+    struct cycles_hash_t {
+        size_t
+        operator()(uint64_t cycles) const
+        {
+            return flat_histogram_mix(cycles);
+        }
+    };
+
+    static const uint64_t PORT_HORIZON = 4096;
+
+    void
+    init_level(level_t &level, level_index_t index);
+
+    // Books a port of level at or after cycle start and returns its cycle.
+    static uint64_t
+    take_port(level_t &level, uint64_t start);
+
+    static void
+    reset_level(level_t &level);
+
+    uint64_t
+    access(core_t &core, level_t &first, level_index_t first_index, cache_result_t res,
+           addr_t addr, uint64_t start);
+
+    uint64_t
+    lookup(level_t *const *levels, level_index_t index, level_index_t served,
+           addr_t addr, uint64_t start);
+
+    uint64_t
+    dram_access(addr_t addr, uint64_t start);
+
+    uint64_t
+    walk(core_t &core, const timing_ref_t &ref, uint64_t start);
+
+    uint64_t
+    walk_access(core_t &core, const walk_access_t &step, uint64_t start);
+
+    void
+    print_level(const char *name, const level_t &level) const;
+
+    // Parameters.
+    uint64_t tlb_cycles;
+    uint64_t pwc_cycles;
+    uint64_t hash_cycles;
+    uint64_t pud_cwc_cycles;
+    uint64_t pmd_cwc_cycles;
+    uint64_t level_cycles[LEVEL_DRAM];
+    uint64_t level_ports[LEVEL_DRAM];
+    uint64_t level_mshrs[LEVEL_DRAM];
+    uint64_t dram_row_hit_cycles;
+    uint64_t dram_row_miss_cycles;
+    uint64_t dram_burst_cycles;
+    uint64_t dram_banks;
+    uint64_t dram_row_bytes;
+    unsigned int line_size;
+    bool ecpt;
+    bool walks_to_l2;
+    bool parallel_cwc;
+    bool overlap_backfill;
+
+    std::vector<core_t> cores;
+    level_t llc;
+    std::vector<bank_t> banks;
+
+    uint64_t first_issue;
+    uint64_t last_done;
+    uint64_t num_refs;
+    uint64_t num_walks;
+    uint64_t walk_cycles_total;
+    uint64_t walker_wait_cycles;
+    uint64_t window_wait_cycles;
+    uint64_t num_dram_accesses;
+    uint64_t num_dram_row_hits;
+    uint64_t dram_bank_wait_cycles;
+    flat_histogram_t<uint64_t, cycles_hash_t> walk_cycles_hist;
+};
+
+#endif /* _TIMING_MODEL_H_ */
@@ -40,99 +40,62 @@ void
 tlb_t::init_blocks()
 {
     std::cerr << "Initialising a TLB with size: " << num_blocks << std::endl;
-    for (int i = 0; i < num_blocks; i++) {
-        blocks[i] = new tlb_entry_t;
-    }
+    pids.assign(num_blocks, 0);
 }
 
-cache_result_t
-tlb_t::request(const memref_t &memref_in)
+void
+tlb_t::add_page_size(int page_bits, caching_device_stats_t *stats, tlb_t *size_parent)
 {
-    // XXX: any better way to derive caching_device_t::request?
-    // Since pid is needed in a lot of places from the beginning to the end,
-    // it might also not be a good way to write a lot of helper functions
-    // to isolate them.
-
-    // Unfortunately we need to make a copy for our loop so we can pass
-    // the right data struct to the parent and stats collectors.
-    memref_t memref;
-    // We support larger sizes to improve the IPC perf.
-    // This means that one memref could touch multiple blocks.
-    // We treat each block separately for statistics purposes.
-    addr_t final_addr = memref_in.data.addr + memref_in.data.size - 1 /*avoid overflow*/;
-    addr_t final_tag = compute_tag(final_addr);
-    addr_t tag = compute_tag(memref_in.data.addr);
-    memref_pid_t pid = memref_in.data.pid;
+    page_size_t page_size = { page_bits, stats, size_parent };
+    page_sizes.push_back(page_size);
+}
 
-    // Optimization: check last tag and pid if single-block
-    if (tag == final_tag && tag == last_tag && pid == last_pid) {
-        // Make sure last_tag and pid are properly in sync.
-        assert(
-            tag != TAG_INVALID &&
-            tag == get_caching_device_block(last_block_idx, last_way).tag &&
-            pid ==
-                ((tlb_entry_t &)get_caching_device_block(last_block_idx, last_way)).pid);
-        stats->access(memref_in, true /*hit*/);
-        if (parent != NULL)
-            parent->get_stats()->child_access(memref_in, true);
-        access_update(last_block_idx, last_way);
-        //std::cerr << "TLB hit short" << std::endl; 
-        return FOUND_L1; //found
+int
+tlb_t::invalidate_pages(addr_t start, addr_t end)
+{
+    int count = invalidate_range(compute_page_tag(start, block_size_bits),
+                                 compute_page_tag(end, block_size_bits),
+                                 INVALIDATION_COHERENCE);
+    for (const page_size_t &page_size : page_sizes) {
+        if (page_size.page_bits == block_size_bits)
+            continue;
+        count += invalidate_range(compute_page_tag(start, page_size.page_bits),
+                                  compute_page_tag(end, page_size.page_bits),
+                                  INVALIDATION_COHERENCE);
     }
+    return count;
+}
 
-    cache_result_t prepare_to_return = NOT_FOUND;
-    memref = memref_in;
-    for (; tag <= final_tag; ++tag) {
-        int way;
-        int block_idx = compute_block_idx(tag);
-
-        if (tag + 1 <= final_tag)
-            memref.data.size = ((tag + 1) << block_size_bits) - memref.data.addr;
-
-        for (way = 0; way < associativity; ++way) {
-            if (get_caching_device_block(block_idx, way).tag == tag &&
-                ((tlb_entry_t &)get_caching_device_block(block_idx, way)).pid == pid) {
-                stats->access(memref, true /*hit*/);
-                if (parent != NULL)
-                    parent->get_stats()->child_access(memref, true);
-                //std::cerr << "TLB hit by search" << std::endl; 
-                prepare_to_return = FOUND_L1; //found
-                break;
-            }
-        }
-
-        if (way == associativity) {
-            stats->access(memref, false /*miss*/);
-            // If no parent we assume we get the data from main memory
-            cache_result_t result = NOT_FOUND;
-            if (parent != NULL) {
-                parent->get_stats()->child_access(memref, false /*miss*/);
-                result = parent->request(memref);
-                prepare_to_return = result;
-            }
-            // XXX: do we need to handle TLB coherency?
-
-            way = replace_which_way(block_idx);
-            get_caching_device_block(block_idx, way).tag = tag;
-            ((tlb_entry_t &)get_caching_device_block(block_idx, way)).pid = pid;
-        }
+void
+tlb_t::save_state(checkpoint_writer_t &out, const std::string &name) const
+{
+    caching_device_t::save_state(out, name);
+    out.write_vector(pids);
+}
 
-        access_update(block_idx, way);
+bool
+tlb_t::restore_state(checkpoint_reader_t &in, const std::string &name,
+                     std::string &error)
+{
+    if (!caching_device_t::restore_state(in, name, error))
+        return false;
+    if (!in.read_vector(pids, num_blocks)) {
+        error = "Failed to read the checkpoint's " + name + ".";
+        return false;
+    }
+    last_pid = 0;
+    return true;
+}
 
-        if (tag + 1 <= final_tag) {
-            addr_t next_addr = (tag + 1) << block_size_bits;
-            memref.data.addr = next_addr;
-            memref.data.size = final_addr - next_addr + 1 /*undo the -1*/;
-        }
-        // Optimization: remember last tag and pid
-        last_tag = tag;
-        last_way = way;
-        last_block_idx = block_idx;
-        last_pid = pid;
+cache_result_t
+tlb_t::request(const memref_t &memref_in)
+{
+    return request(memref_in, block_size_bits);
+}
 
-        //std::cerr << "TLB return result after search " << prepare_to_return << std::endl; 
-        return prepare_to_return;
-    }
-    //std::cerr << "TLB return result after search " << prepare_to_return << std::endl; 
-    return prepare_to_return;
+cache_result_t
+tlb_t::request(const memref_t &memref_in, int page_bits)
+{
+    lfu_policy_t policy;
+    return request_with_policy(memref_in, page_bits, policy);
 }
@@ -37,22 +37,212 @@
 #define _TLB_H_ 1
 
 #include "caching_device.h"
-#include "tlb_entry.h"
 #include "tlb_stats.h"
 
-#include "caching_device.h"
-
 class tlb_t : public caching_device_t {
 public:
     virtual cache_result_t
     request(const memref_t &memref);
+    // Looks up the translation of a page of 1 << page_bits bytes, which may be
+    // larger than the TLB's own page size.  Such entries carry their page size
+    // in the tag, so one TLB can hold several page sizes.
+    virtual cache_result_t
+    request(const memref_t &memref, int page_bits);
+
+    // Gives the pages of 1 << page_bits bytes their own statistics, counted
+    // besides the TLB's, and their own parent TLB.  The caller owns stats.
+    void
+    add_page_size(int page_bits, caching_device_stats_t *stats, tlb_t *size_parent);
+
+    // Invalidates the entries of every page size overlapping the virtual
+    // addresses [start, end], of any process, as a TLB shootdown.  Returns how
+    // many there were.
+    int
+    invalidate_pages(addr_t start, addr_t end);
+
+    // caching_device_t's state with the pid of each entry.
+    virtual void
+    save_state(checkpoint_writer_t &out, const std::string &name) const;
+    virtual bool
+    restore_state(checkpoint_reader_t &in, const std::string &name, std::string &error);
 
 protected:
+    // The lookup, fill and replacement of caching_device_t::request_with_policy()
+    // with entries matched on their pid too.
+    template <typename policy_t>
+    cache_result_t
+    request_with_policy(const memref_t &memref, int page_bits, policy_t &policy);
+
+    // The page size of a tag for a page larger than the TLB's page size sits
+    // above the largest VPN.
+    static const int TAG_PAGE_BITS_SHIFT = 58;
+
+    inline addr_t
+    compute_page_tag(addr_t addr, int page_bits)
+    {
+        addr_t tag = addr >> page_bits;
+        if (page_bits != block_size_bits)
+            tag |= (addr_t)page_bits << TAG_PAGE_BITS_SHIFT;
+        return tag;
+    }
+    inline addr_t
+    page_tag_to_addr(addr_t tag, int page_bits)
+    {
+        return (tag & (((addr_t)1 << TAG_PAGE_BITS_SHIFT) - 1)) << page_bits;
+    }
+
     virtual void
     init_blocks();
 
+    // The process ID of each entry, alongside caching_device_t::tags, to
+    // differentiate virtual pages that have the same VPN but belong to
+    // different processes.
+    // XXX: support page privilege and MMU-related exceptions
+    std::vector<memref_pid_t> pids;
+
     // Optimization: remember last pid in addition to last tag
     memref_pid_t last_pid;
+
+    struct page_size_t {
+        int page_bits;
+        caching_device_stats_t *stats;
+        tlb_t *parent;
+    };
+    std::vector<page_size_t> page_sizes;
 };
 
+// A TLB with a replacement policy other than the default LFU.
+template <typename policy_t> class policy_tlb_t : public tlb_t {
+public:
+    using tlb_t::request;
+    virtual cache_result_t
+    request(const memref_t &memref, int page_bits)
+    {
+        return request_with_policy(memref, page_bits, policy);
+    }
+
+protected:
+    virtual void
+    init_blocks()
+    {
+        tlb_t::init_blocks();
+        policy.init(blocks_per_set, associativity, counters.data());
+    }
+
+    policy_t policy;
+};
+
+template <typename policy_t>
+cache_result_t
+tlb_t::request_with_policy(const memref_t &memref_in, int page_bits, policy_t &policy)
+{
+    // XXX: any better way to derive caching_device_t::request?
+    // Since pid is needed in a lot of places from the beginning to the end,
+    // it might also not be a good way to write a lot of helper functions
+    // to isolate them.
+
+    // Unfortunately we need to make a copy for our loop so we can pass
+    // the right data struct to the parent and stats collectors.
+    memref_t memref;
+    // We support larger sizes to improve the IPC perf.
+    // This means that one memref could touch multiple blocks.
+    // We treat each block separately for statistics purposes.
+    addr_t final_addr = memref_in.data.addr + memref_in.data.size - 1 /*avoid overflow*/;
+    addr_t final_tag = compute_page_tag(final_addr, page_bits);
+    addr_t tag = compute_page_tag(memref_in.data.addr, page_bits);
+    memref_pid_t pid = memref_in.data.pid;
+    caching_device_stats_t *size_stats = NULL;
+    caching_device_t *size_parent = parent;
+    num_requests++;
+    // Entries of other processes are other tags: the pid goes above the VPN.
+    if (curve != nullptr)
+        curve->access(tag ^ ((addr_t)pid << 36));
+    for (const page_size_t &page_size : page_sizes) {
+        if (page_size.page_bits == page_bits) {
+            size_stats = page_size.stats;
+            size_parent = page_size.parent;
+        }
+    }
+
+    // Optimization: check last tag and pid if single-block
+    if (tag == final_tag && tag == last_tag && pid == last_pid) {
+        // Make sure last_tag and pid are properly in sync.
+        assert(tag != TAG_INVALID && tag == tags[last_block_idx + last_way] &&
+               pid == pids[last_block_idx + last_way]);
+        stats->access(memref_in, true /*hit*/);
+        if (size_stats != NULL)
+            size_stats->access(memref_in, true /*hit*/);
+        if (size_parent != NULL)
+            size_parent->get_stats()->child_access(memref_in, true);
+        record_hit(last_block_idx + last_way, memref_in);
+        policy.access_update(last_block_idx / associativity, &tags[last_block_idx],
+                             &counters[last_block_idx], associativity, last_way,
+                             memref_in);
+        //std::cerr << "TLB hit short" << std::endl; 
+        return FOUND_L1; //found
+    }
+
+    cache_result_t prepare_to_return = NOT_FOUND;
+    memref = memref_in;
+    for (; tag <= final_tag; ++tag) {
+        int way;
+        int block_idx = compute_block_idx(tag);
+        int set = block_idx / associativity;
+
+        if (tag + 1 <= final_tag)
+            memref.data.size = page_tag_to_addr(tag + 1, page_bits) - memref.data.addr;
+
+        way = find_way_pid(&tags[block_idx], &pids[block_idx], associativity, tag, pid);
+        if (way < associativity) {
+            stats->access(memref, true /*hit*/);
+            if (size_stats != NULL)
+                size_stats->access(memref, true /*hit*/);
+            if (size_parent != NULL)
+                size_parent->get_stats()->child_access(memref, true);
+            //std::cerr << "TLB hit by search" << std::endl; 
+            prepare_to_return = FOUND_L1; //found
+            record_hit(block_idx + way, memref);
+            policy.access_update(set, &tags[block_idx], &counters[block_idx],
+                                 associativity, way, memref);
+        } else {
+            stats->access(memref, false /*miss*/);
+            if (size_stats != NULL)
+                size_stats->access(memref, false /*miss*/);
+            record_miss(tag, memref);
+            // If no parent we assume we get the data from main memory
+            cache_result_t result = NOT_FOUND;
+            if (size_parent != NULL) {
+                size_parent->get_stats()->child_access(memref, false /*miss*/);
+                result = static_cast<tlb_t *>(size_parent)->request(memref, page_bits);
+                prepare_to_return = result;
+            }
+            // TLB coherence is kept by shootdowns: see invalidate_pages().
+
+            way = policy.replace_which_way(set, &tags[block_idx], &counters[block_idx],
+                                           associativity, 0, associativity, memref);
+            tags[block_idx + way] = tag;
+            pids[block_idx + way] = pid;
+            record_fill(block_idx + way, memref);
+            policy.insert_update(set, &tags[block_idx], &counters[block_idx],
+                                 associativity, way, memref);
+        }
+
+        if (tag + 1 <= final_tag) {
+            addr_t next_addr = page_tag_to_addr(tag + 1, page_bits);
+            memref.data.addr = next_addr;
+            memref.data.size = final_addr - next_addr + 1 /*undo the -1*/;
+        }
+        // Optimization: remember last tag and pid
+        last_tag = tag;
+        last_way = way;
+        last_block_idx = block_idx;
+        last_pid = pid;
+
+        //std::cerr << "TLB return result after search " << prepare_to_return << std::endl; 
+        return prepare_to_return;
+    }
+    //std::cerr << "TLB return result after search " << prepare_to_return << std::endl; 
+    return prepare_to_return;
+}
+
 #endif /* _TLB_H_ */
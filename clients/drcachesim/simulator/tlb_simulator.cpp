@@ -40,6 +40,10 @@
 #include "../common/options.h"
 #include "../common/utils.h"
 #include "droption.h"
+#include "cache_hawkeye.h"
+#include "cache_fifo.h"
+#include "cache_lru.h"
+#include "cache_rrip.h"
 #include "tlb_stats.h"
 #include "tlb.h"
 #include "tlb_simulator.h"
@@ -58,6 +62,7 @@ tlb_simulator_t::tlb_simulator_t(const tlb_simulator_knobs_t &knobs_)
                   knobs_.verbose)
     , knobs(knobs_)
 {
+    knob_core_from_cpu = knobs.core_from_access_cpu;
     itlbs = new tlb_t *[knobs.num_cores];
     dtlbs = new tlb_t *[knobs.num_cores];
     lltlbs = new tlb_t *[knobs.num_cores];
@@ -67,19 +72,19 @@ tlb_simulator_t::tlb_simulator_t(const tlb_simulator_knobs_t &knobs_)
         lltlbs[i] = NULL;
     }
     for (unsigned int i = 0; i < knobs.num_cores; i++) {
-        itlbs[i] = create_tlb(knobs.TLB_replace_policy);
+        itlbs[i] = create_tlb(level_replace_policy(TLB_L1I));
         if (itlbs[i] == NULL) {
             error_string = "Failed to create itlbs";
             success = false;
             return;
         }
-        dtlbs[i] = create_tlb(knobs.TLB_replace_policy);
+        dtlbs[i] = create_tlb(level_replace_policy(TLB_L1D));
         if (dtlbs[i] == NULL) {
             error_string = "Failed to create dtlbs";
             success = false;
             return;
         }
-        lltlbs[i] = create_tlb(knobs.TLB_replace_policy);
+        lltlbs[i] = create_tlb(level_replace_policy(TLB_L2));
         if (lltlbs[i] == NULL) {
             error_string = "Failed to create lltlbs";
             success = false;
@@ -98,10 +103,121 @@ tlb_simulator_t::tlb_simulator_t(const tlb_simulator_knobs_t &knobs_)
             return;
         }
     }
+    if (knobs.TLB_page_sizes && !init_page_sizes()) {
+        success = false;
+        return;
+    }
+    if (knobs.miss_ratio_curves && !init_curves()) {
+        success = false;
+        return;
+    }
+}
+
+bool
+tlb_simulator_t::init_curves()
+{
+    const unsigned int assoc[TLB_LEVELS] = { knobs.TLB_L1I_assoc, knobs.TLB_L1D_assoc,
+                                             knobs.TLB_L2_assoc };
+    for (int level = 0; level < TLB_LEVELS; level++) {
+        std::vector<unsigned int> assocs;
+        if (!miss_ratio_curve_t::parse_assocs(knobs.mrc_assocs, assoc[level],
+                                              knobs.mrc_max_entries, assocs,
+                                              error_string))
+            return false;
+        for (unsigned int i = 0; i < knobs.num_cores; i++) {
+            miss_ratio_curve_t *curve = new miss_ratio_curve_t;
+            curves[level].push_back(curve);
+            if (!curve->init(knobs.mrc_max_entries, assocs, knobs.mrc_sample_sets,
+                             error_string))
+                return false;
+            level_tlb(level, i)->set_miss_ratio_curve(curve);
+        }
+    }
+    return true;
+}
+
+static const int tlb_page_bits[TLB_PAGE_SIZES] = { 12, 21, 30 };
+static const char *const tlb_page_size_names[TLB_PAGE_SIZES] = { "4K", "2M", "1G" };
+
+bool
+tlb_simulator_t::init_page_sizes()
+{
+    if (knobs.page_size >= (1ULL << tlb_page_bits[TLB_PAGE_2MB])) {
+        error_string = "Usage error: -TLB_page_sizes needs a -page_size below 2MB.";
+        return false;
+    }
+    const unsigned int entries[TLB_LEVELS][TLB_PAGE_SIZES] = {
+        { knobs.TLB_L1I_entries, knobs.TLB_L1I_2M_entries, knobs.TLB_L1I_1G_entries },
+        { knobs.TLB_L1D_entries, knobs.TLB_L1D_2M_entries, knobs.TLB_L1D_1G_entries },
+        { knobs.TLB_L2_entries, knobs.TLB_L2_2M_entries, knobs.TLB_L2_1G_entries },
+    };
+    const unsigned int assoc[TLB_LEVELS][TLB_PAGE_SIZES] = {
+        { knobs.TLB_L1I_assoc, knobs.TLB_L1I_2M_assoc, knobs.TLB_L1I_1G_assoc },
+        { knobs.TLB_L1D_assoc, knobs.TLB_L1D_2M_assoc, knobs.TLB_L1D_1G_assoc },
+        { knobs.TLB_L2_assoc, knobs.TLB_L2_2M_assoc, knobs.TLB_L2_1G_assoc },
+    };
+    int base_bits = compute_log2((int)knobs.page_size);
+    for (unsigned int i = 0; i < knobs.num_cores; i++) {
+        // The L2 TLBs come first as they are the parents of the L1 arrays.
+        for (int level : { TLB_L2, TLB_L1I, TLB_L1D }) {
+            tlb_t *base = level_tlb(level, i);
+            bool shared = false;
+            for (int size = TLB_PAGE_2MB; size < TLB_PAGE_SIZES; size++) {
+                tlb_t *parent = level == TLB_L2 ? NULL : size_tlbs[TLB_L2][size][i];
+                if (entries[level][size] == 0) {
+                    tlb_stats_t *stats = new tlb_stats_t;
+                    base->add_page_size(tlb_page_bits[size], stats, parent);
+                    size_tlbs[level][size].push_back(base);
+                    size_stats[level][size].push_back(stats);
+                    shared = true;
+                    continue;
+                }
+                tlb_t *tlb = create_tlb(level_replace_policy(level));
+                size_tlbs[level][size].push_back(tlb);
+                size_stats[level][size].push_back(NULL);
+                if (tlb == NULL ||
+                    !tlb->init(assoc[level][size], 1 << tlb_page_bits[size],
+                               entries[level][size], parent, new tlb_stats_t)) {
+                    error_string = "Usage error: failed to initialize the TLB arrays for "
+                                   "2MB and 1GB pages. Ensure entry number and "
+                                   "associativity are powers of 2.";
+                    return false;
+                }
+                size_stats[level][size].back() = tlb->get_stats();
+            }
+            caching_device_stats_t *base_stats = base->get_stats();
+            if (shared) {
+                base_stats = new tlb_stats_t;
+                base->add_page_size(base_bits, base_stats,
+                                    level == TLB_L2 ? NULL : lltlbs[i]);
+            }
+            size_tlbs[level][TLB_PAGE_4KB].push_back(base);
+            size_stats[level][TLB_PAGE_4KB].push_back(base_stats);
+        }
+    }
+    return true;
 }
 
 tlb_simulator_t::~tlb_simulator_t()
 {
+    for (int level = 0; level < TLB_LEVELS; level++) {
+        for (miss_ratio_curve_t *curve : curves[level])
+            delete curve;
+    }
+    for (int level = 0; level < TLB_LEVELS; level++) {
+        for (int size = 0; size < TLB_PAGE_SIZES; size++) {
+            for (size_t i = 0; i < size_tlbs[level][size].size(); i++) {
+                tlb_t *tlb = size_tlbs[level][size][i];
+                if (tlb == level_tlb(level, (unsigned int)i)) {
+                    if (size_stats[level][size][i] != tlb->get_stats())
+                        delete size_stats[level][size][i];
+                } else if (tlb != NULL) {
+                    delete tlb->get_stats();
+                    delete tlb;
+                }
+            }
+        }
+    }
     for (unsigned int i = 0; i < knobs.num_cores; i++) {
         // Try to handle failure during construction.
         if (itlbs[i] == NULL)
@@ -134,61 +250,58 @@ tlb_simulator_t::process_memref(const memref_t &memref) {
 std::pair<bool, bool>
 tlb_simulator_t::process_memref_tlb(const memref_t &memref)
 {
+    int core;
+    bool warmup_done;
+    if (!schedule_memref_tlb(memref, &core, &warmup_done))
+        return std::pair<bool, bool>(false, true);
+    if (core < 0)
+        return std::pair<bool, bool>(true, true);
+    bool found = lookup_tlb(memref, core);
+    if (warmup_done)
+        reset_stats();
+    return std::pair<bool, bool>(true, found);
+}
+
+bool
+tlb_simulator_t::schedule_memref_tlb(const memref_t &memref, int *core, bool *warmup_done)
+{
+    *core = -1;
+    *warmup_done = false;
     if (knobs.skip_refs > 0) {
         knobs.skip_refs--;
-        std::cerr << "Warning: skip_refs " << memref.data.addr << "...";
-        return std::pair<bool, bool>(true, true);
+        if (knobs.verbose >= 3)
+            std::cerr << "Warning: skip_refs " << memref.data.addr << "...";
+        return true;
     }
 
     // The references after warmup and simulated ones are dropped.
     if (knobs.warmup_refs == 0 && knobs.sim_refs == 0) {
-        std::cerr << "Warning: warmup+skiprefs " << memref.data.addr << "...";
-        return std::pair<bool, bool>(true, true);
+        if (knobs.verbose >= 3)
+            std::cerr << "Warning: warmup+skiprefs " << memref.data.addr << "...";
+        return true;
     }
 
     // Both warmup and simulated references are simulated.
     if (!simulator_t::process_memref(memref)) {
-        std::cerr << "Warning: untrue " << memref.data.addr << "...";
-        return std::pair<bool, bool>(true, true);
+        if (knobs.verbose >= 3)
+            std::cerr << "Warning: untrue " << memref.data.addr << "...";
+        return true;
     }
 
     if (memref.marker.type == TRACE_TYPE_MARKER) {
       // We ignore markers before we ask core_for_thread, to avoid asking
       // too early on a timestamp marker.
-        std::cerr << __FUNCTION__ << "memref.marker.type == TRACE_TYPE_MARKER" << memref.data.addr << "...";
-        return std::pair<bool, bool>(true, true);
+        if (knobs.verbose >= 3)
+            std::cerr << __FUNCTION__ << "memref.marker.type == TRACE_TYPE_MARKER" << memref.data.addr << "...";
+        return true;
     }
 
-    // We use a static scheduling of threads to cores, as it is
-    // not practical to measure which core each thread actually
-    // ran on for each memref.
-    int core;
-    if (memref.data.tid == last_thread)
-        core = last_core;
-    else {
-        core = core_for_thread(memref.data.tid);
-        last_thread = memref.data.tid;
-        last_core = core;
-    }
+    *core = core_for_memref(memref);
 
-    bool found = false;
-
-    if (type_is_instr(memref.instr.type)) {
-        //Debug
-        //std::cerr << "Checking ITLB for addr " << std::hex << memref.instr.addr << std::dec << "...";
-        found = (itlbs[core]->request(memref) != NOT_FOUND);
-        if (knobs.verbose >= 2) {
-          std::cerr << "found in ITLB: " << found << std::endl;
-        }
-    }
-    else if (memref.data.type == TRACE_TYPE_READ || memref.data.type == TRACE_TYPE_WRITE) {
-        //std::cerr << "Checking DTLB for addr " << std::hex << memref.data.addr << std::dec << "...";
-        found = (dtlbs[core]->request(memref) != NOT_FOUND);
-        if (knobs.verbose >= 2) {
-          std::cerr << "found in DTLB: " << found << std::endl;
-        }
-    }
-    else if (memref.exit.type == TRACE_TYPE_THREAD_EXIT) {
+    if (type_is_instr(memref.instr.type) || memref.data.type == TRACE_TYPE_READ ||
+        memref.data.type == TRACE_TYPE_WRITE) {
+        // Looked up by lookup_tlb().
+    } else if (memref.exit.type == TRACE_TYPE_THREAD_EXIT) {
         handle_thread_exit(memref.exit.tid);
         last_thread = 0;
     } else if (type_is_prefetch(memref.data.type) ||
@@ -200,7 +313,7 @@ tlb_simulator_t::process_memref_tlb(const memref_t &memref)
     } else {
         std::cout << __func__ << std::endl;
         error_string = "Unhandled memref type " + std::to_string(memref.data.type);
-        return std::pair<bool, bool>(false, true);
+        return false;
     }
 
     if (knobs.verbose >= 3) {
@@ -214,18 +327,164 @@ tlb_simulator_t::process_memref_tlb(const memref_t &memref)
     if (knobs.warmup_refs > 0) { // warm tlbs up
         knobs.warmup_refs--;
         // reset tlb stats when warming up is completed
-        if (knobs.warmup_refs == 0) {
-            for (unsigned int i = 0; i < knobs.num_cores; i++) {
-                std::cerr << "Finished warmup of TLB" << std::endl;
-                itlbs[i]->get_stats()->reset();
-                dtlbs[i]->get_stats()->reset();
-                lltlbs[i]->get_stats()->reset();
-            }
-        }
+        if (knobs.warmup_refs == 0)
+            *warmup_done = true;
     } else {
         knobs.sim_refs--;
     }
-    return std::pair<bool, bool>(true, found);
+    return true;
+}
+
+bool
+tlb_simulator_t::lookup_tlb(const memref_t &memref, int core, tlb_page_size_t page_size)
+{
+    bool found = false;
+
+    if (knobs.TLB_page_sizes) {
+        int level;
+        if (type_is_instr(memref.instr.type))
+            level = TLB_L1I;
+        else if (memref.data.type == TRACE_TYPE_READ ||
+                 memref.data.type == TRACE_TYPE_WRITE)
+            level = TLB_L1D;
+        else
+            return found;
+        tlb_t *tlb = size_tlbs[level][page_size][core];
+        if (page_size == TLB_PAGE_4KB)
+            found = (tlb->request(memref) != NOT_FOUND);
+        else
+            found = (tlb->request(memref, tlb_page_bits[page_size]) != NOT_FOUND);
+        if (knobs.verbose >= 2) {
+            std::cerr << "found in " << (level == TLB_L1I ? "ITLB " : "DTLB ")
+                      << tlb_page_size_names[page_size] << ": " << found << std::endl;
+        }
+        return found;
+    }
+
+    if (type_is_instr(memref.instr.type)) {
+        //Debug
+        //std::cerr << "Checking ITLB for addr " << std::hex << memref.instr.addr << std::dec << "...";
+        found = (itlbs[core]->request(memref) != NOT_FOUND);
+        if (knobs.verbose >= 2) {
+          std::cerr << "found in ITLB: " << found << std::endl;
+        }
+    }
+    else if (memref.data.type == TRACE_TYPE_READ || memref.data.type == TRACE_TYPE_WRITE) {
+        //std::cerr << "Checking DTLB for addr " << std::hex << memref.data.addr << std::dec << "...";
+        found = (dtlbs[core]->request(memref) != NOT_FOUND);
+        if (knobs.verbose >= 2) {
+          std::cerr << "found in DTLB: " << found << std::endl;
+        }
+    }
+    return found;
+}
+
+bool
+tlb_simulator_t::prefetch_tlb(const memref_t &memref, int core)
+{
+    tlb_t *tlb = knobs.TLB_page_sizes ? size_tlbs[TLB_L2][TLB_PAGE_4KB][core] : lltlbs[core];
+    return tlb->request(memref) == NOT_FOUND;
+}
+
+void
+tlb_simulator_t::set_prefetch_late_refs(uint64_t refs)
+{
+    for (unsigned int i = 0; i < knobs.num_cores; i++) {
+        for (int level = 0; level < TLB_LEVELS; level++) {
+            level_tlb(level, i)->set_prefetch_late_refs(refs);
+            if (!knobs.TLB_page_sizes)
+                continue;
+            for (int size = 0; size < TLB_PAGE_SIZES; size++)
+                size_tlbs[level][size][i]->set_prefetch_late_refs(refs);
+        }
+    }
+}
+
+int
+tlb_simulator_t::shootdown(addr_t start, addr_t end)
+{
+    int count = 0;
+    for (unsigned int i = 0; i < knobs.num_cores; i++) {
+        for (int level = 0; level < TLB_LEVELS; level++) {
+            count += level_tlb(level, i)->invalidate_pages(start, end);
+            if (!knobs.TLB_page_sizes)
+                continue;
+            // The separate arrays for large pages.
+            for (int size = TLB_PAGE_2MB; size < TLB_PAGE_SIZES; size++) {
+                if (size_tlbs[level][size][i] != level_tlb(level, i))
+                    count += size_tlbs[level][size][i]->invalidate_pages(start, end);
+            }
+        }
+    }
+    return count;
+}
+
+std::vector<std::pair<std::string, tlb_t *>>
+tlb_simulator_t::checkpoint_tlbs() const
+{
+    static const char *const level_names[TLB_LEVELS] = { "TLB-L1I", "TLB-L1D", "TLB-LL" };
+    std::vector<std::pair<std::string, tlb_t *>> tlbs;
+    for (unsigned int i = 0; i < knobs.num_cores; i++) {
+        for (int level = 0; level < TLB_LEVELS; level++) {
+            std::string name = "core " + std::to_string(i) + " " + level_names[level];
+            tlbs.push_back(std::make_pair(name, level_tlb(level, i)));
+            if (!knobs.TLB_page_sizes)
+                continue;
+            for (int size = TLB_PAGE_2MB; size < TLB_PAGE_SIZES; size++) {
+                if (size_tlbs[level][size][i] != level_tlb(level, i)) {
+                    tlbs.push_back(std::make_pair(name + " " + tlb_page_size_names[size],
+                                                  size_tlbs[level][size][i]));
+                }
+            }
+        }
+    }
+    return tlbs;
+}
+
+void
+tlb_simulator_t::save_checkpoint(checkpoint_writer_t &out) const
+{
+    for (auto &it : checkpoint_tlbs())
+        it.second->save_state(out, it.first);
+    // The TLB warmup may outlast the cache one.
+    out.write_u64(knobs.warmup_refs);
+}
+
+bool
+tlb_simulator_t::restore_checkpoint(checkpoint_reader_t &in, std::string &error)
+{
+    for (auto &it : checkpoint_tlbs()) {
+        if (!it.second->restore_state(in, it.first, error))
+            return false;
+    }
+    knobs.warmup_refs = in.read_u64();
+    knobs.warmup_fraction = 0.0;
+    if (!in.ok()) {
+        error = "Failed to read the TLB warmup from the checkpoint.";
+        return false;
+    }
+    return true;
+}
+
+void
+tlb_simulator_t::reset_stats()
+{
+    for (unsigned int i = 0; i < knobs.num_cores; i++) {
+        std::cerr << "Finished warmup of TLB" << std::endl;
+        itlbs[i]->get_stats()->reset();
+        dtlbs[i]->get_stats()->reset();
+        lltlbs[i]->get_stats()->reset();
+    }
+    for (int level = 0; level < TLB_LEVELS; level++) {
+        for (int size = 0; size < TLB_PAGE_SIZES; size++) {
+            for (caching_device_stats_t *stats : size_stats[level][size]) {
+                if (stats != NULL)
+                    stats->reset();
+            }
+        }
+        for (miss_ratio_curve_t *curve : curves[level])
+            curve->reset();
+    }
 }
 
 bool
@@ -237,28 +496,83 @@ tlb_simulator_t::print_results()
         if (thread_ever_counts[i] > 0) {
             std::cerr << "  TLB-L1I stats:" << std::endl;
             itlbs[i]->get_stats()->print_stats("    ");
+            print_page_sizes(TLB_L1I, i);
             std::cerr << "  TLB-L1D stats:" << std::endl;
             dtlbs[i]->get_stats()->print_stats("    ");
+            print_page_sizes(TLB_L1D, i);
             std::cerr << "  TLB-LL stats:" << std::endl;
             lltlbs[i]->get_stats()->print_stats("    ");
+            print_page_sizes(TLB_L2, i);
+        }
+    }
+    if (knobs.miss_ratio_curves) {
+        static const char *const level_names[TLB_LEVELS] = { "TLB-L1I", "TLB-L1D",
+                                                             "TLB-LL" };
+        for (int level = 0; level < TLB_LEVELS; level++) {
+            std::cerr << "  " << level_names[level]
+                      << " LRU miss ratio curve, all cores:" << std::endl;
+            miss_ratio_curve_t::print_curves(curves[level], "    ");
         }
     }
     return true;
 }
 
+void
+tlb_simulator_t::print_page_sizes(int level, unsigned int core)
+{
+    if (!knobs.TLB_page_sizes)
+        return;
+    static const char *const level_names[TLB_LEVELS] = { "TLB-L1I", "TLB-L1D", "TLB-LL" };
+    for (int size = 0; size < TLB_PAGE_SIZES; size++) {
+        std::cerr << "  " << level_names[level] << " " << tlb_page_size_names[size]
+                  << " page stats";
+        if (size_tlbs[level][size][core] == level_tlb(level, core)) {
+            if (size != TLB_PAGE_4KB)
+                std::cerr << " (shared with " << level_names[level] << ")";
+        } else {
+            std::cerr << " (separate array)";
+        }
+        std::cerr << ":" << std::endl;
+        size_stats[level][size][core]->print_stats("    ");
+    }
+}
+
+std::string
+tlb_simulator_t::level_replace_policy(int level) const
+{
+    const std::string &policy = level == TLB_L1I
+        ? knobs.TLB_L1I_replace
+        : (level == TLB_L1D ? knobs.TLB_L1D_replace : knobs.TLB_L2_replace);
+    return policy.empty() ? knobs.TLB_replace_policy : policy;
+}
+
 tlb_t *
 tlb_simulator_t::create_tlb(std::string policy)
 {
-    // XXX: how to implement different replacement policies?
-    // Should we extend tlb_t to tlb_XXX_t so as to avoid multiple inheritence?
-    // Or should we adopt multiple inheritence to have caching_device_XXX_t as one base
-    // and tlb_t as another base class?
+    // tlb_t is LFU; other policies are passed to tlb_t's lookup by
+    // policy_tlb_t.
     if (policy == REPLACE_POLICY_NON_SPECIFIED || // default LFU
         policy == REPLACE_POLICY_LFU)             // set to LFU
         return new tlb_t;
+    if (policy == REPLACE_POLICY_LRU)
+        return new policy_tlb_t<lru_policy_t>;
+    if (policy == REPLACE_POLICY_FIFO)
+        return new policy_tlb_t<fifo_policy_t>;
+    if (policy == REPLACE_POLICY_SRRIP)
+        return new policy_tlb_t<srrip_policy_t>;
+    if (policy == REPLACE_POLICY_BRRIP)
+        return new policy_tlb_t<brrip_policy_t>;
+    if (policy == REPLACE_POLICY_DRRIP)
+        return new policy_tlb_t<drrip_policy_t>;
+    if (policy == REPLACE_POLICY_SHIP)
+        return new policy_tlb_t<ship_policy_t>;
+    if (policy == REPLACE_POLICY_HAWKEYE)
+        return new policy_tlb_t<hawkeye_policy_t>;
 
     // undefined replacement policy
-    ERRMSG("Usage error: undefined replacement policy. "
-           "Please choose " REPLACE_POLICY_LFU ".\n");
+    ERRMSG("Usage error: undefined TLB replacement policy. "
+           "Please choose " REPLACE_POLICY_LFU ", " REPLACE_POLICY_LRU
+           ", " REPLACE_POLICY_FIFO ", " REPLACE_POLICY_SRRIP ", " REPLACE_POLICY_BRRIP ", " REPLACE_POLICY_DRRIP
+           ", " REPLACE_POLICY_SHIP " or " REPLACE_POLICY_HAWKEYE ".\n");
     return NULL;
 }
@@ -42,6 +42,10 @@
 #include "tlb_stats.h"
 #include "tlb.h"
 
+// The page sizes told apart with -TLB_page_sizes.  TLB_PAGE_4KB stands for
+// the -page_size of the TLBs.
+enum tlb_page_size_t { TLB_PAGE_4KB, TLB_PAGE_2MB, TLB_PAGE_1GB, TLB_PAGE_SIZES };
+
 class tlb_simulator_t : public simulator_t {
 public:
     tlb_simulator_t(const tlb_simulator_knobs_t &knobs);
@@ -56,10 +60,81 @@ public:
     std::pair<bool,bool> 
     process_memref_tlb(const memref_t &memref); 
 
+    // process_memref_tlb() in three steps, so that the lookups of different
+    // cores can run on different threads.  schedule_memref_tlb() does the
+    // in-order part (skipping, warmup and simulation counts, core assignment)
+    // and sets *core to the core whose TLBs lookup_tlb() searches, or to -1 if
+    // the reference is not simulated and counts as a hit.  If it sets
+    // *warmup_done, reset_stats() must be called once the lookup is done.
+    // With -TLB_page_sizes, lookup_tlb() searches and fills the TLBs for
+    // page_size, which the caller takes from the page walk.
+    bool
+    schedule_memref_tlb(const memref_t &memref, int *core, bool *warmup_done);
+    bool
+    lookup_tlb(const memref_t &memref, int core,
+               tlb_page_size_t page_size = TLB_PAGE_4KB);
+    void
+    reset_stats();
+    // Prefetches the translation of memref's page, a hardware prefetch, into
+    // core's L2 TLB.  Returns whether it was missing, in which case the
+    // caller fetches its page table entry.
+    bool
+    prefetch_tlb(const memref_t &memref, int core);
+    void
+    set_prefetch_late_refs(uint64_t refs);
+    // Invalidates the translations of the virtual addresses [start, end] in
+    // every core's TLBs, as a TLB shootdown does.  Returns how many entries
+    // there were.
+    int
+    shootdown(addr_t start, addr_t end);
+    // Writes the state of every TLB and what remains of their warmup to a
+    // checkpoint, or reads them back.
+    void
+    save_checkpoint(checkpoint_writer_t &out) const;
+    bool
+    restore_checkpoint(checkpoint_reader_t &in, std::string &error);
+
+    tlb_t *
+    get_itlb(unsigned int core) const
+    {
+        return itlbs[core];
+    }
+    tlb_t *
+    get_dtlb(unsigned int core) const
+    {
+        return dtlbs[core];
+    }
+    tlb_t *
+    get_lltlb(unsigned int core) const
+    {
+        return lltlbs[core];
+    }
+
 protected:
     // Create a tlb_t object with a specific replacement policy.
     virtual tlb_t *
     create_tlb(std::string policy);
+    // The replacement policy of the TLBs of a level.
+    std::string
+    level_replace_policy(int level) const;
+
+    enum { TLB_L1I, TLB_L1D, TLB_L2, TLB_LEVELS };
+    tlb_t *
+    level_tlb(int level, unsigned int core) const
+    {
+        return level == TLB_L1I ? itlbs[core]
+                                : (level == TLB_L1D ? dtlbs[core] : lltlbs[core]);
+    }
+    bool
+    init_page_sizes();
+    // Attaches the -miss_ratio_curves of each level to its TLBs.
+    bool
+    init_curves();
+    // The TLBs of a checkpoint, named.
+    std::vector<std::pair<std::string, tlb_t *>>
+    checkpoint_tlbs() const;
+    void
+    print_page_sizes(int level, unsigned int core);
 
     tlb_simulator_knobs_t knobs;
 
@@ -68,6 +143,17 @@ protected:
     tlb_t **itlbs;
     tlb_t **dtlbs;
     tlb_t **lltlbs;
+
+    // With -TLB_page_sizes, the TLB holding the translations of each page
+    // size at each level, per core: a separate array, or the level's TLB in
+    // itlbs, dtlbs or lltlbs.
+    std::vector<tlb_t *> size_tlbs[TLB_LEVELS][TLB_PAGE_SIZES];
+    // Their statistics for that page size.  For a TLB holding several page
+    // sizes these are kept through tlb_t::add_page_size_stats() and owned here.
+    std::vector<caching_device_stats_t *> size_stats[TLB_LEVELS][TLB_PAGE_SIZES];
+    // With -miss_ratio_curves, those of the requests of each level's TLB, per
+    // core.
+    std::vector<miss_ratio_curve_t *> curves[TLB_LEVELS];
 };
 
 #endif /* _TLB_SIMULATOR_H_ */
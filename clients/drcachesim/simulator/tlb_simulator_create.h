@@ -58,12 +58,33 @@ struct tlb_simulator_knobs_t {
         , TLB_L1D_assoc(32)
         , TLB_L2_entries(1024)
         , TLB_L2_assoc(4)
+        , TLB_page_sizes(false)
+        , TLB_L1I_2M_entries(8)
+        , TLB_L1I_2M_assoc(8)
+        , TLB_L1I_1G_entries(0)
+        , TLB_L1I_1G_assoc(4)
+        , TLB_L1D_2M_entries(32)
+        , TLB_L1D_2M_assoc(4)
+        , TLB_L1D_1G_entries(4)
+        , TLB_L1D_1G_assoc(4)
+        , TLB_L2_2M_entries(0)
+        , TLB_L2_2M_assoc(4)
+        , TLB_L2_1G_entries(16)
+        , TLB_L2_1G_assoc(4)
         , TLB_replace_policy("LFU")
+        , TLB_L1I_replace("")
+        , TLB_L1D_replace("")
+        , TLB_L2_replace("")
         , skip_refs(0)
         , warmup_refs(0)
         , warmup_fraction(0.0)
         , sim_refs(1ULL << 63)
         , cpu_scheduling(false)
+        , core_from_access_cpu(false)
+        , miss_ratio_curves(false)
+        , mrc_max_entries(4096)
+        , mrc_assocs("")
+        , mrc_sample_sets(1)
         , verbose(0)
     {
     }
@@ -75,12 +96,37 @@ struct tlb_simulator_knobs_t {
     unsigned int TLB_L1D_assoc;
     unsigned int TLB_L2_entries;
     unsigned int TLB_L2_assoc;
+    bool TLB_page_sizes;
+    // With TLB_page_sizes, the arrays for 2MB and 1GB pages at each level.
+    // 0 entries keeps the size in the level's page_size TLB.
+    unsigned int TLB_L1I_2M_entries;
+    unsigned int TLB_L1I_2M_assoc;
+    unsigned int TLB_L1I_1G_entries;
+    unsigned int TLB_L1I_1G_assoc;
+    unsigned int TLB_L1D_2M_entries;
+    unsigned int TLB_L1D_2M_assoc;
+    unsigned int TLB_L1D_1G_entries;
+    unsigned int TLB_L1D_1G_assoc;
+    unsigned int TLB_L2_2M_entries;
+    unsigned int TLB_L2_2M_assoc;
+    unsigned int TLB_L2_1G_entries;
+    unsigned int TLB_L2_1G_assoc;
     std::string TLB_replace_policy;
+    // Per-level replacement policies; empty uses TLB_replace_policy.
+    std::string TLB_L1I_replace;
+    std::string TLB_L1D_replace;
+    std::string TLB_L2_replace;
     uint64_t skip_refs;
     uint64_t warmup_refs;
     double warmup_fraction;
     uint64_t sim_refs;
     bool cpu_scheduling;
+    bool core_from_access_cpu;
+    // LRU miss ratio curves of each TLB level: see miss_ratio_curve_t.
+    bool miss_ratio_curves;
+    unsigned int mrc_max_entries;
+    std::string mrc_assocs;
+    unsigned int mrc_sample_sets;
     unsigned int verbose;
 };
 
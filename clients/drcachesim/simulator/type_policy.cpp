@@ -0,0 +1,127 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+#include "type_policy.h"
+#include <iomanip>
+#include <iostream>
+#include <locale>
+
+static const char *const type_class_names[TYPE_CLASS_COUNT] = {
+    "instr", "data", "PE1", "PE2", "PE3", "PE4",
+};
+
+type_policy_t::type_policy_t(bool bypass_leaf_)
+    : bypass_leaf(bypass_leaf_)
+    , associativity(0)
+    , num_blocks(0)
+    , num_accesses(0)
+{
+    for (int i = 0; i < TYPE_CLASS_COUNT; i++) {
+        occupancy[i] = 0;
+        occupancy_sum[i] = 0.;
+        last_change[i] = 0;
+    }
+}
+
+bool
+type_policy_t::init(int associativity_, int num_blocks_)
+{
+    associativity = associativity_;
+    num_blocks = num_blocks_;
+    block_classes.assign(num_blocks, TYPE_CLASS_COUNT);
+    return true;
+}
+
+void
+type_policy_t::add_occupancy(int cls, int delta)
+{
+    occupancy_sum[cls] += (double)occupancy[cls] * (num_accesses - last_change[cls]);
+    last_change[cls] = num_accesses;
+    occupancy[cls] += delta;
+}
+
+void
+type_policy_t::fill(int block, const memref_t &memref)
+{
+    if (block_classes[block] != TYPE_CLASS_COUNT)
+        add_occupancy(block_classes[block], -1);
+    block_classes[block] = (uint8_t)get_type_class(memref.data.type);
+    add_occupancy(block_classes[block], 1);
+}
+
+void
+type_policy_t::invalidate(int block)
+{
+    if (block_classes[block] == TYPE_CLASS_COUNT)
+        return;
+    add_occupancy(block_classes[block], -1);
+    block_classes[block] = TYPE_CLASS_COUNT;
+}
+
+void
+type_policy_t::print_stats(std::string prefix)
+{
+    std::cerr << prefix << "Occupancy by type (" << name()
+              << (bypass_leaf ? ", leaf bypass" : "") << "):" << std::endl;
+    for (int cls = 0; cls < TYPE_CLASS_COUNT; cls++) {
+        // Bring the sum up to date.
+        add_occupancy(cls, 0);
+        double average =
+            num_accesses == 0 ? 0. : occupancy_sum[cls] / num_accesses / num_blocks;
+        std::cerr << prefix << "  " << std::setw(16) << std::left
+                  << (std::string(type_class_names[cls]) + ":") << std::setw(12)
+                  << std::right << occupancy[cls] << " blocks" << std::setw(10)
+                  << std::fixed << std::setprecision(2) << (average * 100)
+                  << "% average" << std::endl;
+    }
+}
+
+pt_partition_policy_t::pt_partition_policy_t(int pt_ways_, bool bypass_leaf_)
+    : type_policy_t(bypass_leaf_)
+    , pt_ways(pt_ways_)
+{
+}
+
+bool
+pt_partition_policy_t::init(int associativity_, int num_blocks_)
+{
+    // Both partitions need a way.
+    if (pt_ways <= 0 || pt_ways >= associativity_)
+        return false;
+    return type_policy_t::init(associativity_, num_blocks_);
+}
+
+pt_priority_policy_t::pt_priority_policy_t(int levels_, bool bypass_leaf_)
+    : type_policy_t(bypass_leaf_)
+    , levels(levels_)
+{
+}
@@ -0,0 +1,200 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* type_policy: how a caching device treats blocks by the type of the request
+ * that brings them in, to model caches that favor page table lines.
+ */
+
+#ifndef _TYPE_POLICY_H_
+#define _TYPE_POLICY_H_ 1
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "memref.h"
+
+// The classes of blocks a type policy tells apart and keeps occupancy of.
+// The page table levels are the walk's request types: PE1 to PE4 from the
+// root to the leaf in radix walks, and ECPT and CWT entries as PE1 and PE2
+// in ECPT walks.
+enum type_class_t {
+    TYPE_CLASS_INSTR,
+    TYPE_CLASS_DATA,
+    TYPE_CLASS_PE1,
+    TYPE_CLASS_PE2,
+    TYPE_CLASS_PE3,
+    TYPE_CLASS_PE4,
+    TYPE_CLASS_COUNT,
+};
+
+static inline type_class_t
+get_type_class(trace_type_t type)
+{
+    if (type >= TRACE_TYPE_PE1 && type <= TRACE_TYPE_PE4)
+        return static_cast<type_class_t>(TYPE_CLASS_PE1 + (type - TRACE_TYPE_PE1));
+    return type_is_instr(type) ? TYPE_CLASS_INSTR : TYPE_CLASS_DATA;
+}
+
+static inline bool
+type_is_page_table(trace_type_t type)
+{
+    return type >= TRACE_TYPE_PE1 && type <= TRACE_TYPE_PE4;
+}
+
+// A caching device with a type policy consults it on every request:
+// - bypass() sends a request straight to the parent without filling.
+// - fill_ways() limits the ways a miss may fill.
+// - insert_with_priority() promotes a new block (see the replacement
+//   policies' promote()) once the replacement policy has inserted it.
+// The base class applies no policy, but for the optional bypass of leaf page
+// table lines, and keeps the occupancy of each class of blocks.
+class type_policy_t {
+public:
+    explicit type_policy_t(bool bypass_leaf = false);
+    virtual ~type_policy_t()
+    {
+    }
+    // Called by the caching device once its blocks are allocated.
+    virtual bool
+    init(int associativity, int num_blocks);
+
+    // Leaf page table lines of 4KB radix walks bypass the device.
+    inline bool
+    bypass(const memref_t &memref) const
+    {
+        return bypass_leaf && memref.data.type == TRACE_TYPE_PE4;
+    }
+    virtual void
+    fill_ways(const memref_t &memref, int *first_way, int *end_way) const
+    {
+        *first_way = 0;
+        *end_way = associativity;
+    }
+    virtual bool
+    insert_with_priority(const memref_t &memref) const
+    {
+        return false;
+    }
+
+    // Occupancy bookkeeping, from the caching device.
+    inline void
+    access()
+    {
+        num_accesses++;
+    }
+    void
+    fill(int block, const memref_t &memref);
+    void
+    invalidate(int block);
+
+    // The name of the policy for the statistics header.
+    virtual std::string
+    name() const
+    {
+        return "share";
+    }
+    void
+    print_stats(std::string prefix);
+
+protected:
+    // Counts a change in the occupancy of cls, weighting the previous one by
+    // the accesses it lasted.
+    void
+    add_occupancy(int cls, int delta);
+
+    bool bypass_leaf;
+    int associativity;
+    int num_blocks;
+    // The class of each valid block.
+    std::vector<uint8_t> block_classes;
+    int_least64_t num_accesses;
+    int_least64_t occupancy[TYPE_CLASS_COUNT];
+    // Sum over accesses of the occupancy of each class, up to last_change.
+    double occupancy_sum[TYPE_CLASS_COUNT];
+    int_least64_t last_change[TYPE_CLASS_COUNT];
+};
+
+// Reserves ways [0, pt_ways) of every set for page table lines and the
+// others for everything else, like a way-partitioned cache that keeps
+// translations from being evicted by data.
+class pt_partition_policy_t : public type_policy_t {
+public:
+    pt_partition_policy_t(int pt_ways, bool bypass_leaf = false);
+    virtual bool
+    init(int associativity, int num_blocks);
+    virtual void
+    fill_ways(const memref_t &memref, int *first_way, int *end_way) const
+    {
+        if (type_is_page_table(memref.data.type)) {
+            *first_way = 0;
+            *end_way = pt_ways;
+        } else {
+            *first_way = pt_ways;
+            *end_way = associativity;
+        }
+    }
+    virtual std::string
+    name() const
+    {
+        return "partition";
+    }
+
+protected:
+    int pt_ways;
+};
+
+// Inserts the page table lines of the top levels of a walk, PE1 to
+// PE<levels>, as if they had just been hit.  Upper levels are shared by more
+// translations, so with fewer levels the priority goes to those.  This only
+// has an effect with replacement policies that insert blocks below the
+// highest retention, like the RRIP family, SHiP, Hawkeye and LFU.
+class pt_priority_policy_t : public type_policy_t {
+public:
+    pt_priority_policy_t(int levels, bool bypass_leaf = false);
+    virtual bool
+    insert_with_priority(const memref_t &memref) const
+    {
+        return type_is_page_table(memref.data.type) &&
+            memref.data.type - TRACE_TYPE_PE1 < levels;
+    }
+    virtual std::string
+    name() const
+    {
+        return "priority";
+    }
+
+protected:
+    int levels;
+};
+
+#endif /* _TYPE_POLICY_H_ */
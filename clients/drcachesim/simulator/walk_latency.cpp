@@ -0,0 +1,188 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+/* walk_latency: estimates address translation latency from the outcome of
+ * each TLB lookup and page walk.
+ */
+
+#include "walk_latency.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include <vector>
+
+walk_latency_t::walk_latency_t()
+    : tlb_cycles(1)
+    , hash_cycles(2)
+    , pud_cwc_cycles(4)
+    , pmd_cwc_cycles(4)
+    , parallel_cwc(true)
+    , overlap_backfill(true)
+    , num_refs(0)
+    , num_walks(0)
+    , translation_cycles(0)
+    , data_cycles(0)
+    , walk_cycles_total(0)
+{
+    // The defaults of calc_page_walk_latency.py.
+    for (int i = 0; i <= ZERO; i++)
+        level_cycles[i] = 0;
+    level_cycles[NOT_FOUND] = 200;
+    level_cycles[FOUND_L1] = 4;
+    level_cycles[FOUND_L2] = 14;
+    level_cycles[FOUND_LLC] = 54;
+    level_cycles[PWC] = 1;
+}
+
+bool
+walk_latency_t::init(const std::string &latencies, bool parallel_cwc_,
+                     bool overlap_backfill_, std::string &error)
+{
+    static const char *const level_names[] = {
+        "MEMORY", "L1", "L2", "LLC", "WRONG", "RANGE_HIT", "RANGE_MISS", "PWC", "ZERO"
+    };
+    parallel_cwc = parallel_cwc_;
+    overlap_backfill = overlap_backfill_;
+
+    std::istringstream list(latencies);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        if (item.empty())
+            continue;
+        size_t eq = item.find('=');
+        char *end = NULL;
+        unsigned long long cycles = 0;
+        if (eq != std::string::npos)
+            cycles = strtoull(item.c_str() + eq + 1, &end, 10);
+        if (eq == std::string::npos || eq + 1 == item.size() || *end != '\0') {
+            error = "Usage error: invalid latency '" + item + "', expected NAME=cycles";
+            return false;
+        }
+        std::string name = item.substr(0, eq);
+        uint64_t *dest = NULL;
+        for (int i = 0; i <= ZERO; i++) {
+            if (name == level_names[i])
+                dest = &level_cycles[i];
+        }
+        if (name == "TLB")
+            dest = &tlb_cycles;
+        else if (name == "HASH")
+            dest = &hash_cycles;
+        else if (name == "PUD_CWC")
+            dest = &pud_cwc_cycles;
+        else if (name == "PMD_CWC")
+            dest = &pmd_cwc_cycles;
+        if (dest == NULL) {
+            error = "Usage error: unknown latency '" + name + "'";
+            return false;
+        }
+        *dest = cycles;
+    }
+    return true;
+}
+
+void
+walk_latency_t::record(bool fetch_buffer_hit, bool walked, uint64_t walk_cycles,
+                       cache_result_t data_cache)
+{
+    num_refs++;
+    if (fetch_buffer_hit)
+        return;
+    translation_cycles += tlb_cycles;
+    if (walked) {
+        num_walks++;
+        translation_cycles += walk_cycles;
+        walk_cycles_total += walk_cycles;
+        walk_cycles_hist.add(walk_cycles);
+    }
+    data_cycles += level_cycles[data_cache];
+}
+
+void
+walk_latency_t::reset()
+{
+    num_refs = 0;
+    num_walks = 0;
+    translation_cycles = 0;
+    data_cycles = 0;
+    walk_cycles_total = 0;
+    walk_cycles_hist.clear();
+}
+
+void
+walk_latency_t::print_results() const
+{
+    std::cerr << "~~~~~~ page walk latency model ~~~~~~" << std::endl;
+    std::cerr << "memory references : " << num_refs << std::endl;
+    std::cerr << "page walks : " << num_walks << std::endl;
+    if (num_refs == 0)
+        return;
+    std::ios_base::fmtflags flags = std::cerr.flags();
+    std::streamsize precision = std::cerr.precision();
+    std::cerr << std::fixed << std::setprecision(3);
+    if (num_walks > 0) {
+        std::vector<std::pair<uint64_t, uint64_t>> hist = walk_cycles_hist.entries();
+        std::sort(hist.begin(), hist.end());
+        std::cerr << "avg page walk cycles : " << (double)walk_cycles_total / num_walks
+                  << std::endl;
+        // Nearest-rank percentiles.
+        static const struct {
+            const char *name;
+            uint64_t permille;
+        } percentiles[] = { { "p50", 500 }, { "p90", 900 }, { "p99", 990 },
+                            { "p99.9", 999 } };
+        size_t pos = 0;
+        uint64_t seen = hist[0].second;
+        for (const auto &pct : percentiles) {
+            uint64_t rank = (num_walks * pct.permille + 999) / 1000;
+            while (seen < rank) {
+                pos++;
+                seen += hist[pos].second;
+            }
+            std::cerr << pct.name << " page walk cycles : " << hist[pos].first
+                      << std::endl;
+        }
+        std::cerr << "max page walk cycles : " << hist.back().first << std::endl;
+        std::cerr << "page walk cycles histogram:" << std::endl;
+        for (const auto &entry : hist)
+            std::cerr << entry.first << "," << entry.second << std::endl;
+    }
+    std::cerr << "translation cycles per reference : "
+              << (double)translation_cycles / num_refs << std::endl;
+    std::cerr << "cycles per reference : "
+              << (double)(translation_cycles + data_cycles) / num_refs << std::endl;
+    std::cerr.flags(flags);
+    std::cerr.precision(precision);
+}
@@ -0,0 +1,170 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+
+/* walk_latency: estimates address translation latency from the outcome of
+ * each TLB lookup and page walk.
+ */
+
+#ifndef _WALK_LATENCY_H_
+#define _WALK_LATENCY_H_ 1
+
+#include <stdint.h>
+#include <string>
+#include "flat_histogram.h"
+#include "memref.h"
+
+// Latencies in cycles are configured per cache_result_t (the level that served a page
+// walk step or the data access) plus the TLB hit, the ECPT hash and the two ECPT cuckoo
+// walk caches.  A radix walk is serial: its latency is the sum of its steps, with a PWC
+// hit at level i charged once per PWC probed on the way (3 - i).  Hashed and flattened
+// walks have no page walk caches: theirs is the plain sum of the steps.  An ECPT walk
+// probes its ways in parallel: its latency is the selected way with early return,
+// otherwise the slowest way, plus the hash and the CWC lookups, which are either serial
+// or parallel.
+class walk_latency_t {
+public:
+    walk_latency_t();
+
+    // Overrides the default latencies from a "NAME=cycles,..." list where NAME
+    // is a cache_result_t name or TLB, HASH, PUD_CWC or PMD_CWC.
+    bool
+    init(const std::string &latencies, bool parallel_cwc, bool overlap_backfill,
+         std::string &error);
+
+    template <typename walk_t>
+    uint64_t
+    radix_walk(const walk_t &walk) const
+    {
+        uint64_t cycles = 0;
+        for (unsigned int i = 0; i < walk.size(); i++) {
+            cycles += level_cycles[walk[i]];
+            if (walk[i] == PWC && i < 3)
+                cycles += level_cycles[PWC] * (2 - i);
+        }
+        return cycles;
+    }
+
+    template <typename walk_t>
+    uint64_t
+    serial_walk(const walk_t &walk) const
+    {
+        uint64_t cycles = 0;
+        for (unsigned int i = 0; i < walk.size(); i++)
+            cycles += level_cycles[walk[i]];
+        return cycles;
+    }
+
+    template <typename walk_t>
+    uint64_t
+    ecpt_walk(const walk_t &walk, bool early_return, uint32_t selected_way) const
+    {
+        uint64_t cycles = 0;
+        if (early_return && selected_way < walk.size()) {
+            cycles = level_cycles[walk[selected_way]];
+        } else {
+            for (unsigned int i = 0; i < walk.size(); i++) {
+                if (level_cycles[walk[i]] > cycles)
+                    cycles = level_cycles[walk[i]];
+            }
+        }
+        return cycles + hash_cycles + cwc_cycles();
+    }
+
+    // The CWT entries refetched after CWC misses: the ways of each table are
+    // fetched in parallel and both tables at once.  The walk only waits for
+    // them when the back-fill does not overlap with it.
+    template <typename walk_t>
+    uint64_t
+    cwt_backfill(const walk_t &pmd_fetch, const walk_t &pud_fetch) const
+    {
+        if (overlap_backfill)
+            return 0;
+        uint64_t cycles = 0;
+        for (unsigned int i = 0; i < pmd_fetch.size(); i++) {
+            if (level_cycles[pmd_fetch[i]] > cycles)
+                cycles = level_cycles[pmd_fetch[i]];
+        }
+        for (unsigned int i = 0; i < pud_fetch.size(); i++) {
+            if (level_cycles[pud_fetch[i]] > cycles)
+                cycles = level_cycles[pud_fetch[i]];
+        }
+        return cycles;
+    }
+
+    // Accounts one memory reference.  A reference served by the instruction
+    // fetch buffer costs nothing; any other pays the TLB lookup, the page walk
+    // if walked, and the access to data_cache.
+    void
+    record(bool fetch_buffer_hit, bool walked, uint64_t walk_cycles,
+           cache_result_t data_cache);
+
+    void
+    reset();
+
+    void
+    print_results() const;
+
+private:
+    struct cycles_hash_t {
+        size_t
+        operator()(uint64_t cycles) const
+        {
+            return flat_histogram_mix(cycles);
+        }
+    };
+
+    uint64_t
+    cwc_cycles() const
+    {
+        if (parallel_cwc)
+            return pud_cwc_cycles > pmd_cwc_cycles ? pud_cwc_cycles : pmd_cwc_cycles;
+        return pud_cwc_cycles + pmd_cwc_cycles;
+    }
+
+    uint64_t level_cycles[ZERO + 1];
+    uint64_t tlb_cycles;
+    uint64_t hash_cycles;
+    uint64_t pud_cwc_cycles;
+    uint64_t pmd_cwc_cycles;
+    bool parallel_cwc;
+    bool overlap_backfill;
+
+    uint64_t num_refs;
+    uint64_t num_walks;
+    uint64_t translation_cycles;
+    uint64_t data_cycles;
+    uint64_t walk_cycles_total;
+    flat_histogram_t<uint64_t, cycles_hash_t> walk_cycles_hist;
+};
+
+#endif /* _WALK_LATENCY_H_ */
@@ -0,0 +1,118 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* way_lookup: searching the ways of one set of a caching device.
+ */
+
+#ifndef _WAY_LOOKUP_H_
+#define _WAY_LOOKUP_H_ 1
+
+#include <vector>
+#include "memref.h"
+
+// The tags (and for TLBs, pids) of a set are contiguous, so a set can be
+// searched with a few vector compares.  Each operation has a scalar kernel
+// and, on x86-64 with GCC or Clang, AVX2 and AVX-512 kernels; one is picked at
+// startup from what the CPU supports.  Small sets are searched inline, as the
+// indirect call costs more than the vector compares save there (see
+// tests/way_lookup_bench.cpp).
+
+// Returns the first way whose tag matches, or associativity if none does.
+typedef int (*find_way_func_t)(const addr_t *tags, int associativity, addr_t tag);
+// Like find_way_func_t, but the pid must match too.
+typedef int (*find_way_pid_func_t)(const addr_t *tags, const memref_pid_t *pids,
+                                   int associativity, addr_t tag, memref_pid_t pid);
+// Increments every counter that is not larger than cnt (LRU aging).
+typedef void (*lru_age_func_t)(int *counters, int associativity, int cnt);
+
+struct way_lookup_kernels_t {
+    const char *name;
+    find_way_func_t find_way;
+    find_way_pid_func_t find_way_pid;
+    lru_age_func_t lru_age;
+};
+
+// The kernels in use for sets of at least WAY_LOOKUP_MIN_WAYS ways.
+const way_lookup_kernels_t &
+way_lookup_kernels();
+
+// All kernels this CPU can run, scalar first.
+std::vector<const way_lookup_kernels_t *>
+way_lookup_available_kernels();
+
+static const int WAY_LOOKUP_MIN_WAYS = 8;
+static const int WAY_LOOKUP_MIN_LRU_WAYS = 32;
+
+extern find_way_func_t find_way_impl;
+extern find_way_pid_func_t find_way_pid_impl;
+extern lru_age_func_t lru_age_impl;
+
+static inline int
+find_way(const addr_t *tags, int associativity, addr_t tag)
+{
+    if (associativity >= WAY_LOOKUP_MIN_WAYS)
+        return find_way_impl(tags, associativity, tag);
+    int way;
+    for (way = 0; way < associativity; ++way) {
+        if (tags[way] == tag)
+            break;
+    }
+    return way;
+}
+
+static inline int
+find_way_pid(const addr_t *tags, const memref_pid_t *pids, int associativity, addr_t tag,
+             memref_pid_t pid)
+{
+    if (associativity >= WAY_LOOKUP_MIN_WAYS)
+        return find_way_pid_impl(tags, pids, associativity, tag, pid);
+    int way;
+    for (way = 0; way < associativity; ++way) {
+        if (tags[way] == tag && pids[way] == pid)
+            break;
+    }
+    return way;
+}
+
+static inline void
+lru_age(int *counters, int associativity, int cnt)
+{
+    if (associativity >= WAY_LOOKUP_MIN_LRU_WAYS) {
+        lru_age_impl(counters, associativity, cnt);
+        return;
+    }
+    // Written without a branch so that the compiler vectorizes it.
+    for (int i = 0; i < associativity; ++i)
+        counters[i] += (counters[i] <= cnt);
+}
+
+#endif /* _WAY_LOOKUP_H_ */
@@ -31,10 +31,33 @@
  */
 
 // Unit tests for drcachesim
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <thread>
+#include "analyzer.h"
+#include "reader/config_reader.h"
+#include "reader/qemu_file_reader.h"
+#ifdef HAS_ZLIB
+#    include "reader/qemu_trace_format.h"
+#endif
 #include "simulator/cache_simulator.h"
+#include "simulator/cache_hawkeye.h"
+#include "simulator/cache_lru.h"
+#include "simulator/cache_rrip.h"
+#include "simulator/flat_histogram.h"
+#include "simulator/prefetcher.h"
+#include "simulator/sampler.h"
+#include "simulator/walk_latency.h"
+#include "simulator/page_table_builder.h"
 #include "../common/memref.h"
+#ifdef UNIX
+#    include <sys/stat.h>
+#endif
 
 static cache_simulator_knobs_t
 make_test_knobs()
@@ -51,22 +74,37 @@ make_test_knobs()
     return knobs;
 }
 
+// A read of addr, identity mapped by a successful 4KB page walk: the
+// simulator caches the physical address the walk ends at.
+static memref_t
+make_test_read(addr_t addr)
+{
+    memref_t ref;
+    memset(&ref, 0, sizeof(ref));
+    ref.data.type = TRACE_TYPE_READ;
+    ref.data.size = 8;
+    ref.data.addr = addr;
+    ref.data.pgtable_results.paddr = addr;
+    ref.data.pgtable_results.success = 1;
+    ref.data.pgtable_results.num_steps = 4;
+    for (int level = 0; level < 4; level++)
+        ref.data.pgtable_results.steps[level] = 0x100000 * (level + 1);
+    return ref;
+}
+
 void
 unit_test_warmup_fraction()
 {
     cache_simulator_knobs_t knobs = make_test_knobs();
     knobs.warmup_fraction = 0.5;
-    cache_simulator_t cache_sim(knobs);
+    cache_simulator_t cache_sim(knobs, tlb_simulator_knobs_t());
 
     // Feed it some memrefs, warmup fraction is set to 0.5 where the capacity at
     // each level is 32 lines each. The first 16 memrefs warm up the cache and
     // the 17th allows us to check for the warmup_fraction.
     std::string error;
     for (int i = 0; i < 16 + 1; i++) {
-        memref_t ref;
-        ref.data.type = TRACE_TYPE_READ;
-        ref.data.size = 8;
-        ref.data.addr = i * 128;
+        memref_t ref = make_test_read(i * 128);
         if (!cache_sim.process_memref(ref)) {
             std::cerr << "drcachesim unit_test_warmup_fraction failed: "
                       << cache_sim.get_error_string() << "\n";
@@ -85,17 +123,14 @@ unit_test_warmup_refs()
 {
     cache_simulator_knobs_t knobs = make_test_knobs();
     knobs.warmup_refs = 16;
-    cache_simulator_t cache_sim(knobs);
+    cache_simulator_t cache_sim(knobs, tlb_simulator_knobs_t());
 
     // Feed it some memrefs, warmup refs = 16 where the capacity at
     // each level is 32 lines each. The first 16 memrefs warm up the cache and
     // the 17th allows us to check.
     std::string error;
     for (int i = 0; i < 16 + 1; i++) {
-        memref_t ref;
-        ref.data.type = TRACE_TYPE_READ;
-        ref.data.size = 8;
-        ref.data.addr = i * 128;
+        memref_t ref = make_test_read(i * 128);
         if (!cache_sim.process_memref(ref)) {
             std::cerr << "drcachesim unit_test_warmup_fraction failed: "
                       << cache_sim.get_error_string() << "\n";
@@ -114,14 +149,11 @@ unit_test_sim_refs()
 {
     cache_simulator_knobs_t knobs = make_test_knobs();
     knobs.sim_refs = 8;
-    cache_simulator_t cache_sim(knobs);
+    cache_simulator_t cache_sim(knobs, tlb_simulator_knobs_t());
 
     std::string error;
     for (int i = 0; i < 16; i++) {
-        memref_t ref;
-        ref.data.type = TRACE_TYPE_READ;
-        ref.data.size = 8;
-        ref.data.addr = i * 128;
+        memref_t ref = make_test_read(i * 128);
         if (!cache_sim.process_memref(ref)) {
             std::cerr << "drcachesim unit_test_sim_refs failed: "
                       << cache_sim.get_error_string() << "\n";
@@ -135,11 +167,1388 @@ unit_test_sim_refs()
     }
 }
 
+// Parses a sweep file holding text into configs.
+static bool
+read_sweep(const std::string &text, const cache_simulator_knobs_t &knobs,
+           std::vector<sweep_config_t> &configs)
+{
+    const std::string path = "drcachesim_unit_test_sweep.txt";
+    std::ofstream out(path);
+    out << text;
+    out.close();
+    config_reader_t config_reader;
+    bool res = config_reader.configure_sweep(path, knobs, tlb_simulator_knobs_t(), configs);
+    remove(path.c_str());
+    return res;
+}
+
+void
+unit_test_sweep_file()
+{
+    cache_simulator_knobs_t knobs = make_test_knobs();
+    std::vector<sweep_config_t> configs;
+    if (!read_sweep("// Two points.\n"
+                    "base {\n"
+                    "}\n"
+                    "small_tlb {\n"
+                    "    TLB_L1D_entries 16\n"
+                    "    TLB_L1D_assoc 4\n"
+                    "    L2_size 512K\n"
+                    "    // Page table walks skip the L1.\n"
+                    "    mmu_to_l2 true\n"
+                    "    L2_replace LRU\n"
+                    "}\n",
+                    knobs, configs) ||
+        configs.size() != 2) {
+        std::cerr << "drcachesim unit_test_sweep_file failed to parse\n";
+        exit(1);
+    }
+    // Each configuration starts from the base knobs and only changes its own.
+    const sweep_config_t &base = configs[0], &small = configs[1];
+    tlb_simulator_knobs_t tlb_knobs;
+    if (base.name != "base" || base.knobs.config_name != "base" ||
+        base.knobs.L1D_size != knobs.L1D_size || base.knobs.mmu_to_l2 != knobs.mmu_to_l2 ||
+        base.tlb_knobs.TLB_L1D_entries != tlb_knobs.TLB_L1D_entries) {
+        std::cerr << "drcachesim unit_test_sweep_file failed: base knobs\n";
+        exit(1);
+    }
+    if (small.name != "small_tlb" || small.knobs.config_name != "small_tlb" ||
+        small.tlb_knobs.TLB_L1D_entries != 16 || small.tlb_knobs.TLB_L1D_assoc != 4 ||
+        small.knobs.L2_size != 512 * 1024 || !small.knobs.mmu_to_l2 ||
+        small.knobs.L2_replace != "LRU" || small.knobs.L1D_size != knobs.L1D_size ||
+        small.tlb_knobs.TLB_L1I_entries != tlb_knobs.TLB_L1I_entries) {
+        std::cerr << "drcachesim unit_test_sweep_file failed: overridden knobs\n";
+        exit(1);
+    }
+    // Repeated names, unknown knobs, sizes that are not powers of 2 and
+    // unterminated blocks are refused.
+    const char *bad[] = {
+        "a {\n}\na {\n}\n",
+        "a {\n    no_such_knob 1\n}\n",
+        "a {\n    L2_size 384K\n}\n",
+        "a {\n    mmu_to_l2 true\n",
+    };
+    for (const char *text : bad) {
+        configs.clear();
+        if (read_sweep(text, knobs, configs)) {
+            std::cerr << "drcachesim unit_test_sweep_file failed: accepted " << text
+                      << "\n";
+            exit(1);
+        }
+    }
+}
+
+// Radix records of a made-up trace: every fifth is an instruction fetch and
+// every seventh walk ends at a 2MB page.
+static std::vector<radix_trans_info>
+make_radix_records(int num_records)
+{
+    std::vector<radix_trans_info> records(num_records);
+    for (int i = 0; i < num_records; i++) {
+        radix_trans_info &rec = records[i];
+        memset(&rec, 0, sizeof(rec));
+        rec.header = i % 5 == 0 ? BIN_RECORD_TYPE_FEC : BIN_RECORD_TYPE_MEM;
+        rec.access_rw = i % 3 != 0;
+        rec.access_sz = 8;
+        rec.vaddr = 0x7f0000000000ULL + (addr_t)(i % 997) * 4160;
+        rec.paddr = 0x100000000ULL + (addr_t)i * 64;
+        int levels = i % 7 == 0 ? PAGE_TABLE_LEAVES - 1 : PAGE_TABLE_LEAVES;
+        for (int j = 0; j < levels; j++)
+            rec.leaves[j] = 0x200000ULL * (j + 1) + (rec.vaddr >> (39 - 9 * j)) * 8;
+    }
+    return records;
+}
+
+static void
+write_records(const std::string &path, const std::vector<radix_trans_info> &records)
+{
+    FILE *file = fopen(path.c_str(), "wb");
+    if (file == NULL ||
+        fwrite(records.data(), sizeof(records[0]), records.size(), file) !=
+            records.size() ||
+        fclose(file) != 0) {
+        std::cerr << "drcachesim unit tests failed to write " << path << "\n";
+        exit(1);
+    }
+}
+
+// Folds the references it is given into a checksum and fails on the one
+// numbered fail_at, if not 0.
+class digest_tool_t : public analysis_tool_t {
+public:
+    explicit digest_tool_t(uint64_t fail_at = 0)
+        : count(0)
+        , digest(0)
+        , fail_at(fail_at)
+    {
+    }
+    virtual bool
+    process_memref(const memref_t &memref)
+    {
+        if (++count == fail_at) {
+            error_string = "failed on purpose";
+            return false;
+        }
+        digest = (digest ^ memref.data.type ^ (memref.data.size << 8) ^
+                  (memref.data.addr << 16)) *
+            0x100000001b3ULL;
+        return true;
+    }
+    virtual bool
+    print_results()
+    {
+        return true;
+    }
+    uint64_t count;
+    uint64_t digest;
+
+private:
+    uint64_t fail_at;
+};
+
+// Reads a QEMU radix trace into tools.
+class qemu_test_analyzer_t : public analyzer_t {
+public:
+    qemu_test_analyzer_t(const std::string &path, analysis_tool_t **tools_,
+                         int num_tools_)
+    {
+        trace_iter = new qemu_file_reader_t(path.c_str(), 0, RADIX, -1, -1);
+        trace_end = new qemu_file_reader_t();
+        tools = tools_;
+        num_tools = num_tools_;
+    }
+};
+
+void
+unit_test_pipelined_analyzer()
+{
+    const std::string path = "drcachesim_unit_test_pipeline.bin";
+    write_records(path, make_radix_records(1000));
+    digest_tool_t serial;
+    analysis_tool_t *serial_tools[] = { &serial };
+    qemu_test_analyzer_t serial_analyzer(path, serial_tools, 1);
+    if (!serial_analyzer.run() || serial.count == 0) {
+        std::cerr << "drcachesim unit_test_pipelined_analyzer failed: serial run\n";
+        exit(1);
+    }
+    // Each tool of a pipelined run sees every reference in trace order,
+    // including with a last batch that is only partly filled.
+    digest_tool_t first, second;
+    analysis_tool_t *tools[] = { &first, &second };
+    qemu_test_analyzer_t analyzer(path, tools, 2);
+    analyzer.set_pipeline(7, 3);
+    if (!analyzer.run() || first.count != serial.count ||
+        first.digest != serial.digest || second.count != serial.count ||
+        second.digest != serial.digest) {
+        std::cerr << "drcachesim unit_test_pipelined_analyzer failed: "
+                     "references differ\n";
+        exit(1);
+    }
+    // A tool's error stops the run and is reported.
+    digest_tool_t failing(100), other;
+    analysis_tool_t *failing_tools[] = { &other, &failing };
+    qemu_test_analyzer_t failing_analyzer(path, failing_tools, 2);
+    failing_analyzer.set_pipeline(16, 2);
+    if (failing_analyzer.run() ||
+        failing_analyzer.get_error_string() != "failed on purpose") {
+        std::cerr << "drcachesim unit_test_pipelined_analyzer failed: error\n";
+        exit(1);
+    }
+    remove(path.c_str());
+}
+
+void
+unit_test_qemu_reader()
+{
+#ifdef UNIX
+    // A regular file is mapped; a pipe is read through the buffer, which takes
+    // more than one refill for this many records.
+    const std::string path = "drcachesim_unit_test_reader.bin";
+    const std::string pipe_path = "drcachesim_unit_test_reader.fifo";
+    std::vector<radix_trans_info> records = make_radix_records(70000);
+    write_records(path, records);
+    digest_tool_t mapped;
+    analysis_tool_t *mapped_tools[] = { &mapped };
+    qemu_test_analyzer_t mapped_analyzer(path, mapped_tools, 1);
+    if (!mapped_analyzer.run() || mapped.count == 0) {
+        std::cerr << "drcachesim unit_test_qemu_reader failed: mapped read\n";
+        exit(1);
+    }
+    remove(pipe_path.c_str());
+    if (mkfifo(pipe_path.c_str(), 0600) != 0) {
+        std::cerr << "drcachesim unit_test_qemu_reader failed to create a pipe\n";
+        exit(1);
+    }
+    std::thread writer([&] { write_records(pipe_path, records); });
+    digest_tool_t buffered;
+    analysis_tool_t *buffered_tools[] = { &buffered };
+    qemu_test_analyzer_t buffered_analyzer(pipe_path, buffered_tools, 1);
+    bool ok = buffered_analyzer.run();
+    writer.join();
+    if (!ok || buffered.count != mapped.count || buffered.digest != mapped.digest) {
+        std::cerr << "drcachesim unit_test_qemu_reader failed: buffered read differs\n";
+        exit(1);
+    }
+    remove(pipe_path.c_str());
+    remove(path.c_str());
+#endif
+}
+
+#ifdef HAS_ZLIB
+// Writes records to path as a container of chunk_records records per chunk,
+// as drqemutrace_convert does.
+static void
+write_container(const std::string &path, const std::vector<radix_trans_info> &records,
+                size_t chunk_records)
+{
+    qemu_trace_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, QEMU_TRACE_MAGIC, QEMU_TRACE_MAGIC_SIZE);
+    header.version = QEMU_TRACE_VERSION;
+    header.arch = RADIX;
+    header.record_size = sizeof(radix_trans_info);
+    header.chunk_records = (uint32_t)chunk_records;
+    FILE *file = fopen(path.c_str(), "wb");
+    if (file == NULL || fwrite(&header, sizeof(header), 1, file) != 1) {
+        std::cerr << "drcachesim unit tests failed to write " << path << "\n";
+        exit(1);
+    }
+    uint64_t offset = sizeof(header);
+    std::vector<qemu_trace_chunk_t> index;
+    for (size_t first = 0; first < records.size(); first += chunk_records) {
+        size_t num = std::min(chunk_records, records.size() - first);
+        std::vector<uint8_t> compressed;
+        qemu_trace_chunk_t chunk;
+        memset(&chunk, 0, sizeof(chunk));
+        if (!qemu_trace_compress_chunk(RADIX, (const uint8_t *)&records[first], num, 6,
+                                       compressed, chunk.encoded_size) ||
+            fwrite(compressed.data(), 1, compressed.size(), file) != compressed.size()) {
+            std::cerr << "drcachesim unit tests failed to write " << path << "\n";
+            exit(1);
+        }
+        chunk.offset = offset;
+        chunk.first_record = first;
+        chunk.compressed_size = (uint32_t)compressed.size();
+        chunk.num_records = (uint32_t)num;
+        chunk.next_header = first + num < records.size() ? records[first + num].header : 0;
+        index.push_back(chunk);
+        offset += compressed.size();
+    }
+    header.num_records = records.size();
+    header.num_chunks = index.size();
+    header.index_offset = offset;
+    if (fwrite(index.data(), sizeof(qemu_trace_chunk_t), index.size(), file) !=
+            index.size() ||
+        fseek(file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, file) != 1 ||
+        fclose(file) != 0) {
+        std::cerr << "drcachesim unit tests failed to write " << path << "\n";
+        exit(1);
+    }
+}
+
+// Returns the number of records of path read back through a container from
+// record first on that match records, stopping at the first mismatch.
+static size_t
+container_matches(const std::string &path, const std::vector<radix_trans_info> &records,
+                  size_t first, bool *failed)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    qemu_trace_container_t container(file, RADIX);
+    std::string error;
+    if (file == NULL || !container.open(error) || !container.seek(first)) {
+        std::cerr << "drcachesim unit_test_qemu_container failed to open: " << error
+                  << "\n";
+        exit(1);
+    }
+    size_t i = first;
+    uint8_t next_header;
+    const uint8_t *record;
+    for (; (record = container.next_record(&next_header)) != NULL; i++) {
+        uint8_t expect_next = i + 1 < records.size() ? records[i + 1].header : 0;
+        if (i >= records.size() || memcmp(record, &records[i], sizeof(records[i])) != 0 ||
+            next_header != expect_next)
+            break;
+    }
+    *failed = container.failed();
+    fclose(file);
+    return i - first;
+}
+
+void
+unit_test_qemu_container()
+{
+    const std::string path = "drcachesim_unit_test_container.qpw";
+    const std::string raw_path = "drcachesim_unit_test_container.bin";
+    const size_t chunk_records = 1000;
+    std::vector<radix_trans_info> records = make_radix_records(5500);
+    write_container(path, records, chunk_records);
+    // Every record comes back, also after seeking into a chunk, to the start
+    // of one or past the end.
+    const size_t seeks[] = { 0, 1, 999, 1000, 2345, 5499, 5500 };
+    bool failed;
+    for (size_t first : seeks) {
+        if (container_matches(path, records, first, &failed) != records.size() - first ||
+            failed) {
+            std::cerr << "drcachesim unit_test_qemu_container failed: records from "
+                      << first << "\n";
+            exit(1);
+        }
+    }
+    // The reader gives the same references from the container as from the raw
+    // records.
+    write_records(raw_path, records);
+    digest_tool_t raw, packed;
+    analysis_tool_t *raw_tools[] = { &raw };
+    analysis_tool_t *packed_tools[] = { &packed };
+    qemu_test_analyzer_t raw_analyzer(raw_path, raw_tools, 1);
+    qemu_test_analyzer_t packed_analyzer(path, packed_tools, 1);
+    if (!raw_analyzer.run() || !packed_analyzer.run() || packed.count != raw.count ||
+        packed.digest != raw.digest) {
+        std::cerr << "drcachesim unit_test_qemu_container failed: reader differs\n";
+        exit(1);
+    }
+    // A corrupt chunk ends the records with an error rather than quietly, after
+    // the chunks before it.
+    FILE *file = fopen(path.c_str(), "r+b");
+    qemu_trace_header_t header;
+    qemu_trace_chunk_t chunk;
+    uint8_t garbage[16];
+    memset(garbage, 0xa5, sizeof(garbage));
+    if (file == NULL || fread(&header, sizeof(header), 1, file) != 1 ||
+        fseek(file, header.index_offset + 2 * sizeof(chunk), SEEK_SET) != 0 ||
+        fread(&chunk, sizeof(chunk), 1, file) != 1 ||
+        fseek(file, chunk.offset + chunk.compressed_size / 2, SEEK_SET) != 0 ||
+        fwrite(garbage, sizeof(garbage), 1, file) != 1 || fclose(file) != 0) {
+        std::cerr << "drcachesim unit_test_qemu_container failed to corrupt\n";
+        exit(1);
+    }
+    if (container_matches(path, records, 0, &failed) != 2 * chunk_records || !failed) {
+        std::cerr << "drcachesim unit_test_qemu_container failed: corrupt chunk\n";
+        exit(1);
+    }
+    // An index that does not fit in the file is refused.
+    header.num_chunks = 1ULL << 40;
+    file = fopen(path.c_str(), "r+b");
+    if (file == NULL || fwrite(&header, sizeof(header), 1, file) != 1 ||
+        fclose(file) != 0) {
+        std::cerr << "drcachesim unit_test_qemu_container failed to corrupt\n";
+        exit(1);
+    }
+    file = fopen(path.c_str(), "rb");
+    qemu_trace_container_t container(file, RADIX);
+    std::string error;
+    if (file == NULL || container.open(error)) {
+        std::cerr << "drcachesim unit_test_qemu_container failed: oversized index\n";
+        exit(1);
+    }
+    fclose(file);
+    remove(path.c_str());
+    remove(raw_path.c_str());
+}
+#endif
+
+struct mixed_hash_t {
+    size_t
+    operator()(uint64_t key) const
+    {
+        return flat_histogram_mix(key);
+    }
+};
+
+// Sends every key to the same slot, so that each lookup probes linearly.
+struct colliding_hash_t {
+    size_t
+    operator()(uint64_t key) const
+    {
+        return 5;
+    }
+};
+
+// Adds keys to a flat_histogram_t and checks it against a std::map.
+template <typename hash_t>
+static void
+check_flat_histogram(int num_keys, int num_adds)
+{
+    flat_histogram_t<uint64_t, hash_t> hist;
+    std::map<uint64_t, uint64_t> expect;
+    uint64_t state = 7;
+    for (int i = 0; i < num_adds; i++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        // Key 0 is a key like any other; only a count of 0 marks a free slot.
+        uint64_t key = (state >> 33) % num_keys;
+        uint64_t count = i % 4 == 0 ? 3 : 1;
+        hist.add(key, count);
+        expect[key] += count;
+    }
+    std::vector<std::pair<uint64_t, uint64_t>> entries = hist.entries();
+    std::sort(entries.begin(), entries.end());
+    if (hist.size() != expect.size() ||
+        entries != std::vector<std::pair<uint64_t, uint64_t>>(expect.begin(),
+                                                               expect.end())) {
+        std::cerr << "drcachesim unit_test_flat_histogram failed: " << num_keys
+                  << " keys\n";
+        exit(1);
+    }
+    hist.clear();
+    hist.add(num_keys);
+    entries = hist.entries();
+    if (hist.size() != 1 || entries.size() != 1 || entries[0].first != (uint64_t)num_keys ||
+        entries[0].second != 1) {
+        std::cerr << "drcachesim unit_test_flat_histogram failed: clear\n";
+        exit(1);
+    }
+}
+
+void
+unit_test_flat_histogram()
+{
+    // Few keys stay in the initial table; many make it grow several times.
+    check_flat_histogram<mixed_hash_t>(5, 1000);
+    check_flat_histogram<mixed_hash_t>(5000, 50000);
+    check_flat_histogram<colliding_hash_t>(300, 3000);
+}
+
+void
+unit_test_walk_latency()
+{
+    typedef std::vector<cache_result_t> walk_t;
+    walk_latency_t latency;
+    std::string error;
+    // The defaults: memory 200, L1 4, L2 14, LLC 54, PWC 1, hash 2 and CWCs 4.
+    if (!latency.init("", true, false, error)) {
+        std::cerr << "drcachesim unit_test_walk_latency failed to init: " << error
+                  << "\n";
+        exit(1);
+    }
+    // A PWC hit at level i of a radix walk pays for the 3 - i PWCs probed.
+    if (latency.radix_walk(walk_t { ZERO, PWC, FOUND_L2, NOT_FOUND }) != 2 + 14 + 200 ||
+        latency.radix_walk(walk_t { PWC, ZERO, ZERO, FOUND_L1 }) != 3 + 4 ||
+        latency.radix_walk(walk_t { FOUND_L1, FOUND_L1, FOUND_L1, FOUND_LLC }) !=
+            3 * 4 + 54 ||
+        latency.serial_walk(walk_t { PWC, FOUND_L1, FOUND_LLC }) != 1 + 4 + 54) {
+        std::cerr << "drcachesim unit_test_walk_latency failed: radix walk\n";
+        exit(1);
+    }
+    // ECPT ways are probed in parallel, after the hash and the CWCs.
+    walk_t ways { FOUND_L1, FOUND_LLC, NOT_FOUND };
+    if (latency.ecpt_walk(ways, true, 1) != 54 + 2 + 4 ||
+        latency.ecpt_walk(ways, false, 1) != 200 + 2 + 4 ||
+        latency.ecpt_walk(ways, true, 3) != 200 + 2 + 4 ||
+        latency.cwt_backfill(walk_t { FOUND_L1, FOUND_L2 }, walk_t { FOUND_LLC }) != 54) {
+        std::cerr << "drcachesim unit_test_walk_latency failed: ECPT walk\n";
+        exit(1);
+    }
+    // Overridden latencies, serial CWCs and a back-fill overlapped with the walk.
+    walk_latency_t custom;
+    if (!custom.init("L1=5,,MEMORY=100,HASH=0,PUD_CWC=3,PMD_CWC=6", false, true, error) ||
+        custom.radix_walk(walk_t { FOUND_L1, NOT_FOUND }) != 105 ||
+        custom.ecpt_walk(ways, false, 0) != 100 + 0 + 3 + 6 ||
+        custom.cwt_backfill(walk_t { NOT_FOUND }, walk_t {}) != 0) {
+        std::cerr << "drcachesim unit_test_walk_latency failed: custom latencies "
+                  << error << "\n";
+        exit(1);
+    }
+    const char *bad[] = { "L1", "L1=", "L1=4x", "L4=10" };
+    for (const char *list : bad) {
+        walk_latency_t refused;
+        if (refused.init(list, true, true, error)) {
+            std::cerr << "drcachesim unit_test_walk_latency failed: accepted " << list
+                      << "\n";
+            exit(1);
+        }
+    }
+}
+
+// Exposes the hits and misses of every cache and data TLB once the pending
+// epoch is simulated.
+class epoch_cache_simulator_t : public cache_simulator_t {
+public:
+    epoch_cache_simulator_t(const cache_simulator_knobs_t &knobs,
+                            const tlb_simulator_knobs_t &tlb_knobs)
+        : cache_simulator_t(knobs, tlb_knobs)
+    {
+    }
+    std::map<std::string, std::pair<int_least64_t, int_least64_t>>
+    counts()
+    {
+        drain_epoch();
+        std::map<std::string, std::pair<int_least64_t, int_least64_t>> res;
+        for (auto &it : all_caches) {
+            caching_device_stats_t *stats = it.second->get_stats();
+            res[it.first] = std::make_pair(stats->get_hits(), stats->get_misses());
+        }
+        for (unsigned int core = 0; core < knobs.num_cores; core++) {
+            caching_device_stats_t *stats = tlb_sim->get_dtlb(core)->get_stats();
+            res["DTLB" + std::to_string(core)] =
+                std::make_pair(stats->get_hits(), stats->get_misses());
+        }
+        return res;
+    }
+};
+
+// Runs four cpus sharing a set of lines, with instruction fetches and a data
+// flush, on sim_threads threads, and returns the counts.
+static std::map<std::string, std::pair<int_least64_t, int_least64_t>>
+run_epochs(unsigned int sim_threads, uint64_t epoch_refs)
+{
+    cache_simulator_knobs_t knobs = make_test_knobs();
+    knobs.num_cores = 4;
+    knobs.L1I_size = 4 * 64;
+    knobs.L1D_size = 4 * 64;
+    knobs.L1I_assoc = 4;
+    knobs.L1D_assoc = 4;
+    knobs.L2_size = 8 * 64;
+    knobs.L2_assoc = 8;
+    knobs.LL_size = 64 * 64;
+    knobs.LL_assoc = 16;
+    knobs.core_from_access_cpu = true;
+    knobs.sim_threads = sim_threads;
+    knobs.epoch_refs = epoch_refs;
+    tlb_simulator_knobs_t tlb_knobs;
+    tlb_knobs.num_cores = 4;
+    tlb_knobs.core_from_access_cpu = true;
+    tlb_knobs.TLB_L1D_entries = 4;
+    tlb_knobs.TLB_L1D_assoc = 4;
+    epoch_cache_simulator_t sim(knobs, tlb_knobs);
+    if (!sim) {
+        std::cerr << "drcachesim unit_test_epochs failed to init: "
+                  << sim.get_error_string() << "\n";
+        exit(1);
+    }
+    for (int i = 0; i < 3000; i++) {
+        addr_t addr = (addr_t)((i * 37) % 256) * 64;
+        memref_t ref;
+        memset(&ref, 0, sizeof(ref));
+        _memref_pgtable_results *results = &ref.data.pgtable_results;
+        if (i % 5 == 0) {
+            ref.instr.type = TRACE_TYPE_INSTR;
+            ref.instr.size = 4;
+            ref.instr.addr = 0x400000 + addr;
+            results = &ref.instr.pgtable_results;
+        } else {
+            // A flush halfway through drains the epoch.
+            ref.data.type = i == 1501
+                ? TRACE_TYPE_DATA_FLUSH
+                : (i % 3 == 0 ? TRACE_TYPE_WRITE : TRACE_TYPE_READ);
+            ref.data.size = i == 1501 ? 64 : 8;
+            ref.data.addr = addr;
+        }
+        results->paddr = 0x400000 * (i % 5 == 0) + addr;
+        results->success = 1;
+        results->cpu = (i / 3) % 4;
+        results->num_steps = 4;
+        for (int level = 0; level < 4; level++) {
+            results->steps[level] =
+                0x1000000 * (level + 1) + ((0x400000 * (i % 5 == 0) + addr) >> 12) * 8;
+        }
+        if (!sim.process_memref(ref)) {
+            std::cerr << "drcachesim unit_test_epochs failed: " << sim.get_error_string()
+                      << "\n";
+            exit(1);
+        }
+    }
+    return sim.counts();
+}
+
+void
+unit_test_epochs()
+{
+    // Epochs give the same results on any number of threads, one included.
+    std::map<std::string, std::pair<int_least64_t, int_least64_t>> one = run_epochs(1, 64);
+    std::map<std::string, std::pair<int_least64_t, int_least64_t>> four =
+        run_epochs(4, 64);
+    if (one != four || one["LLC"].first == 0 || one["LLC"].second == 0) {
+        std::cerr << "drcachesim unit_test_epochs failed: counts differ\n";
+        exit(1);
+    }
+}
+
+// Exposes the per-page-size data TLBs of core 0 and their statistics.
+class page_size_tlb_simulator_t : public tlb_simulator_t {
+public:
+    page_size_tlb_simulator_t(const tlb_simulator_knobs_t &knobs)
+        : tlb_simulator_t(knobs)
+    {
+    }
+    tlb_t *
+    data_tlb(tlb_page_size_t size) const
+    {
+        return size_tlbs[TLB_L1D][size][0];
+    }
+    caching_device_stats_t *
+    data_stats(tlb_page_size_t size) const
+    {
+        return size_stats[TLB_L1D][size][0];
+    }
+};
+
+static bool
+lookup_data(page_size_tlb_simulator_t &sim, addr_t addr, tlb_page_size_t size)
+{
+    memref_t ref;
+    memset(&ref, 0, sizeof(ref));
+    ref.data.type = TRACE_TYPE_READ;
+    ref.data.size = 8;
+    ref.data.addr = addr;
+    return sim.lookup_tlb(ref, 0, size);
+}
+
+static void
+check_tlb_page_sizes(unsigned int l1d_2m_entries)
+{
+    tlb_simulator_knobs_t knobs;
+    knobs.num_cores = 1;
+    knobs.TLB_page_sizes = true;
+    knobs.TLB_L1D_2M_entries = l1d_2m_entries;
+    page_size_tlb_simulator_t sim(knobs);
+    if (!sim) {
+        std::cerr << "drcachesim unit_test_tlb_page_sizes failed to init: "
+                  << sim.get_error_string() << "\n";
+        exit(1);
+    }
+    // With no 2MB entries the 2MB translations share the 4KB array.
+    bool shared = l1d_2m_entries == 0;
+    if ((sim.data_tlb(TLB_PAGE_2MB) == sim.get_dtlb(0)) != shared ||
+        sim.data_tlb(TLB_PAGE_4KB) != sim.get_dtlb(0)) {
+        std::cerr << "drcachesim unit_test_tlb_page_sizes failed: arrays\n";
+        exit(1);
+    }
+    // Two 4KB pages of one 2MB page share its translation, which does not
+    // stand for either 4KB one.
+    if (lookup_data(sim, 0x200000, TLB_PAGE_2MB) ||
+        !lookup_data(sim, 0x3ff000, TLB_PAGE_2MB) ||
+        lookup_data(sim, 0x3ff000, TLB_PAGE_4KB) ||
+        !lookup_data(sim, 0x3ff008, TLB_PAGE_4KB) ||
+        lookup_data(sim, 0x200000, TLB_PAGE_4KB) ||
+        !lookup_data(sim, 0x201000, TLB_PAGE_2MB)) {
+        std::cerr << "drcachesim unit_test_tlb_page_sizes failed: lookups with "
+                  << l1d_2m_entries << " 2MB entries\n";
+        exit(1);
+    }
+    caching_device_stats_t *stats_2m = sim.data_stats(TLB_PAGE_2MB);
+    caching_device_stats_t *stats_4k = sim.data_stats(TLB_PAGE_4KB);
+    if (stats_2m->get_hits() != 2 || stats_2m->get_misses() != 1 ||
+        stats_4k->get_hits() != 1 || stats_4k->get_misses() != 2) {
+        std::cerr << "drcachesim unit_test_tlb_page_sizes failed: stats with "
+                  << l1d_2m_entries << " 2MB entries\n";
+        exit(1);
+    }
+}
+
+void
+unit_test_tlb_page_sizes()
+{
+    check_tlb_page_sizes(32);
+    check_tlb_page_sizes(0);
+    // A base page of 2MB and an array that is not a power of 2 are refused.
+    tlb_simulator_knobs_t large_pages;
+    large_pages.TLB_page_sizes = true;
+    large_pages.page_size = 2 * 1024 * 1024;
+    tlb_simulator_knobs_t odd_array;
+    odd_array.TLB_page_sizes = true;
+    odd_array.TLB_L1D_2M_entries = 24;
+    tlb_simulator_t large_sim(large_pages);
+    tlb_simulator_t odd_sim(odd_array);
+    bool refused = !large_sim && !odd_sim;
+    if (!refused) {
+        std::cerr << "drcachesim unit_test_tlb_page_sizes failed: accepted bad knobs\n";
+        exit(1);
+    }
+}
+
+// Whether a cache_simulator_t accepts the walk cache knobs of knobs.
+static bool
+walk_caches_accepted(const cache_simulator_knobs_t &knobs)
+{
+    cache_simulator_t sim(knobs, tlb_simulator_knobs_t());
+    bool refused = !sim;
+    return !refused;
+}
+
+void
+unit_test_walk_cache_knobs()
+{
+    cache_simulator_knobs_t knobs = make_test_knobs();
+    std::vector<sweep_config_t> configs;
+    if (!read_sweep("small_walk_caches {\n"
+                    "    PWC_PMD_entries 64\n"
+                    "    PWC_PMD_assoc 4\n"
+                    "    PWC_PGD_replace LRU\n"
+                    "    CWC_PUD_entries 8\n"
+                    "    CWC_PMD_assoc 1\n"
+                    "    // Way counts need not be powers of 2.\n"
+                    "    ECPT_4K_ways 5\n"
+                    "    ECPT_1G_ways 0\n"
+                    "    CWT_2M_ways 3\n"
+                    "}\n",
+                    knobs, configs) ||
+        configs.size() != 1) {
+        std::cerr << "drcachesim unit_test_walk_cache_knobs failed to parse\n";
+        exit(1);
+    }
+    const cache_simulator_knobs_t &small = configs[0].knobs;
+    if (small.PWC_PMD_entries != 64 || small.PWC_PMD_assoc != 4 ||
+        small.PWC_PGD_replace != "LRU" || small.CWC_PUD_entries != 8 ||
+        small.CWC_PMD_assoc != 1 || small.ECPT_4K_ways != 5 || small.ECPT_1G_ways != 0 ||
+        small.CWT_2M_ways != 3 || small.PWC_PUD_entries != knobs.PWC_PUD_entries ||
+        small.ECPT_2M_ways != knobs.ECPT_2M_ways) {
+        std::cerr << "drcachesim unit_test_walk_cache_knobs failed: parsed knobs\n";
+        exit(1);
+    }
+    // Cache geometry must be a power of 2 and way counts cannot be negative.
+    const char *bad[] = {
+        "a {\n    PWC_PUD_entries 24\n}\n",
+        "a {\n    CWC_PMD_assoc 0\n}\n",
+        "a {\n    ECPT_2M_ways -1\n}\n",
+    };
+    for (const char *text : bad) {
+        configs.clear();
+        if (read_sweep(text, knobs, configs)) {
+            std::cerr << "drcachesim unit_test_walk_cache_knobs failed: accepted "
+                      << text << "\n";
+            exit(1);
+        }
+    }
+
+    // The simulator builds the walk caches of either scheme from the knobs.
+    cache_simulator_knobs_t radix = knobs;
+    radix.PWC_PMD_entries = 64;
+    radix.PWC_PMD_assoc = 4;
+    cache_simulator_knobs_t ecpt = knobs;
+    ecpt.arch = ECPT;
+    ecpt.CWC_PUD_entries = 8;
+    ecpt.ECPT_4K_ways = 4;
+    ecpt.ECPT_2M_ways = 2;
+    if (!walk_caches_accepted(radix) || !walk_caches_accepted(ecpt)) {
+        std::cerr << "drcachesim unit_test_walk_cache_knobs failed: refused knobs\n";
+        exit(1);
+    }
+    // A PWC smaller than its associativity, an ECPT without 4KB ways and more
+    // ECPT or CWT ways than a trace record holds are refused.
+    cache_simulator_knobs_t small_pwc = radix;
+    small_pwc.PWC_PMD_entries = 2;
+    cache_simulator_knobs_t no_ways = ecpt;
+    no_ways.ECPT_4K_ways = 0;
+    cache_simulator_knobs_t many_ecpt_ways = ecpt;
+    many_ecpt_ways.ECPT_1G_ways = 1;
+    cache_simulator_knobs_t many_ways = ecpt;
+    many_ways.CWT_2M_ways = MAX_AUX_INFO;
+    many_ways.CWT_1G_ways = 1;
+    if (walk_caches_accepted(small_pwc) || walk_caches_accepted(no_ways) ||
+        walk_caches_accepted(many_ecpt_ways) || walk_caches_accepted(many_ways)) {
+        std::cerr << "drcachesim unit_test_walk_cache_knobs failed: accepted bad "
+                     "knobs\n";
+        exit(1);
+    }
+}
+
+// Loops numlines lines through one cache set loops times and returns the hits.
+static int_least64_t
+loop_through_set(cache_t *cache, int assoc, int numlines, int loops)
+{
+    cache_stats_t *stats = new cache_stats_t("", false);
+    if (!cache->init(assoc, 64, assoc * 64, NULL, stats)) {
+        std::cerr << "drcachesim unit_test_replacement_policies failed to init\n";
+        exit(1);
+    }
+    for (int i = 0; i < loops * numlines; i++) {
+        memref_t ref;
+        memset(&ref, 0, sizeof(ref));
+        ref.data.type = TRACE_TYPE_READ;
+        ref.data.size = 8;
+        ref.data.addr = (i % numlines) * 64;
+        cache->request(ref);
+    }
+    int_least64_t hits = stats->get_hits();
+    delete cache;
+    delete stats;
+    return hits;
+}
+
+void
+unit_test_replacement_policies()
+{
+    // A working set that fits is kept by every policy.
+    cache_t *fitting[] = { new cache_lru_t, new policy_cache_t<srrip_policy_t>,
+                           new policy_cache_t<brrip_policy_t>,
+                           new policy_cache_t<drrip_policy_t>,
+                           new policy_cache_t<ship_policy_t>,
+                           new policy_cache_t<hawkeye_policy_t> };
+    for (cache_t *cache : fitting) {
+        if (loop_through_set(cache, 4, 4, 10) != 4 * 9) {
+            std::cerr << "drcachesim unit_test_replacement_policies failed: "
+                      << "fitting working set not kept\n";
+            exit(1);
+        }
+    }
+    // A loop one line larger than the set thrashes SRRIP, while the mostly
+    // distant insertion of BRRIP keeps part of it.
+    if (loop_through_set(new policy_cache_t<srrip_policy_t>, 4, 5, 100) != 0 ||
+        loop_through_set(new policy_cache_t<brrip_policy_t>, 4, 5, 100) == 0) {
+        std::cerr << "drcachesim unit_test_replacement_policies failed: "
+                  << "thrashing loop\n";
+        exit(1);
+    }
+}
+
+// Loops a page table line and numlines data lines through one set of an SRRIP
+// cache, with type_policy if not null, and returns the page table line's hits.
+static int_least64_t
+loop_with_page_table_line(type_policy_t *type_policy, int assoc, int numlines, int loops)
+{
+    cache_t *cache = new policy_cache_t<srrip_policy_t>;
+    cache_stats_t *stats = new cache_stats_t("", false);
+    if (!cache->init(assoc, 64, assoc * 64, NULL, stats) ||
+        !cache->set_type_policy(type_policy)) {
+        std::cerr << "drcachesim unit_test_type_policies failed to init\n";
+        exit(1);
+    }
+    int_least64_t hits = 0;
+    for (int i = 0; i < loops * (numlines + 1); i++) {
+        memref_t ref;
+        memset(&ref, 0, sizeof(ref));
+        int line = i % (numlines + 1);
+        ref.data.type = line == 0 ? TRACE_TYPE_PE4 : TRACE_TYPE_READ;
+        ref.data.size = 8;
+        ref.data.addr = line * 64;
+        if (cache->request(ref) == FOUND_L1 && line == 0)
+            hits++;
+    }
+    delete cache;
+    delete stats;
+    delete type_policy;
+    return hits;
+}
+
+void
+unit_test_type_policies()
+{
+    // The page table line is thrashed out with the data in a shared set, but
+    // is kept by a way reserved for page table lines or by its insertion
+    // priority.
+    if (loop_with_page_table_line(nullptr, 4, 4, 100) != 0 ||
+        loop_with_page_table_line(new pt_partition_policy_t(1), 4, 4, 100) != 99 ||
+        loop_with_page_table_line(new pt_priority_policy_t(4), 4, 4, 100) != 99) {
+        std::cerr << "drcachesim unit_test_type_policies failed\n";
+        exit(1);
+    }
+}
+
+// Reads num_pages pages sequentially, one read per line, through a cache
+// large enough to hold them all with the given prefetcher, and returns the
+// misses, or -1 if no prefetch was useful.
+static int_least64_t
+stream_through_pages(prefetcher_t *prefetcher, int num_pages)
+{
+    cache_t *cache = new cache_lru_t;
+    cache_stats_t *stats = new cache_stats_t("", false);
+    if (!cache->init(8, 64, num_pages * 4096, NULL, stats, prefetcher)) {
+        std::cerr << "drcachesim unit_test_prefetchers failed to init\n";
+        exit(1);
+    }
+    for (int i = 0; i < num_pages * 4096 / 64; i++) {
+        memref_t ref;
+        memset(&ref, 0, sizeof(ref));
+        ref.data.type = TRACE_TYPE_READ;
+        ref.data.size = 8;
+        ref.data.addr = 0x100000 + i * 64;
+        cache->request(ref);
+    }
+    int_least64_t misses = stats->get_misses();
+    if (prefetcher != nullptr && stats->get_prefetch_useful() == 0)
+        misses = -1;
+    delete cache;
+    delete stats;
+    delete prefetcher;
+    return misses;
+}
+
+void
+unit_test_prefetchers()
+{
+    // The stride and stream prefetchers pick up the sequential stream after a
+    // few lines of each page.  The spatial one learns the footprint of a
+    // page once it leaves its 32 active regions, and then fetches the whole
+    // of each new page.
+    const int pages = 128;
+    int_least64_t none = stream_through_pages(nullptr, pages);
+    int_least64_t stride = stream_through_pages(new stride_prefetcher_t(64, 2), pages);
+    int_least64_t stream = stream_through_pages(new stream_prefetcher_t(64, 2), pages);
+    int_least64_t spatial = stream_through_pages(new spatial_prefetcher_t(64), pages);
+    if (none != pages * 64 || stride <= 0 || stride >= none / 2 || stream <= 0 ||
+        stream >= none / 2 || spatial <= 0 || spatial >= none / 2) {
+        std::cerr << "drcachesim unit_test_prefetchers failed: " << none << " " << stride
+                  << " " << stream << " " << spatial << "\n";
+        exit(1);
+    }
+}
+
+void
+unit_test_coherence()
+{
+    // Two cores with an L1 and an L2 each, the L2s tracked by a directory.
+    const int cores = 2;
+    cache_t *l1[cores], *l2[cores];
+    snoop_filter_t snoop_filter;
+    for (int i = 0; i < cores; i++) {
+        l1[i] = new cache_lru_t;
+        l2[i] = new cache_lru_t;
+        if (!l2[i]->init(4, 64, 16 * 64, NULL, new cache_stats_t("", false)) ||
+            !l1[i]->init(4, 64, 4 * 64, l2[i], new cache_stats_t("", false))) {
+            std::cerr << "drcachesim unit_test_coherence failed to init\n";
+            exit(1);
+        }
+        l2[i]->set_inclusive(true, { l1[i] });
+        l2[i]->set_snoop_filter(&snoop_filter, i, true);
+        l1[i]->set_snoop_filter(&snoop_filter, i, false);
+    }
+    if (!snoop_filter.init({ l2[0], l2[1] })) {
+        std::cerr << "drcachesim unit_test_coherence failed to init\n";
+        exit(1);
+    }
+    memref_t ref;
+    memset(&ref, 0, sizeof(ref));
+    ref.data.type = TRACE_TYPE_READ;
+    ref.data.size = 8;
+    ref.data.addr = 0x1000;
+    l1[0]->request(ref);
+    l1[1]->request(ref);
+    // Core 1's write hits in its L1 and takes the line from core 0.
+    ref.data.type = TRACE_TYPE_WRITE;
+    if (l1[1]->request(ref) != FOUND_L1 || l1[0]->probe(0x1000) ||
+        l2[0]->probe(0x1000) || !l2[1]->probe(0x1000)) {
+        std::cerr << "drcachesim unit_test_coherence failed: write did not invalidate\n";
+        exit(1);
+    }
+    // Core 0 misses on it again, which the directory sees as a read of a line
+    // core 1 modified, leaving it shared.
+    ref.data.type = TRACE_TYPE_READ;
+    if (l1[0]->request(ref) != NOT_FOUND || !l2[1]->probe(0x1000)) {
+        std::cerr << "drcachesim unit_test_coherence failed: read did not share\n";
+        exit(1);
+    }
+    // A line core 0 evicts from its L2 leaves its L1 too.
+    for (int i = 1; i <= 16; i++) {
+        ref.data.addr = 0x1000 + i * 16 * 64;
+        l2[0]->request(ref);
+    }
+    if (l1[0]->probe(0x1000)) {
+        std::cerr << "drcachesim unit_test_coherence failed: L2 not inclusive\n";
+        exit(1);
+    }
+    for (int i = 0; i < cores; i++) {
+        delete l1[i]->get_stats();
+        delete l2[i]->get_stats();
+        delete l1[i];
+        delete l2[i];
+    }
+}
+
+// Times two data references that miss to DRAM.
+static uint64_t
+timing_two_misses(unsigned int issue_window, addr_t second_addr)
+{
+    timing_model_t timing;
+    std::string error;
+    if (!timing.init("", 1, 64, issue_window, 1, false, false, true, true, error)) {
+        std::cerr << "drcachesim unit_test_timing_model failed to init: " << error
+                  << "\n";
+        exit(1);
+    }
+    timing_model_t::timing_ref_t ref;
+    ref.fetch_buffer_hit = false;
+    ref.is_inst = false;
+    ref.walked = false;
+    ref.pwc_probes = 0;
+    ref.selected_way = -1;
+    ref.accessed = true;
+    ref.res = NOT_FOUND;
+    ref.addr = 0x100000;
+    timing.reference(0, ref);
+    ref.addr = second_addr;
+    timing.reference(0, ref);
+    return timing.get_cycles();
+}
+
+void
+unit_test_timing_model()
+{
+    // An uncontended miss to a closed DRAM row: TLB, L1, L2, LLC and DRAM.
+    const uint64_t miss_cycles = 1 + 4 + 10 + 40 + 146;
+    // In order, the second miss, to another bank, starts after the first.
+    if (timing_two_misses(1, 0x200000 + 8192) != 2 * miss_cycles) {
+        std::cerr << "drcachesim unit_test_timing_model failed: in-order misses "
+                     "overlapped\n";
+        exit(1);
+    }
+    // With a window of two they overlap.
+    if (timing_two_misses(2, 0x200000 + 8192) != miss_cycles + 1) {
+        std::cerr << "drcachesim unit_test_timing_model failed: windowed misses did "
+                     "not overlap\n";
+        exit(1);
+    }
+    // A miss to the block already in flight merges into its MSHR.
+    if (timing_two_misses(2, 0x100008) != miss_cycles) {
+        std::cerr << "drcachesim unit_test_timing_model failed: miss did not merge\n";
+        exit(1);
+    }
+}
+
+void
+unit_test_interference()
+{
+    interference_t first, second;
+    std::string error;
+    if (!first.init(INTERFERENCE_UNIFORM, "", RADIX, 1 << 20, 64, 7, error) ||
+        !second.init(INTERFERENCE_UNIFORM, "", RADIX, 1 << 20, 64, 7, error)) {
+        std::cerr << "drcachesim unit_test_interference failed to init: " << error
+                  << "\n";
+        exit(1);
+    }
+    // The same seed draws the same requests, and a rate of 150 hundredths
+    // averages one and a half requests.
+    unsigned int total = 0;
+    for (int i = 0; i < 10000; i++) {
+        unsigned int num = first.num_requests(150);
+        if (num != second.num_requests(150) || num < 1 || num > 2) {
+            std::cerr << "drcachesim unit_test_interference failed: request count\n";
+            exit(1);
+        }
+        total += num;
+        addr_t addr = first.next_addr();
+        if (addr != second.next_addr() || addr >= 1 << 20) {
+            std::cerr << "drcachesim unit_test_interference failed: address\n";
+            exit(1);
+        }
+    }
+    if (total < 14500 || total > 15500) {
+        std::cerr << "drcachesim unit_test_interference failed: rate " << total
+                  << "\n";
+        exit(1);
+    }
+    if (first.num_requests(0) != 0 || first.num_requests(200) != 2) {
+        std::cerr << "drcachesim unit_test_interference failed: whole rates\n";
+        exit(1);
+    }
+    interference_t strided;
+    if (!strided.init(INTERFERENCE_STRIDE, "", RADIX, 256, 64, 7, error) ||
+        strided.next_addr() != 0 || strided.next_addr() != 64 ||
+        strided.next_addr() != 128 || strided.next_addr() != 192 ||
+        strided.next_addr() != 0) {
+        std::cerr << "drcachesim unit_test_interference failed: stride\n";
+        exit(1);
+    }
+}
+
+// The hits of an exact LRU structure of entries entries and assoc ways, 0
+// being fully associative, on tags.
+static uint64_t
+lru_hits(const std::vector<addr_t> &tags, unsigned int entries, unsigned int assoc)
+{
+    unsigned int sets = assoc == 0 ? 1 : entries / assoc;
+    unsigned int ways = assoc == 0 ? entries : assoc;
+    std::vector<std::vector<addr_t>> stacks(sets);
+    uint64_t hits = 0;
+    for (addr_t tag : tags) {
+        std::vector<addr_t> &stack = stacks[tag % sets];
+        auto it = std::find(stack.begin(), stack.end(), tag);
+        if (it != stack.end()) {
+            hits++;
+            stack.erase(it);
+        } else if (stack.size() == ways)
+            stack.pop_back();
+        stack.insert(stack.begin(), tag);
+    }
+    return hits;
+}
+
+void
+unit_test_miss_ratio_curve()
+{
+    miss_ratio_curve_t curve;
+    std::string error;
+    const std::vector<unsigned int> assocs = { 1, 4, 0 };
+    if (!curve.init(64, assocs, 1, error)) {
+        std::cerr << "drcachesim unit_test_miss_ratio_curve failed to init: " << error
+                  << "\n";
+        exit(1);
+    }
+    // A mix of hot and cold tags.
+    std::vector<addr_t> tags;
+    uint64_t state = 1;
+    for (int i = 0; i < 20000; i++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        addr_t tag = (state >> 33) % ((state >> 20) % 4 == 0 ? 256 : 24);
+        tags.push_back(tag);
+        curve.access(tag);
+    }
+    for (unsigned int assoc : assocs) {
+        for (unsigned int entries = assoc == 0 ? 1 : assoc; entries <= 64; entries *= 2) {
+            uint64_t hits = 0, accesses = 0;
+            if (!curve.get_counts(entries, assoc, &hits, &accesses) ||
+                accesses != tags.size() || hits != lru_hits(tags, entries, assoc)) {
+                std::cerr << "drcachesim unit_test_miss_ratio_curve failed: " << entries
+                          << " entries, assoc " << assoc << "\n";
+                exit(1);
+            }
+        }
+    }
+}
+
+// Reads the lines [first, first + numlines) through cache and returns the hits.
+static int_least64_t
+read_lines(cache_t *cache, int first, int numlines)
+{
+    int_least64_t hits = 0;
+    for (int i = first; i < first + numlines; i++) {
+        memref_t ref;
+        memset(&ref, 0, sizeof(ref));
+        ref.data.type = TRACE_TYPE_READ;
+        ref.data.size = 8;
+        ref.data.addr = i * 64;
+        if (cache->request(ref) == FOUND_L1)
+            hits++;
+    }
+    return hits;
+}
+
+void
+unit_test_checkpoint()
+{
+    const std::string path = "drcachesim_unit_test_checkpoint.bin";
+    cache_t *warm = new cache_lru_t, *cold = new cache_lru_t, *other = new cache_lru_t;
+    cache_stats_t *stats = new cache_stats_t("", false);
+    if (!warm->init(4, 64, 16 * 64, NULL, stats) ||
+        !cold->init(4, 64, 16 * 64, NULL, stats) ||
+        !other->init(8, 64, 16 * 64, NULL, stats)) {
+        std::cerr << "drcachesim unit_test_checkpoint failed to init\n";
+        exit(1);
+    }
+    // Fill the cache, then replace the oldest half of it.
+    read_lines(warm, 0, 16);
+    read_lines(warm, 16, 8);
+    checkpoint_writer_t out;
+    checkpoint_header_t header = { RADIX, 1, 24 };
+    std::string error;
+    if (!out.open(path, error)) {
+        std::cerr << "drcachesim unit_test_checkpoint failed: " << error << "\n";
+        exit(1);
+    }
+    out.write_header(header);
+    warm->save_state(out, "cache");
+    if (!out.close(error)) {
+        std::cerr << "drcachesim unit_test_checkpoint failed: " << error << "\n";
+        exit(1);
+    }
+    // The restored cache holds the same lines with the same recency, and one
+    // with another geometry refuses the state.
+    checkpoint_reader_t in, in_other;
+    checkpoint_header_t read_header;
+    if (!in.open(path, &read_header, error) || read_header.trace_refs != 24 ||
+        !cold->restore_state(in, "cache", error) || !in.close(error) ||
+        read_lines(cold, 8, 16) != 16 || read_lines(cold, 24, 4) != 0 ||
+        read_lines(cold, 16, 4) != 4 || !in_other.open(path, &read_header, error) ||
+        other->restore_state(in_other, "cache", error)) {
+        std::cerr << "drcachesim unit_test_checkpoint failed: " << error << "\n";
+        exit(1);
+    }
+    remove(path.c_str());
+    delete warm;
+    delete cold;
+    delete other;
+    delete stats;
+}
+
+void
+unit_test_sampler()
+{
+    sampler_t sampler;
+    std::string error;
+    // Periods of 10: 2 skipped, 3 functional, 1 detailed and 4 measured.
+    if (!sampler.init(10, 4, 1, 2, 0.05, 0.95, error)) {
+        std::cerr << "drcachesim unit_test_sampler failed to init: " << error << "\n";
+        exit(1);
+    }
+    const sample_phase_t period[] = {
+        SAMPLE_SKIP,       SAMPLE_SKIP,    SAMPLE_FUNCTIONAL, SAMPLE_FUNCTIONAL,
+        SAMPLE_FUNCTIONAL, SAMPLE_DETAILED, SAMPLE_MEASURE,   SAMPLE_MEASURE,
+        SAMPLE_MEASURE,    SAMPLE_MEASURE
+    };
+    // Every window walks on 2 references of 4 but the last one or two, which
+    // spreads the estimate until enough windows narrow it down.
+    int windows = 0;
+    while (!sampler.is_done() && windows < 1000) {
+        for (int i = 0; i < 10; i++) {
+            if (sampler.next() != period[i] ||
+                sampler.window_complete() != (i == 9)) {
+                std::cerr << "drcachesim unit_test_sampler failed: schedule\n";
+                exit(1);
+            }
+            if (period[i] == SAMPLE_MEASURE)
+                sampler.measure(true, i < 8 || (i == 8 && windows % 3 == 0), 10);
+        }
+        sampler.end_window();
+        windows++;
+    }
+    sample_estimate_t rate = sampler.walk_rate();
+    if (std::abs(sampler_t::confidence_z(0.95) - 1.96) > 0.01 || !sampler.is_done() ||
+        windows < 30 || sampler.next() != SAMPLE_DONE ||
+        std::abs(rate.mean - 100.0 * 7 / 12) > rate.half_width ||
+        rate.relative_error > 0.05 || sampler.walk_latency().mean != 10.0) {
+        std::cerr << "drcachesim unit_test_sampler failed: estimates\n";
+        exit(1);
+    }
+}
+
+void
+unit_test_page_table_builder()
+{
+    std::string error;
+    _memref_pgtable_results walk;
+    page_table_builder_t radix;
+    if (!radix.init(RADIX, SCHEME_RADIX, "4K", 0, 0, 0, 0, 0, error)) {
+        std::cerr << "drcachesim unit_test_page_table_builder failed to init: " << error
+                  << "\n";
+        exit(1);
+    }
+    // Neighbouring 4KB pages share their upper levels and leaf page table page.
+    memset(&walk, 0, sizeof(walk));
+    radix.translate(1, 0x7f0000001234, walk);
+    _memref_pgtable_results next;
+    memset(&next, 0, sizeof(next));
+    radix.translate(1, 0x7f0000002000, next);
+    if (walk.success != 1 || walk.num_steps != 4 || (walk.paddr & 0xfff) != 0x234 ||
+        next.paddr == walk.paddr - 0x234 ||
+        memcmp(walk.steps, next.steps, 3 * sizeof(addr_t)) != 0 ||
+        next.steps[3] != walk.steps[3] + 8) {
+        std::cerr << "drcachesim unit_test_page_table_builder failed: radix\n";
+        exit(1);
+    }
+    // A recorded 2MB page keeps its physical address and ends the walk early.
+    memset(&walk, 0, sizeof(walk));
+    walk.success = 1;
+    walk.num_steps = 3;
+    walk.paddr = 0x40234567;
+    radix.translate(2, 0x600000234567, walk);
+    memset(&next, 0, sizeof(next));
+    radix.translate(2, 0x600000300000, next);
+    if (walk.num_steps != 3 || walk.paddr != 0x40234567 || next.num_steps != 3 ||
+        next.paddr != 0x40300000 || next.steps[2] != walk.steps[2]) {
+        std::cerr << "drcachesim unit_test_page_table_builder failed: huge page\n";
+        exit(1);
+    }
+
+    page_table_builder_t ecpt;
+    if (!ecpt.init(ECPT, SCHEME_ECPT, "4K", 3, 3, 0, 2, 2, error)) {
+        std::cerr << "drcachesim unit_test_page_table_builder failed to init: " << error
+                  << "\n";
+        exit(1);
+    }
+    // Enough clusters to resize the ways: each cluster still has an entry of
+    // its own in the way the walk selects.
+    std::vector<addr_t> entries;
+    for (addr_t cluster = 0; cluster < 4096; cluster++) {
+        memset(&walk, 0, sizeof(walk));
+        ecpt.translate(1, 0x10000000 + cluster * 8 * 4096, walk);
+        if (walk.num_steps != ECPT_TABLE_LEAVES || walk.aux_info.selected_ecpt_way >= 3 ||
+            walk.aux_info.n_cwt_steps != 4 || !walk.aux_info.pmd_header.present_4KB ||
+            walk.aux_info.pmd_header.present_2MB || !walk.aux_info.pud_header.present_4KB) {
+            std::cerr << "drcachesim unit_test_page_table_builder failed: ecpt walk\n";
+            exit(1);
+        }
+    }
+    for (addr_t cluster = 0; cluster < 4096; cluster++) {
+        memset(&walk, 0, sizeof(walk));
+        ecpt.translate(1, 0x10000000 + cluster * 8 * 4096, walk);
+        entries.push_back(walk.steps[walk.aux_info.selected_ecpt_way]);
+    }
+    std::sort(entries.begin(), entries.end());
+    if (std::adjacent_find(entries.begin(), entries.end()) != entries.end()) {
+        std::cerr << "drcachesim unit_test_page_table_builder failed: ecpt entries\n";
+        exit(1);
+    }
+
+    page_table_builder_t flattened;
+    page_table_builder_t hashed;
+    page_table_builder_t nested;
+    if (!flattened.init(RADIX, SCHEME_FLATTENED, "4K", 0, 0, 0, 0, 0, error) ||
+        !hashed.init(RADIX, SCHEME_HASHED, "4K", 0, 0, 0, 0, 0, error) ||
+        !nested.init(RADIX, SCHEME_NESTED, "4K", 0, 0, 0, 0, 0, error)) {
+        std::cerr << "drcachesim unit_test_page_table_builder failed to init: " << error
+                  << "\n";
+        exit(1);
+    }
+    // A flattened walk reads the merged upper and lower nodes.
+    memset(&walk, 0, sizeof(walk));
+    flattened.translate(1, 0x7f0000001234, walk);
+    memset(&next, 0, sizeof(next));
+    flattened.translate(1, 0x7f0000002000, next);
+    if (walk.num_steps != 2 || next.num_steps != 2 || next.steps[0] != walk.steps[0] ||
+        next.steps[1] != walk.steps[1] + 8) {
+        std::cerr << "drcachesim unit_test_page_table_builder failed: flattened\n";
+        exit(1);
+    }
+    // Through a resize of the hashed table, each cluster's walk still ends at
+    // a line of its own.
+    entries.clear();
+    for (addr_t cluster = 0; cluster < 4096; cluster++) {
+        memset(&walk, 0, sizeof(walk));
+        hashed.translate(1, 0x10000000 + cluster * 8 * 4096, walk);
+    }
+    for (addr_t cluster = 0; cluster < 4096; cluster++) {
+        memset(&walk, 0, sizeof(walk));
+        hashed.translate(1, 0x10000000 + cluster * 8 * 4096, walk);
+        if (walk.num_steps == 0 || walk.num_steps > 4) {
+            std::cerr << "drcachesim unit_test_page_table_builder failed: hashed walk\n";
+            exit(1);
+        }
+        entries.push_back(walk.steps[walk.num_steps - 1]);
+    }
+    std::sort(entries.begin(), entries.end());
+    if (std::adjacent_find(entries.begin(), entries.end()) != entries.end()) {
+        std::cerr << "drcachesim unit_test_page_table_builder failed: hashed entries\n";
+        exit(1);
+    }
+    // A nested translation gives the guest walk and the host physical address
+    // that the host walk of the guest physical address ends at.
+    memset(&walk, 0, sizeof(walk));
+    nested.translate(1, 0x7f0000001234, walk);
+    addr_t host_steps[PAGE_TABLE_LEAVES];
+    addr_t hpa = 0;
+    if (walk.num_steps != 4 || (walk.steps[PAGE_TABLE_LEAVES] & 0xfff) != 0x234 ||
+        nested.host_walk(walk.steps[PAGE_TABLE_LEAVES], host_steps, hpa) != 4 ||
+        hpa != walk.paddr || hpa == walk.steps[PAGE_TABLE_LEAVES]) {
+        std::cerr << "drcachesim unit_test_page_table_builder failed: nested\n";
+        exit(1);
+    }
+}
+
 int
 main(int argc, const char *argv[])
 {
     unit_test_warmup_fraction();
     unit_test_warmup_refs();
     unit_test_sim_refs();
+    unit_test_sweep_file();
+    unit_test_pipelined_analyzer();
+    unit_test_qemu_reader();
+#ifdef HAS_ZLIB
+    unit_test_qemu_container();
+#endif
+    unit_test_flat_histogram();
+    unit_test_walk_latency();
+    unit_test_epochs();
+    unit_test_tlb_page_sizes();
+    unit_test_walk_cache_knobs();
+    unit_test_replacement_policies();
+    unit_test_type_policies();
+    unit_test_prefetchers();
+    unit_test_coherence();
+    unit_test_timing_model();
+    unit_test_interference();
+    unit_test_miss_ratio_curve();
+    unit_test_checkpoint();
+    unit_test_sampler();
+    unit_test_page_table_builder();
     return 0;
 }
@@ -0,0 +1,170 @@
+/* **********************************************************
+ * Copyright (c) 2015-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+// Microbenchmark for the set search kernels in simulator/way_lookup.h.
+// Checks every kernel available on this CPU against the scalar one and prints
+// lookups per second for each associativity.  An optional argument sets the
+// number of lookups per measurement.
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "simulator/way_lookup.h"
+
+static const int NUM_SETS = 1024;
+static const int NUM_QUERIES = 4096;
+
+struct bench_sets_t {
+    int associativity;
+    std::vector<addr_t> tags;
+    std::vector<memref_pid_t> pids;
+    std::vector<int> counters;
+    // Half of the queries hit, at a random way.
+    std::vector<int> query_set;
+    std::vector<addr_t> query_tag;
+    std::vector<memref_pid_t> query_pid;
+};
+
+static bench_sets_t
+make_sets(int associativity, std::mt19937_64 &rng)
+{
+    bench_sets_t b;
+    b.associativity = associativity;
+    int num_blocks = NUM_SETS * associativity;
+    b.tags.resize(num_blocks);
+    b.pids.resize(num_blocks);
+    b.counters.resize(num_blocks);
+    for (int i = 0; i < num_blocks; ++i) {
+        b.tags[i] = rng() >> 16;
+        b.pids[i] = rng() % 4;
+        b.counters[i] = i % associativity;
+    }
+    for (int q = 0; q < NUM_QUERIES; ++q) {
+        int set = rng() % NUM_SETS;
+        b.query_set.push_back(set * associativity);
+        if (rng() % 2 == 0) {
+            int way = rng() % associativity;
+            b.query_tag.push_back(b.tags[set * associativity + way]);
+            b.query_pid.push_back(b.pids[set * associativity + way]);
+        } else {
+            b.query_tag.push_back(rng() >> 16);
+            b.query_pid.push_back(rng() % 4);
+        }
+    }
+    return b;
+}
+
+static bool
+check_kernels(const way_lookup_kernels_t &k, const way_lookup_kernels_t &ref,
+              bench_sets_t &b)
+{
+    int assoc = b.associativity;
+    for (int q = 0; q < NUM_QUERIES; ++q) {
+        const addr_t *tags = &b.tags[b.query_set[q]];
+        const memref_pid_t *pids = &b.pids[b.query_set[q]];
+        if (k.find_way(tags, assoc, b.query_tag[q]) !=
+                ref.find_way(tags, assoc, b.query_tag[q]) ||
+            k.find_way_pid(tags, pids, assoc, b.query_tag[q], b.query_pid[q]) !=
+                ref.find_way_pid(tags, pids, assoc, b.query_tag[q], b.query_pid[q]))
+            return false;
+        std::vector<int> got(b.counters.begin() + b.query_set[q],
+                             b.counters.begin() + b.query_set[q] + assoc);
+        std::vector<int> expect = got;
+        int cnt = q % assoc;
+        k.lru_age(got.data(), assoc, cnt);
+        ref.lru_age(expect.data(), assoc, cnt);
+        if (got != expect)
+            return false;
+    }
+    return true;
+}
+
+template <typename func_t>
+static double
+measure(uint64_t lookups, func_t lookup)
+{
+    auto start = std::chrono::steady_clock::now();
+    int sink = 0;
+    for (uint64_t i = 0; i < lookups; ++i)
+        sink += lookup(i % NUM_QUERIES);
+    std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+    // Keep the compiler from dropping the loop.
+    if (sink == -1)
+        std::cerr << "";
+    return lookups / secs.count();
+}
+
+int
+main(int argc, const char *argv[])
+{
+    uint64_t lookups = argc > 1 ? strtoull(argv[1], NULL, 0) : 20000000;
+    std::vector<const way_lookup_kernels_t *> kernels = way_lookup_available_kernels();
+    std::mt19937_64 rng(42);
+    std::cout << "Using " << way_lookup_kernels().name << " kernels\n";
+    std::cout << std::setw(8) << "kernel" << std::setw(7) << "assoc" << std::setw(16)
+              << "find_way/s" << std::setw(16) << "find_way_pid/s" << std::setw(16)
+              << "lru_age/s"
+              << "\n";
+    for (int assoc : { 1, 2, 4, 8, 12, 16, 32 }) {
+        bench_sets_t b = make_sets(assoc, rng);
+        for (const way_lookup_kernels_t *k : kernels) {
+            if (!check_kernels(*k, *kernels[0], b)) {
+                std::cerr << "way_lookup_bench failed: " << k->name
+                          << " disagrees with scalar at associativity " << assoc
+                          << "\n";
+                exit(1);
+            }
+            double find = measure(lookups, [&](int q) {
+                return k->find_way(&b.tags[b.query_set[q]], assoc, b.query_tag[q]);
+            });
+            double find_pid = measure(lookups, [&](int q) {
+                return k->find_way_pid(&b.tags[b.query_set[q]], &b.pids[b.query_set[q]],
+                                       assoc, b.query_tag[q], b.query_pid[q]);
+            });
+            double age = measure(lookups, [&](int q) {
+                int *counters = &b.counters[b.query_set[q]];
+                k->lru_age(counters, assoc, q % assoc);
+                // Keep the counters bounded as LRU does.
+                counters[q % assoc] = 0;
+                return counters[0];
+            });
+            std::cout << std::setw(8) << k->name << std::setw(7) << assoc
+                      << std::setw(16) << std::scientific << std::setprecision(3)
+                      << find << std::setw(16) << find_pid << std::setw(16) << age
+                      << "\n";
+        }
+    }
+    return 0;
+}
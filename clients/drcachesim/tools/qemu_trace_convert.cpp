@@ -0,0 +1,246 @@
+/* **********************************************************
+ * Copyright (c) 2016-2018 Google, Inc.  All rights reserved.
+ * **********************************************************/
+
+/*
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Google, Inc. nor the names of its contributors may be
+ *   used to endorse or promote products derived from this software without
+ *   specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL VMWARE, INC. OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ */
+
+/* Converts QEMU page-walk traces between the raw .bin format and the compressed,
+ * chunked container format of reader/qemu_trace_format.h.
+ */
+
+#ifdef WINDOWS
+#    define UNICODE
+#    define _UNICODE
+#    define WIN32_LEAN_AND_MEAN
+#    include <windows.h>
+#endif
+
+#include <algorithm>
+#include <future>
+#include <string.h>
+#include <thread>
+#include <vector>
+#include "droption.h"
+#include "dr_frontend.h"
+#include "../reader/qemu_trace_format.h"
+
+#define FATAL_ERROR(msg, ...)                               \
+    do {                                                    \
+        fprintf(stderr, "ERROR: " msg "\n", ##__VA_ARGS__); \
+        fflush(stderr);                                     \
+        exit(1);                                            \
+    } while (0)
+
+static droption_t<std::string> op_in(DROPTION_SCOPE_FRONTEND, "in", "",
+                                     "[Required] Input trace file",
+                                     "Specifies the trace to convert.");
+
+static droption_t<std::string> op_out(DROPTION_SCOPE_FRONTEND, "out", "",
+                                      "[Required] Output trace file",
+                                      "Specifies the path to the converted trace.");
+
+static droption_t<std::string> op_arch(DROPTION_SCOPE_FRONTEND, "arch", "radix",
+                                       "Page table architecture of the trace",
+                                       "Specifies the record layout of the trace: "
+                                       "'radix' or 'ecpt'.");
+
+static droption_t<unsigned int> op_chunk_records(
+    DROPTION_SCOPE_FRONTEND, "chunk_records", QEMU_TRACE_DEFAULT_CHUNK_RECORDS,
+    "Records per compressed chunk",
+    "Specifies the number of records in each independently decodable chunk.  Smaller "
+    "chunks make seeks cheaper; larger ones compress slightly better.");
+
+static droption_t<int> op_level(DROPTION_SCOPE_FRONTEND, "level", 6, 1, 9,
+                                "zlib compression level",
+                                "Specifies the zlib compression level, from 1 to 9.");
+
+static droption_t<bool> op_unpack(DROPTION_SCOPE_FRONTEND, "unpack", false,
+                                  "Convert a container back to a raw trace",
+                                  "Converts a container produced by this tool back "
+                                  "into the raw .bin format instead of the reverse.");
+
+struct pack_chunk_t {
+    std::vector<uint8_t> records;
+    std::vector<uint8_t> compressed;
+    uint32_t encoded_size;
+    bool ok;
+};
+
+static void
+compress_chunk(trans_arch arch, size_t record_size, int level, pack_chunk_t *chunk)
+{
+    chunk->ok = qemu_trace_compress_chunk(arch, chunk->records.data(),
+                                          chunk->records.size() / record_size, level,
+                                          chunk->compressed, chunk->encoded_size);
+}
+
+static void
+pack(FILE *in, FILE *out, trans_arch arch)
+{
+    size_t record_size = qemu_trace_record_size(arch);
+    size_t chunk_bytes = (size_t)op_chunk_records.get_value() * record_size;
+    unsigned int batch = std::max(1U, std::thread::hardware_concurrency());
+    qemu_trace_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, QEMU_TRACE_MAGIC, QEMU_TRACE_MAGIC_SIZE);
+    header.version = QEMU_TRACE_VERSION;
+    header.arch = arch;
+    header.record_size = (uint32_t)record_size;
+    header.chunk_records = op_chunk_records.get_value();
+    // The header is rewritten once the index location is known.
+    if (fwrite(&header, sizeof(header), 1, out) != 1)
+        FATAL_ERROR("Failed to write %s", op_out.get_value().c_str());
+    uint64_t offset = sizeof(header);
+    std::vector<qemu_trace_chunk_t> index;
+    std::vector<pack_chunk_t> chunks(batch);
+    size_t leftover = 0;
+    bool done = false;
+    while (!done) {
+        // Read a batch of chunks and compress them in parallel.
+        size_t count = 0;
+        for (; count < batch; count++) {
+            std::vector<uint8_t> &records = chunks[count].records;
+            records.resize(chunk_bytes);
+            size_t got = fread(records.data(), 1, chunk_bytes, in);
+            leftover = got % record_size;
+            records.resize(got - leftover);
+            if (got < chunk_bytes) {
+                done = true;
+                if (!records.empty())
+                    count++;
+                break;
+            }
+        }
+        std::vector<std::future<void>> workers;
+        for (size_t i = 0; i < count; i++) {
+            workers.push_back(std::async(std::launch::async, compress_chunk, arch,
+                                         record_size, op_level.get_value(), &chunks[i]));
+        }
+        for (size_t i = 0; i < count; i++) {
+            workers[i].get();
+            if (!chunks[i].ok)
+                FATAL_ERROR("Failed to compress chunk %zu", index.size());
+            qemu_trace_chunk_t entry;
+            memset(&entry, 0, sizeof(entry));
+            entry.offset = offset;
+            entry.first_record = header.num_records;
+            entry.compressed_size = (uint32_t)chunks[i].compressed.size();
+            entry.encoded_size = chunks[i].encoded_size;
+            entry.num_records = (uint32_t)(chunks[i].records.size() / record_size);
+            // Patch the previous chunk, possibly from the last batch, now
+            // that the header following it is known.
+            if (!index.empty())
+                index.back().next_header = chunks[i].records[0];
+            index.push_back(entry);
+            if (fwrite(chunks[i].compressed.data(), 1, entry.compressed_size, out) !=
+                entry.compressed_size)
+                FATAL_ERROR("Failed to write %s", op_out.get_value().c_str());
+            offset += entry.compressed_size;
+            header.num_records += entry.num_records;
+        }
+    }
+    if (ferror(in))
+        FATAL_ERROR("Failed to read %s", op_in.get_value().c_str());
+    if (leftover != 0) {
+        fprintf(stderr, "Warning: ignoring %zu trailing bytes of a partial record\n",
+                leftover);
+    }
+    header.num_chunks = index.size();
+    header.index_offset = offset;
+    if (fwrite(index.data(), sizeof(qemu_trace_chunk_t), index.size(), out) !=
+            index.size() ||
+        fseek(out, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, out) != 1)
+        FATAL_ERROR("Failed to write %s", op_out.get_value().c_str());
+    fprintf(stderr, "Packed %llu records into %zu chunks: %llu -> %llu bytes\n",
+            (unsigned long long)header.num_records, index.size(),
+            (unsigned long long)(header.num_records * record_size),
+            (unsigned long long)(offset + index.size() * sizeof(qemu_trace_chunk_t)));
+}
+
+static void
+unpack(FILE *in, FILE *out, trans_arch arch)
+{
+    if (!qemu_trace_is_container(in))
+        FATAL_ERROR("%s is not a QEMU trace container", op_in.get_value().c_str());
+    qemu_trace_container_t container(in, arch);
+    std::string error;
+    if (!container.open(error))
+        FATAL_ERROR("Failed to open %s: %s", op_in.get_value().c_str(), error.c_str());
+    size_t record_size = qemu_trace_record_size(arch);
+    const uint8_t *record;
+    uint8_t next_header;
+    while ((record = container.next_record(&next_header)) != NULL) {
+        if (fwrite(record, record_size, 1, out) != 1)
+            FATAL_ERROR("Failed to write %s", op_out.get_value().c_str());
+    }
+    if (container.failed())
+        FATAL_ERROR("Corrupt chunk in %s", op_in.get_value().c_str());
+}
+
+int
+_tmain(int argc, const TCHAR *targv[])
+{
+    // Convert to UTF-8 if necessary
+    char **argv;
+    drfront_status_t sc = drfront_convert_args(targv, &argv, argc);
+    if (sc != DRFRONT_SUCCESS)
+        FATAL_ERROR("Failed to process args: %d", sc);
+
+    std::string parse_err;
+    if (!droption_parser_t::parse_argv(DROPTION_SCOPE_FRONTEND, argc, (const char **)argv,
+                                       &parse_err, NULL) ||
+        op_in.get_value().empty() || op_out.get_value().empty()) {
+        FATAL_ERROR("Usage error: %s\nUsage:\n%s", parse_err.c_str(),
+                    droption_parser_t::usage_short(DROPTION_SCOPE_ALL).c_str());
+    }
+    trans_arch arch;
+    if (op_arch.get_value() == "radix")
+        arch = RADIX;
+    else if (op_arch.get_value() == "ecpt")
+        arch = ECPT;
+    else
+        FATAL_ERROR("Unknown -arch %s", op_arch.get_value().c_str());
+    if (op_chunk_records.get_value() == 0)
+        FATAL_ERROR("-chunk_records must be positive");
+
+    FILE *in = fopen(op_in.get_value().c_str(), "rb");
+    if (in == NULL)
+        FATAL_ERROR("Failed to open %s", op_in.get_value().c_str());
+    FILE *out = fopen(op_out.get_value().c_str(), "wb");
+    if (out == NULL)
+        FATAL_ERROR("Failed to create %s", op_out.get_value().c_str());
+    if (op_unpack.get_value())
+        unpack(in, out, arch);
+    else
+        pack(in, out, arch);
+    if (fclose(out) != 0)
+        FATAL_ERROR("Failed to write %s", op_out.get_value().c_str());
+    fclose(in);
+    return 0;
+}